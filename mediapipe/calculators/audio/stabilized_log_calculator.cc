@@ -75,7 +75,13 @@ class StabilizedLogCalculator : public CalculatorBase {
   }
 
   absl::Status Process(CalculatorContext* cc) override {
-    auto input_matrix = cc->Inputs().Index(0).Get<Matrix>();
+    // The log is computed in place if the calculator is the sole owner of the
+    // input matrix.
+    MP_ASSIGN_OR_RETURN(
+        std::unique_ptr<Matrix> output_frame,
+        cc->Inputs().Index(0).Value().ConsumeIfSoleOwner<Matrix>());
+    const Matrix& input_matrix =
+        output_frame ? *output_frame : cc->Inputs().Index(0).Get<Matrix>();
     if (input_matrix.array().isNaN().any()) {
       return absl::InvalidArgumentError("NaN input to log operation.");
     }
@@ -84,8 +90,13 @@ class StabilizedLogCalculator : public CalculatorBase {
         return absl::OutOfRangeError("Negative input to log operation.");
       }
     }
-    std::unique_ptr<Matrix> output_frame(new Matrix(
-        output_scale_ * (input_matrix.array() + stabilizer_).log().matrix()));
+    if (output_frame) {
+      output_frame->array() =
+          output_scale_ * (output_frame->array() + stabilizer_).log();
+    } else {
+      output_frame = std::make_unique<Matrix>(
+          output_scale_ * (input_matrix.array() + stabilizer_).log().matrix());
+    }
     cc->Outputs().Index(0).Add(output_frame.release(), cc->InputTimestamp());
     return absl::OkStatus();
   }
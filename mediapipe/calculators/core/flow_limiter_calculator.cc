@@ -13,11 +13,15 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <memory>
 #include <utility>
 #include <vector>
 
+#include "absl/time/time.h"
 #include "mediapipe/calculators/core/flow_limiter_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/deps/clock.h"
+#include "mediapipe/framework/deps/monotonic_clock.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/util/header_util.h"
 
@@ -27,6 +31,7 @@ constexpr char kFinishedTag[] = "FINISHED";
 constexpr char kAllowTag[] = "ALLOW";
 constexpr char kMaxInFlightTag[] = "MAX_IN_FLIGHT";
 constexpr char kOptionsTag[] = "OPTIONS";
+constexpr char kClockTag[] = "CLOCK";
 
 // FlowLimiterCalculator is used to limit the number of frames in flight
 // by dropping input frames when necessary.
@@ -69,6 +74,36 @@ constexpr char kOptionsTag[] = "OPTIONS";
 // input streams are treated as auxiliary input streams.  The auxiliary input
 // streams are limited to timestamps allowed by the "ALLOW" stream.
 //
+// With `adaptive_in_flight` options, `max_in_flight` is adapted to the
+// latency of each frame, measured from its release until its "FINISHED"
+// timestamp arrives.  A frame finishing within `target_latency` while
+// `max_in_flight` frames are in flight grows `max_in_flight` by
+// 1 / `max_in_flight`, and a late frame or a frame abandoned after
+// `in_flight_timeout` shrinks it by `decrease_factor`.  The optional "CLOCK"
+// input side packet provides the clock measuring latency, and the optional
+// "MAX_IN_FLIGHT" output stream reports the `max_in_flight` in effect at each
+// released frame.
+//
+// Example config:
+// node {
+//   calculator: "FlowLimiterCalculator"
+//   input_stream: "raw_frames"
+//   input_stream: "FINISHED:finished"
+//   input_stream_info: {
+//     tag_index: 'FINISHED'
+//     back_edge: true
+//   }
+//   output_stream: "sampled_frames"
+//   output_stream: "MAX_IN_FLIGHT:max_in_flight"
+//   options: {
+//     [mediapipe.FlowLimiterCalculatorOptions.ext] {
+//       max_in_flight: 1
+//       max_in_queue: 1
+//       adaptive_in_flight { target_latency: 50000 max_in_flight: 4 }
+//     }
+//   }
+// }
+//
 class FlowLimiterCalculator : public CalculatorBase {
  public:
   static absl::Status GetContract(CalculatorContract* cc) {
@@ -85,9 +120,16 @@ class FlowLimiterCalculator : public CalculatorBase {
     }
     cc->Inputs().Get("FINISHED", 0).SetAny();
     cc->InputSidePackets().Tag(kMaxInFlightTag).Set<int>().Optional();
+    cc->InputSidePackets()
+        .Tag(kClockTag)
+        .Set<std::shared_ptr<::mediapipe::Clock>>()
+        .Optional();
     cc->Outputs().Tag(kAllowTag).Set<bool>().Optional();
+    cc->Outputs().Tag(kMaxInFlightTag).Set<int>().Optional();
     cc->SetInputStreamHandler("ImmediateInputStreamHandler");
     cc->SetProcessTimestampBounds(true);
+    // Stale FINISHED timestamps still release their place in flight.
+    cc->SetProcessStaleTimestamps(true);
     return absl::OkStatus();
   }
 
@@ -98,6 +140,22 @@ class FlowLimiterCalculator : public CalculatorBase {
       options_.set_max_in_flight(
           cc->InputSidePackets().Tag(kMaxInFlightTag).Get<int>());
     }
+    if (cc->InputSidePackets().HasTag(kClockTag)) {
+      clock_ = cc->InputSidePackets()
+                   .Tag(kClockTag)
+                   .Get<std::shared_ptr<::mediapipe::Clock>>();
+    } else {
+      clock_ = std::shared_ptr<::mediapipe::Clock>(
+          ::mediapipe::MonotonicClock::CreateSynchronizedMonotonicClock());
+    }
+    if (options_.has_adaptive_in_flight()) {
+      const auto& adaptive = options_.adaptive_in_flight();
+      RET_CHECK_GE(adaptive.min_in_flight(), 1);
+      RET_CHECK_LE(adaptive.min_in_flight(), adaptive.max_in_flight());
+      RET_CHECK(adaptive.decrease_factor() > 0 &&
+                adaptive.decrease_factor() <= 1);
+    }
+    in_flight_window_ = options_.max_in_flight();
     input_queues_.resize(cc->Inputs().NumEntries(""));
     allowed_[Timestamp::Unset()] = true;
     RET_CHECK_OK(CopyInputHeadersToOutputs(cc->Inputs(), &(cc->Outputs())));
@@ -111,8 +169,13 @@ class FlowLimiterCalculator : public CalculatorBase {
     // Process the FINISHED input stream.
     Packet finished_packet = cc->Inputs().Tag(kFinishedTag).Value();
     if (finished_packet.Timestamp() == cc->InputTimestamp()) {
+      const bool window_full = frames_in_flight_.size() >= MaxInFlight();
+      const absl::Time now = clock_->TimeNow();
       while (!frames_in_flight_.empty() &&
-             frames_in_flight_.front() <= finished_packet.Timestamp()) {
+             frames_in_flight_.front().timestamp <=
+                 finished_packet.Timestamp()) {
+        const FrameInFlight& frame = frames_in_flight_.front();
+        AdaptInFlight(frame.timestamp, now - frame.release_time, window_full);
         frames_in_flight_.pop_front();
       }
     }
@@ -132,7 +195,9 @@ class FlowLimiterCalculator : public CalculatorBase {
     if (timeout > 0 && latest_ts == cc->InputTimestamp() &&
         latest_ts < Timestamp::Max()) {
       while (!frames_in_flight_.empty() &&
-             (latest_ts - frames_in_flight_.front()) > timeout) {
+             (latest_ts - frames_in_flight_.front().timestamp) > timeout) {
+        AdaptInFlight(frames_in_flight_.front().timestamp,
+                      absl::InfiniteDuration(), false);
         frames_in_flight_.pop_front();
       }
     }
@@ -144,7 +209,13 @@ class FlowLimiterCalculator : public CalculatorBase {
       input_queue.pop_front();
       cc->Outputs().Get("", 0).AddPacket(packet);
       SendAllow(true, packet.Timestamp(), cc);
-      frames_in_flight_.push_back(packet.Timestamp());
+      if (cc->Outputs().HasTag(kMaxInFlightTag)) {
+        cc->Outputs()
+            .Tag(kMaxInFlightTag)
+            .AddPacket(MakePacket<int>(MaxInFlight()).At(packet.Timestamp()));
+      }
+      frames_in_flight_.push_back({packet.Timestamp(), clock_->TimeNow()});
+      last_released_ = packet.Timestamp();
     }
 
     // Limit the number of queued frames.
@@ -168,6 +239,10 @@ class FlowLimiterCalculator : public CalculatorBase {
         SetNextTimestampBound(bound, &cc->Outputs().Tag(kAllowTag));
       }
     }
+    if (cc->Outputs().HasTag(kMaxInFlightTag)) {
+      SetNextTimestampBound(cc->Outputs().Get("", 0).NextTimestampBound(),
+                            &cc->Outputs().Tag(kMaxInFlightTag));
+    }
 
     ProcessAuxiliaryInputs(cc);
 
@@ -189,8 +264,47 @@ class FlowLimiterCalculator : public CalculatorBase {
  private:
   // Returns true if an additional frame can be released for processing.
   // The "ALLOW" output stream indicates this condition at each input frame.
-  bool ProcessingAllowed() {
-    return frames_in_flight_.size() < options_.max_in_flight();
+  bool ProcessingAllowed() { return frames_in_flight_.size() < MaxInFlight(); }
+
+  // Returns true if max_in_flight is adapted to frame latency.
+  bool IsAdaptive() const {
+    return options_.adaptive_in_flight().target_latency() > 0;
+  }
+
+  // Returns the maximum number of frames in flight.
+  int MaxInFlight() const {
+    if (!IsAdaptive()) {
+      return options_.max_in_flight();
+    }
+    const auto& adaptive = options_.adaptive_in_flight();
+    return std::clamp(static_cast<int>(in_flight_window_),
+                      adaptive.min_in_flight(), adaptive.max_in_flight());
+  }
+
+  // Adapts the in-flight window to the latency of a finished frame.  The
+  // window grows additively while frames finish within the target latency
+  // and the window is full, and shrinks multiplicatively when a frame is late.
+  void AdaptInFlight(Timestamp timestamp, absl::Duration latency,
+                     bool window_full) {
+    if (!IsAdaptive()) {
+      return;
+    }
+    const auto& adaptive = options_.adaptive_in_flight();
+    const double min_window = adaptive.min_in_flight();
+    const double max_window = adaptive.max_in_flight();
+    in_flight_window_ = std::clamp(in_flight_window_, min_window, max_window);
+    if (latency > absl::Microseconds(adaptive.target_latency())) {
+      // The frames released before the last decrease were released with the
+      // larger window, so they don't decrease it again.
+      if (last_decrease_ == Timestamp::Unset() || timestamp > last_decrease_) {
+        in_flight_window_ = std::max(
+            min_window, in_flight_window_ * adaptive.decrease_factor());
+        last_decrease_ = last_released_;
+      }
+    } else if (window_full) {
+      in_flight_window_ =
+          std::min(max_window, in_flight_window_ + 1.0 / in_flight_window_);
+    }
   }
 
   // Outputs a packet indicating whether a frame was sent or dropped.
@@ -257,10 +371,24 @@ class FlowLimiterCalculator : public CalculatorBase {
   }
 
  private:
+  // A frame released for processing.
+  struct FrameInFlight {
+    Timestamp timestamp;
+    absl::Time release_time;
+  };
+
   FlowLimiterCalculatorOptions options_;
   std::vector<std::deque<Packet>> input_queues_;
-  std::deque<Timestamp> frames_in_flight_;
+  std::deque<FrameInFlight> frames_in_flight_;
   std::map<Timestamp, bool> allowed_;
+  std::shared_ptr<::mediapipe::Clock> clock_;
+  // The adapted max_in_flight, with the fraction of a frame accumulated by
+  // additive increases.
+  double in_flight_window_ = 1;
+  // The latest released frame, and the latest released frame when the window
+  // was last decreased.
+  Timestamp last_released_ = Timestamp::Unset();
+  Timestamp last_decrease_ = Timestamp::Unset();
 };
 REGISTER_CALCULATOR(FlowLimiterCalculator);
 
@@ -560,6 +560,107 @@ TEST_F(FlowLimiterCalculatorTest, FinishedDelayed) {
   EXPECT_EQ(out_1_packets_, expected_output);
 }
 
+// Shows that adaptive_in_flight adapts max_in_flight to the frame latency.
+// Two pipelined SleepCalculators each take 22 ms per frame, so 2 frames in
+// flight generally finish within the 50 ms target latency, and more frames in
+// flight are late.  The "MAX_IN_FLIGHT" stream reports the adapted limit.
+TEST_F(FlowLimiterCalculatorTest, AdaptiveInFlight) {
+  // Configure the test.
+  SetUpInputData();
+  SetUpSimulationClock();
+  CalculatorGraphConfig graph_config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: 'in_1'
+        node {
+          calculator: 'FlowLimiterCalculator'
+          input_side_packet: 'OPTIONS:limiter_options'
+          input_side_packet: 'CLOCK:shared_clock'
+          input_stream: 'in_1'
+          input_stream: 'FINISHED:out_1'
+          input_stream_info: { tag_index: 'FINISHED' back_edge: true }
+          output_stream: 'in_1_sampled'
+          output_stream: 'MAX_IN_FLIGHT:max_in_flight'
+        }
+        node {
+          calculator: 'SleepCalculator'
+          input_side_packet: 'WARMUP_TIME:sleep_time'
+          input_side_packet: 'SLEEP_TIME:sleep_time'
+          input_side_packet: 'CLOCK:clock'
+          input_stream: 'PACKET:in_1_sampled'
+          output_stream: 'PACKET:stage_1'
+        }
+        node {
+          calculator: 'SleepCalculator'
+          input_side_packet: 'WARMUP_TIME:sleep_time'
+          input_side_packet: 'SLEEP_TIME:sleep_time'
+          input_side_packet: 'CLOCK:clock'
+          input_stream: 'PACKET:stage_1'
+          output_stream: 'PACKET:out_1'
+        }
+      )pb");
+  auto limiter_options = ParseTextProtoOrDie<FlowLimiterCalculatorOptions>(R"pb(
+    max_in_flight: 4
+    max_in_queue: 1
+    adaptive_in_flight {
+      target_latency: 50000  # 50 ms
+      min_in_flight: 1
+      max_in_flight: 4
+    }
+  )pb");
+  std::map<std::string, Packet> side_packets = {
+      {"limiter_options",
+       MakePacket<FlowLimiterCalculatorOptions>(limiter_options)},
+      {"sleep_time", MakePacket<int64_t>(22000)},
+      {"clock", MakePacket<mediapipe::Clock*>(clock_)},
+      {"shared_clock", MakePacket<std::shared_ptr<mediapipe::Clock>>(
+                           simulation_clock_)},
+  };
+
+  // Start the graph.
+  std::vector<Packet> max_in_flight_packets;
+  MP_ASSERT_OK(graph_.Initialize(graph_config));
+  MP_EXPECT_OK(graph_.ObserveOutputStream("out_1", [this](Packet p) {
+    out_1_packets_.push_back(p);
+    return absl::OkStatus();
+  }));
+  MP_EXPECT_OK(graph_.ObserveOutputStream(
+      "max_in_flight", [&max_in_flight_packets](Packet p) {
+        max_in_flight_packets.push_back(p);
+        return absl::OkStatus();
+      }));
+  simulation_clock_->ThreadStart();
+  MP_ASSERT_OK(graph_.StartRun(side_packets));
+
+  // Add 40 input packets, one every 10 ms.
+  // 1. packets 0 through 4 are released with the initial max_in_flight 4.
+  // 2. packet-1 finishes late, and max_in_flight drops to 2.
+  // 3. packets finish on time, and max_in_flight grows to 3 at packet-19.
+  // 4. packets finish late again, and max_in_flight drops to 1.
+  // 5. packets finish on time, and max_in_flight grows back to 2.
+  for (int i = 0; i < 40; ++i) {
+    MP_EXPECT_OK(graph_.AddPacketToInputStream("in_1", input_packets_[i]));
+    clock_->Sleep(absl::Microseconds(10000));
+  }
+
+  // Finish the graph.
+  MP_EXPECT_OK(graph_.CloseAllPacketSources());
+  clock_->Sleep(absl::Microseconds(100000));
+  MP_EXPECT_OK(graph_.WaitUntilDone());
+  simulation_clock_->ThreadFinish();
+
+  // Validate the output.
+  std::vector<int64_t> expected_timestamps;
+  for (int i : {0, 1, 2, 3, 4, 10, 13, 15, 17, 19, 20, 21, 24, 30, 35, 36,
+                39}) {
+    expected_timestamps.push_back(input_packets_[i].Timestamp().Value());
+  }
+  EXPECT_EQ(TimestampValues(out_1_packets_), expected_timestamps);
+  EXPECT_EQ(TimestampValues(max_in_flight_packets), expected_timestamps);
+  EXPECT_EQ(PacketValues<int>(max_in_flight_packets),
+            (std::vector<int>{4, 4, 4, 4, 4, 2, 2, 2, 2, 3, 3, 3, 3, 1, 2, 2,
+                              2}));
+}
+
 // Shows that packets on auxiliary input streams are relesed for the same
 // timestamps as the main input stream, whether the auxiliary packets arrive
 // early or late.
@@ -101,6 +101,8 @@ class ABSL_DEPRECATED("Use FlowLimiterCalculator instead.")
     }
 
     cc->SetInputStreamHandler("ImmediateInputStreamHandler");
+    // Stale FINISHED packets still release their place in flight.
+    cc->SetProcessStaleTimestamps(true);
 
     return absl::OkStatus();
   }
@@ -246,6 +246,18 @@ absl::Status ImageCroppingCalculator::RenderCpu(CalculatorContext* cc) {
   output_width *= scale;
   output_height *= scale;
 
+  // Cropping the whole unrotated image doesn't change it, so the input packet
+  // is passed through rather than copied.
+  if (rotation == 0.0f && scale == 1.0f &&
+      target_width == input_img.Width() &&
+      target_height == input_img.Height() &&
+      rect_center_x == input_img.Width() / 2.0f &&
+      rect_center_y == input_img.Height() / 2.0f) {
+    cc->Outputs().Tag(kImageTag).AddPacket(
+        cc->Inputs().Tag(kImageTag).Value());
+    return absl::OkStatus();
+  }
+
   float dst_corners[8] = {
       0, output_height, 0, 0, output_width, 0, output_width, output_height};
   const cv::Mat dst_points = cv::Mat(4, 2, CV_32F, dst_corners);
@@ -267,16 +279,16 @@ absl::Status ImageCroppingCalculator::RenderCpu(CalculatorContext* cc) {
   const cv::Mat shift_dst = cv::Mat(3, 3, CV_64F, shift_dst_vec);
   const cv::Mat adjusted_projection_matrix =
       shift_dst * projection_matrix * shift_src;
-  cv::Mat cropped_image;
-  cv::warpPerspective(input_mat, cropped_image, adjusted_projection_matrix,
-                      cv::Size(output_width, output_height),
-                      /* flags = */ 0,
-                      /* borderMode = */ border_mode);
-
+  // Warp directly into the output frame, which has the size and type that
+  // cv::warpPerspective expects, so that it isn't reallocated.
+  const cv::Size output_size(output_width, output_height);
   std::unique_ptr<ImageFrame> output_frame(new ImageFrame(
-      input_img.Format(), cropped_image.cols, cropped_image.rows));
+      input_img.Format(), output_size.width, output_size.height));
   cv::Mat output_mat = formats::MatView(output_frame.get());
-  cropped_image.copyTo(output_mat);
+  cv::warpPerspective(input_mat, output_mat, adjusted_projection_matrix,
+                      output_size,
+                      /* flags = */ 0,
+                      /* borderMode = */ border_mode);
   cc->Outputs().Tag(kImageTag).Add(output_frame.release(),
                                    cc->InputTimestamp());
   return absl::OkStatus();
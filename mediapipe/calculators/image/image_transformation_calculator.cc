@@ -296,6 +296,15 @@ absl::Status ImageTransformationCalculator::GetContract(
 #endif  // !MEDIAPIPE_DISABLE_GPU
   }
 
+  // CPU processing keeps no state between frames, unless transformations are
+  // given on input streams, where each packet applies to the next frames.
+  if (!use_gpu && !cc->Inputs().HasTag("OUTPUT_DIMENSIONS") &&
+      !cc->Inputs().HasTag("ROTATION_DEGREES") &&
+      !cc->Inputs().HasTag("FLIP_HORIZONTALLY") &&
+      !cc->Inputs().HasTag("FLIP_VERTICALLY")) {
+    cc->SetStateless(true);
+  }
+
   return absl::OkStatus();
 }
 
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 #include "mediapipe/calculators/image/recolor_calculator.pb.h"
@@ -232,8 +233,16 @@ absl::Status RecolorCalculator::RenderCpu(CalculatorContext* cc) {
         .AddPacket(cc->Inputs().Tag(kImageFrameTag).Value());
     return absl::OkStatus();
   }
-  // Get inputs and setup output.
-  const auto& input_img = cc->Inputs().Tag(kImageFrameTag).Get<ImageFrame>();
+  // Get inputs and setup output. Each pixel is blended in place, so the input
+  // frame is reused for the output if the calculator is its sole owner.
+  MP_ASSIGN_OR_RETURN(std::unique_ptr<ImageFrame> output_img,
+                      cc->Inputs()
+                          .Tag(kImageFrameTag)
+                          .Value()
+                          .ConsumeIfSoleOwner<ImageFrame>());
+  const auto& input_img =
+      output_img ? *output_img
+                 : cc->Inputs().Tag(kImageFrameTag).Get<ImageFrame>();
   const auto& mask_img = cc->Inputs().Tag(kMaskCpuTag).Get<ImageFrame>();
 
   cv::Mat input_mat = formats::MatView(&input_img);
@@ -253,8 +262,10 @@ absl::Status RecolorCalculator::RenderCpu(CalculatorContext* cc) {
   cv::resize(mask_mat, mask_full, input_mat.size());
   const cv::Vec3b recolor = {color_[0], color_[1], color_[2]};
 
-  auto output_img = absl::make_unique<ImageFrame>(
-      input_img.Format(), input_mat.cols, input_mat.rows);
+  if (output_img == nullptr) {
+    output_img = absl::make_unique<ImageFrame>(input_img.Format(),
+                                               input_mat.cols, input_mat.rows);
+  }
   cv::Mat output_mat = mediapipe::formats::MatView(output_img.get());
 
   const int invert_mask = invert_mask_ ? 1 : 0;
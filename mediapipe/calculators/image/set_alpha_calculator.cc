@@ -271,22 +271,35 @@ absl::Status SetAlphaCalculator::RenderCpu(CalculatorContext* cc) {
     ABSL_LOG(ERROR) << "Only 3 or 4 channel 8-bit input image supported";
   }
 
-  // Setup destination image
-  auto output_frame = absl::make_unique<ImageFrame>(
-      ImageFormat::SRGBA, input_mat.cols, input_mat.rows);
+  // Setup destination image. Only the alpha channel of an RGBA input frame
+  // changes, so it is updated in place if the calculator is its sole owner.
+  std::unique_ptr<ImageFrame> output_frame;
+  if (input_frame.Format() == ImageFormat::SRGBA) {
+    MP_ASSIGN_OR_RETURN(output_frame, cc->Inputs()
+                                          .Tag(kInputFrameTag)
+                                          .Value()
+                                          .ConsumeIfSoleOwner<ImageFrame>());
+  }
+  const bool update_in_place = output_frame != nullptr;
+  if (!update_in_place) {
+    output_frame = absl::make_unique<ImageFrame>(
+        ImageFormat::SRGBA, input_mat.cols, input_mat.rows);
+  }
   cv::Mat output_mat = formats::MatView(output_frame.get());
 
+  // Copy rgb part of the image in CPU
+  if (!update_in_place) {
+    if (input_mat.channels() == 3) {
+      cv::cvtColor(input_mat, output_mat, cv::COLOR_RGB2RGBA);
+    } else {
+      input_mat.copyTo(output_mat);
+    }
+  }
+
   const bool has_alpha_mask = cc->Inputs().HasTag(kInputAlphaTag) &&
                               !cc->Inputs().Tag(kInputAlphaTag).IsEmpty();
   const bool use_alpha_mask = alpha_value_ < 0 && has_alpha_mask;
 
-  // Copy rgb part of the image in CPU
-  if (input_mat.channels() == 3) {
-    cv::cvtColor(input_mat, output_mat, cv::COLOR_RGB2RGBA);
-  } else {
-    input_mat.copyTo(output_mat);
-  }
-
   // Setup alpha image in CPU.
   if (use_alpha_mask) {
     const auto& alpha_mask = cc->Inputs().Tag(kInputAlphaTag).Get<ImageFrame>();
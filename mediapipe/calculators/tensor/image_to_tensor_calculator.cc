@@ -13,19 +13,23 @@
 // limitations under the License.
 
 #include <array>
+#include <cstdint>
 #include <memory>
 #include <vector>
 
-#include "absl/log/absl_log.h"
+#include "absl/strings/str_cat.h"
 #include "mediapipe/calculators/tensor/image_to_tensor_calculator.pb.h"
 #include "mediapipe/calculators/tensor/image_to_tensor_converter.h"
+#include "mediapipe/calculators/tensor/image_to_tensor_converter_cpu.h"
 #include "mediapipe/calculators/tensor/image_to_tensor_utils.h"
 #include "mediapipe/framework/api2/node.h"
 #include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/frame_buffer.h"
 #include "mediapipe/framework/formats/image.h"
 #include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/formats/rect.pb.h"
 #include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/formats/yuv_image.h"
 #include "mediapipe/framework/memory_manager.h"
 #include "mediapipe/framework/memory_manager_service.h"
 #include "mediapipe/framework/port.h"
@@ -33,6 +37,7 @@
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/framework/port/statusor.h"
+#include "mediapipe/gpu/gpu_buffer_storage_yuv_image.h"
 #include "mediapipe/gpu/gpu_origin.pb.h"
 
 #if !MEDIAPIPE_DISABLE_OPENCV
@@ -69,14 +74,18 @@ namespace api2 {
 //           ImageFrame [ImageFormat::SRGB/SRGBA] (for backward compatibility
 //           with existing graphs that use IMAGE for ImageFrame input)
 //   IMAGE_GPU - GpuBuffer [GpuBufferFormat::kBGRA32]
+//   YUV_IMAGE - YUVImage [FOURCC_NV12 / NV21 / YV12 / I420]
 //     Image to extract from.
 //
 //   Note:
-//   - One and only one of IMAGE and IMAGE_GPU should be specified.
+//   - One and only one of IMAGE, IMAGE_GPU and YUV_IMAGE should be specified.
 //   - IMAGE input of type Image is processed on GPU if the data is already on
 //     GPU (i.e., Image::UsesGpu() returns true), or otherwise processed on CPU.
 //   - IMAGE input of type ImageFrame is always processed on CPU.
 //   - IMAGE_GPU input (of type GpuBuffer) is always processed on GPU.
+//   - YUV_IMAGE input is processed on CPU, and only the pixels sampled from
+//     the region to extract are converted to RGB, which avoids converting
+//     whole frames with YUVToImageCalculator when the region is small.
 //
 //   NORM_RECT - NormalizedRect @Optional
 //     Describes region of image to extract.
@@ -127,6 +136,7 @@ class ImageToTensorCalculator : public Node {
   static constexpr Input<
       OneOf<mediapipe::Image, mediapipe::ImageFrame>>::Optional kIn{"IMAGE"};
   static constexpr Input<GpuBuffer>::Optional kInGpu{"IMAGE_GPU"};
+  static constexpr Input<YUVImage>::Optional kInYuv{"YUV_IMAGE"};
   static constexpr Input<mediapipe::NormalizedRect>::Optional kInNormRect{
       "NORM_RECT"};
   static constexpr Output<std::vector<Tensor>> kOutTensors{"TENSORS"};
@@ -134,7 +144,7 @@ class ImageToTensorCalculator : public Node {
       "LETTERBOX_PADDING"};
   static constexpr Output<std::array<float, 16>>::Optional kOutMatrix{"MATRIX"};
 
-  MEDIAPIPE_NODE_CONTRACT(kIn, kInGpu, kInNormRect, kOutTensors,
+  MEDIAPIPE_NODE_CONTRACT(kIn, kInGpu, kInYuv, kInNormRect, kOutTensors,
                           kOutLetterboxPadding, kOutMatrix);
 
   static absl::Status UpdateContract(CalculatorContract* cc) {
@@ -142,8 +152,11 @@ class ImageToTensorCalculator : public Node {
         cc->Options<mediapipe::ImageToTensorCalculatorOptions>();
 
     RET_CHECK_OK(ValidateOptionOutputDims(options));
-    RET_CHECK(kIn(cc).IsConnected() ^ kInGpu(cc).IsConnected())
-        << "One and only one of IMAGE and IMAGE_GPU input is expected.";
+    RET_CHECK_EQ(kIn(cc).IsConnected() + kInGpu(cc).IsConnected() +
+                     kInYuv(cc).IsConnected(),
+                 1)
+        << "One and only one of IMAGE, IMAGE_GPU and YUV_IMAGE input is "
+           "expected.";
 
 #if MEDIAPIPE_DISABLE_GPU
     if (kInGpu(cc).IsConnected()) {
@@ -173,7 +186,8 @@ class ImageToTensorCalculator : public Node {
 
   absl::Status Process(CalculatorContext* cc) {
     if ((kIn(cc).IsConnected() && kIn(cc).IsEmpty()) ||
-        (kInGpu(cc).IsConnected() && kInGpu(cc).IsEmpty())) {
+        (kInGpu(cc).IsConnected() && kInGpu(cc).IsEmpty()) ||
+        (kInYuv(cc).IsConnected() && kInYuv(cc).IsEmpty())) {
       // Timestamp bound update happens automatically.
       return absl::OkStatus();
     }
@@ -197,6 +211,10 @@ class ImageToTensorCalculator : public Node {
       }
     }
 
+    if (kInYuv(cc).IsConnected()) {
+      return ProcessYuv(cc, norm_rect);
+    }
+
 #if MEDIAPIPE_DISABLE_GPU
     MP_ASSIGN_OR_RETURN(auto image, GetInputImage(kIn(cc)));
 #else
@@ -205,22 +223,12 @@ class ImageToTensorCalculator : public Node {
                                                  : GetInputImage(kIn(cc)));
 #endif  // MEDIAPIPE_DISABLE_GPU
 
-    RotatedRect roi = GetRoi(image->width(), image->height(), norm_rect);
     const int tensor_width = params_.output_width.value_or(image->width());
     const int tensor_height = params_.output_height.value_or(image->height());
-    MP_ASSIGN_OR_RETURN(auto padding,
-                        PadRoi(tensor_width, tensor_height,
-                               options_.keep_aspect_ratio(), &roi));
-    if (kOutLetterboxPadding(cc).IsConnected()) {
-      kOutLetterboxPadding(cc).Send(padding);
-    }
-    if (kOutMatrix(cc).IsConnected()) {
-      std::array<float, 16> matrix;
-      GetRotatedSubRectToRectTransformMatrix(
-          roi, image->width(), image->height(),
-          /*flip_horizontally=*/false, &matrix);
-      kOutMatrix(cc).Send(std::move(matrix));
-    }
+    MP_ASSIGN_OR_RETURN(RotatedRect roi,
+                        GetRoiAndSendTransforms(cc, image->width(),
+                                                image->height(), tensor_width,
+                                                tensor_height, norm_rect));
 
     // Lazy initialization of the GPU or CPU converter.
     MP_RETURN_IF_ERROR(InitConverterIfNecessary(cc, *image.get()));
@@ -244,6 +252,74 @@ class ImageToTensorCalculator : public Node {
   }
 
  private:
+  // Returns the ROI to extract from the image, and sends the letterbox padding
+  // and the transform matrix of the ROI.
+  absl::StatusOr<RotatedRect> GetRoiAndSendTransforms(
+      CalculatorContext* cc, int image_width, int image_height,
+      int tensor_width, int tensor_height,
+      const absl::optional<mediapipe::NormalizedRect>& norm_rect) {
+    RotatedRect roi = GetRoi(image_width, image_height, norm_rect);
+    MP_ASSIGN_OR_RETURN(auto padding,
+                        PadRoi(tensor_width, tensor_height,
+                               options_.keep_aspect_ratio(), &roi));
+    if (kOutLetterboxPadding(cc).IsConnected()) {
+      kOutLetterboxPadding(cc).Send(padding);
+    }
+    if (kOutMatrix(cc).IsConnected()) {
+      std::array<float, 16> matrix;
+      GetRotatedSubRectToRectTransformMatrix(roi, image_width, image_height,
+                                             /*flip_horizontally=*/false,
+                                             &matrix);
+      kOutMatrix(cc).Send(std::move(matrix));
+    }
+    return roi;
+  }
+
+  absl::Status ProcessYuv(
+      CalculatorContext* cc,
+      const absl::optional<mediapipe::NormalizedRect>& norm_rect) {
+    const YUVImage& yuv_image = *kInYuv(cc);
+    const libyuv::FourCC fourcc = yuv_image.fourcc();
+    if (fourcc != libyuv::FOURCC_NV12 && fourcc != libyuv::FOURCC_NV21 &&
+        fourcc != libyuv::FOURCC_YV12 && fourcc != libyuv::FOURCC_I420) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Unsupported YUVImage format: ", static_cast<uint32_t>(fourcc)));
+    }
+    // The FrameBuffer view shares the planes of the YUVImage, which the input
+    // packet keeps alive during the conversion.
+    const GpuBufferStorageYuvImage yuv_storage(
+        std::const_pointer_cast<YUVImage>(
+            SharedPtrWithPacket<YUVImage>(kInYuv(cc).packet())));
+    std::shared_ptr<const FrameBuffer> frame_buffer =
+        yuv_storage.GetReadView(mediapipe::internal::types<FrameBuffer>{});
+
+    const int tensor_width = params_.output_width.value_or(yuv_image.width());
+    const int tensor_height =
+        params_.output_height.value_or(yuv_image.height());
+    MP_ASSIGN_OR_RETURN(
+        RotatedRect roi,
+        GetRoiAndSendTransforms(cc, yuv_image.width(), yuv_image.height(),
+                                tensor_width, tensor_height, norm_rect));
+
+    if (!yuv_converter_) {
+      MP_ASSIGN_OR_RETURN(
+          yuv_converter_,
+          CreateCpuYuvConverter(
+              cc, GetBorderMode(options_.border_mode()),
+              GetOutputTensorType(/*uses_gpu=*/false, params_)));
+    }
+    Tensor tensor(GetOutputTensorType(/*uses_gpu=*/false, params_),
+                  {1, tensor_height, tensor_width, 3}, memory_manager_);
+    MP_RETURN_IF_ERROR(yuv_converter_->Convert(
+        *frame_buffer, roi, params_.range_min, params_.range_max,
+        /*tensor_buffer_offset=*/0, tensor));
+
+    auto result = std::make_unique<std::vector<Tensor>>();
+    result->push_back(std::move(tensor));
+    kOutTensors(cc).Send(std::move(result));
+    return absl::OkStatus();
+  }
+
   absl::Status InitConverterIfNecessary(CalculatorContext* cc,
                                         const Image& image) {
     // Lazy initialization of the GPU or CPU converter.
@@ -279,6 +355,13 @@ class ImageToTensorCalculator : public Node {
 #endif  // !MEDIAPIPE_DISABLE_GPU
       }
     } else {
+      if (!cpu_converter_ && options_.use_fused_cpu_converter()) {
+        MP_ASSIGN_OR_RETURN(
+            cpu_converter_,
+            CreateCpuConverter(
+                cc, GetBorderMode(options_.border_mode()),
+                GetOutputTensorType(/*uses_gpu=*/false, params_)));
+      }
       if (!cpu_converter_) {
 #if !MEDIAPIPE_DISABLE_OPENCV
         MP_ASSIGN_OR_RETURN(
@@ -296,9 +379,11 @@ class ImageToTensorCalculator : public Node {
                 cc, GetBorderMode(options_.border_mode()),
                 GetOutputTensorType(/*uses_gpu=*/false, params_)));
 #else
-        ABSL_LOG(FATAL) << "Cannot create image to tensor CPU converter since "
-                           "MEDIAPIPE_DISABLE_OPENCV is defined and "
-                           "MEDIAPIPE_ENABLE_HALIDE is not defined.";
+        MP_ASSIGN_OR_RETURN(
+            cpu_converter_,
+            CreateCpuConverter(
+                cc, GetBorderMode(options_.border_mode()),
+                GetOutputTensorType(/*uses_gpu=*/false, params_)));
 #endif  // !MEDIAPIPE_DISABLE_HALIDE
       }
     }
@@ -307,6 +392,7 @@ class ImageToTensorCalculator : public Node {
 
   std::unique_ptr<ImageToTensorConverter> gpu_converter_;
   std::unique_ptr<ImageToTensorConverter> cpu_converter_;
+  std::unique_ptr<YuvToTensorConverter> yuv_converter_;
   mediapipe::ImageToTensorCalculatorOptions options_;
   OutputTensorParams params_;
   MemoryManager* memory_manager_ = nullptr;
@@ -12,8 +12,10 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <string>
 #include <vector>
@@ -34,6 +36,7 @@
 #include "mediapipe/framework/formats/image_frame_opencv.h"
 #include "mediapipe/framework/formats/rect.pb.h"
 #include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/formats/yuv_image.h"
 #include "mediapipe/framework/port/gtest.h"
 #include "mediapipe/framework/port/opencv_core_inc.h"
 #include "mediapipe/framework/port/opencv_imgcodecs_inc.h"
@@ -543,6 +546,46 @@ TEST(ImageToTensorCalculatorTest, CanBeUsedWithoutGpuServiceSet) {
   MP_ASSERT_OK(graph.WaitUntilDone());
 }
 
+TEST(ImageToTensorCalculatorTest, ConvertsYuvImage) {
+  CalculatorRunner runner(R"pb(
+    calculator: "ImageToTensorCalculator"
+    input_stream: "YUV_IMAGE:image"
+    output_stream: "TENSORS:tensor"
+    options {
+      [mediapipe.ImageToTensorCalculatorOptions.ext] {
+        output_tensor_width: 16
+        output_tensor_height: 8
+        output_tensor_float_range { min: 0.0f max: 1.0f }
+      }
+    }
+  )pb");
+  // A mid-gray NV12 image.
+  constexpr int kWidth = 64;
+  constexpr int kHeight = 32;
+  auto y_plane = std::make_unique<uint8_t[]>(kWidth * kHeight);
+  auto uv_plane = std::make_unique<uint8_t[]>(kWidth * kHeight / 2);
+  std::fill_n(y_plane.get(), kWidth * kHeight, 128);
+  std::fill_n(uv_plane.get(), kWidth * kHeight / 2, 128);
+  runner.MutableInputs()->Tag("YUV_IMAGE").packets.push_back(
+      MakePacket<YUVImage>(libyuv::FOURCC_NV12, std::move(y_plane), kWidth,
+                           std::move(uv_plane), kWidth, nullptr, 0, kWidth,
+                           kHeight)
+          .At(Timestamp(0)));
+  MP_ASSERT_OK(runner.Run());
+
+  const auto& output_packets = runner.Outputs().Tag("TENSORS").packets;
+  ASSERT_EQ(output_packets.size(), 1);
+  const auto& tensors = output_packets[0].Get<std::vector<Tensor>>();
+  ASSERT_EQ(tensors.size(), 1);
+  EXPECT_EQ(tensors[0].shape().dims, std::vector<int>({1, 8, 16, 3}));
+  auto view = tensors[0].GetCpuReadView();
+  const float* values = view.buffer<float>();
+  for (int i = 0; i < tensors[0].shape().num_elements(); ++i) {
+    // BT.601 limited range gray: 1.164 * (128 - 16) / 255.
+    EXPECT_NEAR(values[i], 0.511f, 1e-3f);
+  }
+}
+
 #if !MEDIAPIPE_DISABLE_GPU && !MEDIAPIPE_METAL_ENABLED
 
 TEST(ImageToTensorCalculatorTest,
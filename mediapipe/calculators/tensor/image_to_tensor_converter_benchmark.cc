@@ -0,0 +1,102 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Benchmark for the CPU image-to-tensor converters.
+//
+// Converts a square ROI of a 640x480 SRGB image into a float tensor of the
+// same size, like the pose and face detection models do. The first argument
+// is the size of the ROI, and the second one whether the ROI is rotated.
+//
+// ImageToTensorCalculatorOptions.use_fused_cpu_converter selects the fused
+// converter in place of OpenCV. Compare it to BM_OpenCvConverter on the target
+// before enabling it.
+//
+// $ bazel run -c opt mediapipe/calculators/tensor:image_to_tensor_converter_benchmark
+#include <cstdint>
+#include <memory>
+
+#include "absl/log/absl_check.h"
+#include "absl/status/statusor.h"
+#include "benchmark/benchmark.h"
+#include "mediapipe/calculators/tensor/image_to_tensor_converter.h"
+#include "mediapipe/calculators/tensor/image_to_tensor_converter_cpu.h"
+#include "mediapipe/calculators/tensor/image_to_tensor_utils.h"
+#include "mediapipe/framework/formats/image.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/tensor.h"
+
+#if !MEDIAPIPE_DISABLE_OPENCV
+#include "mediapipe/calculators/tensor/image_to_tensor_converter_opencv.h"
+#endif  // !MEDIAPIPE_DISABLE_OPENCV
+
+namespace mediapipe {
+namespace {
+
+constexpr int kImageWidth = 640;
+constexpr int kImageHeight = 480;
+
+Image MakeImage() {
+  auto frame = std::make_shared<ImageFrame>(ImageFormat::SRGB, kImageWidth,
+                                            kImageHeight);
+  for (int y = 0; y < kImageHeight; ++y) {
+    uint8_t* row = frame->MutablePixelData() + y * frame->WidthStep();
+    for (int x = 0; x < kImageWidth * 3; ++x) {
+      row[x] = static_cast<uint8_t>(x * 7 + y * 13);
+    }
+  }
+  return Image(std::move(frame));
+}
+
+void RunConverter(
+    benchmark::State& state,
+    absl::StatusOr<std::unique_ptr<ImageToTensorConverter>> converter) {
+  ABSL_CHECK_OK(converter);
+  const int size = state.range(0);
+  const bool rotated = state.range(1);
+  const Image image = MakeImage();
+  const RotatedRect roi = {/*center_x=*/kImageWidth / 2.0f,
+                           /*center_y=*/kImageHeight / 2.0f,
+                           /*width=*/kImageHeight * 0.8f,
+                           /*height=*/kImageHeight * 0.8f,
+                           /*rotation=*/rotated ? 0.3f : 0.0f};
+  Tensor tensor(Tensor::ElementType::kFloat32, {1, size, size, 3});
+  for (auto _ : state) {
+    ABSL_CHECK_OK((*converter)->Convert(image, roi, /*range_min=*/-1.0f,
+                                        /*range_max=*/1.0f,
+                                        /*tensor_buffer_offset=*/0, tensor));
+  }
+  state.SetItemsProcessed(state.iterations() * size * size);
+}
+
+void BM_FusedCpuConverter(benchmark::State& state) {
+  RunConverter(state,
+               CreateCpuConverter(/*cc=*/nullptr, BorderMode::kReplicate,
+                                  Tensor::ElementType::kFloat32));
+}
+BENCHMARK(BM_FusedCpuConverter)->ArgsProduct({{192, 256}, {0, 1}});
+
+#if !MEDIAPIPE_DISABLE_OPENCV
+void BM_OpenCvConverter(benchmark::State& state) {
+  RunConverter(state,
+               CreateOpenCvConverter(/*cc=*/nullptr, BorderMode::kReplicate,
+                                     Tensor::ElementType::kFloat32));
+}
+BENCHMARK(BM_OpenCvConverter)->ArgsProduct({{192, 256}, {0, 1}});
+#endif  // !MEDIAPIPE_DISABLE_OPENCV
+
+}  // namespace
+}  // namespace mediapipe
+
+BENCHMARK_MAIN();
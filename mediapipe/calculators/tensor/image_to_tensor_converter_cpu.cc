@@ -0,0 +1,397 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tensor/image_to_tensor_converter_cpu.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "mediapipe/calculators/tensor/image_to_tensor_converter.h"
+#include "mediapipe/calculators/tensor/image_to_tensor_utils.h"
+#include "mediapipe/framework/calculator_context.h"
+#include "mediapipe/framework/formats/frame_buffer.h"
+#include "mediapipe/framework/formats/image.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+
+namespace mediapipe {
+
+namespace {
+
+// The two pixels along one axis that a bilinear sample interpolates, and
+// their weights. Pixels outside of the image are clamped to its border, and
+// weigh nothing with BorderMode::kZero.
+struct AxisTap {
+  int index0;
+  int index1;
+  float weight0;
+  float weight1;
+};
+
+AxisTap GetAxisTap(float position, int size, BorderMode border_mode) {
+  // Keeps far away positions in the int range.
+  position = std::clamp(position, -2.0f, static_cast<float>(size + 1));
+  const float floor = std::floor(position);
+  const int index0 = static_cast<int>(floor);
+  const int index1 = index0 + 1;
+  AxisTap tap = {std::clamp(index0, 0, size - 1),
+                 std::clamp(index1, 0, size - 1), 1.0f - (position - floor),
+                 position - floor};
+  if (border_mode == BorderMode::kZero) {
+    if (index0 < 0 || index0 >= size) tap.weight0 = 0.0f;
+    if (index1 < 0 || index1 >= size) tap.weight1 = 0.0f;
+  }
+  return tap;
+}
+
+// The affine mapping from the tensor pixel (x, y) to the image position
+// (x_x * x + x_y * y + x_0, y_x * x + y_y * y + y_0).
+struct AffineMapping {
+  float x_x, x_y, x_0;
+  float y_x, y_y, y_0;
+};
+
+// Maps the corners of the tensor to the corners of the ROI, the same way as
+// the OpenCV converter.
+AffineMapping GetAffineMapping(const RotatedRect& roi, int output_width,
+                               int output_height) {
+  std::array<float, 16> matrix;
+  GetRotatedSubRectToRectTransformMatrix(roi, /*rect_width=*/1,
+                                         /*rect_height=*/1,
+                                         /*flip_horizontally=*/false, &matrix);
+  return {matrix[0] / output_width, matrix[1] / output_height, matrix[3],
+          matrix[4] / output_width, matrix[5] / output_height, matrix[7]};
+}
+
+// Samples an interleaved 8-bit image with kChannels channels, and returns
+// its first kOutChannels channels.
+template <int kChannels, int kOutChannels_>
+class InterleavedSource {
+ public:
+  static constexpr int kOutChannels = kOutChannels_;
+  static_assert(kOutChannels <= kChannels);
+
+  explicit InterleavedSource(const ImageFrame& frame)
+      : pixels_(frame.PixelData()),
+        row_size_(frame.WidthStep()),
+        width_(frame.Width()),
+        height_(frame.Height()) {}
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+
+  void Sample(const AxisTap& x, const AxisTap& y,
+              float (&values)[kOutChannels]) const {
+    const uint8_t* row0 = pixels_ + y.index0 * row_size_;
+    const uint8_t* row1 = pixels_ + y.index1 * row_size_;
+    const uint8_t* p00 = row0 + x.index0 * kChannels;
+    const uint8_t* p01 = row0 + x.index1 * kChannels;
+    const uint8_t* p10 = row1 + x.index0 * kChannels;
+    const uint8_t* p11 = row1 + x.index1 * kChannels;
+    const float w00 = y.weight0 * x.weight0;
+    const float w01 = y.weight0 * x.weight1;
+    const float w10 = y.weight1 * x.weight0;
+    const float w11 = y.weight1 * x.weight1;
+    for (int c = 0; c < kOutChannels; ++c) {
+      values[c] = w00 * p00[c] + w01 * p01[c] + w10 * p10[c] + w11 * p11[c];
+    }
+  }
+
+ private:
+  const uint8_t* const pixels_;
+  const int row_size_;
+  const int width_;
+  const int height_;
+};
+
+// Samples a YUV 4:2:0 image, and returns RGB values.
+//
+// The chroma planes are upsampled with the nearest neighbor like libyuv does,
+// and the conversion to RGB is affine, so the samples match the ones of the
+// converted RGB image, except that they are clamped after the interpolation
+// instead of before.
+class YuvSource {
+ public:
+  static constexpr int kOutChannels = 3;
+
+  YuvSource(const FrameBuffer::YuvData& yuv_data,
+            const FrameBuffer::Dimension& dimension)
+      : yuv_data_(yuv_data),
+        width_(dimension.width),
+        height_(dimension.height) {}
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+
+  void Sample(const AxisTap& x, const AxisTap& y,
+              float (&values)[kOutChannels]) const {
+    const float w00 = y.weight0 * x.weight0;
+    const float w01 = y.weight0 * x.weight1;
+    const float w10 = y.weight1 * x.weight0;
+    const float w11 = y.weight1 * x.weight1;
+    const uint8_t* y_row0 =
+        yuv_data_.y_buffer + y.index0 * yuv_data_.y_row_stride;
+    const uint8_t* y_row1 =
+        yuv_data_.y_buffer + y.index1 * yuv_data_.y_row_stride;
+    const float luma = w00 * y_row0[x.index0] + w01 * y_row0[x.index1] +
+                       w10 * y_row1[x.index0] + w11 * y_row1[x.index1];
+    const int uv_row0 = (y.index0 / 2) * yuv_data_.uv_row_stride;
+    const int uv_row1 = (y.index1 / 2) * yuv_data_.uv_row_stride;
+    const int uv_column0 = (x.index0 / 2) * yuv_data_.uv_pixel_stride;
+    const int uv_column1 = (x.index1 / 2) * yuv_data_.uv_pixel_stride;
+    auto sample_chroma = [&](const uint8_t* plane) {
+      return w00 * plane[uv_row0 + uv_column0] +
+             w01 * plane[uv_row0 + uv_column1] +
+             w10 * plane[uv_row1 + uv_column0] +
+             w11 * plane[uv_row1 + uv_column1];
+    };
+    // The offsets of the conversion are scaled by the total weight, which is
+    // less than 1 when BorderMode::kZero drops pixels outside of the image.
+    const float weight = w00 + w01 + w10 + w11;
+    const float scaled_luma = 1.164f * (luma - 16.0f * weight);
+    const float u = sample_chroma(yuv_data_.u_buffer) - 128.0f * weight;
+    const float v = sample_chroma(yuv_data_.v_buffer) - 128.0f * weight;
+    values[0] = Saturate(scaled_luma + 1.596f * v);
+    values[1] = Saturate(scaled_luma - 0.391f * u - 0.813f * v);
+    values[2] = Saturate(scaled_luma + 2.018f * u);
+  }
+
+ private:
+  static float Saturate(float value) { return std::clamp(value, 0.0f, 255.0f); }
+
+  const FrameBuffer::YuvData yuv_data_;
+  const int width_;
+  const int height_;
+};
+
+// Converts a transformed value to the tensor type, rounding and saturating
+// integers like OpenCV's convertTo.
+template <typename T>
+T ToTensorValue(float value) {
+  if constexpr (std::is_floating_point_v<T>) {
+    return value;
+  } else {
+    constexpr float kMin = std::numeric_limits<T>::min();
+    constexpr float kMax = std::numeric_limits<T>::max();
+    return static_cast<T>(std::lrint(std::clamp(value, kMin, kMax)));
+  }
+}
+
+// Samples the ROI of "source" into "output", a row-major tensor image of
+// output_width x output_height pixels with Source::kOutChannels channels, and
+// applies "transform" to the sampled values.
+template <typename T, typename Source>
+void SampleRoi(const Source& source, const AffineMapping& mapping,
+               BorderMode border_mode, const ValueTransformation& transform,
+               int output_width, int output_height,
+               std::vector<AxisTap>& column_taps, T* output) {
+  constexpr int kOutChannels = Source::kOutChannels;
+  float values[kOutChannels];
+  auto store = [&](T* pixel) {
+    for (int c = 0; c < kOutChannels; ++c) {
+      pixel[c] = ToTensorValue<T>(transform.scale * values[c] +
+                                  transform.offset);
+    }
+  };
+  if (mapping.x_y == 0.0f && mapping.y_x == 0.0f) {
+    // Without rotation, the columns sample the same image columns in every
+    // row.
+    column_taps.resize(output_width);
+    for (int x = 0; x < output_width; ++x) {
+      column_taps[x] = GetAxisTap(mapping.x_x * x + mapping.x_0,
+                                  source.width(), border_mode);
+    }
+    for (int y = 0; y < output_height; ++y) {
+      const AxisTap row_tap = GetAxisTap(mapping.y_y * y + mapping.y_0,
+                                         source.height(), border_mode);
+      T* row = output + y * output_width * kOutChannels;
+      for (int x = 0; x < output_width; ++x) {
+        source.Sample(column_taps[x], row_tap, values);
+        store(row + x * kOutChannels);
+      }
+    }
+    return;
+  }
+  for (int y = 0; y < output_height; ++y) {
+    T* row = output + y * output_width * kOutChannels;
+    float image_x = mapping.x_y * y + mapping.x_0;
+    float image_y = mapping.y_y * y + mapping.y_0;
+    for (int x = 0; x < output_width; ++x) {
+      source.Sample(GetAxisTap(image_x, source.width(), border_mode),
+                    GetAxisTap(image_y, source.height(), border_mode),
+                    values);
+      store(row + x * kOutChannels);
+      image_x += mapping.x_x;
+      image_y += mapping.y_x;
+    }
+  }
+}
+
+class CpuProcessor : public ImageToTensorConverter,
+                     public YuvToTensorConverter {
+ public:
+  CpuProcessor(BorderMode border_mode, Tensor::ElementType tensor_type)
+      : border_mode_(border_mode), tensor_type_(tensor_type) {}
+
+  absl::Status Convert(const mediapipe::Image& input, const RotatedRect& roi,
+                       float range_min, float range_max,
+                       int tensor_buffer_offset,
+                       Tensor& output_tensor) override {
+    const bool is_supported_format =
+        input.image_format() == mediapipe::ImageFormat::SRGB ||
+        input.image_format() == mediapipe::ImageFormat::SRGBA ||
+        input.image_format() == mediapipe::ImageFormat::GRAY8;
+    if (!is_supported_format) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Unsupported format: ", static_cast<uint32_t>(input.image_format())));
+    }
+    std::shared_ptr<const ImageFrame> frame = input.GetImageFrameSharedPtr();
+    RET_CHECK(frame);
+    switch (frame->NumberOfChannels()) {
+      case 1:
+        return ConvertSource(InterleavedSource<1, 1>(*frame), roi, range_min,
+                             range_max, tensor_buffer_offset, output_tensor);
+      case 3:
+        return ConvertSource(InterleavedSource<3, 3>(*frame), roi, range_min,
+                             range_max, tensor_buffer_offset, output_tensor);
+      case 4:
+        return ConvertSource(InterleavedSource<4, 3>(*frame), roi, range_min,
+                             range_max, tensor_buffer_offset, output_tensor);
+      default:
+        return absl::InvalidArgumentError(absl::StrCat(
+            "Unsupported number of channels: ", frame->NumberOfChannels()));
+    }
+  }
+
+  absl::Status Convert(const FrameBuffer& input, const RotatedRect& roi,
+                       float range_min, float range_max,
+                       int tensor_buffer_offset,
+                       Tensor& output_tensor) override {
+    MP_ASSIGN_OR_RETURN(const FrameBuffer::YuvData yuv_data,
+                        FrameBuffer::GetYuvDataFromFrameBuffer(input));
+    return ConvertSource(YuvSource(yuv_data, input.dimension()), roi,
+                         range_min, range_max, tensor_buffer_offset,
+                         output_tensor);
+  }
+
+ private:
+  template <typename Source>
+  absl::Status ConvertSource(const Source& source, const RotatedRect& roi,
+                             float range_min, float range_max,
+                             int tensor_buffer_offset, Tensor& output_tensor) {
+    RET_CHECK_GE(tensor_buffer_offset, 0)
+        << "The input tensor_buffer_offset needs to be non-negative.";
+    const Tensor::Shape& output_shape = output_tensor.shape();
+    RET_CHECK_EQ(output_shape.dims.size(), 4)
+        << "Wrong output dims size: " << output_shape.dims.size();
+    RET_CHECK_GE(output_shape.dims[0], 1)
+        << "The batch dimension needs to be equal or larger than 1.";
+    RET_CHECK_EQ(output_shape.dims[3], Source::kOutChannels)
+        << "Wrong output channel: " << output_shape.dims[3];
+
+    constexpr float kInputImageRangeMin = 0.0f;
+    constexpr float kInputImageRangeMax = 255.0f;
+    MP_ASSIGN_OR_RETURN(
+        const ValueTransformation transform,
+        GetValueRangeTransformation(kInputImageRangeMin, kInputImageRangeMax,
+                                    range_min, range_max));
+    const AffineMapping mapping =
+        GetAffineMapping(roi, output_shape.dims[2], output_shape.dims[1]);
+
+    auto buffer_view = output_tensor.GetCpuWriteView();
+    switch (tensor_type_) {
+      case Tensor::ElementType::kFloat32:
+        return SampleRoiToBuffer(source, mapping, transform, output_shape,
+                                 tensor_buffer_offset,
+                                 buffer_view.buffer<float>());
+      case Tensor::ElementType::kUInt8:
+        return SampleRoiToBuffer(source, mapping, transform, output_shape,
+                                 tensor_buffer_offset,
+                                 buffer_view.buffer<uint8_t>());
+      case Tensor::ElementType::kInt8:
+        return SampleRoiToBuffer(source, mapping, transform, output_shape,
+                                 tensor_buffer_offset,
+                                 buffer_view.buffer<int8_t>());
+      default:
+        return absl::InvalidArgumentError(
+            absl::StrCat("Unsupported tensor type: ", tensor_type_));
+    }
+  }
+
+  template <typename Source, typename T>
+  absl::Status SampleRoiToBuffer(const Source& source,
+                                 const AffineMapping& mapping,
+                                 const ValueTransformation& transform,
+                                 const Tensor::Shape& output_shape,
+                                 int tensor_buffer_offset, T* buffer) {
+    const int output_height = output_shape.dims[1];
+    const int output_width = output_shape.dims[2];
+    const int output_channels = output_shape.dims[3];
+    RET_CHECK_GE(output_shape.num_elements(),
+                 tensor_buffer_offset / sizeof(T) +
+                     output_height * output_width * output_channels)
+        << "The buffer offset + the input image size is larger than the "
+           "allocated tensor buffer.";
+    SampleRoi(source, mapping, border_mode_, transform, output_width,
+              output_height, column_taps_,
+              buffer + tensor_buffer_offset / sizeof(T));
+    return absl::OkStatus();
+  }
+
+  const BorderMode border_mode_;
+  const Tensor::ElementType tensor_type_;
+  // Reused across conversions to avoid allocating them for every frame.
+  std::vector<AxisTap> column_taps_;
+};
+
+absl::Status ValidateTensorType(Tensor::ElementType tensor_type) {
+  if (tensor_type != Tensor::ElementType::kInt8 &&
+      tensor_type != Tensor::ElementType::kFloat32 &&
+      tensor_type != Tensor::ElementType::kUInt8) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Tensor type is currently not supported by CpuProcessor, type: ",
+        tensor_type));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<ImageToTensorConverter>> CreateCpuConverter(
+    CalculatorContext* cc, BorderMode border_mode,
+    Tensor::ElementType tensor_type) {
+  MP_RETURN_IF_ERROR(ValidateTensorType(tensor_type));
+  return std::make_unique<CpuProcessor>(border_mode, tensor_type);
+}
+
+absl::StatusOr<std::unique_ptr<YuvToTensorConverter>> CreateCpuYuvConverter(
+    CalculatorContext* cc, BorderMode border_mode,
+    Tensor::ElementType tensor_type) {
+  MP_RETURN_IF_ERROR(ValidateTensorType(tensor_type));
+  return std::make_unique<CpuProcessor>(border_mode, tensor_type);
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,64 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_CALCULATORS_TENSOR_IMAGE_TO_TENSOR_CONVERTER_CPU_H_
+#define MEDIAPIPE_CALCULATORS_TENSOR_IMAGE_TO_TENSOR_CONVERTER_CPU_H_
+
+#include <memory>
+
+#include "absl/status/statusor.h"
+#include "mediapipe/calculators/tensor/image_to_tensor_converter.h"
+#include "mediapipe/calculators/tensor/image_to_tensor_utils.h"
+#include "mediapipe/framework/calculator_context.h"
+#include "mediapipe/framework/formats/frame_buffer.h"
+#include "mediapipe/framework/formats/tensor.h"
+
+namespace mediapipe {
+
+// Creates a CPU image-to-tensor converter that doesn't depend on OpenCV.
+//
+// The converter crops, rotates, resizes (with bilinear interpolation) and
+// normalizes the ROI in a single pass, sampling the input ImageFrame directly
+// into the output tensor without intermediate images. It supports SRGB, SRGBA
+// and GRAY8 inputs, and produces the same results as the OpenCV converter up
+// to interpolation rounding.
+absl::StatusOr<std::unique_ptr<ImageToTensorConverter>> CreateCpuConverter(
+    CalculatorContext* cc, BorderMode border_mode,
+    Tensor::ElementType tensor_type);
+
+// Converts YUV frames to RGB tensors.
+class YuvToTensorConverter {
+ public:
+  virtual ~YuvToTensorConverter() = default;
+
+  // Converts the ROI of a YUV 4:2:0 frame (kNV12, kNV21, kYV12 or kYV21) to
+  // an RGB tensor. The arguments are the same as the ones of
+  // ImageToTensorConverter::Convert.
+  virtual absl::Status Convert(const FrameBuffer& input,
+                               const RotatedRect& roi, float range_min,
+                               float range_max, int tensor_buffer_offset,
+                               Tensor& output_tensor) = 0;
+};
+
+// Creates a CPU converter for YUV frames that converts only the pixels that
+// it samples from the ROI to RGB, instead of the whole frame. It uses the
+// BT.601 limited range coefficients like YUVToImageCalculator, and otherwise
+// works like the converter of CreateCpuConverter.
+absl::StatusOr<std::unique_ptr<YuvToTensorConverter>> CreateCpuYuvConverter(
+    CalculatorContext* cc, BorderMode border_mode,
+    Tensor::ElementType tensor_type);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_CALCULATORS_TENSOR_IMAGE_TO_TENSOR_CONVERTER_CPU_H_
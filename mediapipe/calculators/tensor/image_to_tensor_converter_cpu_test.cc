@@ -0,0 +1,318 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tensor/image_to_tensor_converter_cpu.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "mediapipe/calculators/tensor/image_to_tensor_converter.h"
+#include "mediapipe/calculators/tensor/image_to_tensor_utils.h"
+#include "mediapipe/framework/formats/frame_buffer.h"
+#include "mediapipe/framework/formats/image.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+using ::testing::FloatEq;
+using ::testing::FloatNear;
+using ::testing::Pointwise;
+
+// Returns an image whose pixel (x, y) has the value 10 * y + x + c in its
+// channel c.
+Image MakeImage(ImageFormat::Format format, int width, int height) {
+  auto frame = std::make_shared<ImageFrame>(format, width, height);
+  const int channels = frame->NumberOfChannels();
+  for (int y = 0; y < height; ++y) {
+    uint8_t* row = frame->MutablePixelData() + y * frame->WidthStep();
+    for (int x = 0; x < width; ++x) {
+      for (int c = 0; c < channels; ++c) {
+        row[x * channels + c] = 10 * y + x + c;
+      }
+    }
+  }
+  return Image(std::move(frame));
+}
+
+template <typename T>
+std::vector<T> Convert(const Image& image, const RotatedRect& roi,
+                       int output_width, int output_height, float range_min,
+                       float range_max,
+                       BorderMode border_mode = BorderMode::kReplicate) {
+  constexpr Tensor::ElementType kElementType =
+      std::is_same_v<T, float>     ? Tensor::ElementType::kFloat32
+      : std::is_same_v<T, uint8_t> ? Tensor::ElementType::kUInt8
+                                   : Tensor::ElementType::kInt8;
+  auto converter =
+      CreateCpuConverter(/*cc=*/nullptr, border_mode, kElementType).value();
+  const int channels = image.channels() == 1 ? 1 : 3;
+  Tensor tensor(kElementType, {1, output_height, output_width, channels});
+  MP_EXPECT_OK(converter->Convert(image, roi, range_min, range_max,
+                                  /*tensor_buffer_offset=*/0, tensor));
+  auto view = tensor.GetCpuReadView();
+  const T* buffer = view.buffer<T>();
+  return std::vector<T>(buffer, buffer + tensor.shape().num_elements());
+}
+
+TEST(ImageToTensorConverterCpuTest, ConvertsWholeImage) {
+  const Image image = MakeImage(ImageFormat::SRGB, 3, 2);
+  const RotatedRect roi = {/*center_x=*/1.5f, /*center_y=*/1.0f,
+                           /*width=*/3.0f, /*height=*/2.0f, /*rotation=*/0};
+  EXPECT_THAT(Convert<float>(image, roi, 3, 2, 0.0f, 255.0f),
+              Pointwise(FloatEq(), std::vector<float>({
+                                       0,  1,  2,  1,  2,  3,  2,  3,  4,  //
+                                       10, 11, 12, 11, 12, 13, 12, 13, 14,
+                                   })));
+}
+
+TEST(ImageToTensorConverterCpuTest, DropsAlpha) {
+  const Image image = MakeImage(ImageFormat::SRGBA, 2, 1);
+  const RotatedRect roi = {/*center_x=*/1.0f, /*center_y=*/0.5f,
+                           /*width=*/2.0f, /*height=*/1.0f, /*rotation=*/0};
+  EXPECT_THAT(Convert<uint8_t>(image, roi, 2, 1, 0.0f, 255.0f),
+              ElementsAre(0, 1, 2, 1, 2, 3));
+}
+
+TEST(ImageToTensorConverterCpuTest, ResizesAndInterpolates) {
+  const Image image = MakeImage(ImageFormat::GRAY8, 4, 4);
+  // Downscaling samples every other pixel.
+  const RotatedRect roi = {/*center_x=*/2.0f, /*center_y=*/2.0f,
+                           /*width=*/4.0f, /*height=*/4.0f, /*rotation=*/0};
+  EXPECT_THAT(Convert<float>(image, roi, 2, 2, 0.0f, 255.0f),
+              Pointwise(FloatEq(), std::vector<float>({0, 2, 20, 22})));
+  // A half pixel shift interpolates between neighbors.
+  const RotatedRect shifted_roi = {/*center_x=*/1.5f, /*center_y=*/1.0f,
+                                   /*width=*/2.0f, /*height=*/2.0f,
+                                   /*rotation=*/0};
+  EXPECT_THAT(Convert<float>(image, shifted_roi, 2, 2, 0.0f, 255.0f),
+              Pointwise(FloatEq(), std::vector<float>({0.5f, 1.5f, 10.5f,
+                                                       11.5f})));
+}
+
+TEST(ImageToTensorConverterCpuTest, Rotates) {
+  const Image image = MakeImage(ImageFormat::GRAY8, 4, 4);
+  const RotatedRect roi = {/*center_x=*/2.0f, /*center_y=*/2.0f,
+                           /*width=*/4.0f, /*height=*/4.0f,
+                           /*rotation=*/static_cast<float>(M_PI / 2)};
+  const std::vector<float> output =
+      Convert<float>(image, roi, 4, 4, 0.0f, 255.0f, BorderMode::kZero);
+  // The tensor pixel (x, y) samples the image pixel (4 - y, x), which is
+  // outside of the image in the first row of the tensor.
+  for (int y = 0; y < 4; ++y) {
+    for (int x = 0; x < 4; ++x) {
+      const float expected = y == 0 ? 0.0f : 10 * x + (4 - y);
+      EXPECT_NEAR(output[y * 4 + x], expected, 1e-3) << x << ", " << y;
+    }
+  }
+}
+
+TEST(ImageToTensorConverterCpuTest, AppliesBorderMode) {
+  const Image image = MakeImage(ImageFormat::GRAY8, 2, 1);
+  // The ROI spans one pixel on each side of the image.
+  const RotatedRect roi = {/*center_x=*/1.0f, /*center_y=*/0.5f,
+                           /*width=*/4.0f, /*height=*/1.0f, /*rotation=*/0};
+  EXPECT_THAT(Convert<float>(image, roi, 4, 1, 0.0f, 255.0f,
+                             BorderMode::kReplicate),
+              Pointwise(FloatEq(), std::vector<float>({0, 0, 1, 1})));
+  EXPECT_THAT(
+      Convert<float>(image, roi, 4, 1, 0.0f, 255.0f, BorderMode::kZero),
+      Pointwise(FloatEq(), std::vector<float>({0, 0, 1, 0})));
+}
+
+TEST(ImageToTensorConverterCpuTest, AppliesValueRange) {
+  auto frame = std::make_shared<ImageFrame>(ImageFormat::GRAY8, 3, 1);
+  frame->MutablePixelData()[0] = 0;
+  frame->MutablePixelData()[1] = 128;
+  frame->MutablePixelData()[2] = 255;
+  const Image image(std::move(frame));
+  const RotatedRect roi = {/*center_x=*/1.5f, /*center_y=*/0.5f,
+                           /*width=*/3.0f, /*height=*/1.0f, /*rotation=*/0};
+  EXPECT_THAT(Convert<float>(image, roi, 3, 1, -1.0f, 1.0f),
+              Pointwise(FloatNear(1e-6), std::vector<float>(
+                                             {-1.0f, 1.0f / 255.0f, 1.0f})));
+  EXPECT_THAT(Convert<int8_t>(image, roi, 3, 1, -128.0f, 127.0f),
+              ElementsAre(-128, 0, 127));
+  EXPECT_THAT(Convert<uint8_t>(image, roi, 3, 1, 0.0f, 510.0f),
+              ElementsAreArray({0, 255, 255}));
+}
+
+TEST(ImageToTensorConverterCpuTest, RejectsUnsupportedTensorType) {
+  EXPECT_FALSE(CreateCpuConverter(/*cc=*/nullptr, BorderMode::kZero,
+                                  Tensor::ElementType::kInt32)
+                   .ok());
+}
+
+// A 4x4 YUV 4:2:0 frame with the same content in all the supported layouts.
+class YuvFrame {
+ public:
+  YuvFrame() {
+    for (int y = 0; y < kSize; ++y) {
+      for (int x = 0; x < kSize; ++x) {
+        luma_[y * kSize + x] = 16 + 50 * y + 10 * x;
+      }
+    }
+    for (int i = 0; i < kChromaSize * kChromaSize; ++i) {
+      u_[i] = 100 + 20 * i;
+      v_[i] = 160 - 30 * i;
+      uv_[2 * i] = u_[i];
+      uv_[2 * i + 1] = v_[i];
+      vu_[2 * i] = v_[i];
+      vu_[2 * i + 1] = u_[i];
+    }
+  }
+
+  FrameBuffer Nv12() { return SemiPlanar(uv_, FrameBuffer::Format::kNV12); }
+  FrameBuffer Nv21() { return SemiPlanar(vu_, FrameBuffer::Format::kNV21); }
+  FrameBuffer Yv21() {
+    return FrameBuffer({LumaPlane(), ChromaPlane(u_, 1), ChromaPlane(v_, 1)},
+                       {kSize, kSize}, FrameBuffer::Format::kYV21);
+  }
+
+  // Converts the pixel (x, y) to RGB like libyuv.
+  std::vector<float> ToRgb(int x, int y) const {
+    const int chroma_index = (y / 2) * kChromaSize + x / 2;
+    const float luma = 1.164f * (luma_[y * kSize + x] - 16);
+    const float u = u_[chroma_index] - 128.0f;
+    const float v = v_[chroma_index] - 128.0f;
+    return {std::clamp(luma + 1.596f * v, 0.0f, 255.0f),
+            std::clamp(luma - 0.391f * u - 0.813f * v, 0.0f, 255.0f),
+            std::clamp(luma + 2.018f * u, 0.0f, 255.0f)};
+  }
+
+  static constexpr int kSize = 4;
+
+ private:
+  static constexpr int kChromaSize = kSize / 2;
+
+  FrameBuffer::Plane LumaPlane() {
+    return {luma_, {/*row_stride_bytes=*/kSize, /*pixel_stride_bytes=*/1}};
+  }
+  FrameBuffer::Plane ChromaPlane(uint8_t* buffer, int pixel_stride) {
+    return {buffer,
+            {/*row_stride_bytes=*/kChromaSize * pixel_stride, pixel_stride}};
+  }
+  FrameBuffer SemiPlanar(uint8_t* chroma, FrameBuffer::Format format) {
+    return FrameBuffer({LumaPlane(), ChromaPlane(chroma, 2)}, {kSize, kSize},
+                       format);
+  }
+
+  uint8_t luma_[kSize * kSize];
+  uint8_t u_[kChromaSize * kChromaSize];
+  uint8_t v_[kChromaSize * kChromaSize];
+  uint8_t uv_[2 * kChromaSize * kChromaSize];
+  uint8_t vu_[2 * kChromaSize * kChromaSize];
+};
+
+std::vector<float> ConvertYuv(const FrameBuffer& frame_buffer,
+                              const RotatedRect& roi, int output_width,
+                              int output_height,
+                              BorderMode border_mode = BorderMode::kReplicate) {
+  auto converter = CreateCpuYuvConverter(/*cc=*/nullptr, border_mode,
+                                         Tensor::ElementType::kFloat32)
+                       .value();
+  Tensor tensor(Tensor::ElementType::kFloat32,
+                {1, output_height, output_width, 3});
+  MP_EXPECT_OK(converter->Convert(frame_buffer, roi, /*range_min=*/0.0f,
+                                  /*range_max=*/255.0f,
+                                  /*tensor_buffer_offset=*/0, tensor));
+  auto view = tensor.GetCpuReadView();
+  const float* buffer = view.buffer<float>();
+  return std::vector<float>(buffer, buffer + tensor.shape().num_elements());
+}
+
+TEST(ImageToTensorConverterCpuTest, ConvertsYuvLikeRgb) {
+  YuvFrame frame;
+  const RotatedRect roi = {/*center_x=*/2.0f, /*center_y=*/2.0f,
+                           /*width=*/4.0f, /*height=*/4.0f, /*rotation=*/0};
+  std::vector<float> expected;
+  for (int y = 0; y < YuvFrame::kSize; ++y) {
+    for (int x = 0; x < YuvFrame::kSize; ++x) {
+      const std::vector<float> rgb = frame.ToRgb(x, y);
+      expected.insert(expected.end(), rgb.begin(), rgb.end());
+    }
+  }
+  EXPECT_THAT(ConvertYuv(frame.Nv12(), roi, 4, 4),
+              Pointwise(FloatNear(1e-3), expected));
+  EXPECT_THAT(ConvertYuv(frame.Nv21(), roi, 4, 4),
+              Pointwise(FloatNear(1e-3), expected));
+  EXPECT_THAT(ConvertYuv(frame.Yv21(), roi, 4, 4),
+              Pointwise(FloatNear(1e-3), expected));
+}
+
+TEST(ImageToTensorConverterCpuTest, InterpolatesYuv) {
+  YuvFrame frame;
+  // Samples between the pixels (1, 1) and (2, 1), which have different
+  // chroma values.
+  const RotatedRect roi = {/*center_x=*/2.0f, /*center_y=*/1.5f,
+                           /*width=*/1.0f, /*height=*/1.0f, /*rotation=*/0};
+  const std::vector<float> left = frame.ToRgb(1, 1);
+  const std::vector<float> right = frame.ToRgb(2, 1);
+  EXPECT_THAT(ConvertYuv(frame.Nv12(), roi, 1, 1),
+              Pointwise(FloatNear(1e-3), std::vector<float>({
+                                             (left[0] + right[0]) / 2,
+                                             (left[1] + right[1]) / 2,
+                                             (left[2] + right[2]) / 2,
+                                         })));
+}
+
+TEST(ImageToTensorConverterCpuTest, AppliesBorderModeToYuv) {
+  YuvFrame frame;
+  // The ROI spans the first column of the image, and one column outside of
+  // it.
+  const RotatedRect roi = {/*center_x=*/0.0f, /*center_y=*/0.5f,
+                           /*width=*/2.0f, /*height=*/1.0f, /*rotation=*/0};
+  const std::vector<float> first = frame.ToRgb(0, 0);
+  EXPECT_THAT(
+      ConvertYuv(frame.Nv12(), roi, 2, 1, BorderMode::kZero),
+      Pointwise(FloatNear(1e-3), std::vector<float>({0, 0, 0, first[0],
+                                                     first[1], first[2]})));
+  EXPECT_THAT(ConvertYuv(frame.Nv12(), roi, 2, 1, BorderMode::kReplicate),
+              Pointwise(FloatNear(1e-3),
+                        std::vector<float>({first[0], first[1], first[2],
+                                            first[0], first[1], first[2]})));
+}
+
+TEST(ImageToTensorConverterCpuTest, RejectsNonYuvFrameBuffer) {
+  uint8_t pixels[3] = {};
+  const FrameBuffer frame_buffer({{pixels, {/*row_stride_bytes=*/3,
+                                            /*pixel_stride_bytes=*/3}}},
+                                 {1, 1}, FrameBuffer::Format::kRGB);
+  auto converter = CreateCpuYuvConverter(/*cc=*/nullptr, BorderMode::kZero,
+                                         Tensor::ElementType::kFloat32)
+                       .value();
+  Tensor tensor(Tensor::ElementType::kFloat32, {1, 1, 1, 3});
+  EXPECT_FALSE(converter
+                   ->Convert(frame_buffer,
+                             {/*center_x=*/0.5f, /*center_y=*/0.5f,
+                              /*width=*/1.0f, /*height=*/1.0f,
+                              /*rotation=*/0},
+                             /*range_min=*/0.0f, /*range_max=*/1.0f,
+                             /*tensor_buffer_offset=*/0, tensor)
+                   .ok());
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -15,6 +15,7 @@
 #include "mediapipe/calculators/tensor/inference_calculator.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <utility>
@@ -22,6 +23,7 @@
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "mediapipe/calculators/tensor/inference_calculator.pb.h"
 #include "mediapipe/framework/api2/node.h"
@@ -89,6 +91,12 @@ absl::Status InferenceCalculator::TensorContractCheck(CalculatorContract* cc) {
       << "Exactly one of TENSORS and TENSOR must be used for input.";
   RET_CHECK(kOutTensors(cc).IsConnected() ^ (kOutTensor(cc).Count() > 0))
       << "Exactly one of TENSORS and TENSOR must be used for output.";
+  if (cc->Options<mediapipe::InferenceCalculatorOptions>()
+          .batch_across_timestamps()) {
+    // The outputs of a batch are sent when its last input set is processed,
+    // at the timestamps of the earlier input sets.
+    cc->SetTimestampOffset(TimestampDiff::Unset());
+  }
   return absl::OkStatus();
 }
 
@@ -116,5 +124,26 @@ InferenceCalculator::GetOpResolverAsPacket(CalculatorContext* cc) {
           tflite::ops::builtin::BuiltinOpResolverWithoutDefaultDelegates>());
 }
 
+std::string InferenceCalculator::GetModelKey(
+    CalculatorContext* cc, const Packet<TfLiteModelPtr>& model,
+    const Packet<tflite::OpResolver>& op_resolver) {
+  const auto& options = cc->Options<mediapipe::InferenceCalculatorOptions>();
+  // Models loaded from the same path are interchangeable. Otherwise, the key
+  // refers to the model object, which the pooled interpreters keep alive.
+  std::string key =
+      options.model_path().empty()
+          ? absl::StrCat("model@",
+                         absl::Hex(reinterpret_cast<uintptr_t>(&*model.Get())))
+          : absl::StrCat("path:", options.model_path());
+  if (kSideInOpResolver(cc).IsConnected() ||
+      kSideInCustomOpResolver(cc).IsConnected()) {
+    absl::StrAppend(
+        &key, ";op_resolver@",
+        absl::Hex(reinterpret_cast<uintptr_t>(&op_resolver.Get())));
+  }
+  absl::StrAppend(&key, ";cpu_num_thread:", options.cpu_num_thread());
+  return key;
+}
+
 }  // namespace api2
 }  // namespace mediapipe
@@ -27,6 +27,7 @@
 #include "absl/status/statusor.h"
 #include "absl/time/time.h"
 #include "mediapipe/calculators/tensor/inference_calculator.pb.h"
+#include "mediapipe/calculators/tensor/inference_calculator_batching.h"
 #include "mediapipe/calculators/tensor/inference_calculator_io_map.h"
 #include "mediapipe/calculators/tensor/inference_runner.h"
 #include "mediapipe/calculators/tensor/tensor_span.h"
@@ -160,6 +161,13 @@ class InferenceCalculator : public NodeIntf {
 
   static absl::StatusOr<Packet<tflite::OpResolver>> GetOpResolverAsPacket(
       CalculatorContext* cc);
+
+  // Returns a key identifying the interpreters built from "model" and
+  // "op_resolver" with the options of the calculator, under which calculators
+  // share interpreters through SharedInferenceResources.
+  static std::string GetModelKey(CalculatorContext* cc,
+                                 const Packet<TfLiteModelPtr>& model,
+                                 const Packet<tflite::OpResolver>& op_resolver);
 };
 
 struct InferenceCalculatorSelector : public InferenceCalculator {
@@ -200,6 +208,13 @@ class InferenceCalculatorNodeImpl : public NodeImpl<Intf, Impl> {
           mediapipe::InferenceCalculatorOptions::InputOutputConfig>(
           GetInputOutputConfig(cc));
       MP_RETURN_IF_ERROR(VerifyInputOutputConfig(*io_config_));
+      batch_across_timestamps_ =
+          cc->Options<mediapipe::InferenceCalculatorOptions>()
+              .batch_across_timestamps();
+    }
+
+    if (batch_across_timestamps_) {
+      return ProcessBatched(cc);
     }
 
     if (InferenceCalculator::kInTensors(cc).IsConnected()) {
@@ -234,7 +249,105 @@ class InferenceCalculatorNodeImpl : public NodeImpl<Intf, Impl> {
   virtual absl::StatusOr<std::vector<Tensor>> Process(
       CalculatorContext* cc, const TensorSpan& tensor_span) = 0;
 
+ protected:
+  // Records the input side packets of the current run, from which the
+  // inference runner is built. Returns whether they differ from the ones
+  // recorded in the previous run.
+  bool RecordSidePackets(CalculatorContext* cc) {
+    std::vector<mediapipe::Packet> side_packets(cc->InputSidePackets().begin(),
+                                                cc->InputSidePackets().end());
+    const bool changed = side_packets != side_packets_;
+    side_packets_ = std::move(side_packets);
+    return changed;
+  }
+
+  // Clears the state of the previous run, for Reset().
+  void ClearRunState() {
+    io_config_ = nullptr;
+    batch_.clear();
+  }
+
  private:
+  // The input tensors of one timestamp of a batch, which are kept alive by
+  // their packets until the batch is processed.
+  struct BatchEntry {
+    Timestamp timestamp;
+    std::vector<api2::PacketBase> packets;
+    std::vector<const Tensor*> tensors;
+  };
+
+  // Collects the input tensors of each timestamp of a batch prepared by a
+  // batching input stream handler, and runs inference on all of them at once
+  // when the last timestamp of the batch is processed. The outputs are split
+  // and sent at the timestamps of the corresponding inputs.
+  absl::Status ProcessBatched(CalculatorContext* cc) {
+    BatchEntry entry{cc->InputTimestamp()};
+    if (InferenceCalculator::kInTensors(cc).IsConnected()) {
+      if (!InferenceCalculator::kInTensors(cc).IsEmpty()) {
+        const auto& input_tensors = *InferenceCalculator::kInTensors(cc);
+        RET_CHECK(!input_tensors.empty());
+        entry.packets.push_back(InferenceCalculator::kInTensors(cc).packet());
+        for (const Tensor& tensor : input_tensors) {
+          entry.tensors.push_back(&tensor);
+        }
+      }
+    } else {
+      for (int i = 0; i < InferenceCalculator::kInTensor(cc).Count(); ++i) {
+        const auto& input = InferenceCalculator::kInTensor(cc)[i];
+        if (input.IsEmpty()) {
+          entry.tensors.clear();
+          break;
+        }
+        entry.packets.push_back(input.packet());
+        entry.tensors.push_back(&*input);
+      }
+    }
+    if (!entry.tensors.empty()) {
+      if (!batch_.empty()) {
+        RET_CHECK_EQ(entry.tensors.size(), batch_.front().tensors.size())
+            << "The number of input tensors changed within a batch.";
+      }
+      batch_.push_back(std::move(entry));
+    }
+    if (!cc->IsLastInBatch() || batch_.empty()) {
+      return absl::OkStatus();
+    }
+
+    std::vector<BatchEntry> batch = std::move(batch_);
+    batch_.clear();
+    std::vector<int> batch_sizes;
+    for (const BatchEntry& batch_entry : batch) {
+      RET_CHECK(!batch_entry.tensors[0]->shape().dims.empty());
+      batch_sizes.push_back(batch_entry.tensors[0]->shape().dims[0]);
+    }
+    std::vector<Tensor> batched_inputs;
+    std::vector<const Tensor*> tensors(batch.size());
+    for (int i = 0; i < batch.front().tensors.size(); ++i) {
+      for (int j = 0; j < batch.size(); ++j) {
+        tensors[j] = batch[j].tensors[i];
+      }
+      MP_ASSIGN_OR_RETURN(Tensor batched_input, BatchTensors(tensors));
+      batched_inputs.push_back(std::move(batched_input));
+    }
+    MP_ASSIGN_OR_RETURN(
+        auto batched_outputs,
+        RemapAndProcessTensors(cc, MakeTensorSpan(batched_inputs)));
+
+    std::vector<std::vector<Tensor>> output_tensors(batch.size());
+    for (const Tensor& batched_output : batched_outputs) {
+      MP_ASSIGN_OR_RETURN(std::vector<Tensor> outputs,
+                          UnbatchTensor(batched_output, batch_sizes));
+      for (int j = 0; j < batch.size(); ++j) {
+        output_tensors[j].push_back(std::move(outputs[j]));
+      }
+    }
+    for (int j = 0; j < batch.size(); ++j) {
+      MP_RETURN_IF_ERROR(SendOutputTensors(cc, std::move(output_tensors[j]),
+                                           batch[j].timestamp));
+    }
+    return absl::OkStatus();
+  }
+
   // Remaps input tensors according to the IO map, runs inference, and remaps
   // output tensors.
   absl::StatusOr<std::vector<Tensor>> RemapAndProcessTensors(
@@ -251,15 +364,23 @@ class InferenceCalculatorNodeImpl : public NodeImpl<Intf, Impl> {
   // ensure we can destroy/move the tensors.
   static absl::Status SendOutputTensors(CalculatorContext* cc,
                                         std::vector<Tensor>&& output_tensors) {
+    return SendOutputTensors(cc, std::move(output_tensors),
+                             cc->InputTimestamp());
+  }
+
+  static absl::Status SendOutputTensors(CalculatorContext* cc,
+                                        std::vector<Tensor>&& output_tensors,
+                                        Timestamp timestamp) {
     if (InferenceCalculator::kOutTensors(cc).IsConnected()) {
-      InferenceCalculator::kOutTensors(cc).Send(std::move(output_tensors));
+      InferenceCalculator::kOutTensors(cc).Send(std::move(output_tensors),
+                                                timestamp);
     } else {
       const int output_count =
           std::min(InferenceCalculator::kOutTensor(cc).Count(),
                    static_cast<int>(output_tensors.size()));
       for (int i = 0; i < output_count; ++i) {
         InferenceCalculator::kOutTensor(cc)[i].Send(
-            std::move(output_tensors[i]));
+            std::move(output_tensors[i]), timestamp);
       }
     }
     return absl::OkStatus();
@@ -284,6 +405,13 @@ class InferenceCalculatorNodeImpl : public NodeImpl<Intf, Impl> {
 
   std::unique_ptr<mediapipe::InferenceCalculatorOptions::InputOutputConfig>
       io_config_;
+
+  // See InferenceCalculatorOptions.batch_across_timestamps.
+  bool batch_across_timestamps_ = false;
+  // The inputs of the batch in progress.
+  std::vector<BatchEntry> batch_;
+  // See RecordSidePackets().
+  std::vector<mediapipe::Packet> side_packets_;
 };
 
 }  // namespace api2
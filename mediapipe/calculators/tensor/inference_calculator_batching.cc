@@ -0,0 +1,91 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tensor/inference_calculator_batching.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/port/ret_check.h"
+
+namespace mediapipe {
+
+absl::StatusOr<Tensor> BatchTensors(absl::Span<const Tensor* const> tensors) {
+  RET_CHECK(!tensors.empty());
+  const Tensor& first = *tensors.front();
+  RET_CHECK(!first.shape().dims.empty())
+      << "Scalar tensors cannot be batched.";
+  std::vector<int> dims = first.shape().dims;
+  dims[0] = 0;
+  for (const Tensor* tensor : tensors) {
+    RET_CHECK(tensor->element_type() == first.element_type())
+        << "Batched tensors must have the same element type.";
+    const std::vector<int>& tensor_dims = tensor->shape().dims;
+    RET_CHECK(tensor_dims.size() == dims.size() &&
+              std::equal(tensor_dims.begin() + 1, tensor_dims.end(),
+                         dims.begin() + 1))
+        << "Batched tensors must have the same dimensions except for the "
+           "first one.";
+    dims[0] += tensor_dims[0];
+  }
+
+  Tensor batch(first.element_type(), Tensor::Shape(dims, /*is_dynamic=*/true),
+               first.quantization_parameters());
+  auto batch_view = batch.GetCpuWriteView();
+  uint8_t* batch_buffer = batch_view.buffer<uint8_t>();
+  for (const Tensor* tensor : tensors) {
+    auto view = tensor->GetCpuReadView();
+    std::memcpy(batch_buffer, view.buffer<uint8_t>(), tensor->bytes());
+    batch_buffer += tensor->bytes();
+  }
+  return batch;
+}
+
+absl::StatusOr<std::vector<Tensor>> UnbatchTensor(
+    const Tensor& tensor, absl::Span<const int> batch_sizes) {
+  const std::vector<int>& dims = tensor.shape().dims;
+  RET_CHECK(!dims.empty()) << "Scalar tensors cannot be unbatched.";
+  int total_batch_size = 0;
+  for (int batch_size : batch_sizes) {
+    total_batch_size += batch_size;
+  }
+  RET_CHECK_EQ(total_batch_size, dims[0])
+      << "The first dimension of the tensor doesn't match the batch.";
+
+  const int bytes_per_batch_entry =
+      dims[0] == 0 ? 0 : tensor.bytes() / dims[0];
+  std::vector<Tensor> result;
+  result.reserve(batch_sizes.size());
+  auto view = tensor.GetCpuReadView();
+  const uint8_t* buffer = view.buffer<uint8_t>();
+  for (int batch_size : batch_sizes) {
+    std::vector<int> entry_dims = dims;
+    entry_dims[0] = batch_size;
+    Tensor entry(tensor.element_type(), Tensor::Shape(entry_dims),
+                 tensor.quantization_parameters());
+    const int bytes = batch_size * bytes_per_batch_entry;
+    std::memcpy(entry.GetCpuWriteView().buffer<uint8_t>(), buffer, bytes);
+    buffer += bytes;
+    result.push_back(std::move(entry));
+  }
+  return result;
+}
+
+}  // namespace mediapipe
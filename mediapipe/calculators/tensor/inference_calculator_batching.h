@@ -0,0 +1,40 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_CALCULATORS_TENSOR_INFERENCE_CALCULATOR_BATCHING_H_
+#define MEDIAPIPE_CALCULATORS_TENSOR_INFERENCE_CALCULATOR_BATCHING_H_
+
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "mediapipe/framework/formats/tensor.h"
+
+namespace mediapipe {
+
+// Concatenates tensors along their first dimension, which is the batch
+// dimension of the model. All tensors must have the same element type and the
+// same dimensions except for the first one. The result has a dynamic shape, so
+// that the inference runner resizes the model input to the size of the batch.
+absl::StatusOr<Tensor> BatchTensors(absl::Span<const Tensor* const> tensors);
+
+// Splits a tensor along its first dimension into tensors whose first
+// dimensions are given by batch_sizes. The batch sizes must add up to the
+// first dimension of the tensor.
+absl::StatusOr<std::vector<Tensor>> UnbatchTensor(
+    const Tensor& tensor, absl::Span<const int> batch_sizes);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_CALCULATORS_TENSOR_INFERENCE_CALCULATOR_BATCHING_H_
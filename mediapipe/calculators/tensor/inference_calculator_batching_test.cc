@@ -0,0 +1,190 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tensor/inference_calculator_batching.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "mediapipe/calculators/tensor/inference_calculator.h"
+#include "mediapipe/calculators/tensor/tensor_span.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+
+// The batch size of the inputs of each inference of
+// InferenceCalculatorDoubling.
+std::vector<int>& InferenceBatchSizes() {
+  static auto* batch_sizes = new std::vector<int>();
+  return *batch_sizes;
+}
+
+struct InferenceCalculatorDoubling : public api2::InferenceCalculator {
+  static constexpr char kCalculatorName[] = "InferenceCalculatorDoubling";
+};
+
+// Stands in for a model whose output is twice its float input.
+class InferenceCalculatorDoublingImpl
+    : public api2::InferenceCalculatorNodeImpl<
+          InferenceCalculatorDoubling, InferenceCalculatorDoublingImpl> {
+ public:
+  static absl::Status UpdateContract(CalculatorContract* cc) {
+    return TensorContractCheck(cc);
+  }
+
+ private:
+  absl::StatusOr<std::vector<Tensor>> Process(
+      CalculatorContext* cc, const TensorSpan& tensor_span) override {
+    RET_CHECK_EQ(tensor_span.size(), 1);
+    const Tensor& input = tensor_span[0];
+    InferenceBatchSizes().push_back(input.shape().dims[0]);
+    Tensor output(Tensor::ElementType::kFloat32, input.shape());
+    auto input_view = input.GetCpuReadView();
+    auto output_view = output.GetCpuWriteView();
+    const float* input_buffer = input_view.buffer<float>();
+    float* output_buffer = output_view.buffer<float>();
+    for (int i = 0; i < input.shape().num_elements(); ++i) {
+      output_buffer[i] = 2 * input_buffer[i];
+    }
+    std::vector<Tensor> outputs;
+    outputs.push_back(std::move(output));
+    return outputs;
+  }
+};
+
+Tensor MakeFloatTensor(std::vector<int> dims, const std::vector<float>& data) {
+  Tensor tensor(Tensor::ElementType::kFloat32, Tensor::Shape(dims));
+  auto view = tensor.GetCpuWriteView();
+  std::copy(data.begin(), data.end(), view.buffer<float>());
+  return tensor;
+}
+
+std::vector<float> TensorData(const Tensor& tensor) {
+  auto view = tensor.GetCpuReadView();
+  const float* buffer = view.buffer<float>();
+  return std::vector<float>(buffer, buffer + tensor.shape().num_elements());
+}
+
+TEST(InferenceCalculatorBatchingTest, BatchesAndUnbatchesTensors) {
+  Tensor a = MakeFloatTensor({1, 2}, {1, 2});
+  Tensor b = MakeFloatTensor({2, 2}, {3, 4, 5, 6});
+  MP_ASSERT_OK_AND_ASSIGN(Tensor batch, BatchTensors({&a, &b}));
+  EXPECT_THAT(batch.shape().dims, ElementsAre(3, 2));
+  EXPECT_TRUE(batch.shape().is_dynamic);
+  EXPECT_THAT(TensorData(batch), ElementsAreArray({1, 2, 3, 4, 5, 6}));
+
+  MP_ASSERT_OK_AND_ASSIGN(std::vector<Tensor> entries,
+                          UnbatchTensor(batch, {1, 2}));
+  ASSERT_EQ(entries.size(), 2);
+  EXPECT_THAT(entries[0].shape().dims, ElementsAre(1, 2));
+  EXPECT_THAT(TensorData(entries[0]), ElementsAre(1, 2));
+  EXPECT_THAT(entries[1].shape().dims, ElementsAre(2, 2));
+  EXPECT_THAT(TensorData(entries[1]), ElementsAre(3, 4, 5, 6));
+}
+
+TEST(InferenceCalculatorBatchingTest, PreservesQuantizationParameters) {
+  Tensor a(Tensor::ElementType::kUInt8, Tensor::Shape({1, 4}),
+           Tensor::QuantizationParameters(0.5f, 3));
+  Tensor b(Tensor::ElementType::kUInt8, Tensor::Shape({1, 4}),
+           Tensor::QuantizationParameters(0.5f, 3));
+  a.GetCpuWriteView();
+  b.GetCpuWriteView();
+  MP_ASSERT_OK_AND_ASSIGN(Tensor batch, BatchTensors({&a, &b}));
+  EXPECT_EQ(batch.quantization_parameters().scale, 0.5f);
+  EXPECT_EQ(batch.quantization_parameters().zero_point, 3);
+}
+
+TEST(InferenceCalculatorBatchingTest, RejectsMismatchedTensors) {
+  Tensor a = MakeFloatTensor({1, 2}, {1, 2});
+  Tensor b = MakeFloatTensor({1, 3}, {3, 4, 5});
+  EXPECT_FALSE(BatchTensors({&a, &b}).ok());
+
+  Tensor c(Tensor::ElementType::kInt32, Tensor::Shape({1, 2}));
+  EXPECT_FALSE(BatchTensors({&a, &c}).ok());
+}
+
+TEST(InferenceCalculatorBatchingTest, RejectsMismatchedBatchSizes) {
+  Tensor batch = MakeFloatTensor({3, 1}, {1, 2, 3});
+  EXPECT_FALSE(UnbatchTensor(batch, {1, 1}).ok());
+}
+
+TEST(InferenceCalculatorBatchingTest, RunsInferenceOncePerBatch) {
+  auto config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "input"
+    node {
+      calculator: "InferenceCalculatorDoubling"
+      input_stream: "TENSORS:input"
+      output_stream: "TENSORS:output"
+      input_stream_handler {
+        input_stream_handler: "BatchingInputStreamHandler"
+        options: {
+          [mediapipe.BatchingInputStreamHandlerOptions.ext]: {
+            batch_size: 3
+          }
+        }
+      }
+      options: {
+        [mediapipe.InferenceCalculatorOptions.ext] {
+          batch_across_timestamps: true
+        }
+      }
+    }
+  )pb");
+  std::vector<Packet> output_packets;
+  tool::AddVectorSink("output", &config, &output_packets);
+  InferenceBatchSizes().clear();
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun({}));
+
+  for (int i = 0; i < 5; ++i) {
+    std::vector<Tensor> tensors;
+    tensors.push_back(MakeFloatTensor({1, 2}, {1.0f * i, 10.0f * i}));
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "input", MakePacket<std::vector<Tensor>>(std::move(tensors))
+                     .At(Timestamp(i))));
+  }
+  MP_ASSERT_OK(graph.WaitUntilIdle());
+  EXPECT_THAT(InferenceBatchSizes(), ElementsAre(3));
+  EXPECT_EQ(output_packets.size(), 3);
+
+  // The incomplete batch is flushed when the node is closed.
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+  EXPECT_THAT(InferenceBatchSizes(), ElementsAre(3, 2));
+  ASSERT_EQ(output_packets.size(), 5);
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(output_packets[i].Timestamp(), Timestamp(i));
+    const auto& tensors = output_packets[i].Get<std::vector<Tensor>>();
+    ASSERT_EQ(tensors.size(), 1);
+    EXPECT_THAT(tensors[0].shape().dims, ElementsAre(1, 2));
+    EXPECT_THAT(TensorData(tensors[0]), ElementsAre(2.0f * i, 20.0f * i));
+  }
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -25,9 +25,12 @@
 #include "mediapipe/calculators/tensor/inference_calculator_utils.h"
 #include "mediapipe/calculators/tensor/inference_interpreter_delegate_runner.h"
 #include "mediapipe/calculators/tensor/inference_runner.h"
+#include "mediapipe/calculators/tensor/shared_inference_resources.h"
 #include "mediapipe/calculators/tensor/tensor_span.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/memory_manager.h"
+#include "mediapipe/framework/memory_manager_service.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status_macros.h"
 #include "tensorflow/lite/interpreter.h"
@@ -46,15 +49,22 @@ class InferenceCalculatorCpuImpl
   static absl::Status UpdateContract(CalculatorContract* cc);
 
   absl::Status Open(CalculatorContext* cc) override;
-  absl::Status Close(CalculatorContext* cc) override;
+  absl::Status Reset(CalculatorContext* cc) override;
 
  private:
+  // Gets the services of the current run. Returns whether they changed.
+  bool UpdateServices(CalculatorContext* cc);
   absl::StatusOr<std::unique_ptr<InferenceRunner>> CreateInferenceRunner(
       CalculatorContext* cc);
   absl::StatusOr<TfLiteDelegatePtr> MaybeCreateDelegate(CalculatorContext* cc);
   absl::StatusOr<std::vector<Tensor>> Process(
       CalculatorContext* cc, const TensorSpan& tensor_span) override;
+  // Kept across graph runs, see Reset().
   std::unique_ptr<InferenceRunner> inference_runner_;
+  MemoryManager* memory_manager_ = nullptr;
+  SharedInferenceResources* shared_resources_ = nullptr;
+  // Whether the runner runs on the XNNPACK delegate of shared_resources_.
+  bool use_shared_xnnpack_ = false;
 };
 
 absl::Status InferenceCalculatorCpuImpl::UpdateContract(
@@ -65,14 +75,50 @@ absl::Status InferenceCalculatorCpuImpl::UpdateContract(
 
   MP_RETURN_IF_ERROR(TensorContractCheck(cc));
 
+  cc->UseService(kMemoryManagerService).Optional();
+  cc->UseService(kSharedInferenceResourcesService).Optional();
+  cc->SetResettable(true);
   return absl::OkStatus();
 }
 
 absl::Status InferenceCalculatorCpuImpl::Open(CalculatorContext* cc) {
+  RecordSidePackets(cc);
+  UpdateServices(cc);
   MP_ASSIGN_OR_RETURN(inference_runner_, CreateInferenceRunner(cc));
   return absl::OkStatus();
 }
 
+absl::Status InferenceCalculatorCpuImpl::Reset(CalculatorContext* cc) {
+  ClearRunState();
+  // The runner, and the model and delegate it holds, are kept from the
+  // previous run unless it was built from other side packets or services.
+  const bool side_packets_changed = RecordSidePackets(cc);
+  const bool services_changed = UpdateServices(cc);
+  if (side_packets_changed || services_changed) {
+    inference_runner_ = nullptr;
+    use_shared_xnnpack_ = false;
+    MP_ASSIGN_OR_RETURN(inference_runner_, CreateInferenceRunner(cc));
+  }
+  return absl::OkStatus();
+}
+
+bool InferenceCalculatorCpuImpl::UpdateServices(CalculatorContext* cc) {
+  MemoryManager* memory_manager = nullptr;
+  if (cc->Service(kMemoryManagerService).IsAvailable()) {
+    memory_manager = &cc->Service(kMemoryManagerService).GetObject();
+  }
+  SharedInferenceResources* shared_resources = nullptr;
+  if (cc->Service(kSharedInferenceResourcesService).IsAvailable()) {
+    shared_resources =
+        &cc->Service(kSharedInferenceResourcesService).GetObject();
+  }
+  const bool changed = memory_manager != memory_manager_ ||
+                       shared_resources != shared_resources_;
+  memory_manager_ = memory_manager;
+  shared_resources_ = shared_resources;
+  return changed;
+}
+
 absl::StatusOr<std::vector<Tensor>> InferenceCalculatorCpuImpl::Process(
     CalculatorContext* cc, const TensorSpan& tensor_span) {
   MP_ASSIGN_OR_RETURN(std::vector<Tensor> output_tensors,
@@ -80,11 +126,6 @@ absl::StatusOr<std::vector<Tensor>> InferenceCalculatorCpuImpl::Process(
   return output_tensors;
 }
 
-absl::Status InferenceCalculatorCpuImpl::Close(CalculatorContext* cc) {
-  inference_runner_ = nullptr;
-  return absl::OkStatus();
-}
-
 absl::StatusOr<std::unique_ptr<InferenceRunner>>
 InferenceCalculatorCpuImpl::CreateInferenceRunner(CalculatorContext* cc) {
   MP_ASSIGN_OR_RETURN(auto model_packet, GetModelAsPacket(cc));
@@ -92,9 +133,23 @@ InferenceCalculatorCpuImpl::CreateInferenceRunner(CalculatorContext* cc) {
   const int interpreter_num_threads =
       cc->Options<mediapipe::InferenceCalculatorOptions>().cpu_num_thread();
   MP_ASSIGN_OR_RETURN(TfLiteDelegatePtr delegate, MaybeCreateDelegate(cc));
+  if (shared_resources_ != nullptr && delegate == nullptr) {
+    // The pooled runners can be used by other graphs, so they don't take
+    // their buffers from the memory manager of this graph.
+    const std::string model_key =
+        GetModelKey(cc, model_packet, op_resolver_packet);
+    return shared_resources_->CreatePooledRunner(
+        model_key, use_shared_xnnpack_,
+        [model_packet, op_resolver_packet,
+         interpreter_num_threads](TfLiteDelegatePtr shared_delegate) {
+          return CreateInferenceInterpreterDelegateRunner(
+              model_packet, op_resolver_packet, std::move(shared_delegate),
+              interpreter_num_threads);
+        });
+  }
   return CreateInferenceInterpreterDelegateRunner(
       std::move(model_packet), std::move(op_resolver_packet),
-      std::move(delegate), interpreter_num_threads);
+      std::move(delegate), interpreter_num_threads, memory_manager_);
 }
 
 absl::StatusOr<TfLiteDelegatePtr>
@@ -150,6 +205,12 @@ InferenceCalculatorCpuImpl::MaybeCreateDelegate(CalculatorContext* cc) {
   const bool use_xnnpack = opts_has_delegate && opts_delegate.has_xnnpack();
 #endif  // defined(__EMSCRIPTEN__)
 
+  if (use_xnnpack && shared_resources_ != nullptr) {
+    // The shared resources provide the XNNPACK delegate, and the delegate
+    // options of the calculator are ignored.
+    use_shared_xnnpack_ = true;
+    return nullptr;
+  }
   if (use_xnnpack) {
     auto xnnpack_opts = TfLiteXNNPackDelegateOptionsDefault();
     xnnpack_opts.num_threads =
@@ -24,6 +24,7 @@
 #include "mediapipe/calculators/tensor/inference_calculator_utils.h"
 #include "mediapipe/calculators/tensor/inference_interpreter_delegate_runner.h"
 #include "mediapipe/calculators/tensor/inference_runner.h"
+#include "mediapipe/calculators/tensor/shared_inference_resources.h"
 #include "mediapipe/calculators/tensor/tensor_span.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/tensor.h"
@@ -41,16 +42,20 @@ class InferenceCalculatorXnnpackImpl
   static absl::Status UpdateContract(CalculatorContract* cc);
 
   absl::Status Open(CalculatorContext* cc) override;
-  absl::Status Close(CalculatorContext* cc) override;
+  absl::Status Reset(CalculatorContext* cc) override;
 
  private:
+  // Gets the services of the current run. Returns whether they changed.
+  bool UpdateServices(CalculatorContext* cc);
   absl::StatusOr<std::vector<Tensor>> Process(
       CalculatorContext* cc, const TensorSpan& tensor_span) override;
   absl::StatusOr<std::unique_ptr<InferenceRunner>> CreateInferenceRunner(
       CalculatorContext* cc);
   absl::StatusOr<TfLiteDelegatePtr> CreateDelegate(CalculatorContext* cc);
 
+  // Kept across graph runs, see Reset().
   std::unique_ptr<InferenceRunner> inference_runner_;
+  SharedInferenceResources* shared_resources_ = nullptr;
 };
 
 absl::Status InferenceCalculatorXnnpackImpl::UpdateContract(
@@ -61,14 +66,42 @@ absl::Status InferenceCalculatorXnnpackImpl::UpdateContract(
   RET_CHECK(!options.model_path().empty() ^ kSideInModel(cc).IsConnected())
       << "Either model as side packet or model path in options is required.";
 
+  cc->UseService(kSharedInferenceResourcesService).Optional();
+  cc->SetResettable(true);
   return absl::OkStatus();
 }
 
 absl::Status InferenceCalculatorXnnpackImpl::Open(CalculatorContext* cc) {
+  RecordSidePackets(cc);
+  UpdateServices(cc);
   MP_ASSIGN_OR_RETURN(inference_runner_, CreateInferenceRunner(cc));
   return absl::OkStatus();
 }
 
+absl::Status InferenceCalculatorXnnpackImpl::Reset(CalculatorContext* cc) {
+  ClearRunState();
+  // The runner, and the model and delegate it holds, are kept from the
+  // previous run unless it was built from other side packets or services.
+  const bool side_packets_changed = RecordSidePackets(cc);
+  const bool services_changed = UpdateServices(cc);
+  if (side_packets_changed || services_changed) {
+    inference_runner_ = nullptr;
+    MP_ASSIGN_OR_RETURN(inference_runner_, CreateInferenceRunner(cc));
+  }
+  return absl::OkStatus();
+}
+
+bool InferenceCalculatorXnnpackImpl::UpdateServices(CalculatorContext* cc) {
+  SharedInferenceResources* shared_resources = nullptr;
+  if (cc->Service(kSharedInferenceResourcesService).IsAvailable()) {
+    shared_resources =
+        &cc->Service(kSharedInferenceResourcesService).GetObject();
+  }
+  const bool changed = shared_resources != shared_resources_;
+  shared_resources_ = shared_resources;
+  return changed;
+}
+
 absl::StatusOr<std::vector<Tensor>> InferenceCalculatorXnnpackImpl::Process(
     CalculatorContext* cc, const TensorSpan& tensor_span) {
   MP_ASSIGN_OR_RETURN(std::vector<Tensor> output_tensors,
@@ -76,17 +109,26 @@ absl::StatusOr<std::vector<Tensor>> InferenceCalculatorXnnpackImpl::Process(
   return output_tensors;
 }
 
-absl::Status InferenceCalculatorXnnpackImpl::Close(CalculatorContext* cc) {
-  inference_runner_ = nullptr;
-  return absl::OkStatus();
-}
-
 absl::StatusOr<std::unique_ptr<InferenceRunner>>
 InferenceCalculatorXnnpackImpl::CreateInferenceRunner(CalculatorContext* cc) {
   MP_ASSIGN_OR_RETURN(auto model_packet, GetModelAsPacket(cc));
   MP_ASSIGN_OR_RETURN(auto op_resolver_packet, GetOpResolverAsPacket(cc));
   const int interpreter_num_threads =
       cc->Options<mediapipe::InferenceCalculatorOptions>().cpu_num_thread();
+  if (shared_resources_ != nullptr) {
+    // The shared resources provide the XNNPACK delegate, and the delegate
+    // options of the calculator are ignored.
+    const std::string model_key =
+        GetModelKey(cc, model_packet, op_resolver_packet);
+    return shared_resources_->CreatePooledRunner(
+        model_key, /*use_xnnpack=*/true,
+        [model_packet, op_resolver_packet,
+         interpreter_num_threads](TfLiteDelegatePtr shared_delegate) {
+          return CreateInferenceInterpreterDelegateRunner(
+              model_packet, op_resolver_packet, std::move(shared_delegate),
+              interpreter_num_threads);
+        });
+  }
   MP_ASSIGN_OR_RETURN(TfLiteDelegatePtr delegate, CreateDelegate(cc));
   return CreateInferenceInterpreterDelegateRunner(
       std::move(model_packet), std::move(op_resolver_packet),
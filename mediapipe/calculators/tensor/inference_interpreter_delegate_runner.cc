@@ -24,6 +24,7 @@
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/tensor.h"
 #include "mediapipe/framework/mediapipe_profiling.h"
+#include "mediapipe/framework/memory_manager.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "tensorflow/lite/c/c_api_types.h"
 #include "tensorflow/lite/c/common.h"
@@ -80,10 +81,12 @@ class InferenceInterpreterDelegateRunner : public InferenceRunner {
  public:
   InferenceInterpreterDelegateRunner(api2::Packet<TfLiteModelPtr> model,
                                      std::unique_ptr<Interpreter> interpreter,
-                                     TfLiteDelegatePtr delegate)
+                                     TfLiteDelegatePtr delegate,
+                                     MemoryManager* memory_manager)
       : model_(std::move(model)),
         interpreter_(std::move(interpreter)),
-        delegate_(std::move(delegate)) {}
+        delegate_(std::move(delegate)),
+        memory_manager_(memory_manager) {}
 
   absl::StatusOr<std::vector<Tensor>> Run(
       CalculatorContext* cc, const TensorSpan& tensor_span) override;
@@ -92,6 +95,7 @@ class InferenceInterpreterDelegateRunner : public InferenceRunner {
   api2::Packet<TfLiteModelPtr> model_;
   std::unique_ptr<Interpreter> interpreter_;
   TfLiteDelegatePtr delegate_;
+  MemoryManager* memory_manager_ = nullptr;
 };
 
 absl::StatusOr<std::vector<Tensor>> InferenceInterpreterDelegateRunner::Run(
@@ -180,7 +184,8 @@ absl::StatusOr<std::vector<Tensor>> InferenceInterpreterDelegateRunner::Run(
     switch (tensor->type) {
       case TfLiteType::kTfLiteFloat16:
       case TfLiteType::kTfLiteFloat32:
-        output_tensors.emplace_back(Tensor::ElementType::kFloat32, shape);
+        output_tensors.emplace_back(Tensor::ElementType::kFloat32, shape,
+                                    memory_manager_);
         CopyTensorBufferFromInterpreter<float>(interpreter_.get(), i,
                                                &output_tensors.back());
         break;
@@ -188,7 +193,8 @@ absl::StatusOr<std::vector<Tensor>> InferenceInterpreterDelegateRunner::Run(
         output_tensors.emplace_back(
             Tensor::ElementType::kUInt8, shape,
             Tensor::QuantizationParameters{tensor->params.scale,
-                                           tensor->params.zero_point});
+                                           tensor->params.zero_point},
+            memory_manager_);
         CopyTensorBufferFromInterpreter<uint8_t>(interpreter_.get(), i,
                                                  &output_tensors.back());
         break;
@@ -196,18 +202,21 @@ absl::StatusOr<std::vector<Tensor>> InferenceInterpreterDelegateRunner::Run(
         output_tensors.emplace_back(
             Tensor::ElementType::kInt8, shape,
             Tensor::QuantizationParameters{tensor->params.scale,
-                                           tensor->params.zero_point});
+                                           tensor->params.zero_point},
+            memory_manager_);
         CopyTensorBufferFromInterpreter<int8_t>(interpreter_.get(), i,
                                                 &output_tensors.back());
         break;
       case TfLiteType::kTfLiteInt32:
-        output_tensors.emplace_back(Tensor::ElementType::kInt32, shape);
+        output_tensors.emplace_back(Tensor::ElementType::kInt32, shape,
+                                    memory_manager_);
         CopyTensorBufferFromInterpreter<int32_t>(interpreter_.get(), i,
                                                  &output_tensors.back());
         break;
       case TfLiteType::kTfLiteBool:
         output_tensors.emplace_back(Tensor::ElementType::kBool, shape,
-                                    Tensor::QuantizationParameters{1.0f, 0});
+                                    Tensor::QuantizationParameters{1.0f, 0},
+                                    memory_manager_);
         CopyTensorBufferFromInterpreter<bool>(interpreter_.get(), i,
                                               &output_tensors.back());
         break;
@@ -227,7 +236,7 @@ absl::StatusOr<std::unique_ptr<InferenceRunner>>
 CreateInferenceInterpreterDelegateRunner(
     api2::Packet<TfLiteModelPtr> model,
     api2::Packet<tflite::OpResolver> op_resolver, TfLiteDelegatePtr delegate,
-    int interpreter_num_threads) {
+    int interpreter_num_threads, MemoryManager* memory_manager) {
   InterpreterBuilder interpreter_builder(*model.Get(), op_resolver.Get());
   if (delegate) {
     interpreter_builder.AddDelegate(delegate.get());
@@ -242,7 +251,8 @@ CreateInferenceInterpreterDelegateRunner(
   RET_CHECK(interpreter);
   RET_CHECK_EQ(interpreter->AllocateTensors(), kTfLiteOk);
   return std::make_unique<InferenceInterpreterDelegateRunner>(
-      std::move(model), std::move(interpreter), std::move(delegate));
+      std::move(model), std::move(interpreter), std::move(delegate),
+      memory_manager);
 }
 
 }  // namespace mediapipe
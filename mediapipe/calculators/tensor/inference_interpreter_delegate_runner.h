@@ -22,6 +22,7 @@
 #include "mediapipe/calculators/tensor/inference_runner.h"
 #include "mediapipe/calculators/tensor/tflite_delegate_ptr.h"
 #include "mediapipe/framework/api2/packet.h"
+#include "mediapipe/framework/memory_manager.h"
 #include "mediapipe/util/tflite/tflite_model_loader.h"
 #include "tensorflow/lite/c/c_api_types.h"
 #include "tensorflow/lite/core/api/op_resolver.h"
@@ -33,11 +34,14 @@ namespace mediapipe {
 //
 // `delegate` can be nullptr, in that case newly initialized interpreter will
 // use what is available by default.
+//
+// `memory_manager` can be nullptr, otherwise the buffers of the output tensors
+// are taken from its pools. It must outlive the runner.
 absl::StatusOr<std::unique_ptr<InferenceRunner>>
 CreateInferenceInterpreterDelegateRunner(
     api2::Packet<TfLiteModelPtr> model,
     api2::Packet<tflite::OpResolver> op_resolver, TfLiteDelegatePtr delegate,
-    int interpreter_num_threads);
+    int interpreter_num_threads, MemoryManager* memory_manager = nullptr);
 
 }  // namespace mediapipe
 
@@ -0,0 +1,186 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tensor/shared_inference_resources.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/log/absl_check.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/calculators/tensor/inference_calculator.pb.h"
+#include "mediapipe/calculators/tensor/inference_calculator_utils.h"
+#include "mediapipe/calculators/tensor/inference_runner.h"
+#include "mediapipe/calculators/tensor/tensor_span.h"
+#include "mediapipe/framework/calculator_context.h"
+#include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h"
+
+namespace mediapipe {
+
+namespace {
+
+std::string PoolKey(const std::string& model_key, bool use_xnnpack) {
+  return absl::StrCat(use_xnnpack ? "xnnpack:" : "cpu:", model_key);
+}
+
+int ResolveNumXnnpackThreads(int num_xnnpack_threads) {
+  if (num_xnnpack_threads > 0) return num_xnnpack_threads;
+  return GetXnnpackNumThreads(/*opts_has_delegate=*/false,
+                              InferenceCalculatorOptions::Delegate());
+}
+
+}  // namespace
+
+class SharedInferenceResources::PooledRunner : public InferenceRunner {
+ public:
+  PooledRunner(SharedInferenceResources* resources, std::string pool_key,
+               Pool* pool)
+      : resources_(resources), pool_key_(std::move(pool_key)), pool_(pool) {}
+
+  ~PooledRunner() override { resources_->Release(pool_key_); }
+
+  absl::StatusOr<std::vector<Tensor>> Run(
+      CalculatorContext* cc, const TensorSpan& tensor_span) override {
+    // The interpreters on the shared XNNPACK delegate run one at a time, so
+    // XNNPACK runners are borrowed under xnnpack_mutex_: concurrent callers
+    // wait for the runner in use instead of building more of them.
+    absl::MutexLockMaybe xnnpack_lock(
+        pool_->use_xnnpack ? &resources_->xnnpack_mutex_ : nullptr);
+    MP_ASSIGN_OR_RETURN(std::unique_ptr<InferenceRunner> runner,
+                        resources_->Borrow(*pool_));
+    absl::StatusOr<std::vector<Tensor>> output_tensors =
+        runner->Run(cc, tensor_span);
+    resources_->Return(*pool_, std::move(runner));
+    return output_tensors;
+  }
+
+ private:
+  SharedInferenceResources* const resources_;
+  const std::string pool_key_;
+  Pool* const pool_;
+};
+
+SharedInferenceResources::SharedInferenceResources(int num_xnnpack_threads)
+    : num_xnnpack_threads_(ResolveNumXnnpackThreads(num_xnnpack_threads)) {}
+
+SharedInferenceResources::~SharedInferenceResources() {
+  absl::MutexLock lock(&mutex_);
+  ABSL_CHECK(pools_.empty())
+      << "SharedInferenceResources destroyed while its runners are in use.";
+}
+
+absl::StatusOr<std::unique_ptr<InferenceRunner>>
+SharedInferenceResources::CreatePooledRunner(const std::string& model_key,
+                                             bool use_xnnpack,
+                                             RunnerFactory factory) {
+  std::string pool_key = PoolKey(model_key, use_xnnpack);
+  Pool* pool;
+  {
+    absl::MutexLock lock(&mutex_);
+    std::unique_ptr<Pool>& entry = pools_[pool_key];
+    if (entry == nullptr) {
+      entry = std::make_unique<Pool>(use_xnnpack, std::move(factory));
+    }
+    pool = entry.get();
+    ++pool->num_users;
+  }
+  auto pooled_runner =
+      std::make_unique<PooledRunner>(this, std::move(pool_key), pool);
+  // Creates the first runner of the pool now, so that the calculator fails
+  // in Open() if the model can't run.
+  absl::MutexLockMaybe xnnpack_lock(use_xnnpack ? &xnnpack_mutex_ : nullptr);
+  MP_ASSIGN_OR_RETURN(std::unique_ptr<InferenceRunner> runner, Borrow(*pool));
+  Return(*pool, std::move(runner));
+  return pooled_runner;
+}
+
+int SharedInferenceResources::NumPooledRunners(const std::string& model_key,
+                                               bool use_xnnpack) {
+  absl::MutexLock lock(&mutex_);
+  auto it = pools_.find(PoolKey(model_key, use_xnnpack));
+  if (it == pools_.end()) return 0;
+  absl::MutexLock pool_lock(&it->second->mutex);
+  return it->second->num_runners;
+}
+
+absl::StatusOr<std::unique_ptr<InferenceRunner>>
+SharedInferenceResources::Borrow(Pool& pool) {
+  {
+    absl::MutexLock lock(&pool.mutex);
+    if (!pool.idle_runners.empty()) {
+      std::unique_ptr<InferenceRunner> runner =
+          std::move(pool.idle_runners.back());
+      pool.idle_runners.pop_back();
+      return runner;
+    }
+  }
+  std::unique_ptr<InferenceRunner> runner;
+  if (pool.use_xnnpack) {
+    // Applying the delegate to an interpreter modifies the delegate.
+    xnnpack_mutex_.AssertHeld();
+    MP_ASSIGN_OR_RETURN(runner, pool.factory(XnnpackDelegate()));
+  } else {
+    MP_ASSIGN_OR_RETURN(runner, pool.factory(nullptr));
+  }
+  RET_CHECK(runner);
+  absl::MutexLock lock(&pool.mutex);
+  ++pool.num_runners;
+  return runner;
+}
+
+void SharedInferenceResources::Return(Pool& pool,
+                                      std::unique_ptr<InferenceRunner> runner) {
+  absl::MutexLock lock(&pool.mutex);
+  pool.idle_runners.push_back(std::move(runner));
+}
+
+void SharedInferenceResources::Release(const std::string& pool_key) {
+  std::unique_ptr<Pool> released_pool;
+  {
+    absl::MutexLock lock(&mutex_);
+    auto it = pools_.find(pool_key);
+    ABSL_CHECK(it != pools_.end());
+    if (--it->second->num_users > 0) return;
+    released_pool = std::move(it->second);
+    pools_.erase(it);
+  }
+  // The runners are destroyed outside of mutex_, and under xnnpack_mutex_ if
+  // they use the XNNPACK delegate. xnnpack_mutex_ is taken before the pool
+  // mutex, like in PooledRunner::Run().
+  absl::MutexLockMaybe xnnpack_lock(
+      released_pool->use_xnnpack ? &xnnpack_mutex_ : nullptr);
+  absl::MutexLock pool_lock(&released_pool->mutex);
+  released_pool->idle_runners.clear();
+}
+
+TfLiteDelegatePtr SharedInferenceResources::XnnpackDelegate() {
+  if (xnnpack_delegate_ == nullptr) {
+    auto xnnpack_opts = TfLiteXNNPackDelegateOptionsDefault();
+    xnnpack_opts.num_threads = num_xnnpack_threads_;
+    xnnpack_delegate_ =
+        TfLiteDelegatePtr(TfLiteXNNPackDelegateCreate(&xnnpack_opts),
+                          &TfLiteXNNPackDelegateDelete);
+  }
+  return TfLiteDelegatePtr(xnnpack_delegate_.get(),
+                           [](TfLiteOpaqueDelegate*) {});
+}
+
+}  // namespace mediapipe
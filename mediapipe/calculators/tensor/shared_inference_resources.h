@@ -0,0 +1,139 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_CALCULATORS_TENSOR_SHARED_INFERENCE_RESOURCES_H_
+#define MEDIAPIPE_CALCULATORS_TENSOR_SHARED_INFERENCE_RESOURCES_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/calculators/tensor/inference_runner.h"
+#include "mediapipe/calculators/tensor/tflite_delegate_ptr.h"
+#include "mediapipe/framework/graph_service.h"
+
+namespace mediapipe {
+
+// Inference resources shared by the CPU inference calculators of several
+// graphs.
+//
+// By default, every InferenceCalculatorCpu and InferenceCalculatorXnnpack
+// builds its own interpreter, and its own XNNPACK delegate with its own thread
+// pool, so a process that runs many graphs runs many threads. Instead, the
+// application can create one SharedInferenceResources and set it as the
+// kSharedInferenceResourcesService object of all its graphs:
+//
+//   auto resources = std::make_shared<SharedInferenceResources>(
+//       /*num_xnnpack_threads=*/4);
+//   MP_RETURN_IF_ERROR(
+//       graph.SetServiceObject(kSharedInferenceResourcesService, resources));
+//
+// The calculators then borrow interpreters from a pool per model, so that the
+// calculators that run the same model share interpreters, and run XNNPACK on a
+// single delegate with num_xnnpack_threads threads. The interpreters of this
+// delegate run one at a time, each on all the threads, so an XNNPACK pool
+// holds a single interpreter that its users wait for.
+//
+// SharedInferenceResources is thread-safe.
+class SharedInferenceResources {
+ public:
+  // Creates a runner on "delegate", which is nullptr unless the runner runs
+  // XNNPACK. The runner must not keep any graph-specific resource, since it
+  // can be used by the calculators of other graphs.
+  using RunnerFactory =
+      std::function<absl::StatusOr<std::unique_ptr<InferenceRunner>>(
+          TfLiteDelegatePtr delegate)>;
+
+  // If "num_xnnpack_threads" isn't positive, the XNNPACK delegate uses the
+  // default number of threads of the platform.
+  explicit SharedInferenceResources(int num_xnnpack_threads = -1);
+  ~SharedInferenceResources();
+
+  SharedInferenceResources(const SharedInferenceResources&) = delete;
+  SharedInferenceResources& operator=(const SharedInferenceResources&) =
+      delete;
+
+  int num_xnnpack_threads() const { return num_xnnpack_threads_; }
+
+  // Returns a runner that borrows a runner from the pool of "model_key" for
+  // every Run(). The pool creates runners with the "factory" of its first
+  // user whenever all its runners are in use, and is destroyed with its last
+  // user. "model_key" identifies the model and everything else "factory"
+  // builds the runners from.
+  //
+  // The returned runner must not outlive this object.
+  absl::StatusOr<std::unique_ptr<InferenceRunner>> CreatePooledRunner(
+      const std::string& model_key, bool use_xnnpack, RunnerFactory factory);
+
+  // Returns the number of runners created for the pool of "model_key" and
+  // "use_xnnpack", or 0 if there is no such pool.
+  int NumPooledRunners(const std::string& model_key, bool use_xnnpack);
+
+ private:
+  class PooledRunner;
+
+  struct Pool {
+    Pool(bool use_xnnpack, RunnerFactory factory)
+        : use_xnnpack(use_xnnpack), factory(std::move(factory)) {}
+
+    const bool use_xnnpack;
+    const RunnerFactory factory;
+
+    // The number of PooledRunners that use this pool. Guarded by mutex_.
+    int num_users = 0;
+
+    absl::Mutex mutex;
+    int num_runners ABSL_GUARDED_BY(mutex) = 0;
+    std::vector<std::unique_ptr<InferenceRunner>> idle_runners
+        ABSL_GUARDED_BY(mutex);
+  };
+
+  // Returns an idle runner of "pool", or creates one. xnnpack_mutex_ must be
+  // held if "pool" uses XNNPACK, which keeps those pools at a single runner.
+  absl::StatusOr<std::unique_ptr<InferenceRunner>> Borrow(Pool& pool);
+  void Return(Pool& pool, std::unique_ptr<InferenceRunner> runner);
+  void Release(const std::string& pool_key);
+
+  // Returns a non-owning pointer to the shared XNNPACK delegate, which is
+  // created on first use.
+  TfLiteDelegatePtr XnnpackDelegate()
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(xnnpack_mutex_);
+
+  const int num_xnnpack_threads_;
+
+  // Serializes the use of the XNNPACK delegate: its thread pool and its
+  // workspace are shared by all the interpreters it is applied to.
+  absl::Mutex xnnpack_mutex_;
+  // Declared before pools_, so that it outlives the interpreters.
+  TfLiteDelegatePtr xnnpack_delegate_ ABSL_GUARDED_BY(xnnpack_mutex_);
+
+  absl::Mutex mutex_;
+  absl::flat_hash_map<std::string, std::unique_ptr<Pool>> pools_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+// Graph service providing the SharedInferenceResources of a graph, if the
+// application sets one.
+inline constexpr GraphService<SharedInferenceResources>
+    kSharedInferenceResourcesService("SharedInferenceResourcesService");
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_CALCULATORS_TENSOR_SHARED_INFERENCE_RESOURCES_H_
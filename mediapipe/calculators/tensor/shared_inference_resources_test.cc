@@ -0,0 +1,210 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tensor/shared_inference_resources.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "mediapipe/calculators/tensor/inference_runner.h"
+#include "mediapipe/calculators/tensor/tensor_span.h"
+#include "mediapipe/calculators/tensor/tflite_delegate_ptr.h"
+#include "mediapipe/framework/calculator_context.h"
+#include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+// Counts the runs of the runner, and calls "on_run" during each run.
+class FakeRunner : public InferenceRunner {
+ public:
+  explicit FakeRunner(int* num_runs, std::function<void()> on_run)
+      : num_runs_(num_runs), on_run_(std::move(on_run)) {}
+
+  absl::StatusOr<std::vector<Tensor>> Run(
+      CalculatorContext* cc, const TensorSpan& tensor_span) override {
+    ++*num_runs_;
+    if (on_run_) on_run_();
+    return std::vector<Tensor>();
+  }
+
+ private:
+  int* const num_runs_;
+  std::function<void()> on_run_;
+};
+
+class SharedInferenceResourcesTest : public ::testing::Test {
+ protected:
+  SharedInferenceResources::RunnerFactory MakeFactory(
+      std::function<void()> on_run = nullptr) {
+    return [this, on_run](TfLiteDelegatePtr delegate)
+               -> absl::StatusOr<std::unique_ptr<InferenceRunner>> {
+      ++num_created_runners_;
+      delegates_.push_back(delegate.get());
+      return std::make_unique<FakeRunner>(&num_runs_, on_run);
+    };
+  }
+
+  SharedInferenceResources resources_{/*num_xnnpack_threads=*/2};
+  int num_created_runners_ = 0;
+  int num_runs_ = 0;
+  std::vector<TfLiteOpaqueDelegate*> delegates_;
+};
+
+TEST_F(SharedInferenceResourcesTest, SharesRunnersPerModel) {
+  MP_ASSERT_OK_AND_ASSIGN(auto runner_1,
+                          resources_.CreatePooledRunner(
+                              "model_1", /*use_xnnpack=*/false, MakeFactory()));
+  MP_ASSERT_OK_AND_ASSIGN(auto runner_2,
+                          resources_.CreatePooledRunner(
+                              "model_1", /*use_xnnpack=*/false, MakeFactory()));
+  EXPECT_EQ(num_created_runners_, 1);
+  EXPECT_EQ(resources_.NumPooledRunners("model_1", /*use_xnnpack=*/false), 1);
+
+  MP_EXPECT_OK(runner_1->Run(nullptr, TensorSpan()));
+  MP_EXPECT_OK(runner_2->Run(nullptr, TensorSpan()));
+  EXPECT_EQ(num_runs_, 2);
+  EXPECT_EQ(num_created_runners_, 1);
+
+  MP_ASSERT_OK_AND_ASSIGN(auto runner_3,
+                          resources_.CreatePooledRunner(
+                              "model_2", /*use_xnnpack=*/false, MakeFactory()));
+  EXPECT_EQ(num_created_runners_, 2);
+  EXPECT_EQ(resources_.NumPooledRunners("model_2", /*use_xnnpack=*/false), 1);
+  EXPECT_EQ(delegates_, std::vector<TfLiteOpaqueDelegate*>(2, nullptr));
+}
+
+TEST_F(SharedInferenceResourcesTest, CreatesRunnersWhenAllAreInUse) {
+  std::unique_ptr<InferenceRunner> runner_2;
+  // runner_2 runs while runner_1 is running.
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto runner_1,
+      resources_.CreatePooledRunner(
+          "model", /*use_xnnpack=*/false, MakeFactory([&runner_2]() {
+            if (runner_2) {
+              auto nested_runner = std::move(runner_2);
+              MP_EXPECT_OK(nested_runner->Run(nullptr, TensorSpan()));
+            }
+          })));
+  MP_ASSERT_OK_AND_ASSIGN(runner_2, resources_.CreatePooledRunner(
+                                        "model", /*use_xnnpack=*/false,
+                                        MakeFactory()));
+  MP_EXPECT_OK(runner_1->Run(nullptr, TensorSpan()));
+  EXPECT_EQ(num_runs_, 2);
+  EXPECT_EQ(resources_.NumPooledRunners("model", /*use_xnnpack=*/false), 2);
+}
+
+TEST_F(SharedInferenceResourcesTest, ReleasesPoolWithItsLastUser) {
+  MP_ASSERT_OK_AND_ASSIGN(auto runner_1,
+                          resources_.CreatePooledRunner(
+                              "model", /*use_xnnpack=*/false, MakeFactory()));
+  MP_ASSERT_OK_AND_ASSIGN(auto runner_2,
+                          resources_.CreatePooledRunner(
+                              "model", /*use_xnnpack=*/false, MakeFactory()));
+  runner_1 = nullptr;
+  EXPECT_EQ(resources_.NumPooledRunners("model", /*use_xnnpack=*/false), 1);
+  runner_2 = nullptr;
+  EXPECT_EQ(resources_.NumPooledRunners("model", /*use_xnnpack=*/false), 0);
+
+  MP_ASSERT_OK_AND_ASSIGN(auto runner_3,
+                          resources_.CreatePooledRunner(
+                              "model", /*use_xnnpack=*/false, MakeFactory()));
+  EXPECT_EQ(num_created_runners_, 2);
+}
+
+TEST_F(SharedInferenceResourcesTest, ReturnsFactoryErrors) {
+  auto failing_factory = [](TfLiteDelegatePtr delegate)
+      -> absl::StatusOr<std::unique_ptr<InferenceRunner>> {
+    return absl::InvalidArgumentError("Unsupported model.");
+  };
+  EXPECT_EQ(resources_
+                .CreatePooledRunner("model", /*use_xnnpack=*/false,
+                                    failing_factory)
+                .status()
+                .code(),
+            absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(resources_.NumPooledRunners("model", /*use_xnnpack=*/false), 0);
+}
+
+TEST_F(SharedInferenceResourcesTest, SharesXnnpackDelegate) {
+  MP_ASSERT_OK_AND_ASSIGN(auto runner_1,
+                          resources_.CreatePooledRunner(
+                              "model_1", /*use_xnnpack=*/true, MakeFactory()));
+  MP_ASSERT_OK_AND_ASSIGN(auto runner_2,
+                          resources_.CreatePooledRunner(
+                              "model_2", /*use_xnnpack=*/true, MakeFactory()));
+  // The XNNPACK and the CPU runners of a model are pooled separately.
+  MP_ASSERT_OK_AND_ASSIGN(auto runner_3,
+                          resources_.CreatePooledRunner(
+                              "model_1", /*use_xnnpack=*/false, MakeFactory()));
+  EXPECT_EQ(resources_.num_xnnpack_threads(), 2);
+  ASSERT_EQ(delegates_.size(), 3);
+  EXPECT_NE(delegates_[0], nullptr);
+  EXPECT_EQ(delegates_[1], delegates_[0]);
+  EXPECT_EQ(delegates_[2], nullptr);
+  MP_EXPECT_OK(runner_1->Run(nullptr, TensorSpan()));
+  MP_EXPECT_OK(runner_2->Run(nullptr, TensorSpan()));
+}
+
+TEST_F(SharedInferenceResourcesTest, KeepsOneXnnpackRunnerUnderConcurrentRuns) {
+  constexpr int kNumThreads = 4;
+  constexpr int kNumRunsPerThread = 10;
+  std::atomic<int> num_running(0);
+  std::atomic<int> max_num_running(0);
+  auto on_run = [&]() {
+    const int running = ++num_running;
+    int max_running = max_num_running.load();
+    while (running > max_running &&
+           !max_num_running.compare_exchange_weak(max_running, running)) {
+    }
+    absl::SleepFor(absl::Milliseconds(1));
+    --num_running;
+  };
+  std::vector<std::unique_ptr<InferenceRunner>> runners;
+  for (int i = 0; i < kNumThreads; ++i) {
+    MP_ASSERT_OK_AND_ASSIGN(
+        runners.emplace_back(),
+        resources_.CreatePooledRunner("model", /*use_xnnpack=*/true,
+                                      MakeFactory(on_run)));
+  }
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([&runners, i]() {
+      for (int run = 0; run < kNumRunsPerThread; ++run) {
+        MP_EXPECT_OK(runners[i]->Run(nullptr, TensorSpan()));
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  EXPECT_EQ(num_runs_, kNumThreads * kNumRunsPerThread);
+  EXPECT_EQ(max_num_running, 1);
+  EXPECT_EQ(num_created_runners_, 1);
+  EXPECT_EQ(resources_.NumPooledRunners("model", /*use_xnnpack=*/true), 1);
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -12,10 +12,15 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <unordered_map>
 #include <vector>
 
+#include "Eigen/Core"
 #include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "mediapipe/calculators/tensor/tensors_to_detections_calculator.pb.h"
 #include "mediapipe/framework/api2/node.h"
@@ -191,7 +196,7 @@ class TensorsToDetectionsCalculator : public Node {
       "IGNORE_CLASSES"};
   static constexpr Output<std::vector<Detection>> kOutDetections{"DETECTIONS"};
   MEDIAPIPE_NODE_CONTRACT(kInTensors, kInAnchors, kSideInIgnoreClasses,
-                          kOutDetections);
+                          kOutDetections, Stateless());
   static absl::Status UpdateContract(CalculatorContract* cc);
 
   absl::Status Open(CalculatorContext* cc) override;
@@ -206,12 +211,22 @@ class TensorsToDetectionsCalculator : public Node {
 
   absl::Status LoadOptions(CalculatorContext* cc);
   absl::Status GpuInit(CalculatorContext* cc);
+  // Finds the top-scored allowed class of every box, and returns the boxes
+  // that pass min_score_thresh with their scores and classes.
+  void FilterBoxesByScore(const float* raw_scores,
+                          std::vector<int>* box_indices,
+                          std::vector<float>* detection_scores,
+                          std::vector<int>* detection_classes);
+  // Decodes the boxes and keypoints of the boxes at "box_indices" into
+  // consecutive rows of "boxes".
   absl::Status DecodeBoxes(const float* raw_boxes,
                            const std::vector<Anchor>& anchors,
+                           absl::Span<const int> box_indices,
                            std::vector<float>* boxes);
   absl::Status ConvertToDetections(const float* detection_boxes,
                                    const float* detection_scores,
                                    const int* detection_classes,
+                                   int num_boxes, int classes_per_detection,
                                    std::vector<Detection>* output_detections);
   Detection ConvertToDetection(float box_ymin, float box_xmin, float box_ymax,
                                float box_xmax, absl::Span<const float> scores,
@@ -223,7 +238,6 @@ class TensorsToDetectionsCalculator : public Node {
   int num_boxes_ = 0;
   int num_coords_ = 0;
   int max_results_ = -1;
-  int classes_per_detection_ = 1;
   BoxFormat box_output_format_ =
       mediapipe::TensorsToDetectionsCalculatorOptions::YXHW;
 
@@ -235,6 +249,10 @@ class TensorsToDetectionsCalculator : public Node {
   // Allowed or ignored class indices based on provided options or side packet.
   // These are used to filter out the output detection results.
   ClassIndexSet class_index_set_;
+  // Added to the raw scores to exclude the disallowed classes from the
+  // maximum: 0 for the allowed classes, and -infinity for the others. Empty
+  // when all the classes are allowed.
+  Eigen::RowVectorXf class_score_mask_;
 
   TensorsToDetectionsCalculatorOptions options_;
   bool scores_tensor_index_is_set_ = false;
@@ -260,6 +278,11 @@ class TensorsToDetectionsCalculator : public Node {
   bool gpu_input_ = false;
   bool gpu_has_enough_work_groups_ = true;
   bool anchors_init_ = false;
+
+  // Process() runs concurrently for different timestamps. The mutex guards the
+  // state initialized by the first invocations, and the GPU buffers shared by
+  // all invocations.
+  absl::Mutex mutex_;
 };
 MEDIAPIPE_REGISTER_NODE(TensorsToDetectionsCalculator);
 
@@ -293,51 +316,56 @@ absl::Status TensorsToDetectionsCalculator::Open(CalculatorContext* cc) {
 
 absl::Status TensorsToDetectionsCalculator::Process(CalculatorContext* cc) {
   auto output_detections = absl::make_unique<std::vector<Detection>>();
-  bool gpu_processing = false;
-  if (CanUseGpu() && gpu_has_enough_work_groups_) {
-    // Use GPU processing only if at least one input tensor is already on GPU
-    // (to avoid CPU->GPU overhead).
-    for (const auto& tensor : *kInTensors(cc)) {
-      if (tensor.ready_on_gpu()) {
-        gpu_processing = true;
-        break;
-      }
-    }
-  }
   const auto& input_tensors = *kInTensors(cc);
   for (const auto& tensor : input_tensors) {
     RET_CHECK(tensor.element_type() == Tensor::ElementType::kFloat32);
   }
   const int num_input_tensors = input_tensors.size();
-  if (!scores_tensor_index_is_set_) {
-    if (num_input_tensors == 2 ||
-        num_input_tensors == kNumInputTensorsWithAnchors) {
-      tensor_mapping_.set_scores_tensor_index(1);
-    } else {
-      tensor_mapping_.set_scores_tensor_index(2);
+  bool gpu_processing = false;
+  {
+    absl::MutexLock lock(&mutex_);
+    if (CanUseGpu() && gpu_has_enough_work_groups_) {
+      // Use GPU processing only if at least one input tensor is already on GPU
+      // (to avoid CPU->GPU overhead).
+      for (const auto& tensor : input_tensors) {
+        if (tensor.ready_on_gpu()) {
+          gpu_processing = true;
+          break;
+        }
+      }
+    }
+    if (!scores_tensor_index_is_set_) {
+      if (num_input_tensors == 2 ||
+          num_input_tensors == kNumInputTensorsWithAnchors) {
+        tensor_mapping_.set_scores_tensor_index(1);
+      } else {
+        tensor_mapping_.set_scores_tensor_index(2);
+      }
+      scores_tensor_index_is_set_ = true;
+    }
+    if (gpu_processing || num_input_tensors != 4) {
+      // Allows custom bounding box indices when receiving 4 cpu tensors.
+      // Uses the default bbox indices in other cases.
+      RET_CHECK(!has_custom_box_indices_);
     }
-    scores_tensor_index_is_set_ = true;
-  }
-  if (gpu_processing || num_input_tensors != 4) {
-    // Allows custom bounding box indices when receiving 4 cpu tensors.
-    // Uses the default bbox indices in other cases.
-    RET_CHECK(!has_custom_box_indices_);
-  }
 
-  if (gpu_processing && !gpu_inited_) {
-    auto status = GpuInit(cc);
-    if (status.ok()) {
-      gpu_inited_ = true;
-    } else if (status.code() == absl::StatusCode::kFailedPrecondition) {
-      // For initialization error because of hardware limitation, fallback to
-      // CPU processing.
-      ABSL_LOG(WARNING) << status.message();
-    } else {
-      // For other error, let the error propagates.
-      return status;
+    if (gpu_processing && !gpu_inited_) {
+      auto status = GpuInit(cc);
+      if (status.ok()) {
+        gpu_inited_ = true;
+      } else if (status.code() == absl::StatusCode::kFailedPrecondition) {
+        // For initialization error because of hardware limitation, fallback
+        // to CPU processing.
+        ABSL_LOG(WARNING) << status.message();
+      } else {
+        // For other error, let the error propagates.
+        return status;
+      }
     }
+    gpu_processing = gpu_processing && gpu_inited_;
   }
-  if (gpu_processing && gpu_inited_) {
+  if (gpu_processing) {
+    absl::MutexLock lock(&mutex_);
     MP_RETURN_IF_ERROR(ProcessGPU(cc, output_detections.get()));
   } else {
     MP_RETURN_IF_ERROR(ProcessCPU(cc, output_detections.get()));
@@ -399,61 +427,39 @@ absl::Status TensorsToDetectionsCalculator::ProcessCPU(
     auto raw_scores = raw_scores_view.buffer<float>();
 
     // TODO: Support other options to load anchors.
-    if (!anchors_init_) {
-      if (input_tensors.size() == kNumInputTensorsWithAnchors) {
-        auto anchor_tensor =
-            &input_tensors[tensor_mapping_.anchors_tensor_index()];
-        RET_CHECK_EQ(anchor_tensor->shape().dims.size(), 2);
-        RET_CHECK_EQ(anchor_tensor->shape().dims[0], num_boxes_);
-        RET_CHECK_EQ(anchor_tensor->shape().dims[1], kNumCoordsPerBox);
-        auto anchor_view = anchor_tensor->GetCpuReadView();
-        auto raw_anchors = anchor_view.buffer<float>();
-        ConvertRawValuesToAnchors(raw_anchors, num_boxes_, &anchors_);
-      } else if (!kInAnchors(cc).IsEmpty()) {
-        anchors_ = *kInAnchors(cc);
-      } else {
-        return absl::UnavailableError("No anchor data available.");
-      }
-      anchors_init_ = true;
-    }
-    std::vector<float> boxes(num_boxes_ * num_coords_);
-    MP_RETURN_IF_ERROR(DecodeBoxes(raw_boxes, anchors_, &boxes));
-
-    std::vector<float> detection_scores(num_boxes_);
-    std::vector<int> detection_classes(num_boxes_);
-
-    // Filter classes by scores.
-    for (int i = 0; i < num_boxes_; ++i) {
-      int class_id = -1;
-      float max_score = -std::numeric_limits<float>::max();
-      // Find the top score for box i.
-      for (int score_idx = 0; score_idx < num_classes_; ++score_idx) {
-        if (IsClassIndexAllowed(score_idx)) {
-          auto score = raw_scores[i * num_classes_ + score_idx];
-          if (options_.sigmoid_score()) {
-            if (options_.has_score_clipping_thresh()) {
-              score = score < -options_.score_clipping_thresh()
-                          ? -options_.score_clipping_thresh()
-                          : score;
-              score = score > options_.score_clipping_thresh()
-                          ? options_.score_clipping_thresh()
-                          : score;
-            }
-            score = 1.0f / (1.0f + std::exp(-score));
-          }
-          if (max_score < score) {
-            max_score = score;
-            class_id = score_idx;
-          }
+    {
+      absl::MutexLock lock(&mutex_);
+      if (!anchors_init_) {
+        if (input_tensors.size() == kNumInputTensorsWithAnchors) {
+          auto anchor_tensor =
+              &input_tensors[tensor_mapping_.anchors_tensor_index()];
+          RET_CHECK_EQ(anchor_tensor->shape().dims.size(), 2);
+          RET_CHECK_EQ(anchor_tensor->shape().dims[0], num_boxes_);
+          RET_CHECK_EQ(anchor_tensor->shape().dims[1], kNumCoordsPerBox);
+          auto anchor_view = anchor_tensor->GetCpuReadView();
+          auto raw_anchors = anchor_view.buffer<float>();
+          ConvertRawValuesToAnchors(raw_anchors, num_boxes_, &anchors_);
+        } else if (!kInAnchors(cc).IsEmpty()) {
+          anchors_ = *kInAnchors(cc);
+        } else {
+          return absl::UnavailableError("No anchor data available.");
         }
+        anchors_init_ = true;
       }
-      detection_scores[i] = max_score;
-      detection_classes[i] = class_id;
     }
-
-    MP_RETURN_IF_ERROR(
-        ConvertToDetections(boxes.data(), detection_scores.data(),
-                            detection_classes.data(), output_detections));
+    // Only the boxes that pass the score threshold are decoded and converted
+    // to detections.
+    std::vector<int> box_indices;
+    std::vector<float> detection_scores;
+    std::vector<int> detection_classes;
+    FilterBoxesByScore(raw_scores, &box_indices, &detection_scores,
+                       &detection_classes);
+    std::vector<float> boxes(box_indices.size() * num_coords_);
+    MP_RETURN_IF_ERROR(DecodeBoxes(raw_boxes, anchors_, box_indices, &boxes));
+
+    MP_RETURN_IF_ERROR(ConvertToDetections(
+        boxes.data(), detection_scores.data(), detection_classes.data(),
+        box_indices.size(), /*classes_per_detection=*/1, output_detections));
   } else {
     // Postprocessing on CPU with postprocessing op (e.g. anchor decoding and
     // non-maximum suppression) within the model.
@@ -483,18 +489,17 @@ absl::Status TensorsToDetectionsCalculator::ProcessCPU(
     RET_CHECK_EQ(detection_scores_tensor->shape().dims[1], max_detections);
 
     auto num_boxes_view = num_boxes_tensor->GetCpuReadView();
-    auto num_boxes = num_boxes_view.buffer<float>();
-    num_boxes_ = num_boxes[0];
+    const int num_boxes = num_boxes_view.buffer<float>()[0];
     // The detection model with Detection_PostProcess op may output duplicate
     // boxes with different classes, in the following format:
     //   num_boxes_tensor = [num_boxes]
     //   detection_classes_tensor = [box_1_class_1, box_1_class_2, ...]
     //   detection_scores_tensor = [box_1_score_1, box_1_score_2, ... ]
     //   detection_boxes_tensor = [box_1, box1, ... ]
-    // Each box repeats classes_per_detection_ times.
+    // Each box repeats classes_per_detection times.
     // Note Detection_PostProcess op is only supported in CPU.
-    RET_CHECK_EQ(max_detections % num_boxes_, 0);
-    classes_per_detection_ = max_detections / num_boxes_;
+    RET_CHECK_EQ(max_detections % num_boxes, 0);
+    const int classes_per_detection = max_detections / num_boxes;
 
     auto detection_boxes_view = detection_boxes_tensor->GetCpuReadView();
     auto detection_boxes = detection_boxes_view.buffer<float>();
@@ -504,13 +509,13 @@ absl::Status TensorsToDetectionsCalculator::ProcessCPU(
 
     auto detection_classes_view = detection_classes_tensor->GetCpuReadView();
     auto detection_classes_ptr = detection_classes_view.buffer<float>();
-    std::vector<int> detection_classes(num_boxes_ * classes_per_detection_);
+    std::vector<int> detection_classes(num_boxes * classes_per_detection);
     for (int i = 0; i < detection_classes.size(); ++i) {
       detection_classes[i] = static_cast<int>(detection_classes_ptr[i]);
     }
-    MP_RETURN_IF_ERROR(ConvertToDetections(detection_boxes, detection_scores,
-                                           detection_classes.data(),
-                                           output_detections));
+    MP_RETURN_IF_ERROR(ConvertToDetections(
+        detection_boxes, detection_scores, detection_classes.data(), num_boxes,
+        classes_per_detection, output_detections));
   }
   return absl::OkStatus();
 }
@@ -588,9 +593,9 @@ absl::Status TensorsToDetectionsCalculator::ProcessGPU(
   }
   auto decoded_boxes_view = decoded_boxes_buffer_->GetCpuReadView();
   auto boxes = decoded_boxes_view.buffer<float>();
-  MP_RETURN_IF_ERROR(ConvertToDetections(boxes, detection_scores.data(),
-                                         detection_classes.data(),
-                                         output_detections));
+  MP_RETURN_IF_ERROR(ConvertToDetections(
+      boxes, detection_scores.data(), detection_classes.data(), num_boxes_,
+      /*classes_per_detection=*/1, output_detections));
 #elif MEDIAPIPE_METAL_ENABLED
   if (!anchors_init_) {
     if (input_tensors.size() == kNumInputTensorsWithAnchors) {
@@ -675,9 +680,9 @@ absl::Status TensorsToDetectionsCalculator::ProcessGPU(
   }
   auto decoded_boxes_view = decoded_boxes_buffer_->GetCpuReadView();
   auto boxes = decoded_boxes_view.buffer<float>();
-  MP_RETURN_IF_ERROR(ConvertToDetections(boxes, detection_scores.data(),
-                                         detection_classes.data(),
-                                         output_detections));
+  MP_RETURN_IF_ERROR(ConvertToDetections(
+      boxes, detection_scores.data(), detection_classes.data(), num_boxes_,
+      /*classes_per_detection=*/1, output_detections));
 
 #else
   ABSL_LOG(ERROR) << "GPU input on non-Android not supported yet.";
@@ -749,6 +754,14 @@ absl::Status TensorsToDetectionsCalculator::LoadOptions(CalculatorContext* cc) {
       class_index_set_.values.insert(options_.ignore_classes(i));
     }
   }
+  if (!class_index_set_.values.empty()) {
+    class_score_mask_.resize(num_classes_);
+    for (int i = 0; i < num_classes_; ++i) {
+      class_score_mask_[i] = IsClassIndexAllowed(i)
+                                 ? 0.0f
+                                 : -std::numeric_limits<float>::infinity();
+    }
+  }
 
   if (options_.has_tensor_mapping()) {
     RET_CHECK_OK(CheckCustomTensorMapping(options_.tensor_mapping()));
@@ -784,10 +797,77 @@ absl::Status TensorsToDetectionsCalculator::LoadOptions(CalculatorContext* cc) {
   return absl::OkStatus();
 }
 
+void TensorsToDetectionsCalculator::FilterBoxesByScore(
+    const float* raw_scores, std::vector<int>* box_indices,
+    std::vector<float>* detection_scores,
+    std::vector<int>* detection_classes) {
+  const bool clip_scores =
+      options_.sigmoid_score() && options_.has_score_clipping_thresh();
+  const float clipping_thresh = options_.score_clipping_thresh();
+  auto clip = [&](float score) {
+    return clip_scores ? std::clamp(score, -clipping_thresh, clipping_thresh)
+                       : score;
+  };
+
+  // The maximum raw score of every box is computed with vectorized
+  // instructions. Clipping and sigmoid are monotonic, so they are applied to
+  // the maximum only, instead of to the score of every class.
+  using RowMajorMatrixXf =
+      Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+  const Eigen::Map<const RowMajorMatrixXf> scores(raw_scores, num_boxes_,
+                                                  num_classes_);
+  Eigen::VectorXf max_scores;
+  if (class_score_mask_.size() == 0) {
+    max_scores = scores.rowwise().maxCoeff();
+  } else {
+    max_scores = (scores.rowwise() + class_score_mask_).rowwise().maxCoeff();
+  }
+
+  for (int i = 0; i < num_boxes_; ++i) {
+    const float* box_scores = raw_scores + i * num_classes_;
+    const float max_score = clip(max_scores[i]);
+    // Finds the first class with the maximum score, like the comparison of
+    // the scores one by one would.
+    int class_id = -1;
+    float score = -std::numeric_limits<float>::max();
+    for (int score_idx = 0; score_idx < num_classes_; ++score_idx) {
+      if (clip(box_scores[score_idx]) == max_score &&
+          IsClassIndexAllowed(score_idx)) {
+        class_id = score_idx;
+        score = max_score;
+        break;
+      }
+    }
+    if (class_id == -1) {
+      // No allowed class, or NaN scores, which the vectorized maximum doesn't
+      // skip.
+      for (int score_idx = 0; score_idx < num_classes_; ++score_idx) {
+        const float class_score = clip(box_scores[score_idx]);
+        if (IsClassIndexAllowed(score_idx) && score < class_score) {
+          class_id = score_idx;
+          score = class_score;
+        }
+      }
+    }
+    if (class_id != -1 && options_.sigmoid_score()) {
+      score = 1.0f / (1.0f + std::exp(-score));
+    }
+    if (!IsClassIndexAllowed(class_id) ||
+        (options_.has_min_score_thresh() &&
+         score < options_.min_score_thresh())) {
+      continue;
+    }
+    box_indices->push_back(i);
+    detection_scores->push_back(score);
+    detection_classes->push_back(class_id);
+  }
+}
+
 absl::Status TensorsToDetectionsCalculator::DecodeBoxes(
     const float* raw_boxes, const std::vector<Anchor>& anchors,
-    std::vector<float>* boxes) {
-  for (int i = 0; i < num_boxes_; ++i) {
+    absl::Span<const int> box_indices, std::vector<float>* boxes) {
+  for (int j = 0; j < box_indices.size(); ++j) {
+    const int i = box_indices[j];
     const int box_offset = i * num_coords_ + options_.box_coord_offset();
 
     float y_center = 0.0;
@@ -834,15 +914,16 @@ absl::Status TensorsToDetectionsCalculator::DecodeBoxes(
     const float ymax = y_center + h / 2.f;
     const float xmax = x_center + w / 2.f;
 
-    (*boxes)[i * num_coords_ + 0] = ymin;
-    (*boxes)[i * num_coords_ + 1] = xmin;
-    (*boxes)[i * num_coords_ + 2] = ymax;
-    (*boxes)[i * num_coords_ + 3] = xmax;
+    (*boxes)[j * num_coords_ + 0] = ymin;
+    (*boxes)[j * num_coords_ + 1] = xmin;
+    (*boxes)[j * num_coords_ + 2] = ymax;
+    (*boxes)[j * num_coords_ + 3] = xmax;
 
     if (options_.num_keypoints()) {
       for (int k = 0; k < options_.num_keypoints(); ++k) {
-        const int offset = i * num_coords_ + options_.keypoint_coord_offset() +
-                           k * options_.num_values_per_keypoint();
+        const int keypoint_offset = options_.keypoint_coord_offset() +
+                                    k * options_.num_values_per_keypoint();
+        const int offset = i * num_coords_ + keypoint_offset;
 
         float keypoint_y = 0.0;
         float keypoint_x = 0.0;
@@ -859,9 +940,11 @@ absl::Status TensorsToDetectionsCalculator::DecodeBoxes(
             break;
         }
 
-        (*boxes)[offset] = keypoint_x / options_.x_scale() * anchors[i].w() +
-                           anchors[i].x_center();
-        (*boxes)[offset + 1] =
+        const int decoded_offset = j * num_coords_ + keypoint_offset;
+        (*boxes)[decoded_offset] =
+            keypoint_x / options_.x_scale() * anchors[i].w() +
+            anchors[i].x_center();
+        (*boxes)[decoded_offset + 1] =
             keypoint_y / options_.y_scale() * anchors[i].h() +
             anchors[i].y_center();
       }
@@ -873,9 +956,10 @@ absl::Status TensorsToDetectionsCalculator::DecodeBoxes(
 
 absl::Status TensorsToDetectionsCalculator::ConvertToDetections(
     const float* detection_boxes, const float* detection_scores,
-    const int* detection_classes, std::vector<Detection>* output_detections) {
-  for (int i = 0; i < num_boxes_ * classes_per_detection_;
-       i += classes_per_detection_) {
+    const int* detection_classes, int num_boxes, int classes_per_detection,
+    std::vector<Detection>* output_detections) {
+  for (int i = 0; i < num_boxes * classes_per_detection;
+       i += classes_per_detection) {
     if (max_results_ > 0 && output_detections->size() == max_results_) {
       break;
     }
@@ -885,8 +969,8 @@ absl::Status TensorsToDetectionsCalculator::ConvertToDetections(
         /*box_xmin=*/detection_boxes[box_offset + box_indices_[1]],
         /*box_ymax=*/detection_boxes[box_offset + box_indices_[2]],
         /*box_xmax=*/detection_boxes[box_offset + box_indices_[3]],
-        absl::MakeConstSpan(detection_scores + i, classes_per_detection_),
-        absl::MakeConstSpan(detection_classes + i, classes_per_detection_),
+        absl::MakeConstSpan(detection_scores + i, classes_per_detection),
+        absl::MakeConstSpan(detection_classes + i, classes_per_detection),
         options_.flip_vertically());
     // if all the scores and classes are filtered out, we skip the empty
     // detection.
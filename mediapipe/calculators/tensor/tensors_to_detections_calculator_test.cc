@@ -0,0 +1,179 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/substitute.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/formats/detection.pb.h"
+#include "mediapipe/framework/formats/location_data.pb.h"
+#include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::FloatNear;
+using ::testing::Pointwise;
+using Node = ::mediapipe::CalculatorGraphConfig::Node;
+
+constexpr int kNumBoxes = 3;
+constexpr int kNumClasses = 3;
+constexpr int kNumCoords = 6;
+
+// The raw boxes are offsets from the anchors, which are all centered in the
+// image, followed by one keypoint.
+constexpr float kRawBoxes[kNumBoxes * kNumCoords] = {
+    0.1f,  0.2f,  0.4f, 0.2f, 0.0f, 0.1f,   //
+    0.0f,  0.0f,  0.5f, 0.5f, 0.0f, 0.0f,   //
+    -0.1f, -0.2f, 0.2f, 0.4f, 0.1f, -0.1f,  //
+};
+constexpr float kRawScores[kNumBoxes * kNumClasses] = {
+    -2.0f, 3.0f,  1.0f,   //
+    -1.0f, -2.0f, -3.0f,  //
+    4.0f,  4.0f,  2.0f,   //
+};
+constexpr float kAnchors[kNumBoxes * 4] = {
+    0.5f, 0.5f, 1.0f, 1.0f,  //
+    0.5f, 0.5f, 1.0f, 1.0f,  //
+    0.5f, 0.5f, 1.0f, 1.0f,  //
+};
+
+float Sigmoid(float x) { return 1.0f / (1.0f + std::exp(-x)); }
+
+Tensor MakeTensor(const float* values, const Tensor::Shape& shape) {
+  Tensor tensor(Tensor::ElementType::kFloat32, shape);
+  auto view = tensor.GetCpuWriteView();
+  std::copy_n(values, shape.num_elements(), view.buffer<float>());
+  return tensor;
+}
+
+// Runs the calculator with the given extra options on the test tensors.
+std::vector<Detection> RunCalculator(const std::string& extra_options) {
+  CalculatorRunner runner(ParseTextProtoOrDie<Node>(absl::Substitute(
+      R"pb(
+        calculator: "TensorsToDetectionsCalculator"
+        input_stream: "TENSORS:tensors"
+        output_stream: "DETECTIONS:detections"
+        options {
+          [mediapipe.TensorsToDetectionsCalculatorOptions.ext] {
+            num_classes: $0
+            num_boxes: $1
+            num_coords: $2
+            num_keypoints: 1
+            keypoint_coord_offset: 4
+            x_scale: 1.0
+            y_scale: 1.0
+            w_scale: 1.0
+            h_scale: 1.0
+            sigmoid_score: true
+            min_score_thresh: 0.5
+            $3
+          }
+        }
+      )pb",
+      kNumClasses, kNumBoxes, kNumCoords, extra_options)));
+  auto tensors = std::make_unique<std::vector<Tensor>>();
+  tensors->push_back(MakeTensor(kRawBoxes, {1, kNumBoxes, kNumCoords}));
+  tensors->push_back(MakeTensor(kRawScores, {1, kNumBoxes, kNumClasses}));
+  tensors->push_back(MakeTensor(kAnchors, {kNumBoxes, 4}));
+  runner.MutableInputs()->Tag("TENSORS").packets.push_back(
+      Adopt(tensors.release()).At(Timestamp(0)));
+  MP_EXPECT_OK(runner.Run());
+  const auto& packets = runner.Outputs().Tag("DETECTIONS").packets;
+  if (packets.size() != 1) {
+    ADD_FAILURE() << "Expected one output packet, got " << packets.size();
+    return {};
+  }
+  return packets[0].Get<std::vector<Detection>>();
+}
+
+// Returns the box of the detection as {xmin, ymin, width, height}, followed by
+// its keypoint.
+std::vector<float> GetLocation(const Detection& detection) {
+  const LocationData& location_data = detection.location_data();
+  const auto& box = location_data.relative_bounding_box();
+  std::vector<float> location = {box.xmin(), box.ymin(), box.width(),
+                                 box.height()};
+  for (const auto& keypoint : location_data.relative_keypoints()) {
+    location.push_back(keypoint.x());
+    location.push_back(keypoint.y());
+  }
+  return location;
+}
+
+TEST(TensorsToDetectionsCalculatorTest, DecodesBoxesAboveScoreThreshold) {
+  const std::vector<Detection> detections = RunCalculator("");
+  ASSERT_EQ(detections.size(), 2);
+
+  EXPECT_THAT(detections[0].label_id(), ElementsAre(1));
+  EXPECT_THAT(detections[0].score(), ElementsAre(FloatNear(Sigmoid(3), 1e-6)));
+  EXPECT_THAT(GetLocation(detections[0]),
+              Pointwise(FloatNear(1e-6),
+                        std::vector<float>({0.6f, 0.4f, 0.2f, 0.4f, 0.6f,
+                                            0.5f})));
+
+  // The first class wins ties.
+  EXPECT_THAT(detections[1].label_id(), ElementsAre(0));
+  EXPECT_THAT(detections[1].score(), ElementsAre(FloatNear(Sigmoid(4), 1e-6)));
+  EXPECT_THAT(GetLocation(detections[1]),
+              Pointwise(FloatNear(1e-6),
+                        std::vector<float>({0.1f, 0.3f, 0.4f, 0.2f, 0.4f,
+                                            0.6f})));
+}
+
+TEST(TensorsToDetectionsCalculatorTest, IgnoresClasses) {
+  const std::vector<Detection> detections =
+      RunCalculator("ignore_classes: 1");
+  ASSERT_EQ(detections.size(), 2);
+  EXPECT_THAT(detections[0].label_id(), ElementsAre(2));
+  EXPECT_THAT(detections[0].score(), ElementsAre(FloatNear(Sigmoid(1), 1e-6)));
+  EXPECT_THAT(detections[1].label_id(), ElementsAre(0));
+}
+
+TEST(TensorsToDetectionsCalculatorTest, AllowsClasses) {
+  const std::vector<Detection> detections = RunCalculator("allow_classes: 2");
+  // The first and the last boxes score high enough in class 2.
+  ASSERT_EQ(detections.size(), 2);
+  EXPECT_THAT(detections[0].label_id(), ElementsAre(2));
+  EXPECT_THAT(detections[0].score(), ElementsAre(FloatNear(Sigmoid(1), 1e-6)));
+  EXPECT_THAT(detections[1].label_id(), ElementsAre(2));
+  EXPECT_THAT(detections[1].score(), ElementsAre(FloatNear(Sigmoid(2), 1e-6)));
+}
+
+TEST(TensorsToDetectionsCalculatorTest, ClipsScoresAndLimitsResults) {
+  const std::vector<Detection> clipped =
+      RunCalculator("score_clipping_thresh: 2.0");
+  ASSERT_EQ(clipped.size(), 2);
+  EXPECT_THAT(clipped[0].label_id(), ElementsAre(1));
+  EXPECT_THAT(clipped[0].score(), ElementsAre(FloatNear(Sigmoid(2), 1e-6)));
+  EXPECT_THAT(clipped[1].label_id(), ElementsAre(0));
+  EXPECT_THAT(clipped[1].score(), ElementsAre(FloatNear(Sigmoid(2), 1e-6)));
+
+  const std::vector<Detection> limited = RunCalculator("max_results: 1");
+  ASSERT_EQ(limited.size(), 1);
+  EXPECT_THAT(limited[0].label_id(), ElementsAre(1));
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -165,6 +165,7 @@ absl::Status DetectionsToRectsCalculator::GetContract(CalculatorContract* cc) {
   if (cc->Outputs().HasTag(kNormRectsTag)) {
     cc->Outputs().Tag(kNormRectsTag).Set<std::vector<NormalizedRect>>();
   }
+  cc->SetFusable(true);
 
   return absl::OkStatus();
 }
@@ -116,6 +116,7 @@ class LandmarkProjectionCalculator : public CalculatorBase {
          id != cc->Outputs().EndId(kLandmarksTag); ++id) {
       cc->Outputs().Get(id).Set<NormalizedLandmarkList>();
     }
+    cc->SetFusable(true);
 
     return absl::OkStatus();
   }
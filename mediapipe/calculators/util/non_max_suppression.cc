@@ -0,0 +1,316 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/util/non_max_suppression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace mediapipe {
+namespace nms {
+namespace {
+
+constexpr int kMaxCellsPerSide = 64;
+
+// Orders boxes by score, and then by decreasing index, so that the greatest
+// box is the first of the highest scored ones. NaN scores rank lowest.
+class ScoreLess {
+ public:
+  explicit ScoreLess(const std::vector<float>& scores) : scores_(scores) {}
+
+  bool operator()(int a, int b) const {
+    const float score_a = RankedScore(a);
+    const float score_b = RankedScore(b);
+    if (score_a != score_b) return score_a < score_b;
+    return a > b;
+  }
+
+ private:
+  float RankedScore(int i) const {
+    return std::isnan(scores_[i]) ? -std::numeric_limits<float>::infinity()
+                                  : scores_[i];
+  }
+
+  const std::vector<float>& scores_;
+};
+
+// Visits boxes by decreasing score without sorting them all up front, which
+// pays off when the suppression stops early.
+class ScoreHeap {
+ public:
+  ScoreHeap(const std::vector<float>& scores, std::vector<int> indices)
+      : less_(scores), indices_(std::move(indices)) {
+    std::make_heap(indices_.begin(), indices_.end(), less_);
+  }
+
+  bool empty() const { return indices_.empty(); }
+  int top() const { return indices_.front(); }
+  void pop() {
+    std::pop_heap(indices_.begin(), indices_.end(), less_);
+    indices_.pop_back();
+  }
+
+ private:
+  ScoreLess less_;
+  std::vector<int> indices_;
+};
+
+// A uniform grid over the extent of the boxes. Boxes are stored in all the
+// cells they cover, so that two boxes whose intersection has a positive area
+// always share a cell.
+class Grid {
+ public:
+  // Sizes the cells like the average box, so that boxes cover a few cells
+  // each. With "single_cell", all the boxes are neighbors of each other.
+  Grid(const Boxes& boxes, const std::vector<int>& indices, bool single_cell)
+      : boxes_(boxes) {
+    float xmin = std::numeric_limits<float>::infinity();
+    float ymin = std::numeric_limits<float>::infinity();
+    float xmax = -std::numeric_limits<float>::infinity();
+    float ymax = -std::numeric_limits<float>::infinity();
+    double total_width = 0.0;
+    double total_height = 0.0;
+    int num_sized = 0;
+    for (int i : indices) {
+      const float width = boxes.xmax[i] - boxes.xmin[i];
+      const float height = boxes.ymax[i] - boxes.ymin[i];
+      if (!std::isfinite(width) || !std::isfinite(height) || width < 0.0f ||
+          height < 0.0f) {
+        continue;
+      }
+      xmin = std::min(xmin, boxes.xmin[i]);
+      ymin = std::min(ymin, boxes.ymin[i]);
+      xmax = std::max(xmax, boxes.xmax[i]);
+      ymax = std::max(ymax, boxes.ymax[i]);
+      total_width += width;
+      total_height += height;
+      ++num_sized;
+    }
+    if (!single_cell && num_sized > 0) {
+      const int max_cells_per_side = std::clamp(
+          static_cast<int>(std::sqrt(static_cast<float>(indices.size()))), 1,
+          kMaxCellsPerSide);
+      num_x_ = NumCells(xmax - xmin, total_width / num_sized,
+                        max_cells_per_side);
+      num_y_ = NumCells(ymax - ymin, total_height / num_sized,
+                        max_cells_per_side);
+      origin_x_ = xmin;
+      origin_y_ = ymin;
+      if (num_x_ > 1) inverse_cell_width_ = num_x_ / (xmax - xmin);
+      if (num_y_ > 1) inverse_cell_height_ = num_y_ / (ymax - ymin);
+    }
+    cells_.resize(num_x_ * num_y_);
+  }
+
+  void Insert(int i) {
+    const CellRange range = GetCellRange(i);
+    for (int y = range.y0; y <= range.y1; ++y) {
+      for (int x = range.x0; x <= range.x1; ++x) {
+        cells_[y * num_x_ + x].push_back(i);
+      }
+    }
+  }
+
+  // Calls "fn" on the boxes sharing a cell with box "i", once per shared
+  // cell, until it returns true. Returns whether "fn" returned true.
+  template <typename Fn>
+  bool AnyNeighbor(int i, Fn fn) const {
+    const CellRange range = GetCellRange(i);
+    for (int y = range.y0; y <= range.y1; ++y) {
+      for (int x = range.x0; x <= range.x1; ++x) {
+        for (int neighbor : cells_[y * num_x_ + x]) {
+          if (fn(neighbor)) return true;
+        }
+      }
+    }
+    return false;
+  }
+
+ private:
+  struct CellRange {
+    int x0, y0, x1, y1;
+  };
+
+  static int NumCells(float extent, double average_size, int max_cells) {
+    const double num_cells = extent / average_size;
+    // Also handles zero-sized boxes, whose ratio is infinite or NaN.
+    if (!(num_cells > 1.0)) return 1;
+    return num_cells >= max_cells ? max_cells
+                                  : static_cast<int>(std::ceil(num_cells));
+  }
+
+  static int GetCell(float value, float origin, float inverse_cell_size,
+                     int num_cells) {
+    const float cell = (value - origin) * inverse_cell_size;
+    // Clamps out-of-range and NaN coordinates.
+    if (!(cell > 0.0f)) return 0;
+    return cell >= num_cells ? num_cells - 1 : static_cast<int>(cell);
+  }
+
+  CellRange GetCellRange(int i) const {
+    return {
+        GetCell(boxes_.xmin[i], origin_x_, inverse_cell_width_, num_x_),
+        GetCell(boxes_.ymin[i], origin_y_, inverse_cell_height_, num_y_),
+        GetCell(boxes_.xmax[i], origin_x_, inverse_cell_width_, num_x_),
+        GetCell(boxes_.ymax[i], origin_y_, inverse_cell_height_, num_y_),
+    };
+  }
+
+  const Boxes& boxes_;
+  int num_x_ = 1;
+  int num_y_ = 1;
+  float origin_x_ = 0.0f;
+  float origin_y_ = 0.0f;
+  float inverse_cell_width_ = 0.0f;
+  float inverse_cell_height_ = 0.0f;
+  std::vector<std::vector<int>> cells_;
+};
+
+float Area(const Boxes& boxes, int i) {
+  return (boxes.xmax[i] - boxes.xmin[i]) * (boxes.ymax[i] - boxes.ymin[i]);
+}
+
+}  // namespace
+
+void Boxes::Reserve(int num_boxes) {
+  xmin.reserve(num_boxes);
+  ymin.reserve(num_boxes);
+  xmax.reserve(num_boxes);
+  ymax.reserve(num_boxes);
+  score.reserve(num_boxes);
+}
+
+void Boxes::Add(float box_xmin, float box_ymin, float box_xmax,
+                float box_ymax, float box_score) {
+  xmin.push_back(box_xmin);
+  ymin.push_back(box_ymin);
+  xmax.push_back(box_xmax);
+  ymax.push_back(box_ymax);
+  score.push_back(box_score);
+}
+
+float OverlapSimilarity(OverlapType overlap_type, const Boxes& boxes, int i,
+                        int j) {
+  // Empty boxes don't intersect anything, while boxes touching along an edge
+  // do, with a zero area.
+  if (boxes.xmin[i] > boxes.xmax[i] || boxes.ymin[i] > boxes.ymax[i] ||
+      boxes.xmin[j] > boxes.xmax[j] || boxes.ymin[j] > boxes.ymax[j] ||
+      boxes.xmax[j] < boxes.xmin[i] || boxes.xmax[i] < boxes.xmin[j] ||
+      boxes.ymax[j] < boxes.ymin[i] || boxes.ymax[i] < boxes.ymin[j]) {
+    return 0.0f;
+  }
+  const float intersection_area =
+      (std::min(boxes.xmax[i], boxes.xmax[j]) -
+       std::max(boxes.xmin[i], boxes.xmin[j])) *
+      (std::min(boxes.ymax[i], boxes.ymax[j]) -
+       std::max(boxes.ymin[i], boxes.ymin[j]));
+  float normalization = 0.0f;
+  switch (overlap_type) {
+    case OverlapType::kJaccard:
+      normalization = (std::max(boxes.xmax[i], boxes.xmax[j]) -
+                       std::min(boxes.xmin[i], boxes.xmin[j])) *
+                      (std::max(boxes.ymax[i], boxes.ymax[j]) -
+                       std::min(boxes.ymin[i], boxes.ymin[j]));
+      break;
+    case OverlapType::kModifiedJaccard:
+      normalization = Area(boxes, j);
+      break;
+    case OverlapType::kIntersectionOverUnion:
+      normalization = Area(boxes, i) + Area(boxes, j) - intersection_area;
+      break;
+  }
+  return normalization > 0.0f ? intersection_area / normalization : 0.0f;
+}
+
+std::vector<int> NonMaxSuppression(const Boxes& boxes, const Options& options) {
+  std::vector<int> candidates;
+  candidates.reserve(boxes.size());
+  for (int i = 0; i < boxes.size(); ++i) {
+    if (options.min_score_threshold > 0 &&
+        boxes.score[i] < options.min_score_threshold) {
+      continue;
+    }
+    candidates.push_back(i);
+  }
+  // A negative threshold suppresses even the boxes that don't intersect.
+  Grid retained_grid(boxes, candidates,
+                     /*single_cell=*/options.min_suppression_threshold < 0);
+  ScoreHeap heap(boxes.score, std::move(candidates));
+
+  std::vector<int> retained;
+  while (!heap.empty() &&
+         (options.max_num_boxes < 0 ||
+          static_cast<int>(retained.size()) < options.max_num_boxes)) {
+    const int i = heap.top();
+    heap.pop();
+    const bool suppressed = retained_grid.AnyNeighbor(i, [&](int r) {
+      return OverlapSimilarity(options.overlap_type, boxes, r, i) >
+             options.min_suppression_threshold;
+    });
+    if (!suppressed) {
+      retained.push_back(i);
+      retained_grid.Insert(i);
+    }
+  }
+  return retained;
+}
+
+std::vector<Cluster> WeightedNonMaxSuppression(const Boxes& boxes,
+                                               const Options& options) {
+  std::vector<int> indices(boxes.size());
+  for (int i = 0; i < boxes.size(); ++i) indices[i] = i;
+  Grid grid(boxes, indices,
+            /*single_cell=*/options.min_suppression_threshold < 0);
+  for (int i : indices) grid.Insert(i);
+  ScoreHeap heap(boxes.score, std::move(indices));
+  const ScoreLess score_less(boxes.score);
+
+  std::vector<bool> removed(boxes.size(), false);
+  // The last iteration that visited each box, as boxes can share more than
+  // one cell with the top box.
+  std::vector<int> visited(boxes.size(), -1);
+  std::vector<Cluster> clusters;
+  for (int iteration = 0;; ++iteration) {
+    while (!heap.empty() && removed[heap.top()]) heap.pop();
+    if (heap.empty()) break;
+    const int top = heap.top();
+    if (options.min_score_threshold > 0 &&
+        boxes.score[top] < options.min_score_threshold) {
+      break;
+    }
+    Cluster cluster = {top, {}};
+    grid.AnyNeighbor(top, [&](int j) {
+      if (removed[j] || visited[j] == iteration) return false;
+      visited[j] = iteration;
+      if (OverlapSimilarity(options.overlap_type, boxes, j, top) >
+          options.min_suppression_threshold) {
+        cluster.members.push_back(j);
+      }
+      return false;
+    });
+    for (int member : cluster.members) removed[member] = true;
+    std::sort(cluster.members.begin(), cluster.members.end(),
+              [&](int a, int b) { return score_less(b, a); });
+    const bool done = cluster.members.empty();
+    clusters.push_back(std::move(cluster));
+    if (done) break;
+  }
+  return clusters;
+}
+
+}  // namespace nms
+}  // namespace mediapipe
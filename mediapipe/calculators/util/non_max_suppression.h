@@ -0,0 +1,88 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_CALCULATORS_UTIL_NON_MAX_SUPPRESSION_H_
+#define MEDIAPIPE_CALCULATORS_UTIL_NON_MAX_SUPPRESSION_H_
+
+#include <vector>
+
+namespace mediapipe {
+namespace nms {
+
+// Axis-aligned boxes and their scores, stored as one array per coordinate so
+// that the suppression loops don't touch Detection protos.
+struct Boxes {
+  std::vector<float> xmin;
+  std::vector<float> ymin;
+  std::vector<float> xmax;
+  std::vector<float> ymax;
+  std::vector<float> score;
+
+  int size() const { return score.size(); }
+  void Reserve(int num_boxes);
+  void Add(float box_xmin, float box_ymin, float box_xmax, float box_ymax,
+           float box_score);
+};
+
+enum class OverlapType {
+  // Intersection over the area of the smallest box containing both boxes.
+  kJaccard,
+  // Intersection over the area of the second box.
+  kModifiedJaccard,
+  // Intersection over the area of the union of both boxes.
+  kIntersectionOverUnion,
+};
+
+struct Options {
+  OverlapType overlap_type = OverlapType::kJaccard;
+  // A box is suppressed by a higher scored box when their overlap similarity
+  // is greater than this threshold.
+  float min_suppression_threshold = 1.0f;
+  // If positive, boxes scored below this threshold are dropped.
+  float min_score_threshold = -1.0f;
+  // Maximum number of boxes retained by NonMaxSuppression, or -1 for no
+  // limit. WeightedNonMaxSuppression ignores it.
+  int max_num_boxes = -1;
+};
+
+// Computes the overlap similarity between boxes "i" and "j".
+float OverlapSimilarity(OverlapType overlap_type, const Boxes& boxes, int i,
+                        int j);
+
+// Returns the indices of the boxes that are not suppressed by a higher scored
+// retained box, by decreasing score.
+//
+// Boxes are visited in score order through a heap, so that only the visited
+// ones are ordered, and are only compared against the retained boxes that
+// share a cell of a uniform grid with them.
+std::vector<int> NonMaxSuppression(const Boxes& boxes, const Options& options);
+
+// A box retained by WeightedNonMaxSuppression, and the boxes it suppressed,
+// whose locations are to be averaged into its own.
+struct Cluster {
+  int index;
+  // The boxes overlapping box "index", including box "index" itself unless it
+  // is degenerate, by decreasing score.
+  std::vector<int> members;
+};
+
+// Repeatedly takes the highest scored remaining box, and removes the remaining
+// boxes that overlap it. A cluster without members ends the suppression.
+std::vector<Cluster> WeightedNonMaxSuppression(const Boxes& boxes,
+                                               const Options& options);
+
+}  // namespace nms
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_CALCULATORS_UTIL_NON_MAX_SUPPRESSION_H_
@@ -0,0 +1,142 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Benchmark for non-maximum suppression.
+//
+// Suppresses 10k candidate boxes jittered around 500 objects, both with the
+// nms engine directly and through NonMaxSuppressionCalculator. The argument
+// selects the DEFAULT (0) or the WEIGHTED (1) algorithm.
+//
+// $ bazel run -c opt mediapipe/calculators/util:non_max_suppression_benchmark
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "absl/log/absl_check.h"
+#include "benchmark/benchmark.h"
+#include "mediapipe/calculators/util/non_max_suppression.h"
+#include "mediapipe/calculators/util/non_max_suppression_calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/detection.pb.h"
+#include "mediapipe/framework/formats/location_data.pb.h"
+#include "mediapipe/framework/packet.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr int kNumBoxes = 10000;
+constexpr int kNumObjects = 500;
+constexpr float kMinSuppressionThreshold = 0.3f;
+
+std::vector<Detection> MakeDetections() {
+  std::mt19937 rng(0 /*seed*/);
+  std::uniform_real_distribution<float> position(0.0f, 0.95f);
+  std::uniform_real_distribution<float> size(0.02f, 0.05f);
+  std::normal_distribution<float> jitter(0.0f, 0.005f);
+  std::uniform_real_distribution<float> score(0.0f, 1.0f);
+  std::vector<float> objects;
+  for (int i = 0; i < kNumObjects; ++i) {
+    objects.insert(objects.end(),
+                   {position(rng), position(rng), size(rng), size(rng)});
+  }
+
+  std::vector<Detection> detections(kNumBoxes);
+  for (int i = 0; i < kNumBoxes; ++i) {
+    const float* object = &objects[(i % kNumObjects) * 4];
+    Detection& detection = detections[i];
+    detection.add_score(score(rng));
+    detection.add_label_id(0);
+    LocationData* location_data = detection.mutable_location_data();
+    location_data->set_format(LocationData::RELATIVE_BOUNDING_BOX);
+    auto* box = location_data->mutable_relative_bounding_box();
+    box->set_xmin(object[0] + jitter(rng));
+    box->set_ymin(object[1] + jitter(rng));
+    box->set_width(object[2] + jitter(rng));
+    box->set_height(object[3] + jitter(rng));
+  }
+  return detections;
+}
+
+void BM_NonMaxSuppression(benchmark::State& state) {
+  const bool weighted = state.range(0);
+  nms::Boxes boxes;
+  for (const Detection& detection : MakeDetections()) {
+    const auto& box = detection.location_data().relative_bounding_box();
+    boxes.Add(box.xmin(), box.ymin(), box.xmin() + box.width(),
+              box.ymin() + box.height(), detection.score(0));
+  }
+  nms::Options options;
+  options.overlap_type = nms::OverlapType::kIntersectionOverUnion;
+  options.min_suppression_threshold = kMinSuppressionThreshold;
+
+  int num_retained = 0;
+  for (auto _ : state) {
+    if (weighted) {
+      num_retained = nms::WeightedNonMaxSuppression(boxes, options).size();
+    } else {
+      num_retained = nms::NonMaxSuppression(boxes, options).size();
+    }
+  }
+  state.counters["retained"] = num_retained;
+  state.SetItemsProcessed(state.iterations() * kNumBoxes);
+}
+BENCHMARK(BM_NonMaxSuppression)->Arg(0)->Arg(1);
+
+void BM_NonMaxSuppressionCalculator(benchmark::State& state) {
+  CalculatorGraphConfig config;
+  config.add_input_stream("detections");
+  auto* node = config.add_node();
+  node->set_calculator("NonMaxSuppressionCalculator");
+  node->add_input_stream("detections");
+  node->add_output_stream("suppressed_detections");
+  auto* options = node->mutable_options()->MutableExtension(
+      NonMaxSuppressionCalculatorOptions::ext);
+  options->set_overlap_type(
+      NonMaxSuppressionCalculatorOptions::INTERSECTION_OVER_UNION);
+  options->set_min_suppression_threshold(kMinSuppressionThreshold);
+  options->set_algorithm(state.range(0)
+                             ? NonMaxSuppressionCalculatorOptions::WEIGHTED
+                             : NonMaxSuppressionCalculatorOptions::DEFAULT);
+
+  CalculatorGraph graph;
+  ABSL_CHECK_OK(graph.Initialize(config));
+  int num_retained = 0;
+  ABSL_CHECK_OK(graph.ObserveOutputStream(
+      "suppressed_detections", [&](const Packet& p) {
+        num_retained = p.Get<std::vector<Detection>>().size();
+        return absl::OkStatus();
+      }));
+  ABSL_CHECK_OK(graph.StartRun({}));
+  const Packet packet = MakePacket<std::vector<Detection>>(MakeDetections());
+
+  int64_t timestamp = 0;
+  for (auto _ : state) {
+    ABSL_CHECK_OK(graph.AddPacketToInputStream(
+        "detections", packet.At(Timestamp(timestamp++))));
+    ABSL_CHECK_OK(graph.WaitUntilIdle());
+  }
+  state.counters["retained"] = num_retained;
+  state.SetItemsProcessed(state.iterations() * kNumBoxes);
+
+  ABSL_CHECK_OK(graph.CloseAllInputStreams());
+  ABSL_CHECK_OK(graph.WaitUntilDone());
+}
+// The graph runs the calculator on its own thread, so measure wall time.
+BENCHMARK(BM_NonMaxSuppressionCalculator)->Arg(0)->Arg(1)->UseRealTime();
+
+}  // namespace
+}  // namespace mediapipe
+
+BENCHMARK_MAIN();
@@ -0,0 +1,231 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/util/non_max_suppression.h"
+
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace nms {
+namespace {
+
+using ::testing::AllOf;
+using ::testing::ElementsAre;
+using ::testing::Field;
+using ::testing::FloatEq;
+using ::testing::IsEmpty;
+
+Boxes MakeRandomBoxes(int num_boxes, std::mt19937& rng) {
+  std::uniform_real_distribution<float> position(0.0f, 1.0f);
+  std::uniform_real_distribution<float> size(0.01f, 0.2f);
+  std::uniform_real_distribution<float> score(0.0f, 1.0f);
+  Boxes boxes;
+  for (int i = 0; i < num_boxes; ++i) {
+    const float xmin = position(rng);
+    const float ymin = position(rng);
+    boxes.Add(xmin, ymin, xmin + size(rng), ymin + size(rng), score(rng));
+  }
+  return boxes;
+}
+
+// Returns the boxes by decreasing score, ties broken by index.
+std::vector<int> SortByScore(const Boxes& boxes) {
+  std::vector<int> indices(boxes.size());
+  for (int i = 0; i < boxes.size(); ++i) indices[i] = i;
+  std::stable_sort(indices.begin(), indices.end(), [&](int a, int b) {
+    return boxes.score[a] > boxes.score[b];
+  });
+  return indices;
+}
+
+// Compares every box to every retained one.
+std::vector<int> BruteForceNonMaxSuppression(const Boxes& boxes,
+                                             const Options& options) {
+  std::vector<int> retained;
+  for (int i : SortByScore(boxes)) {
+    if (options.min_score_threshold > 0 &&
+        boxes.score[i] < options.min_score_threshold) {
+      break;
+    }
+    const bool suppressed =
+        std::any_of(retained.begin(), retained.end(), [&](int r) {
+          return OverlapSimilarity(options.overlap_type, boxes, r, i) >
+                 options.min_suppression_threshold;
+        });
+    if (!suppressed) retained.push_back(i);
+    if (options.max_num_boxes > 0 &&
+        static_cast<int>(retained.size()) >= options.max_num_boxes) {
+      break;
+    }
+  }
+  return retained;
+}
+
+// Compares the top box to every remaining one.
+std::vector<Cluster> BruteForceWeightedNonMaxSuppression(
+    const Boxes& boxes, const Options& options) {
+  std::vector<int> remaining = SortByScore(boxes);
+  std::vector<Cluster> clusters;
+  while (!remaining.empty()) {
+    const int top = remaining[0];
+    if (options.min_score_threshold > 0 &&
+        boxes.score[top] < options.min_score_threshold) {
+      break;
+    }
+    Cluster cluster = {top, {}};
+    std::vector<int> rest;
+    for (int i : remaining) {
+      if (OverlapSimilarity(options.overlap_type, boxes, i, top) >
+          options.min_suppression_threshold) {
+        cluster.members.push_back(i);
+      } else {
+        rest.push_back(i);
+      }
+    }
+    clusters.push_back(std::move(cluster));
+    if (rest.size() == remaining.size()) break;
+    remaining = std::move(rest);
+  }
+  return clusters;
+}
+
+TEST(NonMaxSuppressionTest, ComputesOverlapSimilarity) {
+  Boxes boxes;
+  boxes.Add(0.0f, 0.0f, 0.4f, 0.4f, 1.0f);
+  boxes.Add(0.2f, 0.2f, 0.4f, 0.6f, 1.0f);
+  boxes.Add(0.4f, 0.0f, 0.8f, 0.4f, 1.0f);
+  boxes.Add(0.5f, 0.5f, 0.4f, 0.6f, 1.0f);
+
+  // The intersection is 0.2 x 0.2, and the bounding box 0.4 x 0.6.
+  EXPECT_THAT(OverlapSimilarity(OverlapType::kJaccard, boxes, 0, 1),
+              FloatEq(0.04f / 0.24f));
+  EXPECT_THAT(OverlapSimilarity(OverlapType::kModifiedJaccard, boxes, 0, 1),
+              FloatEq(0.04f / 0.08f));
+  EXPECT_THAT(
+      OverlapSimilarity(OverlapType::kIntersectionOverUnion, boxes, 0, 1),
+      FloatEq(0.04f / (0.16f + 0.08f - 0.04f)));
+  // Boxes touching along an edge, and empty boxes, don't overlap.
+  EXPECT_EQ(OverlapSimilarity(OverlapType::kJaccard, boxes, 0, 2), 0.0f);
+  EXPECT_EQ(OverlapSimilarity(OverlapType::kJaccard, boxes, 1, 3), 0.0f);
+}
+
+TEST(NonMaxSuppressionTest, SuppressesOverlappingBoxes) {
+  Boxes boxes;
+  boxes.Add(0.0f, 0.0f, 0.5f, 0.5f, 0.6f);
+  boxes.Add(0.1f, 0.1f, 0.5f, 0.5f, 0.9f);
+  boxes.Add(0.5f, 0.5f, 1.0f, 1.0f, 0.3f);
+  boxes.Add(0.6f, 0.6f, 1.0f, 1.0f, 0.1f);
+
+  Options options;
+  options.min_suppression_threshold = 0.5f;
+  EXPECT_THAT(NonMaxSuppression(boxes, options), ElementsAre(1, 2));
+
+  options.max_num_boxes = 1;
+  EXPECT_THAT(NonMaxSuppression(boxes, options), ElementsAre(1));
+
+  options.max_num_boxes = -1;
+  options.min_score_threshold = 0.95f;
+  EXPECT_THAT(NonMaxSuppression(boxes, options), IsEmpty());
+}
+
+TEST(NonMaxSuppressionTest, NegativeThresholdSuppressesDisjointBoxes) {
+  Boxes boxes;
+  boxes.Add(0.0f, 0.0f, 0.1f, 0.1f, 0.5f);
+  boxes.Add(0.9f, 0.9f, 1.0f, 1.0f, 0.6f);
+
+  Options options;
+  options.min_suppression_threshold = -1.0f;
+  EXPECT_THAT(NonMaxSuppression(boxes, options), ElementsAre(1));
+}
+
+TEST(NonMaxSuppressionTest, MatchesBruteForce) {
+  std::mt19937 rng(0 /*seed*/);
+  for (const OverlapType overlap_type :
+       {OverlapType::kJaccard, OverlapType::kModifiedJaccard,
+        OverlapType::kIntersectionOverUnion}) {
+    for (const int num_boxes : {0, 1, 10, 1000}) {
+      const Boxes boxes = MakeRandomBoxes(num_boxes, rng);
+      for (const float min_score_threshold : {-1.0f, 0.5f}) {
+        Options options;
+        options.overlap_type = overlap_type;
+        options.min_suppression_threshold = 0.3f;
+        options.min_score_threshold = min_score_threshold;
+        EXPECT_EQ(NonMaxSuppression(boxes, options),
+                  BruteForceNonMaxSuppression(boxes, options));
+      }
+    }
+  }
+}
+
+TEST(WeightedNonMaxSuppressionTest, ClustersOverlappingBoxes) {
+  Boxes boxes;
+  boxes.Add(0.0f, 0.0f, 0.5f, 0.5f, 0.6f);
+  boxes.Add(0.1f, 0.1f, 0.5f, 0.5f, 0.9f);
+  boxes.Add(0.5f, 0.5f, 1.0f, 1.0f, 0.3f);
+
+  Options options;
+  options.min_suppression_threshold = 0.5f;
+  EXPECT_THAT(
+      WeightedNonMaxSuppression(boxes, options),
+      ElementsAre(
+          AllOf(Field(&Cluster::index, 1),
+                Field(&Cluster::members, ElementsAre(1, 0))),
+          AllOf(Field(&Cluster::index, 2),
+                Field(&Cluster::members, ElementsAre(2)))));
+}
+
+TEST(WeightedNonMaxSuppressionTest, StopsAtDegenerateBox) {
+  Boxes boxes;
+  boxes.Add(0.0f, 0.0f, 0.5f, 0.5f, 0.6f);
+  // A zero-sized box doesn't overlap itself.
+  boxes.Add(0.2f, 0.2f, 0.2f, 0.2f, 0.9f);
+
+  Options options;
+  options.min_suppression_threshold = 0.5f;
+  EXPECT_THAT(WeightedNonMaxSuppression(boxes, options),
+              ElementsAre(AllOf(Field(&Cluster::index, 1),
+                                Field(&Cluster::members, IsEmpty()))));
+}
+
+TEST(WeightedNonMaxSuppressionTest, MatchesBruteForce) {
+  std::mt19937 rng(0 /*seed*/);
+  for (const int num_boxes : {0, 1, 10, 1000}) {
+    const Boxes boxes = MakeRandomBoxes(num_boxes, rng);
+    for (const float min_suppression_threshold : {-1.0f, 0.3f}) {
+      Options options;
+      options.overlap_type = OverlapType::kIntersectionOverUnion;
+      options.min_suppression_threshold = min_suppression_threshold;
+      options.min_score_threshold = 0.2f;
+      const std::vector<Cluster> clusters =
+          WeightedNonMaxSuppression(boxes, options);
+      const std::vector<Cluster> expected =
+          BruteForceWeightedNonMaxSuppression(boxes, options);
+      ASSERT_EQ(clusters.size(), expected.size());
+      for (int i = 0; i < clusters.size(); ++i) {
+        EXPECT_EQ(clusters[i].index, expected[i].index);
+        EXPECT_EQ(clusters[i].members, expected[i].members);
+      }
+    }
+  }
+}
+
+}  // namespace
+}  // namespace nms
+}  // namespace mediapipe
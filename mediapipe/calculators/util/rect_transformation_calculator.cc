@@ -101,6 +101,7 @@ absl::Status RectTransformationCalculator::GetContract(CalculatorContract* cc) {
     cc->Inputs().Tag(kImageSizeTag).Set<std::pair<int, int>>();
     cc->Outputs().Index(0).Set<std::vector<NormalizedRect>>();
   }
+  cc->SetFusable(true);
 
   return absl::OkStatus();
 }
@@ -58,6 +58,21 @@ class TimestampChange {
   int64_t offset_;
 };
 
+// Declares the node stateless, so that it can process several timestamps
+// concurrently. See CalculatorContract::SetStateless.
+//
+// Example:
+//   MEDIAPIPE_NODE_CONTRACT(kIn, kOut, Stateless());
+class Stateless {
+ public:
+  constexpr Stateless() = default;
+
+  absl::Status AddToContract(CalculatorContract* cc) const {
+    cc->SetStateless(true);
+    return {};
+  }
+};
+
 namespace internal {
 
 template <class Base>
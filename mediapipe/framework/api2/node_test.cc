@@ -1,7 +1,9 @@
 #include "mediapipe/framework/api2/node.h"
 
+#include <memory>
 #include <tuple>
 #include <utility>
+#include <vector>
 
 #include "absl/log/absl_log.h"
 #include "mediapipe/framework/api2/packet.h"
@@ -15,6 +17,7 @@
 #include "mediapipe/framework/port/parse_text_proto.h"
 #include "mediapipe/framework/port/status_macros.h"
 #include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/tool/sink.h"
 
 namespace mediapipe {
 namespace api2 {
@@ -564,6 +567,66 @@ TEST(NodeTest, ConsumeInputs) {
   MP_EXPECT_OK(graph.WaitUntilDone());
 }
 
+// Increments its input, in place if it holds the only reference to it.
+struct InPlaceIncrementNode : public Node {
+  static constexpr Input<int> kIn{"IN"};
+  static constexpr Output<int> kOut{"OUT"};
+  static constexpr Output<bool> kInPlace{"IN_PLACE"};
+
+  MEDIAPIPE_NODE_CONTRACT(kIn, kOut, kInPlace);
+
+  absl::Status Process(CalculatorContext* cc) override {
+    MP_ASSIGN_OR_RETURN(std::unique_ptr<int> value,
+                        kIn(cc).ConsumeIfSoleOwner());
+    kInPlace(cc).Send(value != nullptr);
+    if (value == nullptr) {
+      value = std::make_unique<int>(*kIn(cc));
+    }
+    ++*value;
+    kOut(cc).Send(std::move(value));
+    return {};
+  }
+};
+MEDIAPIPE_REGISTER_NODE(InPlaceIncrementNode);
+
+TEST(NodeTest, ConsumeInputIfSoleOwner) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "in"
+        output_stream: "out"
+        output_stream: "in_place"
+        node {
+          calculator: "InPlaceIncrementNode"
+          input_stream: "IN:in"
+          output_stream: "OUT:out"
+          output_stream: "IN_PLACE:in_place"
+        }
+      )pb");
+  std::vector<mediapipe::Packet> out;
+  std::vector<mediapipe::Packet> in_place;
+  tool::AddVectorSink("out", &config, &out);
+  tool::AddVectorSink("in_place", &config, &in_place);
+  mediapipe::CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config, {}));
+  MP_ASSERT_OK(graph.StartRun({}));
+  // The graph holds the only reference to the first packet.
+  MP_ASSERT_OK(graph.AddPacketToInputStream(
+      "in", mediapipe::MakePacket<int>(10).At(Timestamp(0))));
+  // The second packet is shared with the test, so it must not be modified.
+  mediapipe::Packet shared = mediapipe::MakePacket<int>(20).At(Timestamp(1));
+  MP_ASSERT_OK(graph.AddPacketToInputStream("in", shared));
+  MP_ASSERT_OK(graph.CloseAllPacketSources());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  ASSERT_EQ(out.size(), 2);
+  EXPECT_EQ(out[0].Get<int>(), 11);
+  EXPECT_EQ(out[1].Get<int>(), 21);
+  ASSERT_EQ(in_place.size(), 2);
+  EXPECT_TRUE(in_place[0].Get<bool>());
+  EXPECT_FALSE(in_place[1].Get<bool>());
+  EXPECT_EQ(shared.Get<int>(), 20);
+}
+
 // Just to test that single-port contracts work.
 struct LogSinkNode : public Node {
   static constexpr Input<int> kIn{"IN"};
@@ -82,6 +82,19 @@ class PacketBase {
     return result;
   }
 
+  // Consumes the payload if this packet is its sole owner, and otherwise
+  // returns nullptr and leaves the packet unchanged. See
+  // mediapipe::Packet::ConsumeIfSoleOwner.
+  template <typename T>
+  absl::StatusOr<std::unique_ptr<T>> ConsumeIfSoleOwner() {
+    mediapipe::Packet old =
+        packet_internal::Create(std::move(payload_), timestamp_);
+    auto result = old.ConsumeIfSoleOwner<T>();
+    if (!result.ok() || *result == nullptr)
+      payload_ = packet_internal::GetHolderShared(std::move(old));
+    return result;
+  }
+
  protected:
   explicit PacketBase(std::shared_ptr<HolderBase> payload)
       : payload_(std::move(payload)) {}
@@ -233,6 +246,10 @@ class Packet : public Packet<internal::Generic> {
     return PacketBase::Consume<T>();
   }
 
+  absl::StatusOr<std::unique_ptr<T>> ConsumeIfSoleOwner() {
+    return PacketBase::ConsumeIfSoleOwner<T>();
+  }
+
  private:
   explicit Packet(std::shared_ptr<HolderBase> payload)
       : Packet<internal::Generic>(std::move(payload)) {}
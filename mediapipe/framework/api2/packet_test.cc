@@ -233,6 +233,24 @@ TEST(PacketTest, Consume) {
   EXPECT_FALSE(p2.IsEmpty());
 }
 
+TEST(PacketTest, ConsumeIfSoleOwner) {
+  auto p = MakePacket<int>(7);
+  auto maybe_int = p.ConsumeIfSoleOwner();
+  EXPECT_TRUE(p.IsEmpty());
+  ASSERT_TRUE(maybe_int.ok());
+  ASSERT_NE(maybe_int.value(), nullptr);
+  EXPECT_EQ(*maybe_int.value(), 7);
+
+  p = MakePacket<int>(3);
+  auto p2 = p;
+  maybe_int = p.ConsumeIfSoleOwner();
+  ASSERT_TRUE(maybe_int.ok());
+  EXPECT_EQ(maybe_int.value(), nullptr);
+  EXPECT_FALSE(p.IsEmpty());
+  EXPECT_EQ(p.Get(), 3);
+  EXPECT_FALSE(p2.IsEmpty());
+}
+
 TEST(PacketTest, OneOfConsume) {
   Packet<OneOf<std::string, int>> p = MakePacket<std::string>("hi");
   EXPECT_TRUE(p.Has<std::string>());
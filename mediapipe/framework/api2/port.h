@@ -626,6 +626,21 @@ class InputShardAccess : public Packet<T> {
     return WrapConsumeCall(f, std::forward<F>(args)...);
   }
 
+  // Consumes the payload if the calculator holds its only reference, and
+  // otherwise returns nullptr, for copy-on-write. See
+  // mediapipe::Packet::ConsumeIfSoleOwner.
+  template <class U = T,
+            class = std::enable_if_t<std::is_same<U, T>{},
+                                     decltype(&Packet<U>::ConsumeIfSoleOwner)>>
+  absl::StatusOr<std::unique_ptr<U>> ConsumeIfSoleOwner() {
+    stream_->Value() = {};
+    auto result = Packet<T>::ConsumeIfSoleOwner();
+    if (!result.ok() || *result == nullptr) {
+      stream_->Value() = ToOldPacket(*this);
+    }
+    return result;
+  }
+
  private:
   InputShardAccess(const CalculatorContext&, InputStreamShard* stream)
       : Packet<T>(stream ? FromOldPacket(stream->Value()).template As<T>()
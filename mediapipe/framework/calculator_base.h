@@ -157,6 +157,14 @@ class CalculatorBase {
   // documentation for the suggested solution.
   virtual absl::Status Close(CalculatorContext* cc) { return absl::OkStatus(); }
 
+  // Is called instead of Open() when a calculator marked resettable
+  // (CalculatorContract::SetResettable) starts another graph run, after its
+  // previous run ended successfully with Close(). Subclasses should clear the
+  // state of the previous run, keep the resources loaded in Open(), and redo
+  // the per-run setup of Open(), such as setting output stream headers and
+  // timestamp offsets. Failures are handled as for Open().
+  virtual absl::Status Reset(CalculatorContext* cc) { return absl::OkStatus(); }
+
   // Returns a value according to which the framework selects
   // the next source calculator to Process(); smaller value means
   // Process() first. The default implementation returns the smallest
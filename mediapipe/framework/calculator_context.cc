@@ -14,7 +14,12 @@
 
 #include "mediapipe/framework/calculator_context.h"
 
+#include <memory>
+#include <string>
+
 #include "absl/log/absl_check.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 
 namespace mediapipe {
 
@@ -38,6 +43,16 @@ int CalculatorContext::NodeId() const {
   return calculator_state_->NodeId();
 }
 
+absl::Time CalculatorContext::Deadline() const {
+  const std::shared_ptr<DeadlineTracker>& tracker = GetDeadlineTracker();
+  return tracker ? tracker->Deadline(InputTimestamp()) : absl::InfiniteFuture();
+}
+
+bool CalculatorContext::DeadlineExceeded() const {
+  const std::shared_ptr<DeadlineTracker>& tracker = GetDeadlineTracker();
+  return tracker && tracker->IsStale(InputTimestamp(), absl::Now());
+}
+
 Counter* CalculatorContext::GetCounter(const std::string& name) {
   ABSL_CHECK(calculator_state_);
   return calculator_state_->GetCounter(name);
@@ -21,8 +21,10 @@
 #include <utility>
 
 #include "absl/log/absl_check.h"
+#include "absl/time/time.h"
 #include "mediapipe/framework/calculator_state.h"
 #include "mediapipe/framework/counter.h"
+#include "mediapipe/framework/deadline_tracker.h"
 #include "mediapipe/framework/graph_service.h"
 #include "mediapipe/framework/input_stream_shard.h"
 #include "mediapipe/framework/output_stream_shard.h"
@@ -84,6 +86,26 @@ class CalculatorContext {
   // No prefix is added to counters created in this way.
   CounterFactory* GetCounterFactory();
 
+  // Returns the packet arena of the current graph run, to be passed to
+  // MakePacketInArena(). Null unless the graph config sets use_packet_arena.
+  const std::shared_ptr<PacketArena>& GetPacketArena() const {
+    return calculator_state_->GetPacketArena();
+  }
+
+  // Returns the deadline tracker of the current graph run, or null if the
+  // graph config doesn't set latency_budget_usec.
+  const std::shared_ptr<DeadlineTracker>& GetDeadlineTracker() const {
+    return calculator_state_->GetDeadlineTracker();
+  }
+
+  // Returns the deadline of the current input timestamp, after which the
+  // output is stale, or absl::InfiniteFuture() if the graph has no latency
+  // budget. Calculators doing long work can use it to stop early.
+  absl::Time Deadline() const;
+
+  // Returns true if the deadline of the current input timestamp has passed.
+  bool DeadlineExceeded() const;
+
   // Returns the current input timestamp, or Timestamp::Unset if there are
   // no input packets.
   Timestamp InputTimestamp() const {
@@ -91,6 +113,19 @@ class CalculatorContext {
                                      : input_timestamps_.front();
   }
 
+  // Returns false if Process() will be called for more input sets of the same
+  // batch right after the current one. Input sets are only batched by input
+  // stream handlers with a batch size greater than 1, see e.g.
+  // BatchingInputStreamHandler. Calculators can use this to process a batch
+  // as a whole, e.g. to run inference on all its input sets at once.
+  bool IsLastInBatch() const {
+    // The last input set of a batch scheduled for Close() is followed by
+    // Timestamp::Done().
+    return input_timestamps_.size() <= 1 ||
+           (input_timestamps_.size() == 2 &&
+            input_timestamps_.back() == Timestamp::Done());
+  }
+
   // Returns a reference to the input side packet set.
   const PacketSet& InputSidePackets() const;
   // Returns a reference to the output side packet collection.
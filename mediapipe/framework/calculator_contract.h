@@ -138,6 +138,42 @@ class CalculatorContract {
   void SetTimestampOffset(TimestampDiff offset) { timestamp_offset_ = offset; }
   TimestampDiff GetTimestampOffset() const { return timestamp_offset_; }
 
+  // Marks the calculator as fusable: Process() only outputs packets at the
+  // input timestamp, and the calculator neither uses stream headers nor relies
+  // on running in its own node. When the graph enables
+  // fuse_calculator_chains, chains of fusable calculators are run back to back
+  // in a single node. See mediapipe/framework/tool/graph_fusion.h.
+  void SetFusable(bool fusable) { fusable_ = fusable; }
+  bool IsFusable() const { return fusable_; }
+
+  // Marks the calculator as resettable: after a successful graph run, the
+  // calculator is kept for the next run of the graph, and CalculatorBase::Reset
+  // is called on it instead of Open(). This avoids reloading expensive
+  // resources, such as models, at every run. See
+  // mediapipe/framework/graph_pool.h.
+  void SetResettable(bool resettable) { resettable_ = resettable; }
+  bool IsResettable() const { return resettable_; }
+
+  // When true, Process is also called for stale timestamps, whose deadline
+  // set by the latency budget of the graph has passed (see
+  // CalculatorGraphConfig::latency_budget_usec). By default, Process is
+  // skipped for them. Calculators that must see every timestamp, e.g. to
+  // count the packets in flight, should set this.
+  void SetProcessStaleTimestamps(bool process_stale_timestamps) {
+    process_stale_timestamps_ = process_stale_timestamps;
+  }
+  bool GetProcessStaleTimestamps() const { return process_stale_timestamps_; }
+
+  // Marks the calculator as stateless: Process() neither depends on nor
+  // modifies state kept between timestamps, and can be called concurrently for
+  // different timestamps. Unless the node sets max_in_flight, a node of a
+  // stateless calculator then runs up to one invocation per CPU core at a
+  // time, and its output packets are still sent in timestamp order. This
+  // applies to nodes with input streams that use the default input and output
+  // stream handlers and don't process timestamp bounds.
+  void SetStateless(bool stateless) { stateless_ = stateless; }
+  bool IsStateless() const { return stateless_; }
+
   class GraphServiceRequest {
    public:
     // APIs that should be used by calculators.
@@ -210,6 +246,10 @@ class CalculatorContract {
   ServiceReqMap service_requests_;
   bool process_timestamps_ = false;
   TimestampDiff timestamp_offset_ = TimestampDiff::Unset();
+  bool fusable_ = false;
+  bool resettable_ = false;
+  bool process_stale_timestamps_ = false;
+  bool stateless_ = false;
 
   friend class CalculatorNode;
 };
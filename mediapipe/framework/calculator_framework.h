@@ -61,6 +61,7 @@
 #include "mediapipe/framework/output_side_packet.h"
 #include "mediapipe/framework/output_stream.h"
 #include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/packet_arena.h"
 #include "mediapipe/framework/packet_generator.h"
 #include "mediapipe/framework/packet_generator_graph.h"
 #include "mediapipe/framework/packet_set.h"
@@ -37,15 +37,21 @@
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_base.h"
+#include "mediapipe/framework/counter.h"
 #include "mediapipe/framework/counter_factory.h"
 #include "mediapipe/framework/delegating_executor.h"
 #include "mediapipe/framework/executor.h"
+#include "mediapipe/framework/formats/cpu_buffer_pool.h"
 #include "mediapipe/framework/graph_output_stream.h"
 #include "mediapipe/framework/graph_service_manager.h"
 #include "mediapipe/framework/input_stream_manager.h"
 #include "mediapipe/framework/mediapipe_profiling.h"
+#include "mediapipe/framework/memory_manager.h"
+#include "mediapipe/framework/memory_manager_service.h"
 #include "mediapipe/framework/output_side_packet_impl.h"
 #include "mediapipe/framework/output_stream_manager.h"
 #include "mediapipe/framework/output_stream_poller.h"
@@ -70,7 +76,9 @@
 #include "mediapipe/framework/thread_pool_executor.h"
 #include "mediapipe/framework/thread_pool_executor.pb.h"
 #include "mediapipe/framework/timestamp.h"
+#include "mediapipe/framework/tool/critical_path.h"
 #include "mediapipe/framework/tool/fill_packet_set.h"
+#include "mediapipe/framework/tool/graph_fusion.h"
 #include "mediapipe/framework/tool/status_util.h"
 #include "mediapipe/framework/tool/tag_map.h"
 #include "mediapipe/framework/tool/validate.h"
@@ -89,6 +97,12 @@ namespace {
 constexpr int kMaxNumAccumulatedErrors = 1000;
 constexpr char kApplicationThreadExecutorType[] = "ApplicationThreadExecutor";
 
+// How often the CRITICAL_PATH scheduling policy updates the node priorities
+// from the profiles while the graph runs. Computing them reads the profiles
+// of all nodes, so the updates are rate limited.
+constexpr absl::Duration kNodePrioritiesUpdateInterval =
+    absl::Milliseconds(100);
+
 // Do not log status payloads, but do include stack traces.
 constexpr absl::StatusToStringMode kStatusLogFlags =
     absl::StatusToStringMode::kWithEverything &
@@ -151,6 +165,11 @@ CalculatorGraph::~CalculatorGraph() {
   if (!status.ok()) {
     ABSL_LOG(ERROR) << "During graph destruction: " << status;
   }
+  // Resettable calculators kept from the last run may use graph services,
+  // which are destroyed before the nodes.
+  for (auto& node : nodes_) {
+    node->ReleaseCalculator();
+  }
 }
 
 absl::Status CalculatorGraph::InitializePacketGeneratorGraph(
@@ -244,10 +263,14 @@ absl::Status CalculatorGraph::InitializeStreams() {
 
 // Hack for backwards compatibility with ancient GPU calculators. Can it
 // be retired yet?
-static void MaybeFixupLegacyGpuNodeContract(CalculatorNode& node) {
+// The contract is only modified once, so that graphs sharing a CompiledGraph
+// (which has already been fixed up) only read it.
+static void MaybeFixupLegacyGpuNodeContract(
+    const CalculatorContract& contract) {
 #if !MEDIAPIPE_DISABLE_GPU
-  if (node.Contract().InputSidePackets().HasTag(kGpuSharedTagName)) {
-    const_cast<CalculatorContract&>(node.Contract()).UseService(kGpuService);
+  if (contract.InputSidePackets().HasTag(kGpuSharedTagName) &&
+      contract.ServiceRequests().count(kGpuService.key) == 0) {
+    const_cast<CalculatorContract&>(contract).UseService(kGpuService);
   }
 #endif  // !MEDIAPIPE_DISABLE_GPU
 }
@@ -272,7 +295,7 @@ absl::Status CalculatorGraph::InitializeCalculatorNodes() {
         validated_graph_.get(), node_ref, input_stream_managers_.get(),
         output_stream_managers_.get(), output_side_packets_.get(),
         &buffer_size_hint, profiler_);
-    MaybeFixupLegacyGpuNodeContract(*nodes_.back());
+    MaybeFixupLegacyGpuNodeContract(nodes_.back()->Contract());
     if (buffer_size_hint > 0) {
       max_queue_size_ = std::max(max_queue_size_, buffer_size_hint);
     }
@@ -310,7 +333,7 @@ absl::Status CalculatorGraph::InitializePacketGeneratorNodes(
         validated_graph_.get(), node_ref, input_stream_managers_.get(),
         output_stream_managers_.get(), output_side_packets_.get(),
         &buffer_size_hint, profiler_);
-    MaybeFixupLegacyGpuNodeContract(*nodes_.back());
+    MaybeFixupLegacyGpuNodeContract(nodes_.back()->Contract());
     if (!result.ok()) {
       // Collect as many errors as we can before failing.
       errors.push_back(result);
@@ -427,13 +450,87 @@ absl::Status CalculatorGraph::InitializeDefaultExecutor(
   return absl::OkStatus();
 }
 
+// Replaces the validated graph by one in which chains of fusable nodes are
+// fused, if enabled by CalculatorGraphConfig::fuse_calculator_chains.
+static absl::Status FuseCalculatorChains(
+    std::unique_ptr<ValidatedGraphConfig>* validated_graph,
+    const GraphServiceManager* service_manager) {
+  if (!(*validated_graph)->Config().fuse_calculator_chains()) {
+    return absl::OkStatus();
+  }
+  CalculatorGraphConfig fused_config;
+  if (!tool::FuseCalculatorChains(**validated_graph, &fused_config)) {
+    return absl::OkStatus();
+  }
+  auto fused_graph = absl::make_unique<ValidatedGraphConfig>();
+  MP_RETURN_IF_ERROR(fused_graph->Initialize(
+      std::move(fused_config), /*graph_registry=*/nullptr,
+      /*graph_options=*/nullptr, service_manager))
+      << "Failed to validate the fused graph.";
+  *validated_graph = std::move(fused_graph);
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::shared_ptr<const CompiledGraph>> CompiledGraph::Create(
+    CalculatorGraphConfig config) {
+  auto validated_graph = absl::make_unique<ValidatedGraphConfig>();
+  MP_RETURN_IF_ERROR(validated_graph->Initialize(std::move(config)));
+  return Create(std::move(validated_graph));
+}
+
+absl::StatusOr<std::shared_ptr<const CompiledGraph>> CompiledGraph::Create(
+    const std::vector<CalculatorGraphConfig>& configs,
+    const std::vector<CalculatorGraphTemplate>& templates,
+    const std::string& graph_type, const Subgraph::SubgraphOptions* options) {
+  auto validated_graph = absl::make_unique<ValidatedGraphConfig>();
+  MP_RETURN_IF_ERROR(
+      validated_graph->Initialize(configs, templates, graph_type, options));
+  return Create(std::move(validated_graph));
+}
+
+absl::StatusOr<std::shared_ptr<const CompiledGraph>> CompiledGraph::Create(
+    std::unique_ptr<ValidatedGraphConfig> validated_graph) {
+  MP_RETURN_IF_ERROR(FuseCalculatorChains(&validated_graph,
+                                          /*service_manager=*/nullptr));
+  // Fix up the contracts now, before the graph is shared.
+  for (const NodeTypeInfo& info : validated_graph->CalculatorInfos()) {
+    MaybeFixupLegacyGpuNodeContract(info.Contract());
+  }
+  for (const NodeTypeInfo& info : validated_graph->GeneratorInfos()) {
+    MaybeFixupLegacyGpuNodeContract(info.Contract());
+  }
+  return std::shared_ptr<const CompiledGraph>(
+      new CompiledGraph(std::move(validated_graph)));
+}
+
 absl::Status CalculatorGraph::Initialize(
     std::unique_ptr<ValidatedGraphConfig> validated_graph,
     const std::map<std::string, Packet>& side_packets) {
-  RET_CHECK(!initialized_).SetNoLogging()
-      << "CalculatorGraph can be initialized only once.";
   RET_CHECK(validated_graph->Initialized()).SetNoLogging()
       << "validated_graph is not initialized.";
+  MP_RETURN_IF_ERROR(
+      FuseCalculatorChains(&validated_graph, &service_manager_));
+  return InitializeValidatedGraph(std::move(validated_graph), side_packets);
+}
+
+absl::Status CalculatorGraph::Initialize(
+    std::shared_ptr<const CompiledGraph> compiled_graph,
+    const std::map<std::string, Packet>& side_packets) {
+  RET_CHECK(compiled_graph != nullptr);
+  // Shares the ownership of the compiled graph.
+  const ValidatedGraphConfig* validated_graph =
+      compiled_graph->validated_graph_.get();
+  return InitializeValidatedGraph(
+      std::shared_ptr<const ValidatedGraphConfig>(std::move(compiled_graph),
+                                                  validated_graph),
+      side_packets);
+}
+
+absl::Status CalculatorGraph::InitializeValidatedGraph(
+    std::shared_ptr<const ValidatedGraphConfig> validated_graph,
+    const std::map<std::string, Packet>& side_packets) {
+  RET_CHECK(!initialized_).SetNoLogging()
+      << "CalculatorGraph can be initialized only once.";
   validated_graph_ = std::move(validated_graph);
 
   MP_RETURN_IF_ERROR(InitializeExecutors());
@@ -760,6 +857,25 @@ absl::Status CalculatorGraph::PrepareForRun(
     RET_CHECK(default_executor);
   }
   scheduler_.Reset();
+  scheduler_.SetNumNodes(nodes_.size());
+  if (validated_graph_->Config().scheduling_policy() ==
+      CalculatorGraphConfig::CRITICAL_PATH) {
+    {
+      absl::MutexLock lock(&node_priorities_mutex_);
+      node_priorities_update_time_ = absl::InfinitePast();
+    }
+    UpdateNodePriorities();
+    // Without the profiler, the node costs can't change during the run.
+    scheduler_.SetUpdateNodePrioritiesWhenIdle(
+        validated_graph_->Config().profiler_config().enable_profiler());
+  }
+  if (validated_graph_->Config().use_packet_arena()) {
+    packet_arena_ = std::make_shared<PacketArena>();
+  }
+  if (validated_graph_->Config().latency_budget_usec() > 0) {
+    deadline_tracker_ = std::make_shared<DeadlineTracker>(
+        absl::Microseconds(validated_graph_->Config().latency_budget_usec()));
+  }
 
   MP_RETURN_IF_ERROR(InitializePacketGeneratorNodes(non_scheduled_generators));
 
@@ -773,7 +889,16 @@ absl::Status CalculatorGraph::PrepareForRun(
     full_input_streams_.clear();
     full_input_streams_.resize(validated_graph_->CalculatorInfos().size() +
                                graph_input_streams_.size());
+    graph_queue_bytes_full_ = false;
   }
+  const CalculatorGraphConfig& config = validated_graph_->Config();
+  account_queue_bytes_ = config.max_queue_bytes() > 0 ||
+                         config.max_graph_queue_bytes() > 0 ||
+                         !graph_input_stream_max_queue_bytes_.empty();
+  graph_queue_bytes_ = 0;
+  peak_graph_queue_bytes_ = 0;
+  max_graph_queue_bytes_ =
+      config.max_graph_queue_bytes() > 0 ? config.max_graph_queue_bytes() : -1;
 
   for (auto& item : graph_input_streams_) {
     item.second->PrepareForRun(
@@ -789,7 +914,14 @@ absl::Status CalculatorGraph::PrepareForRun(
         std::bind(&CalculatorGraph::UpdateThrottledNodes, this,
                   std::placeholders::_1, std::placeholders::_2);
     node->SetQueueSizeCallbacks(queue_size_callback, queue_size_callback);
+    if (account_queue_bytes_) {
+      node->EnableInputStreamByteAccounting(
+          [this](int64_t delta) { UpdateGraphQueueBytes(delta); });
+    }
     scheduler_.AssignNodeToSchedulerQueue(node.get());
+    node->SetReportCpuMigrations(ReportsCpuMigrations(node->Executor()));
+    node->SetPacketArena(packet_arena_);
+    node->SetDeadlineTracker(deadline_tracker_);
     // TODO: update calculator node to use GraphServiceManager
     // instead of service packets?
     const absl::Status result = node->PrepareForRun(
@@ -829,6 +961,10 @@ absl::Status CalculatorGraph::PrepareForRun(
   // streams.
   for (auto& node : nodes_) {
     node->SetMaxInputStreamQueueSize(max_queue_size_);
+    if (account_queue_bytes_) {
+      node->SetMaxInputStreamQueueByteSize(
+          config.max_queue_bytes() > 0 ? config.max_queue_bytes() : -1);
+    }
   }
 
   // Allow graph input streams to override the global max queue size.
@@ -841,6 +977,15 @@ absl::Status CalculatorGraph::PrepareForRun(
         name_max.first);
     (*stream)->SetMaxQueueSize(name_max.second);
   }
+  for (const auto& name_max : graph_input_stream_max_queue_bytes_) {
+    std::unique_ptr<GraphInputStream>* stream =
+        mediapipe::FindOrNull(graph_input_streams_, name_max.first);
+    RET_CHECK(stream).SetNoLogging() << absl::Substitute(
+        "SetInputStreamMaxQueueBytes called on \"$0\" which is not a "
+        "graph input stream.",
+        name_max.first);
+    (*stream)->SetMaxQueueByteSize(name_max.second);
+  }
 
   for (auto& node : nodes_) {
     if (node->IsSource()) {
@@ -941,68 +1086,98 @@ absl::Status CalculatorGraph::AddPacketToInputStreamInternal(
   auto node_id_it = graph_input_stream_node_ids_.find(stream_name);
   ABSL_CHECK(node_id_it != graph_input_stream_node_ids_.end())
       << "Map key not found: " << stream_name;
-  int node_id = node_id_it->second;
+  return AddPacketToGraphInputStream(stream->get(), node_id_it->second,
+                                     std::forward<T>(packet));
+}
+
+template <typename T>
+absl::Status CalculatorGraph::AddPacketToGraphInputStream(
+    GraphInputStream* stream, int node_id, T&& packet) {
+  MP_RETURN_IF_ERROR(WaitForGraphInputStream(node_id));
+  LogGraphInputPacket(stream, packet);
+  // InputStreamManager is thread safe. GraphInputStream is not, so this method
+  // should not be called by multiple threads concurrently. Note that this could
+  // potentially lead to the max queue size being exceeded by one packet at most
+  // because we don't have the lock over the input stream.
+  stream->AddPacket(std::forward<T>(packet));
+  return FinishAddingToGraphInputStream(stream);
+}
+
+absl::Status CalculatorGraph::AddPacketsToGraphInputStream(
+    GraphInputStream* stream, int node_id, absl::Span<Packet> packets) {
+  MP_RETURN_IF_ERROR(WaitForGraphInputStream(node_id));
+  for (Packet& packet : packets) {
+    LogGraphInputPacket(stream, packet);
+    stream->AddPacket(std::move(packet));
+  }
+  return FinishAddingToGraphInputStream(stream);
+}
+
+absl::Status CalculatorGraph::WaitForGraphInputStream(int node_id) {
   ABSL_CHECK_GE(node_id, validated_graph_->CalculatorInfos().size());
-  {
-    absl::MutexLock lock(&full_input_streams_mutex_);
-    if (full_input_streams_.empty()) {
-      return mediapipe::FailedPreconditionErrorBuilder(MEDIAPIPE_LOC)
-             << "CalculatorGraph::AddPacketToInputStream() is called before "
-                "StartRun()";
+  absl::MutexLock lock(&full_input_streams_mutex_);
+  if (full_input_streams_.empty()) {
+    return mediapipe::FailedPreconditionErrorBuilder(MEDIAPIPE_LOC)
+           << "CalculatorGraph::AddPacketToInputStream() is called before "
+              "StartRun()";
+  }
+  if (graph_input_stream_add_mode_ ==
+      GraphInputStreamAddMode::ADD_IF_NOT_FULL) {
+    if (has_error_) {
+      absl::Status error_status;
+      GetCombinedErrors("Graph has errors: ", &error_status);
+      return error_status;
     }
-    if (graph_input_stream_add_mode_ ==
-        GraphInputStreamAddMode::ADD_IF_NOT_FULL) {
-      if (has_error_) {
-        absl::Status error_status;
-        GetCombinedErrors("Graph has errors: ", &error_status);
-        return error_status;
-      }
-      // Return with StatusUnavailable if this stream is being throttled.
-      if (!full_input_streams_[node_id].empty()) {
-        return mediapipe::UnavailableErrorBuilder(MEDIAPIPE_LOC)
-               << "Graph is throttled.";
-      }
-    } else if (graph_input_stream_add_mode_ ==
-               GraphInputStreamAddMode::WAIT_TILL_NOT_FULL) {
-      // Wait until this stream is not being throttled.
-      // TODO: instead of checking has_error_, we could just check
-      // if the graph is done. That could also be indicated by returning an
-      // error from WaitUntilGraphInputStreamUnthrottled.
-      while (!has_error_ && !full_input_streams_[node_id].empty()) {
-        // TODO: allow waiting for a specific stream?
-        scheduler_.WaitUntilGraphInputStreamUnthrottled(
-            &full_input_streams_mutex_);
-      }
-      if (has_error_) {
-        absl::Status error_status;
-        GetCombinedErrors("Graph has errors: ", &error_status);
-        return error_status;
-      }
+    // Return with StatusUnavailable if this stream is being throttled.
+    if (IsSourceThrottled(node_id)) {
+      return mediapipe::UnavailableErrorBuilder(MEDIAPIPE_LOC)
+             << "Graph is throttled.";
+    }
+  } else if (graph_input_stream_add_mode_ ==
+             GraphInputStreamAddMode::WAIT_TILL_NOT_FULL) {
+    // Wait until this stream is not being throttled.
+    // TODO: instead of checking has_error_, we could just check
+    // if the graph is done. That could also be indicated by returning an
+    // error from WaitUntilGraphInputStreamUnthrottled.
+    while (!has_error_ && IsSourceThrottled(node_id)) {
+      // TODO: allow waiting for a specific stream?
+      scheduler_.WaitUntilGraphInputStreamUnthrottled(
+          &full_input_streams_mutex_);
+    }
+    if (has_error_) {
+      absl::Status error_status;
+      GetCombinedErrors("Graph has errors: ", &error_status);
+      return error_status;
     }
   }
+  return absl::OkStatus();
+}
 
+void CalculatorGraph::LogGraphInputPacket(GraphInputStream* stream,
+                                          const Packet& packet) {
   // Adding profiling info for a new packet entering the graph.
-  const std::string* stream_id = &(*stream)->GetManager()->Name();
+  const std::string* stream_id = &stream->GetManager()->Name();
   profiler_->LogEvent(TraceEvent(TraceEvent::PROCESS)
                           .set_is_finish(true)
                           .set_input_ts(packet.Timestamp())
                           .set_stream_id(stream_id)
                           .set_packet_ts(packet.Timestamp())
                           .set_packet_data_id(&packet));
+  if (deadline_tracker_) {
+    deadline_tracker_->AddInputTimestamp(packet.Timestamp(), absl::Now());
+  }
+}
 
-  // InputStreamManager is thread safe. GraphInputStream is not, so this method
-  // should not be called by multiple threads concurrently. Note that this could
-  // potentially lead to the max queue size being exceeded by one packet at most
-  // because we don't have the lock over the input stream.
-  (*stream)->AddPacket(std::forward<T>(packet));
+absl::Status CalculatorGraph::FinishAddingToGraphInputStream(
+    GraphInputStream* stream) {
   if (has_error_) {
     absl::Status error_status;
     GetCombinedErrors("Graph has errors: ", &error_status);
     return error_status;
   }
-  (*stream)->PropagateUpdatesToMirrors();
+  stream->PropagateUpdatesToMirrors();
 
-  VLOG(2) << "Packet added directly to: " << stream_name;
+  VLOG(2) << "Packet added directly to: " << stream->GetManager()->Name();
   // Note: one reason why we need to call the scheduler here is that we have
   // re-throttled the graph input streams, and we may need to unthrottle them
   // again if the graph is still idle. Unthrottling basically only lets in one
@@ -1011,6 +1186,37 @@ absl::Status CalculatorGraph::AddPacketToInputStreamInternal(
   return absl::OkStatus();
 }
 
+absl::StatusOr<CalculatorGraph::InputStreamHandle>
+CalculatorGraph::GetInputStreamHandle(absl::string_view stream_name) {
+  auto stream_it = graph_input_streams_.find(stream_name);
+  RET_CHECK(stream_it != graph_input_streams_.end()).SetNoLogging()
+      << absl::Substitute(
+             "GetInputStreamHandle called on input stream \"$0\" which is not "
+             "a graph input stream.",
+             stream_name);
+  return InputStreamHandle(this, stream_it->second.get(),
+                           graph_input_stream_node_ids_.at(stream_name));
+}
+
+absl::Status CalculatorGraph::InputStreamHandle::AddPacket(
+    const Packet& packet) {
+  return graph_->AddPacketToGraphInputStream(stream_, node_id_, packet);
+}
+
+absl::Status CalculatorGraph::InputStreamHandle::AddPacket(Packet&& packet) {
+  return graph_->AddPacketToGraphInputStream(stream_, node_id_,
+                                             std::move(packet));
+}
+
+absl::Status CalculatorGraph::InputStreamHandle::AddPackets(
+    absl::Span<Packet> packets) {
+  return graph_->AddPacketsToGraphInputStream(stream_, node_id_, packets);
+}
+
+const std::string& CalculatorGraph::InputStreamHandle::name() const {
+  return stream_->GetManager()->Name();
+}
+
 absl::Status CalculatorGraph::SetInputStreamMaxQueueSize(
     const std::string& stream_name, int max_queue_size) {
   // graph_input_streams_ has not been filled in yet, so we'll check this when
@@ -1019,6 +1225,14 @@ absl::Status CalculatorGraph::SetInputStreamMaxQueueSize(
   return absl::OkStatus();
 }
 
+absl::Status CalculatorGraph::SetInputStreamMaxQueueBytes(
+    const std::string& stream_name, int64_t max_queue_bytes) {
+  // As in SetInputStreamMaxQueueSize, this is checked when the graph is
+  // started.
+  graph_input_stream_max_queue_bytes_[stream_name] = max_queue_bytes;
+  return absl::OkStatus();
+}
+
 bool CalculatorGraph::HasInputStream(const std::string& stream_name) {
   return mediapipe::FindOrNull(graph_input_streams_, stream_name) != nullptr;
 }
@@ -1217,7 +1431,7 @@ void CalculatorGraph::UpdateThrottledNodes(InputStreamManager* stream,
             scheduler_.ThrottledGraphInputStream();
           }
         } else {
-          if (!is_throttled) {
+          if (!is_throttled && !graph_queue_bytes_full_) {
             CalculatorNode& node = *nodes_[node_id];
             // Add this node to the scheduler queue if possible.
             if (node.Active() && !node.Closed()) {
@@ -1237,7 +1451,61 @@ void CalculatorGraph::UpdateThrottledNodes(InputStreamManager* stream,
 
 bool CalculatorGraph::IsNodeThrottled(int node_id) {
   absl::MutexLock lock(&full_input_streams_mutex_);
-  return max_queue_size_ != -1 && !full_input_streams_[node_id].empty();
+  if (graph_queue_bytes_full_ && nodes_[node_id]->IsSource()) {
+    return true;
+  }
+  return (max_queue_size_ != -1 || account_queue_bytes_) &&
+         !full_input_streams_[node_id].empty();
+}
+
+void CalculatorGraph::UpdateGraphQueueBytes(int64_t delta) {
+  const int64_t queue_bytes = graph_queue_bytes_.fetch_add(delta) + delta;
+  int64_t peak_queue_bytes = peak_graph_queue_bytes_.load();
+  while (queue_bytes > peak_queue_bytes &&
+         !peak_graph_queue_bytes_.compare_exchange_weak(peak_queue_bytes,
+                                                        queue_bytes)) {
+  }
+  const int64_t max_queue_bytes = max_graph_queue_bytes_;
+  if (max_queue_bytes != -1 &&
+      (queue_bytes - delta >= max_queue_bytes) !=
+          (queue_bytes >= max_queue_bytes)) {
+    UpdateGraphQueueBytesThrottling();
+  }
+}
+
+void CalculatorGraph::UpdateGraphQueueBytesThrottling() {
+  std::vector<CalculatorNode*> nodes_to_schedule;
+  {
+    absl::MutexLock lock(&full_input_streams_mutex_);
+    // As in UpdateThrottledNodes, the state is recomputed under the lock, so
+    // that callbacks arriving out of order don't interfere.
+    const int64_t max_queue_bytes = max_graph_queue_bytes_;
+    const bool is_full =
+        max_queue_bytes != -1 && graph_queue_bytes_ >= max_queue_bytes;
+    if (full_input_streams_.empty() || is_full == graph_queue_bytes_full_) {
+      return;
+    }
+    VLOG(2) << "The graph is "
+            << (is_full ? "throttling" : "no longer throttling")
+            << " its sources, with " << graph_queue_bytes_ << " queued bytes.";
+    graph_queue_bytes_full_ = is_full;
+    // The scheduler counts the exceeded budget like a throttled graph input
+    // stream, so that it resolves a deadlock once the graph becomes idle.
+    if (is_full) {
+      scheduler_.ThrottledGraphInputStream();
+    } else {
+      scheduler_.UnthrottledGraphInputStream();
+      for (auto& node : nodes_) {
+        if (node->IsSource() && full_input_streams_[node->Id()].empty() &&
+            node->Active() && !node->Closed()) {
+          nodes_to_schedule.push_back(node.get());
+        }
+      }
+    }
+  }
+  if (!nodes_to_schedule.empty()) {
+    scheduler_.ScheduleUnthrottledReadyNodes(nodes_to_schedule);
+  }
 }
 
 // Returns true if an input stream serves as a graph-output-stream.
@@ -1253,6 +1521,23 @@ bool IsGraphOutputStream(
   return false;
 }
 
+void CalculatorGraph::UpdateNodePriorities() {
+  absl::MutexLock lock(&node_priorities_mutex_);
+  const absl::Time now = absl::Now();
+  if (now - node_priorities_update_time_ < kNodePrioritiesUpdateInterval) {
+    return;
+  }
+  node_priorities_update_time_ = now;
+  // The node costs come from the profiles of the previous runs and of the
+  // current one. Without profiles, e.g. if the profiler is disabled, all nodes
+  // cost the same.
+  std::vector<CalculatorProfile> profiles;
+  profiler_->GetCalculatorProfiles(&profiles).IgnoreError();
+  scheduler_.SetNodePriorities(tool::CriticalPathPriorities(
+      *validated_graph_,
+      tool::NodeCostsFromProfiles(*validated_graph_, profiles)));
+}
+
 bool CalculatorGraph::UnthrottleSources() {
   // NOTE: We can be sure that this function will grow input streams enough
   // to unthrottle at least one source node.  The current stream queue sizes
@@ -1260,9 +1545,11 @@ bool CalculatorGraph::UnthrottleSources() {
   // This is a sufficient because successfully growing at least one full input
   // stream during each call to UnthrottleSources will eventually resolve
   // each deadlock.
+  bool graph_queue_bytes_full;
   absl::flat_hash_set<InputStreamManager*> full_streams;
   {
     absl::MutexLock lock(&full_input_streams_mutex_);
+    graph_queue_bytes_full = graph_queue_bytes_full_;
     for (absl::flat_hash_set<InputStreamManager*>& s : full_input_streams_) {
       for (auto& stream : s) {
         // The queue size of a graph output stream shouldn't change. Throttling
@@ -1274,6 +1561,26 @@ bool CalculatorGraph::UnthrottleSources() {
       }
     }
   }
+  if (graph_queue_bytes_full) {
+    if (Config().report_deadlock()) {
+      RecordError(absl::UnavailableError(absl::StrCat(
+          "Detected a deadlock due to input throttling: the input streams of "
+          "the graph hold ",
+          graph_queue_bytes_.load(),
+          " bytes. All calculators are idle while packet sources remain "
+          "active and throttled.  Consider adjusting "
+          "\"max_graph_queue_bytes\" or \"report_deadlock\".")));
+    } else {
+      const int64_t new_max_queue_bytes = graph_queue_bytes_ + 1;
+      max_graph_queue_bytes_ = new_max_queue_bytes;
+      UpdateGraphQueueBytesThrottling();
+      ABSL_LOG_EVERY_N(WARNING, 100) << absl::StrCat(
+          "Resolved a deadlock by increasing max_graph_queue_bytes to ",
+          new_max_queue_bytes,
+          ". Consider increasing max_graph_queue_bytes for better "
+          "performance.");
+    }
+  }
   for (InputStreamManager* stream : full_streams) {
     if (Config().report_deadlock()) {
       RecordError(absl::UnavailableError(absl::StrCat(
@@ -1284,15 +1591,33 @@ bool CalculatorGraph::UnthrottleSources() {
           "\"report_deadlock\".")));
       continue;
     }
-    int new_size = stream->QueueSize() + 1;
-    stream->SetMaxQueueSize(new_size);
-    ABSL_LOG_EVERY_N(WARNING, 100) << absl::StrCat(
-        "Resolved a deadlock by increasing max_queue_size of input stream: \"",
-        stream->Name(), "\" of a node \"", GetParentNodeDebugName(stream),
-        "\" to ", new_size,
-        ". Consider increasing max_queue_size for better performance.");
+    // A stream may be full because of its queue size, its queued bytes, or
+    // both.
+    const int queue_size = stream->QueueSize();
+    if (stream->MaxQueueSize() != -1 && queue_size >= stream->MaxQueueSize()) {
+      int new_size = queue_size + 1;
+      stream->SetMaxQueueSize(new_size);
+      ABSL_LOG_EVERY_N(WARNING, 100) << absl::StrCat(
+          "Resolved a deadlock by increasing max_queue_size of input "
+          "stream: \"",
+          stream->Name(), "\" of a node \"", GetParentNodeDebugName(stream),
+          "\" to ", new_size,
+          ". Consider increasing max_queue_size for better performance.");
+    }
+    const int64_t queue_bytes = stream->QueueByteSize();
+    if (stream->MaxQueueByteSize() != -1 &&
+        queue_bytes >= stream->MaxQueueByteSize()) {
+      const int64_t new_max_queue_bytes = queue_bytes + 1;
+      stream->SetMaxQueueByteSize(new_max_queue_bytes);
+      ABSL_LOG_EVERY_N(WARNING, 100) << absl::StrCat(
+          "Resolved a deadlock by increasing max_queue_bytes of input "
+          "stream: \"",
+          stream->Name(), "\" of a node \"", GetParentNodeDebugName(stream),
+          "\" to ", new_max_queue_bytes,
+          ". Consider increasing max_queue_bytes for better performance.");
+    }
   }
-  return !full_streams.empty();
+  return graph_queue_bytes_full || !full_streams.empty();
 }
 
 CalculatorGraph::GraphInputStreamAddMode
@@ -1365,6 +1690,18 @@ bool CalculatorGraph::IsReservedExecutorName(const std::string& name) {
   return ValidatedGraphConfig::IsReservedExecutorName(name);
 }
 
+bool CalculatorGraph::ReportsCpuMigrations(const std::string& name) const {
+  for (const ExecutorConfig& executor_config :
+       validated_graph_->Config().executor()) {
+    if (executor_config.name() == name) {
+      return executor_config.options()
+          .GetExtension(ThreadPoolExecutorOptions::ext)
+          .report_cpu_migrations();
+    }
+  }
+  return false;
+}
+
 absl::Status CalculatorGraph::FinishRun() {
   // Check for any errors that may have occurred.
   absl::Status status = absl::OkStatus();
@@ -1392,6 +1729,10 @@ void CalculatorGraph::CleanupAfterRun(absl::Status* status) {
   for (auto& node : nodes_) {
     node->CleanupAfterRun(*status);
   }
+  packet_arena_ = nullptr;
+  deadline_tracker_ = nullptr;
+  UpdateCpuBufferPoolCounters();
+  UpdateQueueByteCounters();
 
   for (auto& graph_output_stream : graph_output_streams_) {
     graph_output_stream->input_stream()->Close();
@@ -1413,6 +1754,45 @@ void CalculatorGraph::CleanupAfterRun(absl::Status* status) {
   // in order to enable GetOutputSidePacket after WaitUntilDone.
 }
 
+void CalculatorGraph::UpdateCpuBufferPoolCounters() {
+  std::shared_ptr<MemoryManager> memory_manager =
+      service_manager_.GetServiceObject(kMemoryManagerService);
+  if (!memory_manager || !memory_manager->GetCpuBufferPool()) {
+    return;
+  }
+  // The counters track the totals of the pool, which may be shared by graphs.
+  const CpuBufferPool::Stats stats =
+      memory_manager->GetCpuBufferPool()->GetStats();
+  Counter* hits = counter_factory_->GetCounter("CpuBufferPool hits");
+  hits->IncrementBy(stats.hits - hits->Get());
+  Counter* misses = counter_factory_->GetCounter("CpuBufferPool misses");
+  misses->IncrementBy(stats.misses - misses->Get());
+}
+
+void CalculatorGraph::UpdateQueueByteCounters() {
+  if (!account_queue_bytes_) {
+    return;
+  }
+  // The counters keep the largest peak of all runs.
+  auto raise_counter = [this](const std::string& name, int64_t value) {
+    Counter* counter = counter_factory_->GetCounter(name);
+    if (value > counter->Get()) {
+      counter->IncrementBy(value - counter->Get());
+    }
+  };
+  for (int index = 0; index < validated_graph_->InputStreamInfos().size();
+       ++index) {
+    const EdgeInfo& edge_info = validated_graph_->InputStreamInfos()[index];
+    if (edge_info.parent_node.type != NodeTypeInfo::NodeType::CALCULATOR) {
+      continue;
+    }
+    raise_counter(absl::StrCat(nodes_[edge_info.parent_node.index]->DebugName(),
+                               "-", edge_info.name, "-PeakQueuedBytes"),
+                  input_stream_managers_[index].PeakQueueByteSize());
+  }
+  raise_counter("PeakQueuedBytes", peak_graph_queue_bytes_);
+}
+
 const OutputStreamManager* CalculatorGraph::FindOutputStreamManager(
     const std::string& name) {
   return &output_stream_managers_
@@ -19,6 +19,7 @@
 #define MEDIAPIPE_FRAMEWORK_CALCULATOR_GRAPH_H_
 
 #include <atomic>
+#include <cstdint>
 #include <functional>
 #include <map>
 #include <memory>
@@ -34,10 +35,13 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_base.h"
 #include "mediapipe/framework/calculator_node.h"
 #include "mediapipe/framework/counter_factory.h"
+#include "mediapipe/framework/deadline_tracker.h"
 #include "mediapipe/framework/executor.h"
 #include "mediapipe/framework/graph_output_stream.h"
 #include "mediapipe/framework/graph_service.h"
@@ -48,6 +52,7 @@
 #include "mediapipe/framework/output_stream_poller.h"
 #include "mediapipe/framework/output_stream_shard.h"
 #include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/packet_arena.h"
 #include "mediapipe/framework/packet_generator_graph.h"
 #include "mediapipe/framework/scheduler.h"
 #include "mediapipe/framework/scheduler_shared.h"
@@ -65,6 +70,60 @@ struct GpuSharedData;
 
 typedef absl::StatusOr<OutputStreamPoller> StatusOrPoller;
 
+// A validated graph that can be shared by many CalculatorGraphs.
+//
+// Creating a CompiledGraph expands subgraphs, fuses calculator chains,
+// validates the graph, and resolves the contracts, packet types and factories
+// of its calculators. CalculatorGraphs initialized from a CompiledGraph skip
+// all of these steps, which makes it cheap to create a short-lived graph per
+// request.
+//
+// Example:
+//   MP_ASSIGN_OR_RETURN(std::shared_ptr<const CompiledGraph> compiled_graph,
+//                       CompiledGraph::Create(config));
+//   ...
+//   // For every request.
+//   CalculatorGraph graph;
+//   MP_RETURN_IF_ERROR(graph.Initialize(compiled_graph));
+//
+// A CompiledGraph is immutable and can be used from several threads. Since it
+// doesn't belong to a CalculatorGraph, its subgraphs are expanded without
+// access to graph services; graphs with subgraphs that depend on services
+// should be initialized from their config instead.
+class CompiledGraph {
+ public:
+  // Compiles the graph from its proto description.
+  static absl::StatusOr<std::shared_ptr<const CompiledGraph>> Create(
+      CalculatorGraphConfig config);
+
+  // Compiles the graph from the specified graph and subgraph configs. See the
+  // corresponding CalculatorGraph::Initialize() for the arguments.
+  static absl::StatusOr<std::shared_ptr<const CompiledGraph>> Create(
+      const std::vector<CalculatorGraphConfig>& configs,
+      const std::vector<CalculatorGraphTemplate>& templates,
+      const std::string& graph_type = "",
+      const Subgraph::SubgraphOptions* options = nullptr);
+
+  CompiledGraph(const CompiledGraph&) = delete;
+  CompiledGraph& operator=(const CompiledGraph&) = delete;
+
+  // Returns the canonicalized CalculatorGraphConfig of the graph.
+  const CalculatorGraphConfig& Config() const {
+    return validated_graph_->Config();
+  }
+
+ private:
+  friend class CalculatorGraph;
+
+  static absl::StatusOr<std::shared_ptr<const CompiledGraph>> Create(
+      std::unique_ptr<ValidatedGraphConfig> validated_graph);
+
+  explicit CompiledGraph(std::unique_ptr<ValidatedGraphConfig> validated_graph)
+      : validated_graph_(std::move(validated_graph)) {}
+
+  const std::unique_ptr<const ValidatedGraphConfig> validated_graph_;
+};
+
 // The class representing a DAG of calculator nodes.
 //
 // CalculatorGraph is the primary API for the MediaPipe Framework.
@@ -146,6 +205,12 @@ class CalculatorGraph {
       const std::string& graph_type = "",
       const Subgraph::SubgraphOptions* options = nullptr);
 
+  // Initializes the graph from a CompiledGraph, without validating its config
+  // again. The CompiledGraph is shared with the graph.
+  absl::Status Initialize(
+      std::shared_ptr<const CompiledGraph> compiled_graph,
+      const std::map<std::string, Packet>& side_packets = {});
+
   // Returns the canonicalized CalculatorGraphConfig for this graph.
   const CalculatorGraphConfig& Config() const {
     return validated_graph_->Config();
@@ -272,6 +337,15 @@ class CalculatorGraph {
   absl::Status AddPacketToInputStream(absl::string_view stream_name,
                                       Packet&& packet);
 
+  // Adds packets to a graph input stream without looking it up by name.
+  class InputStreamHandle;
+
+  // Returns a handle to the graph input stream "stream_name", for adding
+  // packets at a high rate. The handle remains valid across runs, as long as
+  // the graph exists. Can be called after Initialize().
+  absl::StatusOr<InputStreamHandle> GetInputStreamHandle(
+      absl::string_view stream_name);
+
   // Indicates that input will arrive no earlier than a certain timestamp.
   absl::Status SetInputStreamTimestampBound(const std::string& stream_name,
                                             Timestamp timestamp);
@@ -280,6 +354,20 @@ class CalculatorGraph {
   absl::Status SetInputStreamMaxQueueSize(const std::string& stream_name,
                                           int max_queue_size);
 
+  // Sets the maximum payload bytes queued for a graph input stream, overriding
+  // max_queue_bytes of the graph config. A value of -1 means no limit.
+  absl::Status SetInputStreamMaxQueueBytes(const std::string& stream_name,
+                                           int64_t max_queue_bytes);
+
+  // Returns the payload bytes queued in the input streams of the nodes, if
+  // the graph config sets max_queue_bytes or max_graph_queue_bytes, or if
+  // SetInputStreamMaxQueueBytes() is called. Returns 0 otherwise.
+  //
+  // At the end of every run, the "<node name>-<stream name>-PeakQueuedBytes"
+  // counter of each input stream and the "PeakQueuedBytes" counter of the
+  // graph are raised to the largest number of bytes queued during the run.
+  int64_t GetQueuedBytes() const { return graph_queue_bytes_; }
+
   // Check if an input stream exists in the graph
   bool HasInputStream(const std::string& name);
 
@@ -399,6 +487,11 @@ class CalculatorGraph {
   // Returns true if at least one max_queue_size has been grown.
   bool UnthrottleSources() ABSL_LOCKS_EXCLUDED(full_input_streams_mutex_);
 
+  // Recomputes the node priorities of the CRITICAL_PATH scheduling policy
+  // from the profiles recorded so far. Called when the running graph becomes
+  // idle, and rate limited.
+  void UpdateNodePriorities() ABSL_LOCKS_EXCLUDED(node_priorities_mutex_);
+
   // Returns the scheduler's runtime measures for overhead measurement.
   // Only meant for test purposes.
   internal::SchedulerTimes GetSchedulerTimes() {
@@ -502,6 +595,10 @@ class CalculatorGraph {
       manager_->SetMaxQueueSize(max_queue_size);
     }
 
+    void SetMaxQueueByteSize(int64_t max_queue_bytes) {
+      manager_->SetMaxQueueByteSize(max_queue_bytes);
+    }
+
     void SetHeader(const Packet& header);
 
     void AddPacket(const Packet& packet) { shard_.AddPacket(packet); }
@@ -527,6 +624,13 @@ class CalculatorGraph {
   absl::Status Initialize(std::unique_ptr<ValidatedGraphConfig> validated_graph,
                           const std::map<std::string, Packet>& side_packets);
 
+  // Initializes the graph from a ValidatedGraphConfig object in which chains
+  // of fusable nodes have already been fused. The object may be shared with
+  // other graphs.
+  absl::Status InitializeValidatedGraph(
+      std::shared_ptr<const ValidatedGraphConfig> validated_graph,
+      const std::map<std::string, Packet>& side_packets);
+
   // AddPacketToInputStreamInternal template is called by either
   // AddPacketToInputStream(Packet&& packet) or
   // AddPacketToInputStream(const Packet& packet).
@@ -534,6 +638,29 @@ class CalculatorGraph {
   absl::Status AddPacketToInputStreamInternal(absl::string_view stream_name,
                                               T&& packet);
 
+  // Adds a packet to a resolved graph input stream with virtual node id
+  // "node_id".
+  template <typename T>
+  absl::Status AddPacketToGraphInputStream(GraphInputStream* stream,
+                                           int node_id, T&& packet);
+
+  // Adds packets to a resolved graph input stream, checking for throttling
+  // and scheduling the graph only once.
+  absl::Status AddPacketsToGraphInputStream(GraphInputStream* stream,
+                                            int node_id,
+                                            absl::Span<Packet> packets);
+
+  // Blocks or fails according to graph_input_stream_add_mode_ while the graph
+  // input stream with virtual node id "node_id" is throttled.
+  absl::Status WaitForGraphInputStream(int node_id);
+
+  // Records a packet entering the graph in the profiler and, if the graph has
+  // a latency budget, in the deadline tracker.
+  void LogGraphInputPacket(GraphInputStream* stream, const Packet& packet);
+
+  // Propagates the packets added to "stream" and schedules the graph.
+  absl::Status FinishAddingToGraphInputStream(GraphInputStream* stream);
+
   // Sets the executor that will run the nodes assigned to the executor
   // named |name|.  If |name| is empty, this sets the default executor.
   // Does not check that the graph is uninitialized and |name| is not a
@@ -559,6 +686,10 @@ class CalculatorGraph {
   // Returns true if |name| is a reserved executor name.
   static bool IsReservedExecutorName(const std::string& name);
 
+  // Returns true if the ThreadPoolExecutorOptions of the executor |name| set
+  // report_cpu_migrations.
+  bool ReportsCpuMigrations(const std::string& name) const;
+
   // Helper functions for Initialize().
   absl::Status InitializeExecutors();
   absl::Status InitializePacketGeneratorGraph(
@@ -600,6 +731,14 @@ class CalculatorGraph {
   // |*status| to the new combined errors on return.
   void CleanupAfterRun(absl::Status* status) ABSL_LOCKS_EXCLUDED(error_mutex_);
 
+  // Updates the "CpuBufferPool hits" and "CpuBufferPool misses" counters from
+  // the tensor buffer pool of the MemoryManager service, if any.
+  void UpdateCpuBufferPoolCounters();
+
+  // Updates the "PeakQueuedBytes" counters from the input streams, if they
+  // account for their queued bytes.
+  void UpdateQueueByteCounters();
+
   // Calls HandlePreRunStatus or HandleStatus on the StatusHandlers. Which one
   // is called depends on the GraphRunState parameter (PRE_RUN or POST_RUN).
   // current_run_side_packets_ must be set before this function is called.
@@ -620,6 +759,23 @@ class CalculatorGraph {
   // status before taking any action.
   void UpdateThrottledNodes(InputStreamManager* stream, bool* stream_was_full);
 
+  // Callback function invoked by the input streams with the changes in their
+  // queued bytes. Throttles or unthrottles all source nodes and graph input
+  // streams when the total crosses max_graph_queue_bytes.
+  void UpdateGraphQueueBytes(int64_t delta);
+
+  // Throttles or unthrottles all source nodes and graph input streams if the
+  // total queued bytes have crossed max_graph_queue_bytes.
+  void UpdateGraphQueueBytesThrottling()
+      ABSL_LOCKS_EXCLUDED(full_input_streams_mutex_);
+
+  // Returns true if the source node or graph input stream with the (virtual)
+  // node id "node_id" is throttled.
+  bool IsSourceThrottled(int node_id) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(full_input_streams_mutex_) {
+    return graph_queue_bytes_full_ || !full_input_streams_[node_id].empty();
+  }
+
   // Returns a comma-separated list of source nodes.
   std::string ListSourceNodes() const;
 
@@ -639,7 +795,8 @@ class CalculatorGraph {
   PacketType any_packet_type_;
 
   // The ValidatedGraphConfig object defining this CalculatorGraph.
-  std::unique_ptr<ValidatedGraphConfig> validated_graph_;
+  // It may be shared with other graphs through a CompiledGraph.
+  std::shared_ptr<const ValidatedGraphConfig> validated_graph_;
 
   // The PacketGeneratorGraph to use to generate all the input side packets.
   PacketGeneratorGraph packet_generator_graph_;
@@ -694,9 +851,33 @@ class CalculatorGraph {
   // Maps graph input streams to their max queue size.
   absl::flat_hash_map<std::string, int> graph_input_stream_max_queue_size_;
 
+  // Maps graph input streams to their max queue bytes.
+  absl::flat_hash_map<std::string, int64_t> graph_input_stream_max_queue_bytes_;
+
+  // True if the input streams of the current run account for their queued
+  // bytes.
+  bool account_queue_bytes_ = false;
+  // The payload bytes queued in the input streams of the nodes, and the
+  // largest value in the current run.
+  std::atomic<int64_t> graph_queue_bytes_ = 0;
+  std::atomic<int64_t> peak_graph_queue_bytes_ = 0;
+  // The maximum of graph_queue_bytes_, from max_graph_queue_bytes, or -1 if
+  // there is no maximum. Raised by UnthrottleSources() to resolve deadlocks.
+  std::atomic<int64_t> max_graph_queue_bytes_ = -1;
+  // True while graph_queue_bytes_ reaches max_graph_queue_bytes_, which
+  // throttles all source nodes and graph input streams.
+  bool graph_queue_bytes_full_ ABSL_GUARDED_BY(full_input_streams_mutex_) =
+      false;
+
   // The factory for making counters associated with this graph.
   std::unique_ptr<CounterFactory> counter_factory_;
 
+  // The packet arena of the current run, if the config sets use_packet_arena.
+  std::shared_ptr<PacketArena> packet_arena_;
+  // The deadline tracker of the current run, if the config sets
+  // latency_budget_usec.
+  std::shared_ptr<DeadlineTracker> deadline_tracker_;
+
   // Executors for the scheduler, keyed by the executor's name. The default
   // executor's name is the empty string.
   std::map<std::string, std::shared_ptr<Executor>> executors_;
@@ -748,9 +929,54 @@ class CalculatorGraph {
   // remains available during the Scheduler destructor.
   std::shared_ptr<ProfilingContext> profiler_;
 
+  // Guards the updates of the node priorities, see UpdateNodePriorities().
+  absl::Mutex node_priorities_mutex_;
+  // When the node priorities were last computed.
+  absl::Time node_priorities_update_time_
+      ABSL_GUARDED_BY(node_priorities_mutex_) = absl::InfinitePast();
+
   internal::Scheduler scheduler_;
 };
 
+// A handle to a graph input stream, obtained from
+// CalculatorGraph::GetInputStreamHandle. Adding packets through the handle
+// behaves like CalculatorGraph::AddPacketToInputStream, but skips the lookup
+// of the stream by name. Like AddPacketToInputStream, a handle must not be used
+// by multiple threads concurrently.
+//
+// Example:
+//   MP_ASSIGN_OR_RETURN(auto input, graph.GetInputStreamHandle("input"));
+//   MP_RETURN_IF_ERROR(graph.StartRun({}));
+//   for (...) {
+//     MP_RETURN_IF_ERROR(input.AddPacket(MakePacket<T>(...).At(timestamp)));
+//   }
+class CalculatorGraph::InputStreamHandle {
+ public:
+  // Adds a packet to the stream, see CalculatorGraph::AddPacketToInputStream.
+  absl::Status AddPacket(const Packet& packet);
+  absl::Status AddPacket(Packet&& packet);
+
+  // Moves "packets" into the stream, in order. The graph input stream add mode
+  // is checked once for the whole batch, so a batch can exceed max_queue_size
+  // by up to its size. The batch is not atomic: if the graph fails or a packet
+  // is rejected partway through, the packets before it remain queued.
+  absl::Status AddPackets(absl::Span<Packet> packets);
+
+  // Returns the name of the stream.
+  const std::string& name() const;
+
+ private:
+  friend class CalculatorGraph;
+  InputStreamHandle(CalculatorGraph* graph, GraphInputStream* stream,
+                    int node_id)
+      : graph_(graph), stream_(stream), node_id_(node_id) {}
+
+  CalculatorGraph* graph_;
+  GraphInputStream* stream_;
+  // The virtual node id of the stream, used for throttling.
+  int node_id_;
+};
+
 }  // namespace mediapipe
 
 #endif  // MEDIAPIPE_FRAMEWORK_CALCULATOR_GRAPH_H_
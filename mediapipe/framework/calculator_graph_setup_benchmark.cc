@@ -0,0 +1,103 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Benchmark for the setup latency of short-lived CalculatorGraphs.
+//
+// BM_InitializeGraph initializes a linear chain of PassThroughCalculators,
+// either from its config or from a CompiledGraph. BM_RunShortLivedGraph also
+// runs the graph on a single packet, as a service creating a graph per request
+// would.
+//
+// $ bazel run -c opt mediapipe/framework:calculator_graph_setup_benchmark
+#include <memory>
+#include <string>
+
+#include "absl/log/absl_check.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+#include "mediapipe/framework/calculator_framework.h"
+
+namespace mediapipe {
+namespace {
+
+// Returns a chain of PassThroughCalculators from "s0" to "s<num_nodes>".
+CalculatorGraphConfig ChainConfig(int num_nodes) {
+  CalculatorGraphConfig config;
+  config.add_input_stream("s0");
+  for (int i = 0; i < num_nodes; ++i) {
+    CalculatorGraphConfig::Node* node = config.add_node();
+    node->set_calculator("PassThroughCalculator");
+    node->add_input_stream(absl::StrCat("s", i));
+    node->add_output_stream(absl::StrCat("s", i + 1));
+  }
+  return config;
+}
+
+// Initializes the graph from "config", or from "compiled_graph" if not null.
+void InitializeGraph(const CalculatorGraphConfig& config,
+                     const std::shared_ptr<const CompiledGraph>& compiled_graph,
+                     CalculatorGraph* graph) {
+  if (compiled_graph) {
+    ABSL_CHECK_OK(graph->Initialize(compiled_graph));
+  } else {
+    ABSL_CHECK_OK(graph->Initialize(config));
+  }
+}
+
+// Arguments: number of nodes, whether to use a CompiledGraph.
+void BM_InitializeGraph(benchmark::State& state) {
+  const CalculatorGraphConfig config = ChainConfig(state.range(0));
+  std::shared_ptr<const CompiledGraph> compiled_graph;
+  if (state.range(1)) {
+    auto status_or_compiled_graph = CompiledGraph::Create(config);
+    ABSL_CHECK_OK(status_or_compiled_graph);
+    compiled_graph = *std::move(status_or_compiled_graph);
+  }
+  for (auto _ : state) {
+    CalculatorGraph graph;
+    InitializeGraph(config, compiled_graph, &graph);
+  }
+}
+BENCHMARK(BM_InitializeGraph)
+    ->ArgsProduct({{1, 10, 100}, {0, 1}})
+    ->ArgNames({"nodes", "compiled"});
+
+// Arguments: number of nodes, whether to use a CompiledGraph.
+void BM_RunShortLivedGraph(benchmark::State& state) {
+  const int num_nodes = state.range(0);
+  const CalculatorGraphConfig config = ChainConfig(num_nodes);
+  std::shared_ptr<const CompiledGraph> compiled_graph;
+  if (state.range(1)) {
+    auto status_or_compiled_graph = CompiledGraph::Create(config);
+    ABSL_CHECK_OK(status_or_compiled_graph);
+    compiled_graph = *std::move(status_or_compiled_graph);
+  }
+  for (auto _ : state) {
+    CalculatorGraph graph;
+    InitializeGraph(config, compiled_graph, &graph);
+    ABSL_CHECK_OK(graph.StartRun({}));
+    ABSL_CHECK_OK(graph.AddPacketToInputStream(
+        "s0", MakePacket<int>(0).At(Timestamp(0))));
+    ABSL_CHECK_OK(graph.CloseAllInputStreams());
+    ABSL_CHECK_OK(graph.WaitUntilDone());
+  }
+}
+BENCHMARK(BM_RunShortLivedGraph)
+    ->ArgsProduct({{1, 10, 100}, {0, 1}})
+    ->ArgNames({"nodes", "compiled"});
+
+}  // namespace
+}  // namespace mediapipe
+
+BENCHMARK_MAIN();
@@ -24,6 +24,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
 #include <tuple>
 #include <utility>
 #include <vector>
@@ -38,8 +39,10 @@
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/collection_item_id.h"
 #include "mediapipe/framework/counter_factory.h"
@@ -3464,6 +3467,194 @@ TEST(CalculatorGraph, SetInputStreamMaxQueueSizeWorksSlowCalculator) {
   MP_ASSERT_OK(graph.WaitUntilDone());
 }
 
+// Returns a packet holding a kQueueBytesPacketSize-byte buffer.
+constexpr int kQueueBytesPacketSize = 1000;
+Packet MakeQueueBytesPacket(Timestamp timestamp) {
+  return MakePacket<std::vector<uint8_t>>(kQueueBytesPacketSize)
+      .At(timestamp);
+}
+
+TEST(CalculatorGraph, MaxQueueBytesThrottlesGraphInputStream) {
+  using Semaphore = SemaphoreCalculator::Semaphore;
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: 'in'
+        input_stream: 'gate'
+        input_stream: 'busy_in'
+        num_threads: 2
+        node {
+          name: 'pass'
+          calculator: 'PassThroughCalculator'
+          input_stream: 'in'
+          input_stream: 'gate'
+          output_stream: 'out'
+          output_stream: 'gate_out'
+        }
+        node {
+          calculator: 'SemaphoreCalculator'
+          input_stream: 'busy_in'
+          output_stream: 'busy_out'
+          input_side_packet: 'POST_SEM:post_sem_busy'
+          input_side_packet: 'WAIT_SEM:wait_sem_busy'
+        }
+      )pb");
+  const int64_t packet_bytes =
+      MakeQueueBytesPacket(Timestamp(0)).PayloadByteSize();
+  config.set_max_queue_bytes(2 * packet_bytes);
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  graph.SetGraphInputStreamAddMode(
+      CalculatorGraph::GraphInputStreamAddMode::ADD_IF_NOT_FULL);
+
+  Semaphore calc_entered_process_busy(0);
+  Semaphore calc_can_exit_process_busy(0);
+  MP_ASSERT_OK(graph.StartRun({
+      {"post_sem_busy", MakePacket<Semaphore*>(&calc_entered_process_busy)},
+      {"wait_sem_busy", MakePacket<Semaphore*>(&calc_can_exit_process_busy)},
+  }));
+  // Prevent deadlock resolution by running the "busy" SemaphoreCalculator
+  // while the queue of "in" is full.
+  MP_ASSERT_OK(graph.AddPacketToInputStream(
+      "busy_in", MakePacket<int>(0).At(Timestamp(0))));
+  calc_entered_process_busy.Acquire(1);
+
+  // "pass" waits for "gate", so the packets of "in" stay queued until they
+  // hold max_queue_bytes.
+  MP_EXPECT_OK(
+      graph.AddPacketToInputStream("in", MakeQueueBytesPacket(Timestamp(0))));
+  MP_EXPECT_OK(
+      graph.AddPacketToInputStream("in", MakeQueueBytesPacket(Timestamp(1))));
+  EXPECT_EQ(graph.GetQueuedBytes(), 2 * packet_bytes);
+  absl::Status status =
+      graph.AddPacketToInputStream("in", MakeQueueBytesPacket(Timestamp(2)));
+  EXPECT_EQ(status.code(), absl::StatusCode::kUnavailable);
+
+  MP_ASSERT_OK(graph.CloseInputStream("gate"));
+  calc_can_exit_process_busy.Release(1);
+  MP_ASSERT_OK(graph.WaitUntilIdle());
+  EXPECT_EQ(graph.GetQueuedBytes(), 0);
+  MP_EXPECT_OK(
+      graph.AddPacketToInputStream("in", MakeQueueBytesPacket(Timestamp(2))));
+
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+  CounterFactory* counters = graph.GetCounterFactory();
+  EXPECT_EQ(counters->GetCounter("pass-in-PeakQueuedBytes")->Get(),
+            2 * packet_bytes);
+  EXPECT_EQ(counters->GetCounter("PeakQueuedBytes")->Get(), 2 * packet_bytes);
+}
+
+TEST(CalculatorGraph, MaxGraphQueueBytesThrottlesAllGraphInputStreams) {
+  using Semaphore = SemaphoreCalculator::Semaphore;
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: 'in_a'
+        input_stream: 'in_b'
+        input_stream: 'gate'
+        input_stream: 'busy_in'
+        num_threads: 2
+        node {
+          calculator: 'PassThroughCalculator'
+          input_stream: 'in_a'
+          input_stream: 'gate'
+          output_stream: 'out_a'
+          output_stream: 'gate_a'
+        }
+        node {
+          calculator: 'PassThroughCalculator'
+          input_stream: 'in_b'
+          input_stream: 'gate'
+          output_stream: 'out_b'
+          output_stream: 'gate_b'
+        }
+        node {
+          calculator: 'SemaphoreCalculator'
+          input_stream: 'busy_in'
+          output_stream: 'busy_out'
+          input_side_packet: 'POST_SEM:post_sem_busy'
+          input_side_packet: 'WAIT_SEM:wait_sem_busy'
+        }
+      )pb");
+  const int64_t packet_bytes =
+      MakeQueueBytesPacket(Timestamp(0)).PayloadByteSize();
+  config.set_max_graph_queue_bytes(2 * packet_bytes);
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  graph.SetGraphInputStreamAddMode(
+      CalculatorGraph::GraphInputStreamAddMode::ADD_IF_NOT_FULL);
+
+  Semaphore calc_entered_process_busy(0);
+  Semaphore calc_can_exit_process_busy(0);
+  MP_ASSERT_OK(graph.StartRun({
+      {"post_sem_busy", MakePacket<Semaphore*>(&calc_entered_process_busy)},
+      {"wait_sem_busy", MakePacket<Semaphore*>(&calc_can_exit_process_busy)},
+  }));
+  MP_ASSERT_OK(graph.AddPacketToInputStream(
+      "busy_in", MakePacket<int>(0).At(Timestamp(0))));
+  calc_entered_process_busy.Acquire(1);
+
+  // Neither queue is full on its own, but together they hold the graph's
+  // budget, which throttles every graph input stream.
+  MP_EXPECT_OK(graph.AddPacketToInputStream(
+      "in_a", MakeQueueBytesPacket(Timestamp(0))));
+  MP_EXPECT_OK(graph.AddPacketToInputStream(
+      "in_b", MakeQueueBytesPacket(Timestamp(0))));
+  EXPECT_EQ(graph.GetQueuedBytes(), 2 * packet_bytes);
+  EXPECT_EQ(graph
+                .AddPacketToInputStream("in_a",
+                                        MakeQueueBytesPacket(Timestamp(1)))
+                .code(),
+            absl::StatusCode::kUnavailable);
+  EXPECT_EQ(graph
+                .AddPacketToInputStream("busy_in",
+                                        MakePacket<int>(1).At(Timestamp(1)))
+                .code(),
+            absl::StatusCode::kUnavailable);
+
+  MP_ASSERT_OK(graph.CloseInputStream("gate"));
+  calc_can_exit_process_busy.Release(1);
+  MP_ASSERT_OK(graph.WaitUntilIdle());
+  EXPECT_EQ(graph.GetQueuedBytes(), 0);
+  MP_EXPECT_OK(graph.AddPacketToInputStream(
+      "in_a", MakeQueueBytesPacket(Timestamp(1))));
+
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+  EXPECT_EQ(graph.GetCounterFactory()->GetCounter("PeakQueuedBytes")->Get(),
+            2 * packet_bytes);
+}
+
+// Verify that max_graph_queue_bytes throttles source nodes.
+TEST(CalculatorGraph, MaxGraphQueueBytesThrottlesSourceNodes) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        max_queue_size: -1
+        max_graph_queue_bytes: 12
+        node {
+          calculator: 'GlobalCountSourceCalculator'
+          input_side_packet: 'global_counter'
+          output_stream: 'counts'
+        }
+        node {
+          calculator: 'PassThroughCalculator'
+          input_stream: 'counts'
+          output_stream: 'out'
+        }
+      )pb");
+  std::vector<Packet> out_packets;
+  tool::AddVectorSink("out", &config, &out_packets);
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  std::atomic<int> global_counter(0);
+  MP_ASSERT_OK(graph.Run(
+      {{"global_counter", MakePacket<std::atomic<int>*>(&global_counter)}}));
+  EXPECT_EQ(out_packets.size(), GlobalCountSourceCalculator::kNumOutputPackets);
+  EXPECT_GT(graph.GetCounterFactory()->GetCounter("PeakQueuedBytes")->Get(),
+            0);
+  EXPECT_LE(graph.GetCounterFactory()->GetCounter("PeakQueuedBytes")->Get(),
+            12);
+}
+
 // Verify the scheduler unthrottles the graph input stream to avoid a deadlock,
 // and won't enter a busy loop.
 TEST(CalculatorGraph, AddPacketNoBusyLoop) {
@@ -3624,6 +3815,83 @@ absl::Status DoProcess(const InputStreamShardSet& inputs,
   return absl::OkStatus();
 }
 
+// With the CRITICAL_PATH scheduling policy, the graph finds out during the run
+// that the slow node is on the critical path, and then runs it first.
+TEST(CalculatorGraph, CriticalPathPrioritiesAreUpdatedDuringRun) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: 'in'
+        num_threads: 1
+        scheduling_policy: CRITICAL_PATH
+        profiler_config { enable_profiler: true }
+        node {
+          calculator: 'PassThroughCalculator'
+          input_stream: 'in'
+          output_stream: 'fanout'
+        }
+        node {
+          calculator: 'mediapipe.nested_ns.ProcessCallbackCalculator'
+          input_stream: 'fanout'
+          output_stream: 'slow'
+          input_side_packet: 'slow_callback'
+        }
+        node {
+          calculator: 'mediapipe.nested_ns.ProcessCallbackCalculator'
+          input_stream: 'fanout'
+          output_stream: 'fast'
+          input_side_packet: 'fast_callback'
+        }
+      )pb");
+  absl::Mutex mutex;
+  std::vector<std::string> run_order;
+  auto make_callback = [&](const std::string& name, absl::Duration duration) {
+    nested_ns::ProcessFunction callback =
+        [&, name, duration](const InputStreamShardSet& inputs,
+                            OutputStreamShardSet* outputs) {
+          absl::SleepFor(duration);
+          {
+            absl::MutexLock lock(&mutex);
+            run_order.push_back(name);
+          }
+          return DoProcess(inputs, outputs);
+        };
+    return AdoptAsUniquePtr(new auto(callback));
+  };
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun(
+      {{"slow_callback", make_callback("slow", absl::Milliseconds(20))},
+       {"fast_callback", make_callback("fast", absl::ZeroDuration())}}));
+  int64_t frame = 0;
+  // Returns the node that ran first for a new packet.
+  auto run_frame = [&]() -> std::string {
+    {
+      absl::MutexLock lock(&mutex);
+      run_order.clear();
+    }
+    MP_EXPECT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(0).At(Timestamp(frame++))));
+    MP_EXPECT_OK(graph.WaitUntilIdle());
+    absl::MutexLock lock(&mutex);
+    return run_order.empty() ? "" : run_order[0];
+  };
+
+  // Without history, the nodes cost the same, and the node declared last runs
+  // first.
+  EXPECT_EQ(run_frame(), "fast");
+  // The priorities are updated at most every 100 ms, when the graph becomes
+  // idle.
+  absl::SleepFor(absl::Milliseconds(150));
+  std::string first_node;
+  for (int i = 0; i < 10 && first_node != "slow"; ++i) {
+    first_node = run_frame();
+  }
+  EXPECT_EQ(first_node, "slow");
+
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+}
+
 TEST(CalculatorGraph, ObserveOutputStream) {
   const int max_count = 10;
   CalculatorGraphConfig config =
@@ -3976,6 +4244,117 @@ TEST(CalculatorGraph, ReuseValidatedGraphConfig) {
   }
 }
 
+TEST(CalculatorGraph, InitializesGraphsFromCompiledGraph) {
+  MP_ASSERT_OK_AND_ASSIGN(
+      std::shared_ptr<const CompiledGraph> compiled_graph,
+      CompiledGraph::Create(ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "in"
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "in"
+          output_stream: "mid"
+        }
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "mid"
+          output_stream: "out"
+        }
+      )pb")));
+
+  for (int i = 0; i < 3; ++i) {
+    CalculatorGraph graph;
+    MP_ASSERT_OK(graph.Initialize(compiled_graph));
+    // The graph uses the config of the compiled graph, without a copy.
+    EXPECT_EQ(&graph.Config(), &compiled_graph->Config());
+
+    std::vector<Packet> out_packets;
+    MP_ASSERT_OK(
+        graph.ObserveOutputStream("out", [&out_packets](const Packet& packet) {
+          out_packets.push_back(packet);
+          return absl::OkStatus();
+        }));
+    MP_ASSERT_OK(graph.StartRun({}));
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(i).At(Timestamp(i))));
+    MP_ASSERT_OK(graph.CloseAllInputStreams());
+    MP_ASSERT_OK(graph.WaitUntilDone());
+    ASSERT_EQ(out_packets.size(), 1);
+    EXPECT_EQ(out_packets[0].Get<int>(), i);
+  }
+}
+
+TEST(CalculatorGraph, GraphKeepsCompiledGraphAlive) {
+  MP_ASSERT_OK_AND_ASSIGN(
+      std::shared_ptr<const CompiledGraph> compiled_graph,
+      CompiledGraph::Create(ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        node {
+          calculator: "GlobalCountSourceCalculator"
+          input_side_packet: "global_counter"
+          output_stream: "unused"
+        }
+      )pb")));
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(compiled_graph));
+  compiled_graph.reset();
+
+  std::atomic<int> global_counter(0);
+  MP_ASSERT_OK(
+      graph.Run({{"global_counter", Adopt(new auto(&global_counter))}}));
+  EXPECT_EQ(global_counter.load(),
+            GlobalCountSourceCalculator::kNumOutputPackets);
+  EXPECT_EQ(graph.Config().node(0).calculator(), "GlobalCountSourceCalculator");
+}
+
+TEST(CalculatorGraph, RunsGraphsOfCompiledGraphConcurrently) {
+  MP_ASSERT_OK_AND_ASSIGN(
+      std::shared_ptr<const CompiledGraph> compiled_graph,
+      CompiledGraph::Create(ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        node {
+          calculator: "GlobalCountSourceCalculator"
+          input_side_packet: "global_counter"
+          output_stream: "unused"
+        }
+      )pb")));
+  std::atomic<int> global_counter(0);
+  Packet global_counter_packet = Adopt(new auto(&global_counter));
+
+  constexpr int kNumThreads = 4;
+  constexpr int kNumGraphsPerThread = 10;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < kNumGraphsPerThread; ++i) {
+        CalculatorGraph graph;
+        MP_ASSERT_OK(graph.Initialize(compiled_graph));
+        MP_ASSERT_OK(graph.Run({{"global_counter", global_counter_packet}}));
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(global_counter.load(),
+            kNumThreads * kNumGraphsPerThread *
+                GlobalCountSourceCalculator::kNumOutputPackets);
+}
+
+TEST(CalculatorGraph, CompiledGraphReportsInvalidConfig) {
+  absl::StatusOr<std::shared_ptr<const CompiledGraph>> compiled_graph =
+      CompiledGraph::Create(ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        node {
+          calculator: "NonExistentCalculator"
+          input_stream: "in"
+          output_stream: "out"
+        }
+      )pb"));
+  ASSERT_FALSE(compiled_graph.ok());
+  EXPECT_THAT(compiled_graph.status().message(),
+              testing::HasSubstr("NonExistentCalculator"));
+
+  CalculatorGraph graph;
+  EXPECT_FALSE(graph.Initialize(std::shared_ptr<const CompiledGraph>()).ok());
+}
+
 class TestRangeStdDevSubgraph : public Subgraph {
  public:
   absl::StatusOr<CalculatorGraphConfig> GetConfig(
@@ -4150,6 +4529,82 @@ TEST(CalculatorGraph, ReservedNameExecutorConfig) {
                                                testing::HasSubstr("reserved")));
 }
 
+TEST(CalculatorGraph, ReportsCpuMigrationsPerExecutor) {
+  CalculatorGraph graph;
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: 'in'
+        executor {
+          name: 'pinned'
+          type: 'ThreadPoolExecutor'
+          options {
+            [mediapipe.ThreadPoolExecutorOptions.ext] {
+              num_threads: 1
+              cpu_ids: 0
+              memory_policy: LOCAL_MEMORY
+              report_cpu_migrations: true
+            }
+          }
+        }
+        node {
+          name: 'pinned_node'
+          calculator: 'PassThroughCalculator'
+          executor: 'pinned'
+          input_stream: 'in'
+          output_stream: 'mid'
+        }
+        node {
+          name: 'default_node'
+          calculator: 'PassThroughCalculator'
+          input_stream: 'mid'
+          output_stream: 'out'
+        }
+      )pb");
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun({}));
+  for (int i = 0; i < 10; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  // Only the node on the executor with report_cpu_migrations has a counter.
+  std::map<std::string, int64_t> counters =
+      graph.GetCounterFactory()->GetCounterSet()->GetCountersValues();
+  EXPECT_THAT(counters,
+              testing::Contains(testing::Key("pinned_node-CpuMigrations")));
+  EXPECT_THAT(counters, testing::Not(testing::Contains(
+                            testing::Key("default_node-CpuMigrations"))));
+}
+
+TEST(CalculatorGraph, BindMemoryPolicyRequiresNumaNodes) {
+  CalculatorGraph graph;
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: 'in'
+        executor {
+          name: 'xyz'
+          type: 'ThreadPoolExecutor'
+          options {
+            [mediapipe.ThreadPoolExecutorOptions.ext] {
+              num_threads: 1
+              memory_policy: BIND_MEMORY
+            }
+          }
+        }
+        node {
+          calculator: 'PassThroughCalculator'
+          executor: 'xyz'
+          input_stream: 'in'
+          output_stream: 'out'
+        }
+      )pb");
+  absl::Status status = graph.Initialize(config);
+  EXPECT_EQ(status.code(), absl::StatusCode::kInvalidArgument);
+  EXPECT_THAT(status.message(), testing::HasSubstr("numa_nodes"));
+}
+
 TEST(CalculatorGraph, ReservedNameNodeExecutor) {
   // A reserved executor name such as "__gpu" must not be used.
   CalculatorGraph graph;
@@ -4520,6 +4975,73 @@ TEST(CalculatorGraph, GraphInputStreamBeforeStartRun) {
             absl::StatusCode::kFailedPrecondition);
 }
 
+TEST(CalculatorGraph, InputStreamHandle) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "input"
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "input"
+          output_stream: "output"
+        }
+      )pb");
+  std::vector<Packet> packet_dump;
+  tool::AddVectorSink("output", &config, &packet_dump);
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  EXPECT_FALSE(graph.GetInputStreamHandle("output").ok());
+  MP_ASSERT_OK_AND_ASSIGN(CalculatorGraph::InputStreamHandle input,
+                          graph.GetInputStreamHandle("input"));
+  EXPECT_EQ(input.name(), "input");
+  EXPECT_EQ(input.AddPacket(MakePacket<int>(0).At(Timestamp(0))).code(),
+            absl::StatusCode::kFailedPrecondition);
+
+  // The handle can be reused across runs.
+  for (int run = 0; run < 2; ++run) {
+    packet_dump.clear();
+    MP_ASSERT_OK(graph.StartRun({}));
+    for (int i = 0; i < 3; ++i) {
+      MP_ASSERT_OK(input.AddPacket(MakePacket<int>(i).At(Timestamp(i))));
+    }
+    std::vector<Packet> batch;
+    for (int i = 3; i < 6; ++i) {
+      batch.push_back(MakePacket<int>(i).At(Timestamp(i)));
+    }
+    MP_ASSERT_OK(input.AddPackets(absl::MakeSpan(batch)));
+    MP_ASSERT_OK(graph.CloseAllInputStreams());
+    MP_ASSERT_OK(graph.WaitUntilDone());
+    ASSERT_EQ(packet_dump.size(), 6);
+    for (int i = 0; i < 6; ++i) {
+      EXPECT_EQ(packet_dump[i].Get<int>(), i);
+      EXPECT_EQ(packet_dump[i].Timestamp(), Timestamp(i));
+    }
+  }
+}
+
+TEST(CalculatorGraph, InputStreamHandleReportsBadTimestamps) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "input"
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "input"
+          output_stream: "output"
+        }
+      )pb");
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK_AND_ASSIGN(CalculatorGraph::InputStreamHandle input,
+                          graph.GetInputStreamHandle("input"));
+  MP_ASSERT_OK(graph.StartRun({}));
+  std::vector<Packet> batch = {MakePacket<int>(1).At(Timestamp(1)),
+                               MakePacket<int>(0).At(Timestamp(0))};
+  // As with AddPacketToInputStream, the error may be reported only once the
+  // packets are propagated.
+  input.AddPackets(absl::MakeSpan(batch)).IgnoreError();
+  graph.CloseAllInputStreams().IgnoreError();
+  EXPECT_FALSE(graph.WaitUntilDone().ok());
+}
+
 // Returns the first packet of the input stream.
 class FirstPacketFilterCalculator : public CalculatorBase {
  public:
@@ -14,6 +14,7 @@
 
 #include "mediapipe/framework/calculator_node.h"
 
+#include <algorithm>
 #include <set>
 #include <string>
 #include <unordered_map>
@@ -28,6 +29,7 @@
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_base.h"
 #include "mediapipe/framework/counter_factory.h"
@@ -48,6 +50,7 @@
 #include "mediapipe/framework/tool/status_util.h"
 #include "mediapipe/framework/tool/tag_map.h"
 #include "mediapipe/framework/tool/validate_name.h"
+#include "mediapipe/util/cpu_util.h"
 
 namespace mediapipe {
 
@@ -91,6 +94,58 @@ void CopyCollection(const CollectionType& other, CollectionType* result) {
   }
 }
 
+// Returns true if the node uses the DefaultInputStreamHandler without options.
+bool UsesDefaultInputStreamHandler(const CalculatorGraphConfig::Node& node,
+                                   const CalculatorContract& contract) {
+  if (node.has_input_stream_handler()) {
+    return node.input_stream_handler().input_stream_handler() ==
+               "DefaultInputStreamHandler" &&
+           !node.input_stream_handler().has_options();
+  }
+  const std::string handler = contract.GetInputStreamHandler();
+  return handler.empty() || handler == "DefaultInputStreamHandler";
+}
+
+// Returns the maximum number of invocations of a node that can run at the
+// same time. Nodes of stateless calculators that don't set max_in_flight run
+// up to one invocation per CPU core, if their stream handlers support
+// parallel invocations.
+int MaxInFlight(const CalculatorGraphConfig::Node& node_config,
+                const CalculatorContract& contract) {
+  if (node_config.max_in_flight() > 0) {
+    return node_config.max_in_flight();
+  }
+  if (contract.IsStateless() && node_config.input_stream_size() > 0 &&
+      !contract.GetProcessTimestampBounds() &&
+      UsesDefaultInputStreamHandler(node_config, contract) &&
+      node_config.output_stream_handler().output_stream_handler() ==
+          "InOrderOutputStreamHandler") {
+    return std::max(mediapipe::NumCPUCores(), 1);
+  }
+  return 1;
+}
+
+// Returns true if the packets of the output stream with index
+// "output_stream_index" are added to its mirrors by one thread at a time,
+// which is the case if the stream belongs to a calculator that runs one
+// invocation at a time and uses the default output stream handler.
+bool PropagatesPacketsSerially(const ValidatedGraphConfig& validated_graph,
+                               int output_stream_index) {
+  const EdgeInfo& edge_info =
+      validated_graph.OutputStreamInfos()[output_stream_index];
+  if (edge_info.parent_node.type != NodeTypeInfo::NodeType::CALCULATOR) {
+    return false;
+  }
+  const CalculatorGraphConfig::Node& node_config =
+      validated_graph.Config().node(edge_info.parent_node.index);
+  const CalculatorContract& contract =
+      validated_graph.CalculatorInfos()[edge_info.parent_node.index]
+          .Contract();
+  return MaxInFlight(node_config, contract) <= 1 &&
+         node_config.output_stream_handler().output_stream_handler() ==
+             "InOrderOutputStreamHandler";
+}
+
 // Copies packet types omitting entries that are optional and not provided.
 std::unique_ptr<PacketTypeSet> RemoveOmittedPacketTypes(
     const PacketTypeSet& packet_types,
@@ -147,15 +202,14 @@ absl::Status CalculatorNode::Initialize(
         "node_ref is not a calculator or packet generator");
   }
 
-  max_in_flight_ = node_config->max_in_flight();
-  max_in_flight_ = max_in_flight_ ? max_in_flight_ : 1;
+  const CalculatorContract& contract = node_type_info_->Contract();
+
+  max_in_flight_ = MaxInFlight(*node_config, contract);
   if (!node_config->executor().empty()) {
     executor_ = node_config->executor();
   }
   source_layer_ = node_config->source_layer();
 
-  const CalculatorContract& contract = node_type_info_->Contract();
-
   // TODO Propagate types between calculators when SetAny is used.
 
   MP_RETURN_IF_ERROR(InitializeOutputSidePackets(
@@ -276,15 +330,28 @@ absl::Status CalculatorNode::InitializeInputStreams(
   MP_RETURN_IF_ERROR(input_stream_handler_->InitializeInputStreamManagers(
       current_input_stream_managers));
 
+  // An input stream read by one invocation at a time and written by a single
+  // calculator has a single producer and a single consumer, so it doesn't
+  // need to lock its packet queue. Graph input streams may be written by
+  // several application threads.
+  const bool single_consumer =
+      max_in_flight_ == 1 &&
+      input_stream_handler_->SupportsSingleProducerSingleConsumerStreams();
+
   // Set all the mirrors.
   for (CollectionItemId id = node_type_info_->InputStreamTypes().BeginId();
        id < node_type_info_->InputStreamTypes().EndId(); ++id) {
-    int output_stream_index =
-        validated_graph_
-            ->InputStreamInfos()[node_type_info_->InputStreamBaseIndex() +
-                                 id.value()]
-            .upstream;
+    const int input_stream_index =
+        node_type_info_->InputStreamBaseIndex() + id.value();
+    const EdgeInfo& edge_info =
+        validated_graph_->InputStreamInfos()[input_stream_index];
+    int output_stream_index = edge_info.upstream;
     RET_CHECK_LE(0, output_stream_index);
+    if (single_consumer && !edge_info.back_edge &&
+        PropagatesPacketsSerially(*validated_graph_, output_stream_index)) {
+      current_input_stream_managers[id.value()]
+          .EnableSingleProducerSingleConsumer();
+    }
     OutputStreamManager* origin_output_stream_manager =
         &output_stream_managers[output_stream_index];
     VLOG(2) << "Adding mirror for input stream with id " << id.value()
@@ -374,6 +441,18 @@ void CalculatorNode::SetMaxInputStreamQueueSize(int max_queue_size) {
   input_stream_handler_->SetMaxQueueSize(max_queue_size);
 }
 
+void CalculatorNode::EnableInputStreamByteAccounting(
+    InputStreamManager::QueueBytesCallback queue_bytes_callback) {
+  ABSL_CHECK(input_stream_handler_);
+  input_stream_handler_->EnableQueueByteAccounting(
+      std::move(queue_bytes_callback));
+}
+
+void CalculatorNode::SetMaxInputStreamQueueByteSize(int64_t max_queue_bytes) {
+  ABSL_CHECK(input_stream_handler_);
+  input_stream_handler_->SetMaxQueueByteSize(max_queue_bytes);
+}
+
 absl::Status CalculatorNode::PrepareForRun(
     const std::map<std::string, Packet>& all_side_packets,
     const std::map<std::string, Packet>& service_packets,
@@ -406,6 +485,19 @@ absl::Status CalculatorNode::PrepareForRun(
       &input_side_packet_handler_.InputSidePackets());
   calculator_state_->SetOutputSidePackets(output_side_packets_.get());
   calculator_state_->SetCounterFactory(counter_factory);
+  calculator_state_->SetPacketArena(packet_arena_);
+  calculator_state_->SetDeadlineTracker(deadline_tracker_);
+  // Sinks are not skipped, since the work for the timestamp is already done.
+  missed_deadlines_counter_ =
+      deadline_tracker_ && !IsSource() &&
+              output_stream_handler_->NumOutputStreams() > 0 &&
+              !contract.GetProcessStaleTimestamps()
+          ? calculator_state_->GetCounter("MissedDeadlines")
+          : nullptr;
+  cpu_migrations_counter_ = report_cpu_migrations_
+                                ? calculator_state_->GetCounter("CpuMigrations")
+                                : nullptr;
+  last_cpu_id_.store(-1, std::memory_order_relaxed);
 
   for (const auto& svc_req : contract.ServiceRequests()) {
     const auto& req = svc_req.second;
@@ -422,14 +514,28 @@ absl::Status CalculatorNode::PrepareForRun(
   MP_RETURN_IF_ERROR(calculator_context_manager_.PrepareForRun(std::bind(
       &CalculatorNode::ConnectShardsToStreams, this, std::placeholders::_1)));
 
-  MP_ASSIGN_OR_RETURN(
-      auto calculator_factory,
-      CalculatorBaseRegistry::CreateByNameInNamespace(
-          validated_graph_->Package(), calculator_state_->CalculatorType()));
-  calculator_ = calculator_factory->CreateCalculator(
-      calculator_context_manager_.GetDefaultCalculatorContext());
+  // A resettable calculator kept by CleanupAfterRun() is reset instead of
+  // being created again.
+  reset_calculator_ = calculator_ != nullptr;
+  if (!reset_calculator_) {
+    // Calculator nodes reuse the factory that validated them. Packet generator
+    // wrappers are looked up in the registry.
+    internal::CalculatorBaseFactory* calculator_factory =
+        node_type_info_->CalculatorFactory();
+    std::unique_ptr<internal::CalculatorBaseFactory> registry_factory;
+    if (calculator_factory == nullptr) {
+      MP_ASSIGN_OR_RETURN(registry_factory,
+                          CalculatorBaseRegistry::CreateByNameInNamespace(
+                              validated_graph_->Package(),
+                              calculator_state_->CalculatorType()));
+      calculator_factory = registry_factory.get();
+    }
+    calculator_ = calculator_factory->CreateCalculator(
+        calculator_context_manager_.GetDefaultCalculatorContext());
+  }
 
   needs_to_close_ = false;
+  calculator_closed_ = false;
 
   {
     absl::MutexLock status_lock(&status_mutex_);
@@ -499,7 +605,8 @@ absl::Status CalculatorNode::OpenNode() {
   } else {
     MEDIAPIPE_PROFILING(OPEN, default_context);
     LegacyCalculatorSupport::Scoped<CalculatorContext> s(default_context);
-    result = calculator_->Open(default_context);
+    result = reset_calculator_ ? calculator_->Reset(default_context)
+                               : calculator_->Open(default_context);
   }
 
   calculator_context_manager_.PopInputTimestampFromContext(default_context);
@@ -515,7 +622,8 @@ absl::Status CalculatorNode::OpenNode() {
       "used to signal that a source node is done producing data.",
       DebugName());
   MP_RETURN_IF_ERROR(result).SetPrepend() << absl::Substitute(
-      "Calculator::Open() for node \"$0\" failed: ", DebugName());
+      "Calculator::$0() for node \"$1\" failed: ",
+      reset_calculator_ ? "Reset" : "Open", DebugName());
   needs_to_close_ = true;
 
   bool offset_enabled = false;
@@ -604,6 +712,7 @@ absl::Status CalculatorNode::CloseNode(const absl::Status& graph_status,
     result = calculator_->Close(default_context);
   }
   needs_to_close_ = false;
+  calculator_closed_ = result.ok();
 
   ABSL_LOG_IF(FATAL, result == tool::StatusStop()) << absl::Substitute(
       "Close() on node \"$0\" returned tool::StatusStop() which should only be "
@@ -637,10 +746,18 @@ void CalculatorNode::CleanupAfterRun(const absl::Status& graph_status) {
         Timestamp::Done());
     CloseNode(graph_status, /*graph_run_ended=*/true).IgnoreError();
   }
-  calculator_ = nullptr;
+  // A resettable calculator is kept for the next run if this run succeeded.
+  if (!(Contract().IsResettable() && calculator_closed_ && graph_status.ok())) {
+    calculator_ = nullptr;
+  }
   // All pending output packets are automatically dropped when calculator
   // context manager destroys all calculator context objects.
   calculator_context_manager_.CleanupAfterRun();
+  // Packets allocated from the arena keep it alive as long as they need it.
+  calculator_state_->SetPacketArena(nullptr);
+  packet_arena_ = nullptr;
+  calculator_state_->SetDeadlineTracker(nullptr);
+  deadline_tracker_ = nullptr;
 
   CloseInputStreams();
   // All output stream shards have been destroyed by calculator context manager.
@@ -654,6 +771,13 @@ void CalculatorNode::CleanupAfterRun(const absl::Status& graph_status) {
   }
 }
 
+void CalculatorNode::ReleaseCalculator() {
+  absl::MutexLock lock(&status_mutex_);
+  if (status_ == kStateUninitialized) {
+    calculator_ = nullptr;
+  }
+}
+
 void CalculatorNode::SchedulingLoop() {
   int max_allowance = 0;
   {
@@ -798,9 +922,31 @@ std::string CalculatorNode::DebugName() const {
   return calculator_state_->NodeName();
 }
 
+void CalculatorNode::RecordCpuMigration() {
+  const int cpu_id = GetCurrentCpuId();
+  if (cpu_id < 0) return;
+  const int last_cpu_id =
+      last_cpu_id_.exchange(cpu_id, std::memory_order_relaxed);
+  if (last_cpu_id >= 0 && last_cpu_id != cpu_id) {
+    cpu_migrations_counter_->Increment();
+  }
+}
+
+bool CalculatorNode::SkipStaleTimestamp(Timestamp input_timestamp) {
+  if (missed_deadlines_counter_ == nullptr ||
+      !deadline_tracker_->IsStale(input_timestamp, absl::Now())) {
+    return false;
+  }
+  missed_deadlines_counter_->Increment();
+  return true;
+}
+
 // TODO: Split this function.
 absl::Status CalculatorNode::ProcessNode(
     CalculatorContext* calculator_context) {
+  if (cpu_migrations_counter_ != nullptr) {
+    RecordCpuMigration();
+  }
   if (IsSource()) {
     // This is a source Calculator.
     if (Closed()) {
@@ -864,6 +1010,12 @@ absl::Status CalculatorNode::ProcessNode(
         if (OutputsAreConstant(calculator_context)) {
           // Do nothing.
           result = absl::OkStatus();
+        } else if (SkipStaleTimestamp(input_timestamp)) {
+          // Lets the downstream nodes move past the stale timestamp.
+          for (auto& output : *outputs) {
+            output.SetNextTimestampBound(input_timestamp.NextAllowedInStream());
+          }
+          result = absl::OkStatus();
         } else {
           MEDIAPIPE_PROFILING(PROCESS, calculator_context);
           LegacyCalculatorSupport::Scoped<CalculatorContext> s(
@@ -919,4 +1071,10 @@ void CalculatorNode::SetQueueSizeCallbacks(
       std::move(becomes_full_callback), std::move(becomes_not_full_callback));
 }
 
+void CalculatorNode::SetBatchTimerCallback(
+    std::function<void()> batch_timer_callback) {
+  ABSL_CHECK(input_stream_handler_);
+  input_stream_handler_->SetBatchTimerCallback(std::move(batch_timer_callback));
+}
+
 }  // namespace mediapipe
@@ -20,6 +20,8 @@
 
 #include <stddef.h>
 
+#include <atomic>
+#include <cstdint>
 #include <functional>
 #include <map>
 #include <memory>
@@ -34,6 +36,7 @@
 #include "mediapipe/framework/calculator_context.h"
 #include "mediapipe/framework/calculator_context_manager.h"
 #include "mediapipe/framework/calculator_state.h"
+#include "mediapipe/framework/deadline_tracker.h"
 #include "mediapipe/framework/input_side_packet_handler.h"
 #include "mediapipe/framework/input_stream_handler.h"
 #include "mediapipe/framework/legacy_calculator_support.h"
@@ -94,6 +97,25 @@ class CalculatorNode {
   // Changes the executor a node is assigned to.
   void SetExecutor(const std::string& executor);
 
+  // If true, the next PrepareForRun() sets up the "CpuMigrations" counter,
+  // which counts the ProcessNode() calls that run on a different CPU than the
+  // previous ProcessNode() call of this node.
+  void SetReportCpuMigrations(bool report_cpu_migrations) {
+    report_cpu_migrations_ = report_cpu_migrations;
+  }
+
+  // Sets the packet arena that the next PrepareForRun() makes available to
+  // the calculator. May be null.
+  void SetPacketArena(std::shared_ptr<PacketArena> packet_arena) {
+    packet_arena_ = std::move(packet_arena);
+  }
+
+  // Sets the deadline tracker that the next PrepareForRun() makes available
+  // to the calculator. May be null.
+  void SetDeadlineTracker(std::shared_ptr<DeadlineTracker> deadline_tracker) {
+    deadline_tracker_ = std::move(deadline_tracker);
+  }
+
   // Calls Process() on the Calculator corresponding to this node.
   absl::Status ProcessNode(CalculatorContext* calculator_context);
 
@@ -139,6 +161,9 @@ class CalculatorNode {
   // the graph run.
   void CleanupAfterRun(const absl::Status& graph_status)
       ABSL_LOCKS_EXCLUDED(status_mutex_);
+  // Deletes the resettable calculator kept by CleanupAfterRun(), if any.
+  // Does nothing during a run.
+  void ReleaseCalculator() ABSL_LOCKS_EXCLUDED(status_mutex_);
 
   // Returns true iff PrepareForRun() has been called (and types verified).
   bool Prepared() const ABSL_LOCKS_EXCLUDED(status_mutex_);
@@ -209,10 +234,23 @@ class CalculatorNode {
       InputStreamManager::QueueSizeCallback becomes_full_callback,
       InputStreamManager::QueueSizeCallback becomes_not_full_callback);
 
+  // Sets the callback that schedules the node when an incomplete input batch
+  // times out. See InputStreamHandler::SetBatchTimerCallback().
+  void SetBatchTimerCallback(std::function<void()> batch_timer_callback);
+
   // Sets each of this node's input streams to use the specified
   // max_queue_size to trigger callbacks.
   void SetMaxInputStreamQueueSize(int max_queue_size);
 
+  // Makes each of this node's input streams account for the payload bytes of
+  // their queued packets, see InputStreamManager::EnableQueueByteAccounting().
+  void EnableInputStreamByteAccounting(
+      InputStreamManager::QueueBytesCallback queue_bytes_callback);
+
+  // Sets each of this node's input streams to use the specified
+  // max_queue_bytes to trigger callbacks.
+  void SetMaxInputStreamQueueByteSize(int64_t max_queue_bytes);
+
   // Closes the node's calculator and input and output streams.
   // graph_status is the current status of the graph run. graph_run_ended
   // indicates whether the graph run has ended.
@@ -285,6 +323,14 @@ class CalculatorNode {
   // Returns true if all outputs will be identical to the previous graph run.
   bool OutputsAreConstant(CalculatorContext* cc);
 
+  // Returns true if Process() should be skipped for "input_timestamp"
+  // because its deadline has passed, and counts the missed deadline.
+  bool SkipStaleTimestamp(Timestamp input_timestamp);
+
+  // Increments cpu_migrations_counter_ if the calling thread runs on a
+  // different CPU than the previous ProcessNode() call.
+  void RecordCpuMigration();
+
   // The calculator.
   std::unique_ptr<CalculatorBase> calculator_;
   // Keeps data which a Calculator subclass needs access to.
@@ -367,6 +413,27 @@ class CalculatorNode {
 
   // True if CleanupAfterRun() needs to call CloseNode().
   bool needs_to_close_ = false;
+  // True if Close() succeeded in the current run.
+  bool calculator_closed_ = false;
+  // True if the current run reuses the resettable calculator of the previous
+  // run, which gets a Reset() call instead of Open().
+  bool reset_calculator_ = false;
+
+  bool report_cpu_migrations_ = false;
+  // Counts CPU migrations between ProcessNode() calls. Null unless
+  // report_cpu_migrations_ is set.
+  Counter* cpu_migrations_counter_ = nullptr;
+  // The CPU the previous ProcessNode() call ran on, or -1.
+  std::atomic<int> last_cpu_id_{-1};
+
+  // The packet arena of the current graph run, or null.
+  std::shared_ptr<PacketArena> packet_arena_;
+
+  // The deadline tracker of the current graph run, or null.
+  std::shared_ptr<DeadlineTracker> deadline_tracker_;
+  // Counts the timestamps skipped because their deadline had passed. Null
+  // unless the node skips stale timestamps.
+  Counter* missed_deadlines_counter_ = nullptr;
 
   internal::SchedulerQueue* scheduler_queue_ = nullptr;
 
@@ -19,21 +19,27 @@
 //
 // TODO: Add more tests to verify the correctness of parallel execution.
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
 #include <random>
 #include <string>
 #include <vector>
 
 #include "absl/memory/memory.h"
+#include "absl/strings/substitute.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
+#include "mediapipe/framework/api2/node.h"
+#include "mediapipe/framework/api2/port.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
 #include "mediapipe/framework/port/parse_text_proto.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/util/cpu_util.h"
 
 namespace mediapipe {
 
@@ -152,5 +158,91 @@ TEST_F(ParallelExecutionTest, SlowPlusOneCalculatorsTest) {
   }
 }
 
+// Adds one to its input, taking less time for later timestamps, so that
+// parallel invocations finish out of order. Records the maximum number of
+// concurrent invocations.
+class StatelessPlusOneCalculator : public api2::Node {
+ public:
+  static constexpr api2::Input<int> kIn{""};
+  static constexpr api2::Output<int> kOut{""};
+  MEDIAPIPE_NODE_CONTRACT(kIn, kOut, api2::Stateless());
+
+  static std::atomic<int> in_flight;
+  static std::atomic<int> max_in_flight;
+
+  absl::Status Process(CalculatorContext* cc) override {
+    const int current = ++in_flight;
+    int max = max_in_flight.load();
+    while (current > max &&
+           !max_in_flight.compare_exchange_weak(max, current)) {
+    }
+    absl::SleepFor(absl::Milliseconds(10 - cc->InputTimestamp().Value() % 10));
+    kOut(cc).Send(*kIn(cc) + 1);
+    --in_flight;
+    return absl::OkStatus();
+  }
+};
+std::atomic<int> StatelessPlusOneCalculator::in_flight{0};
+std::atomic<int> StatelessPlusOneCalculator::max_in_flight{0};
+MEDIAPIPE_REGISTER_NODE(StatelessPlusOneCalculator);
+
+// Runs 40 timestamps through a StatelessPlusOneCalculator node with the given
+// options, and returns the maximum number of concurrent invocations.
+int RunStatelessNode(const std::string& node_options,
+                     std::vector<Packet>* output_packets) {
+  CalculatorGraphConfig graph_config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(absl::Substitute(
+          R"pb(
+            input_stream: "input"
+            node {
+              calculator: "StatelessPlusOneCalculator"
+              input_stream: "input"
+              output_stream: "output"
+              $0
+            }
+            num_threads: 4
+          )pb",
+          node_options));
+  StatelessPlusOneCalculator::max_in_flight = 0;
+  CalculatorGraph graph;
+  MP_EXPECT_OK(graph.Initialize(graph_config));
+  MP_EXPECT_OK(graph.ObserveOutputStream("output", [&](const Packet& packet) {
+    output_packets->push_back(packet);
+    return absl::OkStatus();
+  }));
+  MP_EXPECT_OK(graph.StartRun({}));
+  for (int i = 0; i < 40; ++i) {
+    MP_EXPECT_OK(graph.AddPacketToInputStream(
+        "input", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  MP_EXPECT_OK(graph.CloseAllInputStreams());
+  MP_EXPECT_OK(graph.WaitUntilDone());
+  return StatelessPlusOneCalculator::max_in_flight;
+}
+
+TEST(StatelessCalculatorTest, RunsTimestampsInParallelInOrder) {
+  std::vector<Packet> output_packets;
+  const int max_in_flight = RunStatelessNode("", &output_packets);
+  EXPECT_LE(max_in_flight, std::max(NumCPUCores(), 1));
+  if (NumCPUCores() > 1) {
+    EXPECT_GT(max_in_flight, 1);
+  }
+  // Output packets are sent in timestamp order.
+  ASSERT_EQ(output_packets.size(), 40);
+  for (int i = 0; i < 40; ++i) {
+    EXPECT_EQ(output_packets[i].Timestamp(), Timestamp(i));
+    EXPECT_EQ(output_packets[i].Get<int>(), i + 1);
+  }
+}
+
+TEST(StatelessCalculatorTest, MaxInFlightOverridesStateless) {
+  std::vector<Packet> output_packets;
+  EXPECT_EQ(RunStatelessNode("max_in_flight: 1", &output_packets), 1);
+  EXPECT_EQ(output_packets.size(), 40);
+  output_packets.clear();
+  EXPECT_LE(RunStatelessNode("max_in_flight: 2", &output_packets), 2);
+  EXPECT_EQ(output_packets.size(), 40);
+}
+
 }  // namespace
 }  // namespace mediapipe
@@ -26,9 +26,11 @@
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/counter.h"
 #include "mediapipe/framework/counter_factory.h"
+#include "mediapipe/framework/deadline_tracker.h"
 #include "mediapipe/framework/graph_service.h"
 #include "mediapipe/framework/graph_service_manager.h"
 #include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/packet_arena.h"
 #include "mediapipe/framework/packet_set.h"
 #include "mediapipe/framework/port.h"
 #include "mediapipe/framework/port/any_proto.h"
@@ -92,6 +94,18 @@ class CalculatorState {
     return profiling_context_;
   }
 
+  // Returns the packet arena of the current graph run, or null if the graph
+  // does not use one.
+  const std::shared_ptr<PacketArena>& GetPacketArena() const {
+    return packet_arena_;
+  }
+
+  // Returns the deadline tracker of the current graph run, or null if the
+  // graph has no latency budget.
+  const std::shared_ptr<DeadlineTracker>& GetDeadlineTracker() const {
+    return deadline_tracker_;
+  }
+
   ////////////////////////////////////////
   // Interface for CalculatorNode.
   ////////////////////////////////////////
@@ -103,6 +117,14 @@ class CalculatorState {
   void SetCounterFactory(CounterFactory* counter_factory) {
     counter_factory_ = counter_factory;
   }
+  // Sets the packet arena.
+  void SetPacketArena(std::shared_ptr<PacketArena> packet_arena) {
+    packet_arena_ = std::move(packet_arena);
+  }
+  // Sets the deadline tracker.
+  void SetDeadlineTracker(std::shared_ptr<DeadlineTracker> deadline_tracker) {
+    deadline_tracker_ = std::move(deadline_tracker);
+  }
 
   absl::Status SetServicePacket(const GraphServiceBase& service,
                                 Packet packet) {
@@ -144,6 +166,10 @@ class CalculatorState {
   OutputSidePacketSet* output_side_packets_;
 
   CounterFactory* counter_factory_;
+
+  std::shared_ptr<PacketArena> packet_arena_;
+
+  std::shared_ptr<DeadlineTracker> deadline_tracker_;
 };
 
 }  // namespace mediapipe
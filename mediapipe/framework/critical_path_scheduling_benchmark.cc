@@ -0,0 +1,147 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Benchmark for the end-to-end latency of a branched graph under the
+// scheduling policies of CalculatorGraphConfig.
+//
+// A fanout node feeds a slow node and four short chains of two fast nodes,
+// which all join in a final node, and the graph runs on two threads. The slow
+// node is declared between the chains, so the NODE_ORDER policy runs it after
+// the chains declared after it. Once the profiler history of the first
+// frames is in, the CRITICAL_PATH policy finds that the slow node is on the
+// critical path and starts it first. Calculators sleep instead of computing,
+// like calculators waiting on an accelerator, so that the result doesn't
+// depend on the number of cores. The benchmark time is the latency of one
+// packet.
+//
+// $ bazel run -c opt mediapipe/framework:critical_path_scheduling_benchmark
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "absl/log/absl_check.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "benchmark/benchmark.h"
+#include "mediapipe/framework/calculator_framework.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr int kNumChains = 4;
+constexpr int64_t kSlowUsec = 3000;
+constexpr int64_t kFastUsec = 250;
+
+// Sleeps for "USEC" microseconds and outputs its first input.
+class SleepingCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    for (CollectionItemId id = cc->Inputs().BeginId();
+         id < cc->Inputs().EndId(); ++id) {
+      cc->Inputs().Get(id).SetAny();
+    }
+    cc->Outputs().Index(0).SetAny();
+    cc->InputSidePackets().Tag("USEC").Set<int64_t>();
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    absl::SleepFor(
+        absl::Microseconds(cc->InputSidePackets().Tag("USEC").Get<int64_t>()));
+    cc->Outputs().Index(0).AddPacket(cc->Inputs().Index(0).Value());
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(SleepingCalculator);
+
+CalculatorGraphConfig BranchedConfig(
+    CalculatorGraphConfig::SchedulingPolicy policy) {
+  CalculatorGraphConfig config;
+  config.add_input_stream("in");
+  config.set_num_threads(2);
+  config.set_scheduling_policy(policy);
+  config.mutable_profiler_config()->set_enable_profiler(true);
+
+  auto add_node = [&config](const std::string& input, const std::string& output,
+                            const std::string& usec) {
+    CalculatorGraphConfig::Node* node = config.add_node();
+    node->set_calculator("SleepingCalculator");
+    node->add_input_stream(input);
+    node->add_output_stream(output);
+    node->add_input_side_packet(absl::StrCat("USEC:", usec));
+    return node;
+  };
+  // The fanout node runs on an executor thread, so that the ready branches
+  // are queued together.
+  add_node("in", "fanout", "zero_usec");
+  auto add_chain = [&add_node](int i) {
+    add_node("fanout", absl::StrCat("fast_", i, "_0"), "fast_usec");
+    add_node(absl::StrCat("fast_", i, "_0"), absl::StrCat("fast_", i, "_1"),
+             "fast_usec");
+  };
+  for (int i = 0; i < kNumChains / 2; ++i) add_chain(i);
+  add_node("fanout", "slow", "slow_usec");
+  for (int i = kNumChains / 2; i < kNumChains; ++i) add_chain(i);
+  CalculatorGraphConfig::Node* join = add_node("slow", "out", "zero_usec");
+  for (int i = 0; i < kNumChains; ++i) {
+    join->add_input_stream(absl::StrCat("fast_", i, "_1"));
+  }
+  return config;
+}
+
+// Arguments: the scheduling policy.
+void BM_BranchedGraphLatency(benchmark::State& state) {
+  const auto policy =
+      static_cast<CalculatorGraphConfig::SchedulingPolicy>(state.range(0));
+  const std::map<std::string, Packet> side_packets = {
+      {"slow_usec", MakePacket<int64_t>(kSlowUsec)},
+      {"fast_usec", MakePacket<int64_t>(kFastUsec)},
+      {"zero_usec", MakePacket<int64_t>(0)},
+  };
+  CalculatorGraph graph;
+  ABSL_CHECK_OK(graph.Initialize(BranchedConfig(policy)));
+  int64_t frame = 0;
+  auto run_frame = [&graph, &frame]() {
+    ABSL_CHECK_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int64_t>(frame).At(Timestamp(frame))));
+    ++frame;
+    ABSL_CHECK_OK(graph.WaitUntilIdle());
+  };
+
+  ABSL_CHECK_OK(graph.StartRun(side_packets));
+  // The CRITICAL_PATH policy updates the priorities from the profiler history
+  // at most every 100 ms, so the warm-up lasts longer than that.
+  const absl::Time warm_up_end = absl::Now() + absl::Milliseconds(250);
+  while (absl::Now() < warm_up_end) {
+    run_frame();
+  }
+  for (auto _ : state) {
+    run_frame();
+  }
+  ABSL_CHECK_OK(graph.CloseAllInputStreams());
+  ABSL_CHECK_OK(graph.WaitUntilDone());
+}
+BENCHMARK(BM_BranchedGraphLatency)
+    ->Arg(CalculatorGraphConfig::NODE_ORDER)
+    ->Arg(CalculatorGraphConfig::CRITICAL_PATH)
+    ->ArgName("policy")
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+
+}  // namespace
+}  // namespace mediapipe
+
+BENCHMARK_MAIN();
@@ -0,0 +1,62 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/deadline_tracker.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/timestamp.h"
+
+namespace mediapipe {
+
+void DeadlineTracker::AddInputTimestamp(Timestamp timestamp, absl::Time now) {
+  absl::MutexLock lock(&mutex_);
+  ExpireDeadlines(now);
+  if (latest_input_ != Timestamp::Unset() && timestamp <= latest_input_) {
+    return;
+  }
+  latest_input_ = timestamp;
+  deadlines_.emplace_back(timestamp, now + budget_);
+}
+
+absl::Time DeadlineTracker::Deadline(Timestamp timestamp) {
+  absl::MutexLock lock(&mutex_);
+  if (latest_stale_ != Timestamp::Unset() && timestamp <= latest_stale_) {
+    return latest_stale_deadline_;
+  }
+  auto it = std::lower_bound(
+      deadlines_.begin(), deadlines_.end(), timestamp,
+      [](const std::pair<Timestamp, absl::Time>& deadline,
+         Timestamp timestamp) { return deadline.first < timestamp; });
+  return it == deadlines_.end() ? absl::InfiniteFuture() : it->second;
+}
+
+bool DeadlineTracker::IsStale(Timestamp timestamp, absl::Time now) {
+  absl::MutexLock lock(&mutex_);
+  ExpireDeadlines(now);
+  return latest_stale_ != Timestamp::Unset() && timestamp <= latest_stale_;
+}
+
+void DeadlineTracker::ExpireDeadlines(absl::Time now) {
+  while (!deadlines_.empty() && deadlines_.front().second <= now) {
+    latest_stale_ = deadlines_.front().first;
+    latest_stale_deadline_ = deadlines_.front().second;
+    deadlines_.pop_front();
+  }
+}
+
+}  // namespace mediapipe
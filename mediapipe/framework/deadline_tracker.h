@@ -0,0 +1,87 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_DEADLINE_TRACKER_H_
+#define MEDIAPIPE_FRAMEWORK_DEADLINE_TRACKER_H_
+
+#include <deque>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/timestamp.h"
+
+namespace mediapipe {
+
+// Tracks the deadlines of the timestamps of a graph run.
+//
+// A CalculatorGraph creates one tracker per run if the graph config sets
+// latency_budget_usec. The deadline of a timestamp is the time at which its
+// first packet was added to a graph input stream, plus the budget. Once the
+// deadline of a timestamp has passed, the timestamp is stale: nodes with
+// output streams skip Process() for it, unless their calculator opts out with
+// CalculatorContract::SetProcessStaleTimestamps, and calculators can check
+// CalculatorContext::DeadlineExceeded() to cancel work in progress.
+//
+// Timestamps are expected to enter the graph in increasing order, so a
+// timestamp is also stale once the deadline of a later timestamp has passed.
+// This keeps only the deadlines that haven't passed yet in memory.
+//
+// DeadlineTracker is thread-safe.
+class DeadlineTracker {
+ public:
+  explicit DeadlineTracker(absl::Duration budget) : budget_(budget) {}
+
+  DeadlineTracker(const DeadlineTracker&) = delete;
+  DeadlineTracker& operator=(const DeadlineTracker&) = delete;
+
+  absl::Duration budget() const { return budget_; }
+
+  // Records that a packet at "timestamp" entered the graph at "now". Only the
+  // first packet of a timestamp sets its deadline; packets older than the
+  // latest timestamp don't set a deadline.
+  void AddInputTimestamp(Timestamp timestamp, absl::Time now)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Returns the deadline of "timestamp": the deadline of the earliest input
+  // timestamp not before it, or absl::InfiniteFuture() if there is none.
+  absl::Time Deadline(Timestamp timestamp) ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Returns true if "timestamp" is stale at "now".
+  bool IsStale(Timestamp timestamp, absl::Time now)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  // Forgets the deadlines that have passed at "now".
+  void ExpireDeadlines(absl::Time now) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const absl::Duration budget_;
+
+  absl::Mutex mutex_;
+  // The input timestamps whose deadline hasn't passed yet, in increasing
+  // order, with their deadlines.
+  std::deque<std::pair<Timestamp, absl::Time>> deadlines_
+      ABSL_GUARDED_BY(mutex_);
+  // The latest input timestamp, and the latest stale input timestamp with its
+  // deadline.
+  Timestamp latest_input_ ABSL_GUARDED_BY(mutex_) = Timestamp::Unset();
+  Timestamp latest_stale_ ABSL_GUARDED_BY(mutex_) = Timestamp::Unset();
+  absl::Time latest_stale_deadline_ ABSL_GUARDED_BY(mutex_) =
+      absl::InfinitePast();
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_DEADLINE_TRACKER_H_
@@ -0,0 +1,207 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/deadline_tracker.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/timestamp.h"
+#include "mediapipe/framework/tool/sink.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::ElementsAre;
+
+const absl::Time kStart = absl::FromUnixSeconds(1000);
+
+TEST(DeadlineTrackerTest, TimestampsBecomeStaleAtTheirDeadline) {
+  DeadlineTracker tracker(absl::Milliseconds(10));
+  tracker.AddInputTimestamp(Timestamp(0), kStart);
+  tracker.AddInputTimestamp(Timestamp(1), kStart + absl::Milliseconds(5));
+  EXPECT_EQ(tracker.Deadline(Timestamp(0)), kStart + absl::Milliseconds(10));
+  EXPECT_EQ(tracker.Deadline(Timestamp(1)), kStart + absl::Milliseconds(15));
+  EXPECT_EQ(tracker.Deadline(Timestamp(2)), absl::InfiniteFuture());
+
+  EXPECT_FALSE(
+      tracker.IsStale(Timestamp(0), kStart + absl::Milliseconds(9)));
+  EXPECT_TRUE(
+      tracker.IsStale(Timestamp(0), kStart + absl::Milliseconds(10)));
+  EXPECT_FALSE(
+      tracker.IsStale(Timestamp(1), kStart + absl::Milliseconds(10)));
+  EXPECT_TRUE(
+      tracker.IsStale(Timestamp(1), kStart + absl::Milliseconds(15)));
+  // Expired deadlines are still reported.
+  EXPECT_EQ(tracker.Deadline(Timestamp(0)), kStart + absl::Milliseconds(15));
+  EXPECT_EQ(tracker.Deadline(Timestamp(1)), kStart + absl::Milliseconds(15));
+}
+
+TEST(DeadlineTrackerTest, FirstPacketOfTimestampSetsDeadline) {
+  DeadlineTracker tracker(absl::Milliseconds(10));
+  tracker.AddInputTimestamp(Timestamp(1), kStart);
+  tracker.AddInputTimestamp(Timestamp(1), kStart + absl::Milliseconds(5));
+  // Timestamps older than the latest one don't get a deadline of their own.
+  tracker.AddInputTimestamp(Timestamp(0), kStart + absl::Milliseconds(5));
+  EXPECT_EQ(tracker.Deadline(Timestamp(1)), kStart + absl::Milliseconds(10));
+  EXPECT_EQ(tracker.Deadline(Timestamp(0)), kStart + absl::Milliseconds(10));
+  EXPECT_TRUE(
+      tracker.IsStale(Timestamp(0), kStart + absl::Milliseconds(10)));
+}
+
+constexpr absl::Duration kLatencyBudget = absl::Milliseconds(200);
+
+// Passes its input through, but takes longer than the latency budget for
+// timestamp 0.
+class SlowFirstTimestampCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).SetAny();
+    cc->Outputs().Index(0).SetSameAs(&cc->Inputs().Index(0));
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    if (cc->InputTimestamp() == Timestamp(0)) {
+      absl::SleepFor(2 * kLatencyBudget);
+      // The calculator would cancel its work here.
+      RET_CHECK(cc->DeadlineExceeded());
+      RET_CHECK_LT(cc->Deadline(), absl::Now());
+    } else {
+      RET_CHECK(!cc->DeadlineExceeded());
+    }
+    cc->Outputs().Index(0).AddPacket(cc->Inputs().Index(0).Value());
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(SlowFirstTimestampCalculator);
+
+// A pass-through calculator that also processes stale timestamps.
+class StalePassThroughCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).SetAny();
+    cc->Outputs().Index(0).SetSameAs(&cc->Inputs().Index(0));
+    cc->SetProcessStaleTimestamps(true);
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    cc->Outputs().Index(0).AddPacket(cc->Inputs().Index(0).Value());
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(StalePassThroughCalculator);
+
+std::vector<int64_t> Timestamps(const std::vector<Packet>& packets) {
+  std::vector<int64_t> timestamps;
+  for (const Packet& packet : packets) {
+    timestamps.push_back(packet.Timestamp().Value());
+  }
+  return timestamps;
+}
+
+TEST(DeadlineTrackerTest, GraphSkipsStaleTimestamps) {
+  auto config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "in"
+    node {
+      name: "slow"
+      calculator: "SlowFirstTimestampCalculator"
+      input_stream: "in"
+      output_stream: "slow_out"
+    }
+    node {
+      name: "skipping"
+      calculator: "PassThroughCalculator"
+      input_stream: "slow_out"
+      output_stream: "skipping_out"
+    }
+    node {
+      name: "processing"
+      calculator: "StalePassThroughCalculator"
+      input_stream: "slow_out"
+      output_stream: "processing_out"
+    }
+  )pb");
+  config.set_latency_budget_usec(absl::ToInt64Microseconds(kLatencyBudget));
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  std::vector<Packet> skipping_out;
+  std::vector<Packet> processing_out;
+  MP_ASSERT_OK(graph.ObserveOutputStream("skipping_out", [&](const Packet& p) {
+    skipping_out.push_back(p);
+    return absl::OkStatus();
+  }));
+  MP_ASSERT_OK(
+      graph.ObserveOutputStream("processing_out", [&](const Packet& p) {
+        processing_out.push_back(p);
+        return absl::OkStatus();
+      }));
+  MP_ASSERT_OK(graph.StartRun({}));
+  // Timestamps 1 and 2 become stale while the slow node processes timestamp
+  // 0, which itself is late.
+  for (int i = 0; i < 3; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  MP_ASSERT_OK(graph.WaitUntilIdle());
+  // The skipped timestamps don't hold back the next ones.
+  MP_ASSERT_OK(graph.AddPacketToInputStream(
+      "in", MakePacket<int>(3).At(Timestamp(3))));
+  MP_ASSERT_OK(graph.WaitUntilIdle());
+
+  EXPECT_THAT(Timestamps(skipping_out), ElementsAre(3));
+  EXPECT_THAT(Timestamps(processing_out), ElementsAre(0, 3));
+  CounterFactory* counters = graph.GetCounterFactory();
+  EXPECT_EQ(counters->GetCounter("slow-MissedDeadlines")->Get(), 2);
+  EXPECT_EQ(counters->GetCounter("skipping-MissedDeadlines")->Get(), 1);
+  EXPECT_EQ(counters->GetCounter("processing-MissedDeadlines")->Get(), 0);
+
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+}
+
+TEST(DeadlineTrackerTest, GraphWithoutBudgetProcessesAllTimestamps) {
+  auto config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "in"
+    node {
+      calculator: "PassThroughCalculator"
+      input_stream: "in"
+      output_stream: "out"
+    }
+  )pb");
+  std::vector<Packet> out;
+  tool::AddVectorSink("out", &config, &out);
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun({}));
+  for (int i = 0; i < 3; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+  EXPECT_THAT(Timestamps(out), ElementsAre(0, 1, 2));
+}
+
+}  // namespace
+}  // namespace mediapipe
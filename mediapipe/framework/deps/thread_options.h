@@ -26,6 +26,13 @@ namespace mediapipe {
 // the field descriptions.
 class ThreadOptions {
  public:
+  // NUMA placement of the memory allocated by the thread.
+  enum class MemoryPolicy {
+    kDefault,  // Inherit the memory policy of the process.
+    kLocal,    // Allocate on the node of the CPU the thread is running on.
+    kBind,     // Allocate only on the nodes in numa_nodes().
+  };
+
   ThreadOptions() : stack_size_(0), nice_priority_level_(0) {}
 
   // Set the thread stack size (in bytes).  Passing stack_size==0 resets
@@ -46,6 +53,16 @@ class ThreadOptions {
     return *this;
   }
 
+  ThreadOptions& set_numa_nodes(const std::set<int>& numa_nodes) {
+    numa_nodes_ = numa_nodes;
+    return *this;
+  }
+
+  ThreadOptions& set_memory_policy(MemoryPolicy memory_policy) {
+    memory_policy_ = memory_policy;
+    return *this;
+  }
+
   ThreadOptions& set_name_prefix(const std::string& name_prefix) {
     name_prefix_ = name_prefix;
     return *this;
@@ -57,12 +74,18 @@ class ThreadOptions {
 
   const std::set<int>& cpu_set() const { return cpu_set_; }
 
+  const std::set<int>& numa_nodes() const { return numa_nodes_; }
+
+  MemoryPolicy memory_policy() const { return memory_policy_; }
+
   std::string name_prefix() const { return name_prefix_; }
 
  private:
   size_t stack_size_;        // Size of thread stack
   int nice_priority_level_;  // Nice priority level of the workers
   std::set<int> cpu_set_;    // CPU set for affinity setting
+  std::set<int> numa_nodes_;  // NUMA nodes for the kBind memory policy
+  MemoryPolicy memory_policy_ = MemoryPolicy::kDefault;
   std::string name_prefix_;  // Name of the thread
 };
 
@@ -110,6 +110,12 @@ namespace internal {
 // name_prefix_long, 1234  -> name_prefix_lon
 std::string CreateThreadName(const std::string& prefix, int thread_id);
 
+// Applies the nice priority level, processor affinity, memory policy and
+// thread name from "thread_options" to the calling thread. Invoked by each
+// worker thread of a thread pool before it starts running tasks.
+void ConfigureWorkerThread(const ThreadOptions& thread_options,
+                           const std::string& name_prefix);
+
 }  // namespace internal
 
 }  // namespace mediapipe
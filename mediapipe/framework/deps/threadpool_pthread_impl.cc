@@ -18,6 +18,10 @@
 #include <sys/syscall.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <set>
+#include <vector>
+
 #include "absl/log/absl_check.h"
 #include "absl/log/absl_log.h"
 #include "absl/strings/str_cat.h"
@@ -59,57 +63,8 @@ void ThreadPool::WorkerThread::Join() { pthread_join(thread_, nullptr); }
 
 void* ThreadPool::WorkerThread::ThreadBody(void* arg) {
   auto thread = reinterpret_cast<WorkerThread*>(arg);
-  int nice_priority_level =
-      thread->pool_->thread_options().nice_priority_level();
-  const std::set<int> selected_cpus = thread->pool_->thread_options().cpu_set();
-#if defined(__linux__)
-  const std::string name =
-      internal::CreateThreadName(thread->name_prefix_, syscall(SYS_gettid));
-  if (nice_priority_level != 0) {
-    if (nice(nice_priority_level) != -1 || errno == 0) {
-      VLOG(1) << "Changed the nice priority level by " << nice_priority_level;
-    } else {
-      ABSL_LOG(ERROR) << "Error : " << strerror(errno) << std::endl
-                      << "Could not change the nice priority level by "
-                      << nice_priority_level;
-    }
-  }
-  if (!selected_cpus.empty()) {
-    cpu_set_t cpu_set;
-    CPU_ZERO(&cpu_set);
-    for (const int cpu : selected_cpus) {
-      CPU_SET(cpu, &cpu_set);
-    }
-    if (sched_setaffinity(syscall(SYS_gettid), sizeof(cpu_set_t), &cpu_set) !=
-            -1 ||
-        errno == 0) {
-      VLOG(1) << "Pinned the thread pool executor to processor "
-              << absl::StrJoin(selected_cpus, ", processor ") << ".";
-    } else {
-      ABSL_LOG(ERROR) << "Error : " << strerror(errno) << std::endl
-                      << "Failed to set processor affinity. Ignore processor "
-                         "affinity setting for now.";
-    }
-  }
-  int error = pthread_setname_np(pthread_self(), name.c_str());
-  if (error != 0) {
-    ABSL_LOG(ERROR) << "Error : " << strerror(error) << std::endl
-                    << "Failed to set name for thread: " << name;
-  }
-#else
-  const std::string name = internal::CreateThreadName(thread->name_prefix_, 0);
-  if (nice_priority_level != 0 || !selected_cpus.empty()) {
-    ABSL_LOG(ERROR) << "Thread priority and processor affinity feature aren't "
-                       "supported on the current platform.";
-  }
-#if __APPLE__
-  int error = pthread_setname_np(name.c_str());
-  if (error != 0) {
-    ABSL_LOG(ERROR) << "Error : " << strerror(error) << std::endl
-                    << "Failed to set name for thread: " << name;
-  }
-#endif  // __APPLE__
-#endif  // __linux__
+  internal::ConfigureWorkerThread(thread->pool_->thread_options(),
+                                  thread->name_prefix_);
   thread->pool_->RunWorker();
   return nullptr;
 }
@@ -182,8 +137,110 @@ const ThreadOptions& ThreadPool::thread_options() const {
   return thread_options_;
 }
 
+namespace {
+
+#if defined(__linux__)
+// Modes of set_mempolicy(2), see <linux/mempolicy.h>.
+constexpr int kMemoryPolicyBind = 2;
+constexpr int kMemoryPolicyLocal = 4;
+
+// Applies "memory_policy" to the calling thread. Calls set_mempolicy(2)
+// directly so that MediaPipe does not depend on libnuma.
+void SetMemoryPolicy(ThreadOptions::MemoryPolicy memory_policy,
+                     const std::set<int>& numa_nodes) {
+  constexpr size_t kBitsPerWord = 8 * sizeof(unsigned long);  // NOLINT
+  std::vector<unsigned long> node_mask;                       // NOLINT
+  int mode;
+  switch (memory_policy) {
+    case ThreadOptions::MemoryPolicy::kDefault:
+      return;
+    case ThreadOptions::MemoryPolicy::kLocal:
+      mode = kMemoryPolicyLocal;
+      break;
+    case ThreadOptions::MemoryPolicy::kBind:
+      mode = kMemoryPolicyBind;
+      for (const int node : numa_nodes) {
+        if (node < 0) continue;
+        node_mask.resize(std::max(node_mask.size(), node / kBitsPerWord + 1));
+        node_mask[node / kBitsPerWord] |= 1UL << (node % kBitsPerWord);
+      }
+      break;
+  }
+  // The kernel expects one more than the number of bits in the mask.
+  const unsigned long max_node =  // NOLINT
+      node_mask.empty() ? 0 : node_mask.size() * kBitsPerWord + 1;
+  if (syscall(SYS_set_mempolicy, mode,
+              node_mask.empty() ? nullptr : node_mask.data(), max_node) == 0) {
+    VLOG(1) << "Set the NUMA memory policy of the thread pool executor.";
+  } else {
+    ABSL_LOG(ERROR) << "Error : " << strerror(errno) << std::endl
+                    << "Failed to set the NUMA memory policy. Ignore memory "
+                       "policy setting for now.";
+  }
+}
+#endif  // __linux__
+
+}  // namespace
+
 namespace internal {
 
+void ConfigureWorkerThread(const ThreadOptions& thread_options,
+                           const std::string& name_prefix) {
+  int nice_priority_level = thread_options.nice_priority_level();
+  const std::set<int> selected_cpus = thread_options.cpu_set();
+#if defined(__linux__)
+  const std::string name =
+      internal::CreateThreadName(name_prefix, syscall(SYS_gettid));
+  if (nice_priority_level != 0) {
+    if (nice(nice_priority_level) != -1 || errno == 0) {
+      VLOG(1) << "Changed the nice priority level by " << nice_priority_level;
+    } else {
+      ABSL_LOG(ERROR) << "Error : " << strerror(errno) << std::endl
+                      << "Could not change the nice priority level by "
+                      << nice_priority_level;
+    }
+  }
+  if (!selected_cpus.empty()) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (const int cpu : selected_cpus) {
+      CPU_SET(cpu, &cpu_set);
+    }
+    if (sched_setaffinity(syscall(SYS_gettid), sizeof(cpu_set_t), &cpu_set) !=
+            -1 ||
+        errno == 0) {
+      VLOG(1) << "Pinned the thread pool executor to processor "
+              << absl::StrJoin(selected_cpus, ", processor ") << ".";
+    } else {
+      ABSL_LOG(ERROR) << "Error : " << strerror(errno) << std::endl
+                      << "Failed to set processor affinity. Ignore processor "
+                         "affinity setting for now.";
+    }
+  }
+  SetMemoryPolicy(thread_options.memory_policy(), thread_options.numa_nodes());
+  int error = pthread_setname_np(pthread_self(), name.c_str());
+  if (error != 0) {
+    ABSL_LOG(ERROR) << "Error : " << strerror(error) << std::endl
+                    << "Failed to set name for thread: " << name;
+  }
+#else
+  const std::string name = internal::CreateThreadName(name_prefix, 0);
+  if (nice_priority_level != 0 || !selected_cpus.empty() ||
+      thread_options.memory_policy() !=
+          ThreadOptions::MemoryPolicy::kDefault) {
+    ABSL_LOG(ERROR) << "Thread priority, processor affinity and memory policy "
+                       "features aren't supported on the current platform.";
+  }
+#if __APPLE__
+  int error = pthread_setname_np(name.c_str());
+  if (error != 0) {
+    ABSL_LOG(ERROR) << "Error : " << strerror(error) << std::endl
+                    << "Failed to set name for thread: " << name;
+  }
+#endif  // __APPLE__
+#endif  // __linux__
+}
+
 // TODO: revise this:
 // - thread_id is not portable
 // - the 16-byte limit is Linux-specific
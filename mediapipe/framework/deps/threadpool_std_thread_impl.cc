@@ -55,14 +55,8 @@ void ThreadPool::WorkerThread::Join() { thread_.join(); }
 
 void* ThreadPool::WorkerThread::ThreadBody(void* arg) {
   auto thread = reinterpret_cast<WorkerThread*>(arg);
-  int nice_priority_level =
-      thread->pool_->thread_options().nice_priority_level();
-  const std::set<int> selected_cpus = thread->pool_->thread_options().cpu_set();
-  if (nice_priority_level != 0 || !selected_cpus.empty()) {
-    ABSL_LOG(ERROR)
-        << "Thread priority and processor affinity feature aren't "
-           "supported by the std::thread threadpool implementation.";
-  }
+  internal::ConfigureWorkerThread(thread->pool_->thread_options(),
+                                  thread->name_prefix_);
   thread->pool_->RunWorker();
   return nullptr;
 }
@@ -137,6 +131,18 @@ const ThreadOptions& ThreadPool::thread_options() const {
 
 namespace internal {
 
+void ConfigureWorkerThread(const ThreadOptions& thread_options,
+                           const std::string& name_prefix) {
+  if (thread_options.nice_priority_level() != 0 ||
+      !thread_options.cpu_set().empty() ||
+      thread_options.memory_policy() !=
+          ThreadOptions::MemoryPolicy::kDefault) {
+    ABSL_LOG(ERROR)
+        << "Thread priority, processor affinity and memory policy features "
+           "aren't supported by the std::thread threadpool implementation.";
+  }
+}
+
 std::string CreateThreadName(const std::string& prefix, int thread_id) {
   std::string name = absl::StrCat(prefix, "/", thread_id);
   constexpr size_t kMaxThreadNameLength = 15;
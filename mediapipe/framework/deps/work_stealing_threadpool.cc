@@ -0,0 +1,141 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/deps/work_stealing_threadpool.h"
+
+#include <utility>
+
+#include "absl/log/absl_check.h"
+#include "mediapipe/framework/deps/threadpool.h"
+
+namespace mediapipe {
+
+namespace {
+
+// Identifies the pool and the deque owned by the current worker thread, so
+// that callbacks scheduled from inside a worker stay on that worker's deque.
+thread_local const WorkStealingThreadPool* current_pool = nullptr;
+thread_local int current_worker_index = -1;
+
+}  // namespace
+
+WorkStealingThreadPool::WorkStealingThreadPool(const std::string& name_prefix,
+                                               int num_threads)
+    : WorkStealingThreadPool(ThreadOptions(), name_prefix, num_threads) {}
+
+WorkStealingThreadPool::WorkStealingThreadPool(
+    const ThreadOptions& thread_options, const std::string& name_prefix,
+    int num_threads)
+    : name_prefix_(name_prefix),
+      thread_options_(thread_options),
+      num_threads_((num_threads == 0) ? 1 : num_threads) {
+  queues_.reserve(num_threads_);
+  for (int i = 0; i < num_threads_; ++i) {
+    queues_.push_back(std::make_unique<WorkerQueue>());
+  }
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool() {
+  {
+    absl::MutexLock lock(&sleep_mutex_);
+    stopped_ = true;
+    sleep_condition_.SignalAll();
+  }
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+  threads_.clear();
+}
+
+void WorkStealingThreadPool::StartWorkers() {
+  ABSL_CHECK(threads_.empty()) << "StartWorkers() called twice.";
+  threads_.reserve(num_threads_);
+  for (int i = 0; i < num_threads_; ++i) {
+    threads_.emplace_back([this, i] {
+      internal::ConfigureWorkerThread(thread_options_, name_prefix_);
+      RunWorker(i);
+    });
+  }
+}
+
+void WorkStealingThreadPool::Schedule(std::function<void()> callback) {
+  int index;
+  if (current_pool == this) {
+    index = current_worker_index;
+  } else {
+    index = next_queue_.fetch_add(1, std::memory_order_relaxed) % num_threads_;
+  }
+  // Publish the task count before the task itself, see num_pending_.
+  num_pending_.fetch_add(1);
+  {
+    WorkerQueue& queue = *queues_[index];
+    absl::MutexLock lock(&queue.mutex);
+    queue.tasks.push_back(std::move(callback));
+  }
+  // Pairs with the increment of num_sleeping_ in RunWorker(): either the
+  // sleeping worker observes num_pending_ > 0, or we observe the sleeper.
+  if (num_sleeping_.load() > 0) {
+    absl::MutexLock lock(&sleep_mutex_);
+    sleep_condition_.Signal();
+  }
+}
+
+bool WorkStealingThreadPool::PopLocal(int worker_index,
+                                      std::function<void()>* task) {
+  WorkerQueue& queue = *queues_[worker_index];
+  absl::MutexLock lock(&queue.mutex);
+  if (queue.tasks.empty()) return false;
+  *task = std::move(queue.tasks.back());
+  queue.tasks.pop_back();
+  return true;
+}
+
+bool WorkStealingThreadPool::Steal(int worker_index,
+                                   std::function<void()>* task) {
+  for (int i = 1; i < num_threads_; ++i) {
+    WorkerQueue& victim = *queues_[(worker_index + i) % num_threads_];
+    absl::MutexLock lock(&victim.mutex);
+    if (victim.tasks.empty()) continue;
+    *task = std::move(victim.tasks.front());
+    victim.tasks.pop_front();
+    num_steals_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+  return false;
+}
+
+void WorkStealingThreadPool::RunWorker(int worker_index) {
+  current_pool = this;
+  current_worker_index = worker_index;
+  while (true) {
+    std::function<void()> task;
+    if (PopLocal(worker_index, &task) || Steal(worker_index, &task)) {
+      num_pending_.fetch_sub(1);
+      task();
+      continue;
+    }
+    absl::MutexLock lock(&sleep_mutex_);
+    num_sleeping_.fetch_add(1);
+    while (num_pending_.load() == 0 && !stopped_) {
+      sleep_condition_.Wait(&sleep_mutex_);
+    }
+    num_sleeping_.fetch_sub(1);
+    // Remaining tasks are drained before the worker exits, like ThreadPool.
+    if (stopped_ && num_pending_.load() == 0) break;
+  }
+  current_pool = nullptr;
+  current_worker_index = -1;
+}
+
+}  // namespace mediapipe
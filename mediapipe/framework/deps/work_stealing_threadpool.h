@@ -0,0 +1,138 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_DEPS_WORK_STEALING_THREADPOOL_H_
+#define MEDIAPIPE_DEPS_WORK_STEALING_THREADPOOL_H_
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/deps/thread_options.h"
+
+namespace mediapipe {
+
+// A thread pool in which every worker thread owns a task deque.
+//
+// Unlike ThreadPool, which keeps all pending callbacks in a single queue
+// guarded by a single mutex, WorkStealingThreadPool spreads the callbacks
+// across per-worker deques:
+//
+// - A callback scheduled from one of the pool's own worker threads is pushed
+//   onto that worker's deque, and the worker pops it back in LIFO order.
+// - A callback scheduled from any other thread is distributed round-robin
+//   across the worker deques.
+// - A worker whose deque is empty steals the oldest callback from the deque
+//   of another worker before going to sleep.
+//
+// This keeps the workers from contending on one lock when many cheap
+// callbacks are scheduled concurrently. No ordering between callbacks is
+// guaranteed, not even for a pool with a single thread.
+//
+// The interface mirrors ThreadPool:
+//
+// {
+//   WorkStealingThreadPool pool("testpool", num_workers);
+//   pool.StartWorkers();
+//   for (int i = 0; i < N; ++i) {
+//     pool.Schedule([i]() { DoWork(i); });
+//   }
+// }
+//
+class WorkStealingThreadPool {
+ public:
+  // Creates a pool that runs callbacks on "num_threads" threads. A value of
+  // 0 is treated as 1.
+  WorkStealingThreadPool(const std::string& name_prefix, int num_threads);
+
+  // Like the constructor above, but also applies "thread_options" (nice
+  // priority level, processor affinity) to each worker thread.
+  WorkStealingThreadPool(const ThreadOptions& thread_options,
+                         const std::string& name_prefix, int num_threads);
+  WorkStealingThreadPool(const WorkStealingThreadPool&) = delete;
+  WorkStealingThreadPool& operator=(const WorkStealingThreadPool&) = delete;
+
+  // Waits for all scheduled callbacks to complete. May be called without
+  // having called StartWorkers().
+  ~WorkStealingThreadPool();
+
+  // REQUIRES: StartWorkers has not been called
+  // Actually start the worker threads.
+  void StartWorkers();
+
+  // REQUIRES: StartWorkers has been called
+  // Adds the specified callback to one of the worker deques. Eventually a
+  // worker thread will pick it up and execute it.
+  void Schedule(std::function<void()> callback);
+
+  // Provided for debugging and testing only.
+  int num_threads() const { return num_threads_; }
+
+  // Returns the number of callbacks that were run by a worker other than the
+  // one whose deque they were scheduled on.
+  int64_t num_steals() const {
+    return num_steals_.load(std::memory_order_relaxed);
+  }
+
+  // Standard thread options.  Use this accessor to get them.
+  const ThreadOptions& thread_options() const { return thread_options_; }
+
+ private:
+  // A task deque owned by one worker. Aligned to a cache line so that workers
+  // locking their own deques do not false-share with their neighbors.
+  struct alignas(64) WorkerQueue {
+    absl::Mutex mutex;
+    std::deque<std::function<void()>> tasks ABSL_GUARDED_BY(mutex);
+  };
+
+  void RunWorker(int worker_index);
+
+  // Pops the most recently pushed task from the deque of "worker_index".
+  bool PopLocal(int worker_index, std::function<void()>* task);
+
+  // Steals the oldest task from the deque of any worker but "worker_index".
+  bool Steal(int worker_index, std::function<void()>* task);
+
+  const std::string name_prefix_;
+  const ThreadOptions thread_options_;
+  const int num_threads_;
+
+  std::vector<std::unique_ptr<WorkerQueue>> queues_;
+  std::vector<std::thread> threads_;
+
+  // Number of scheduled tasks that have not been taken off a deque yet. It is
+  // incremented before a task is pushed, so a worker that observes zero can
+  // safely go to sleep.
+  std::atomic<int64_t> num_pending_{0};
+  // Number of workers currently sleeping (or about to sleep) on
+  // sleep_condition_. Schedule() only needs to signal when it is nonzero.
+  std::atomic<int> num_sleeping_{0};
+  // Round-robin cursor for callbacks scheduled from non-worker threads.
+  std::atomic<uint32_t> next_queue_{0};
+  std::atomic<int64_t> num_steals_{0};
+
+  absl::Mutex sleep_mutex_;
+  absl::CondVar sleep_condition_;
+  bool stopped_ ABSL_GUARDED_BY(sleep_mutex_) = false;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_DEPS_WORK_STEALING_THREADPOOL_H_
@@ -0,0 +1,128 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/deps/work_stealing_threadpool.h"
+
+#include <atomic>
+
+#include "absl/synchronization/barrier.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace {
+
+TEST(WorkStealingThreadPoolTest, DestroyWithoutStart) {
+  WorkStealingThreadPool thread_pool("testpool", 10);
+}
+
+TEST(WorkStealingThreadPoolTest, EmptyThread) {
+  WorkStealingThreadPool thread_pool("testpool", 0);
+  ASSERT_EQ(1, thread_pool.num_threads());
+  thread_pool.StartWorkers();
+}
+
+TEST(WorkStealingThreadPoolTest, SingleThread) {
+  absl::Mutex mu;
+  int n = 100;
+  {
+    WorkStealingThreadPool thread_pool("testpool", 1);
+    ASSERT_EQ(1, thread_pool.num_threads());
+    thread_pool.StartWorkers();
+
+    for (int i = 0; i < 100; ++i) {
+      thread_pool.Schedule([&n, &mu]() mutable {
+        absl::MutexLock l(&mu);
+        --n;
+      });
+    }
+  }
+
+  EXPECT_EQ(0, n);
+}
+
+TEST(WorkStealingThreadPoolTest, MultiThreads) {
+  absl::Mutex mu;
+  int n = 1000;
+  {
+    WorkStealingThreadPool thread_pool("testpool", 10);
+    ASSERT_EQ(10, thread_pool.num_threads());
+    thread_pool.StartWorkers();
+
+    for (int i = 0; i < 1000; ++i) {
+      thread_pool.Schedule([&n, &mu]() mutable {
+        absl::MutexLock l(&mu);
+        --n;
+      });
+    }
+  }
+
+  EXPECT_EQ(0, n);
+}
+
+// Callbacks that schedule more callbacks land on the scheduling worker's own
+// deque. The other workers must steal them to make progress.
+TEST(WorkStealingThreadPoolTest, NestedScheduleIsStolen) {
+  constexpr int kFanOut = 64;
+  std::atomic<int> num_done{0};
+  absl::Barrier all_started(4);
+  {
+    WorkStealingThreadPool thread_pool("testpool", 4);
+    thread_pool.StartWorkers();
+    thread_pool.Schedule([&] {
+      for (int i = 0; i < kFanOut; ++i) {
+        thread_pool.Schedule([&, i] {
+          // The last four tasks block until all of them run at the same
+          // time, which is only possible if the idle workers steal.
+          if (i >= kFanOut - 4) {
+            all_started.Block();
+          }
+          num_done.fetch_add(1);
+        });
+      }
+    });
+  }
+
+  EXPECT_EQ(kFanOut, num_done.load());
+}
+
+TEST(WorkStealingThreadPoolTest, ScheduleFromManyThreads) {
+  std::atomic<int> num_done{0};
+  {
+    WorkStealingThreadPool thread_pool("testpool", 4);
+    thread_pool.StartWorkers();
+    WorkStealingThreadPool producers("producers", 4);
+    producers.StartWorkers();
+    for (int p = 0; p < 4; ++p) {
+      producers.Schedule([&] {
+        for (int i = 0; i < 1000; ++i) {
+          thread_pool.Schedule([&] { num_done.fetch_add(1); });
+        }
+      });
+    }
+  }
+
+  EXPECT_EQ(4000, num_done.load());
+}
+
+TEST(WorkStealingThreadPoolTest, CreateWithThreadOptions) {
+  ThreadOptions thread_options = ThreadOptions().set_nice_priority_level(1);
+  WorkStealingThreadPool thread_pool(thread_options, "testpool", 10);
+  ASSERT_EQ(10, thread_pool.num_threads());
+  ASSERT_EQ(1, thread_pool.thread_options().nice_priority_level());
+  thread_pool.StartWorkers();
+}
+
+}  // namespace
+}  // namespace mediapipe
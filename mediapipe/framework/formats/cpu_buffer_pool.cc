@@ -0,0 +1,59 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/formats/cpu_buffer_pool.h"
+
+#include <memory>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/deps/aligned_malloc_and_free.h"
+#include "mediapipe/framework/port/status_macros.h"
+
+namespace mediapipe {
+
+absl::StatusOr<std::unique_ptr<CpuBuffer>> CpuBuffer::Create(
+    const CpuBufferSpec& spec) {
+  // Zero-sized tensors still get a distinct, non-null buffer.
+  void* data = aligned_malloc(spec.size > 0 ? spec.size : 1, spec.alignment);
+  if (data == nullptr) {
+    return absl::ResourceExhaustedError(
+        absl::StrCat("Failed to allocate a CPU buffer of ", spec.size,
+                     " bytes aligned to ", spec.alignment, " bytes."));
+  }
+  return std::unique_ptr<CpuBuffer>(new CpuBuffer(spec, data));
+}
+
+CpuBuffer::~CpuBuffer() { aligned_free(data_); }
+
+absl::StatusOr<std::shared_ptr<CpuBuffer>> CpuBufferPool::GetBuffer(
+    const CpuBufferSpec& spec) {
+  MP_ASSIGN_OR_RETURN(std::shared_ptr<CpuBuffer> buffer, Get(spec));
+  if (buffer->TakeReused()) {
+    hits_.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    misses_.fetch_add(1, std::memory_order_relaxed);
+  }
+  return buffer;
+}
+
+CpuBufferPool::Stats CpuBufferPool::GetStats() const {
+  Stats stats;
+  stats.hits = hits_.load(std::memory_order_relaxed);
+  stats.misses = misses_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,140 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_FORMATS_CPU_BUFFER_POOL_H_
+#define MEDIAPIPE_FRAMEWORK_FORMATS_CPU_BUFFER_POOL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "absl/status/statusor.h"
+#include "mediapipe/gpu/multi_pool.h"
+#include "mediapipe/gpu/reusable_pool.h"
+
+namespace mediapipe {
+
+// The alignment of pooled CPU buffers, which is enough for any SIMD load.
+inline constexpr size_t kCpuBufferAlignment = 64;
+
+// Describes a CPU buffer. Tensors with the same element type and shape use
+// buffers with the same spec.
+struct CpuBufferSpec {
+  size_t size = 0;
+  size_t alignment = kCpuBufferAlignment;
+
+  template <typename H>
+  friend H AbslHashValue(H h, const CpuBufferSpec& spec) {
+    return H::combine(std::move(h), spec.size, spec.alignment);
+  }
+  bool operator==(const CpuBufferSpec& other) const {
+    return size == other.size && alignment == other.alignment;
+  }
+};
+
+// An aligned, uninitialized CPU buffer.
+class CpuBuffer {
+ public:
+  static absl::StatusOr<std::unique_ptr<CpuBuffer>> Create(
+      const CpuBufferSpec& spec);
+  ~CpuBuffer();
+
+  CpuBuffer(const CpuBuffer&) = delete;
+  CpuBuffer& operator=(const CpuBuffer&) = delete;
+
+  void* data() const { return data_; }
+  const CpuBufferSpec& spec() const { return spec_; }
+
+  // Called by ReusablePool when the buffer is handed out again.
+  void Reuse() { reused_ = true; }
+
+  // Returns whether the buffer has been reused since the last call.
+  bool TakeReused() { return std::exchange(reused_, false); }
+
+ private:
+  CpuBuffer(const CpuBufferSpec& spec, void* data)
+      : spec_(spec), data_(data) {}
+
+  const CpuBufferSpec spec_;
+  void* const data_;
+  bool reused_ = false;
+};
+
+namespace internal {
+
+// Pools CpuBuffers with identical CpuBufferSpec.
+class CpuBufferSpecPool : public ReusablePool<CpuBuffer> {
+ public:
+  static std::shared_ptr<CpuBufferSpecPool> Create(
+      const CpuBufferSpec& spec, const MultiPoolOptions& options) {
+    return std::shared_ptr<CpuBufferSpecPool>(
+        new CpuBufferSpecPool(spec, options));
+  }
+  static absl::StatusOr<std::unique_ptr<CpuBuffer>> CreateBufferWithoutPool(
+      const CpuBufferSpec& spec) {
+    return CpuBuffer::Create(spec);
+  }
+
+ protected:
+  CpuBufferSpecPool(const CpuBufferSpec& spec, const MultiPoolOptions& options)
+      : ReusablePool<CpuBuffer>(
+            [this] { return CreateBufferWithoutPool(spec_); }, options),
+        spec_(spec) {}
+
+  const CpuBufferSpec spec_;
+};
+
+}  // namespace internal
+
+// The default options of CpuBufferPool. More buffers are kept than for GPU
+// buffers, since CPU tensors often stay in flight for several frames.
+inline constexpr MultiPoolOptions kDefaultCpuBufferPoolOptions = {
+    /*keep_count=*/4,
+};
+
+// Pools the CPU buffers of Tensors. A buffer is returned to the pool when the
+// last Tensor using it is destroyed, and reused by the next Tensor of the same
+// byte size.
+class CpuBufferPool : public MultiPool<internal::CpuBufferSpecPool,
+                                       CpuBufferSpec,
+                                       std::shared_ptr<CpuBuffer>> {
+ public:
+  struct Stats {
+    // Number of buffers that were reused.
+    int64_t hits = 0;
+    // Number of buffers that had to be allocated.
+    int64_t misses = 0;
+  };
+
+  explicit CpuBufferPool(
+      const MultiPoolOptions& options = kDefaultCpuBufferPoolOptions)
+      : MultiPool<internal::CpuBufferSpecPool, CpuBufferSpec,
+                  std::shared_ptr<CpuBuffer>>(options) {}
+
+  absl::StatusOr<std::shared_ptr<CpuBuffer>> GetBuffer(
+      const CpuBufferSpec& spec);
+
+  // Returns the hits and misses of the pool since its creation.
+  Stats GetStats() const;
+
+ private:
+  std::atomic<int64_t> hits_ = 0;
+  std::atomic<int64_t> misses_ = 0;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_FORMATS_CPU_BUFFER_POOL_H_
@@ -0,0 +1,152 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/formats/cpu_buffer_pool.h"
+
+#include <cstdint>
+#include <memory>
+
+#include "absl/status/status.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/memory_manager.h"
+#include "mediapipe/framework/memory_manager_service.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+TEST(CpuBufferPoolTest, AlignsBuffers) {
+  CpuBufferPool pool;
+  for (int size : {1, 3, 100, 4096}) {
+    CpuBufferSpec spec;
+    spec.size = size;
+    MP_ASSERT_OK_AND_ASSIGN(auto buffer, pool.GetBuffer(spec));
+    EXPECT_EQ(
+        reinterpret_cast<uintptr_t>(buffer->data()) % kCpuBufferAlignment, 0);
+  }
+}
+
+TEST(CpuBufferPoolTest, ReusesBuffersOfSameSpec) {
+  CpuBufferPool pool;
+  void* data = nullptr;
+  // The pool of a spec is only created after a few requests.
+  for (int i = 0; i < 4; ++i) {
+    MP_ASSERT_OK_AND_ASSIGN(auto buffer, pool.GetBuffer({256}));
+    data = buffer->data();
+  }
+  MP_ASSERT_OK_AND_ASSIGN(auto buffer, pool.GetBuffer({256}));
+  EXPECT_EQ(buffer->data(), data);
+  MP_ASSERT_OK_AND_ASSIGN(auto other_buffer, pool.GetBuffer({512}));
+  EXPECT_NE(other_buffer->data(), data);
+
+  const CpuBufferPool::Stats stats = pool.GetStats();
+  EXPECT_GE(stats.hits, 2);
+  EXPECT_EQ(stats.hits + stats.misses, 6);
+}
+
+TEST(CpuBufferPoolTest, BuffersInUseAreNotShared) {
+  CpuBufferPool pool;
+  for (int i = 0; i < 4; ++i) {
+    MP_ASSERT_OK(pool.GetBuffer({64}));
+  }
+  MP_ASSERT_OK_AND_ASSIGN(auto first, pool.GetBuffer({64}));
+  MP_ASSERT_OK_AND_ASSIGN(auto second, pool.GetBuffer({64}));
+  EXPECT_NE(first->data(), second->data());
+}
+
+TEST(CpuBufferPoolTest, TensorsUsePoolOfMemoryManager) {
+  MemoryManager memory_manager;
+  const void* data = nullptr;
+  for (int i = 0; i < 4; ++i) {
+    Tensor tensor(Tensor::ElementType::kFloat32, Tensor::Shape{2, 8},
+                  &memory_manager);
+    auto view = tensor.GetCpuWriteView();
+    view.buffer<float>()[0] = i;
+    data = view.buffer<float>();
+  }
+  Tensor tensor(Tensor::ElementType::kFloat32, Tensor::Shape{2, 8},
+                &memory_manager);
+  EXPECT_EQ(tensor.GetCpuWriteView().buffer<float>(), data);
+
+  // Moved tensors keep their pooled buffer.
+  Tensor moved = std::move(tensor);
+  EXPECT_EQ(moved.GetCpuReadView().buffer<float>(), data);
+  EXPECT_GT(memory_manager.GetCpuBufferPool()->GetStats().hits, 0);
+}
+
+// Outputs a tensor for each input packet.
+class PooledTensorCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).SetAny();
+    cc->Outputs().Index(0).Set<Tensor>();
+    cc->UseService(kMemoryManagerService).Optional();
+    return absl::OkStatus();
+  }
+
+  absl::Status Open(CalculatorContext* cc) override {
+    if (cc->Service(kMemoryManagerService).IsAvailable()) {
+      memory_manager_ = &cc->Service(kMemoryManagerService).GetObject();
+    }
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    Tensor tensor(Tensor::ElementType::kFloat32, Tensor::Shape{1, 16},
+                  memory_manager_);
+    tensor.GetCpuWriteView().buffer<float>()[0] = 1.0f;
+    cc->Outputs().Index(0).AddPacket(
+        MakePacket<Tensor>(std::move(tensor)).At(cc->InputTimestamp()));
+    return absl::OkStatus();
+  }
+
+ private:
+  MemoryManager* memory_manager_ = nullptr;
+};
+REGISTER_CALCULATOR(PooledTensorCalculator);
+
+TEST(CpuBufferPoolTest, GraphReportsPoolCounters) {
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "input"
+    node {
+      calculator: "PooledTensorCalculator"
+      input_stream: "input"
+      output_stream: "output"
+    }
+  )pb")));
+  MP_ASSERT_OK(graph.StartRun({}));
+  for (int i = 0; i < 10; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "input", MakePacket<int>(i).At(Timestamp(i))));
+    MP_ASSERT_OK(graph.WaitUntilIdle());
+  }
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  // The graph created a default MemoryManager for the calculator.
+  const int64_t hits =
+      graph.GetCounterFactory()->GetCounter("CpuBufferPool hits")->Get();
+  const int64_t misses =
+      graph.GetCounterFactory()->GetCounter("CpuBufferPool misses")->Get();
+  EXPECT_EQ(hits + misses, 10);
+  EXPECT_GE(hits, 8);
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -42,6 +42,7 @@
 
 #include "absl/base/attributes.h"
 #include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/payload_size.h"
 #include "mediapipe/framework/port.h"
 #include "mediapipe/framework/tool/type_util.h"
 
@@ -253,6 +254,13 @@ class ImageFrame {
   std::unique_ptr<uint8_t[], Deleter> pixel_data_;
 };
 
+template <>
+struct PayloadSize<ImageFrame> {
+  static size_t ByteSize(const ImageFrame& image_frame) {
+    return sizeof(image_frame) + image_frame.PixelDataSize();
+  }
+};
+
 }  // namespace mediapipe
 
 #endif  // MEDIAPIPE_FRAMEWORK_FORMATS_IMAGE_FRAME_H_
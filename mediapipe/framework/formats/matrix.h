@@ -25,12 +25,20 @@
 
 #include "Eigen/Core"
 #include "mediapipe/framework/formats/matrix_data.pb.h"
+#include "mediapipe/framework/payload_size.h"
 #include "mediapipe/framework/port.h"
 
 namespace mediapipe {
 
 typedef Eigen::MatrixXf Matrix;
 
+template <>
+struct PayloadSize<Matrix> {
+  static size_t ByteSize(const Matrix& matrix) {
+    return sizeof(matrix) + matrix.size() * sizeof(float);
+  }
+};
+
 // Produce a MatrixData proto from an Eigen Matrix. Useful when wanting to
 // copy a repeated float field.
 void MatrixDataProtoFromMatrix(const Matrix& matrix, MatrixData* matrix_data);
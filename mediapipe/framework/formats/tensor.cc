@@ -435,6 +435,8 @@ void Tensor::Move(Tensor* src) {
   src->element_type_ = ElementType::kNone;  // Mark as invalidated.
   cpu_buffer_ = src->cpu_buffer_;
   src->cpu_buffer_ = nullptr;
+  pooled_cpu_buffer_ = std::move(src->pooled_cpu_buffer_);
+  cpu_buffer_pool_ = std::move(src->cpu_buffer_pool_);
   ahwb_tracking_key_ = src->ahwb_tracking_key_;
   mtl_resources_ = std::move(src->mtl_resources_);
   MoveAhwbStuff(src);
@@ -459,6 +461,9 @@ Tensor::Tensor(ElementType element_type, const Shape& shape,
     : element_type_(element_type),
       shape_(shape),
       mtl_resources_(std::make_unique<MtlResources>()) {
+  if (memory_manager) {
+    cpu_buffer_pool_ = memory_manager->GetCpuBufferPool();
+  }
 #ifdef MEDIAPIPE_TENSOR_USE_AHWB
   if (memory_manager) {
     hardware_buffer_pool_ = memory_manager->GetAndroidHardwareBufferPool();
@@ -472,6 +477,9 @@ Tensor::Tensor(ElementType element_type, const Shape& shape,
       shape_(shape),
       quantization_parameters_(quantization_parameters),
       mtl_resources_(std::make_unique<MtlResources>()) {
+  if (memory_manager) {
+    cpu_buffer_pool_ = memory_manager->GetCpuBufferPool();
+  }
 #ifdef MEDIAPIPE_TENSOR_USE_AHWB
   if (memory_manager) {
     hardware_buffer_pool_ = memory_manager->GetAndroidHardwareBufferPool();
@@ -563,7 +571,9 @@ void Tensor::Invalidate() {
   }
 #endif  // MEDIAPIPE_OPENGL_ES_VERSION >= MEDIAPIPE_OPENGL_ES_31
 
-  if (cpu_buffer_) {
+  if (pooled_cpu_buffer_) {
+    pooled_cpu_buffer_ = nullptr;
+  } else if (cpu_buffer_) {
     free(cpu_buffer_);
   }
   cpu_buffer_ = nullptr;
@@ -636,6 +646,14 @@ absl::Status Tensor::ReadBackGpuToCpu() const {
 }
 
 Tensor::CpuReadView Tensor::GetCpuReadView() const {
+  {
+    // Readers of an up-to-date CPU buffer don't change the tensor, so they only
+    // share the mutex and don't block each other.
+    auto reader_lock = absl::make_unique<absl::ReaderMutexLock>(&view_mutex_);
+    if (HasValidCpuBuffer()) {
+      return {cpu_buffer_, std::move(reader_lock)};
+    }
+  }
   auto lock = absl::make_unique<absl::MutexLock>(&view_mutex_);
   ABSL_LOG_IF(FATAL, valid_ == kValidNone)
       << "Tensor must be written prior to read from.";
@@ -681,6 +699,14 @@ Tensor::CpuWriteView Tensor::GetCpuWriteView(
   return {cpu_buffer_, std::move(lock)};
 }
 
+bool Tensor::HasValidCpuBuffer() const {
+#ifdef MEDIAPIPE_TENSOR_USE_AHWB
+  // Reading through an AHardwareBuffer locks and unlocks it.
+  if (ahwb_) return false;
+#endif  // MEDIAPIPE_TENSOR_USE_AHWB
+  return cpu_buffer_ != nullptr && (valid_ & kValidCpu);
+}
+
 void Tensor::AllocateCpuBuffer() const {
   if (!cpu_buffer_) {
 #ifdef MEDIAPIPE_TENSOR_USE_AHWB
@@ -689,6 +715,16 @@ void Tensor::AllocateCpuBuffer() const {
 #if MEDIAPIPE_METAL_ENABLED
     cpu_buffer_ = AllocateVirtualMemory(bytes());
 #else
+    if (cpu_buffer_pool_) {
+      auto buffer = cpu_buffer_pool_->GetBuffer({bytes(), kCpuBufferAlignment});
+      if (buffer.ok()) {
+        pooled_cpu_buffer_ = std::move(buffer).value();
+        cpu_buffer_ = pooled_cpu_buffer_->data();
+        return;
+      }
+      ABSL_LOG_FIRST_N(WARNING, 1)
+          << "Failed to get a pooled CPU buffer: " << buffer.status();
+    }
     cpu_buffer_ = malloc(bytes());
 #endif  // MEDIAPIPE_METAL_ENABLED
   }
@@ -30,7 +30,9 @@
 #include "absl/status/status.h"
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/formats/tensor/internal.h"
+#include "mediapipe/framework/formats/cpu_buffer_pool.h"
 #include "mediapipe/framework/memory_manager.h"
+#include "mediapipe/framework/payload_size.h"
 // Exports MEDIAPIPE_TENSOR_USE_AHWB macro.
 #include "mediapipe/framework/port.h"
 
@@ -86,6 +88,10 @@ namespace mediapipe {
 // auto view = tensor.GetCpuReadView();
 // float* pointer = view.buffer<float>();
 // ...reading the cpu memory...
+//
+// CPU read views of a tensor whose CPU buffer is up to date are shared: any
+// number of threads can hold them at the same time, while write views and all
+// other views remain exclusive.
 
 struct MtlResources;
 class Tensor {
@@ -98,7 +104,12 @@ class Tensor {
    protected:
     explicit View(std::unique_ptr<absl::MutexLock>&& lock)
         : lock_(std::move(lock)) {}
+    explicit View(std::unique_ptr<absl::ReaderMutexLock>&& reader_lock)
+        : reader_lock_(std::move(reader_lock)) {}
+    View(View&& src) = default;
     std::unique_ptr<absl::MutexLock> lock_;
+    // Held instead of lock_ by views which share the tensor with other readers.
+    std::unique_ptr<absl::ReaderMutexLock> reader_lock_;
   };
 
  public:
@@ -140,6 +151,8 @@ class Tensor {
     int zero_point = 0;
   };
 
+  // If "memory_manager" is set, the CPU buffer of the tensor is taken from and
+  // returned to its pools.
   Tensor(ElementType element_type, const Shape& shape,
          MemoryManager* memory_manager = nullptr);
   Tensor(ElementType element_type, const Shape& shape,
@@ -163,7 +176,7 @@ class Tensor {
       return static_cast<typename std::tuple_element<
           std::is_const<T>::value, std::tuple<P*, const P*> >::type>(buffer_);
     }
-    CpuView(CpuView&& src) : View(std::move(src.lock_)) {
+    CpuView(CpuView&& src) : View(std::move(src)) {
       buffer_ = std::exchange(src.buffer_, nullptr);
       release_callback_ = std::exchange(src.release_callback_, nullptr);
     }
@@ -178,6 +191,8 @@ class Tensor {
         : View(std::move(lock)),
           buffer_(buffer),
           release_callback_(release_callback) {}
+    CpuView(T* buffer, std::unique_ptr<absl::ReaderMutexLock>&& reader_lock)
+        : View(std::move(reader_lock)), buffer_(buffer) {}
     T* buffer_;
     std::function<void()> release_callback_;
   };
@@ -195,8 +210,7 @@ class Tensor {
     AHardwareBuffer* handle() const {
       return hardware_buffer_->GetAHardwareBuffer();
     }
-    AHardwareBufferView(AHardwareBufferView&& src)
-        : View(std::move(src.lock_)) {
+    AHardwareBufferView(AHardwareBufferView&& src) : View(std::move(src)) {
       hardware_buffer_ = std::move(src.hardware_buffer_);
       file_descriptor_ = src.file_descriptor_;
       fence_fd_ = std::exchange(src.fence_fd_, nullptr);
@@ -254,8 +268,7 @@ class Tensor {
   class OpenGlTexture2dView : public View {
    public:
     GLuint name() const { return name_; }
-    OpenGlTexture2dView(OpenGlTexture2dView&& src)
-        : View(std::move(src.lock_)) {
+    OpenGlTexture2dView(OpenGlTexture2dView&& src) : View(std::move(src)) {
       name_ = std::exchange(src.name_, GL_INVALID_INDEX);
     }
     // To fit a tensor into a texture two layouts are used:
@@ -286,7 +299,7 @@ class Tensor {
    public:
     GLuint name() const { return name_; }
 
-    OpenGlBufferView(OpenGlBufferView&& src) : View(std::move(src.lock_)) {
+    OpenGlBufferView(OpenGlBufferView&& src) : View(std::move(src)) {
       name_ = std::exchange(src.name_, GL_INVALID_INDEX);
       ssbo_read_ = std::exchange(src.ssbo_read_, nullptr);
     }
@@ -379,11 +392,19 @@ class Tensor {
   // A list of resource which are currently allocated and synchronized between
   // each-other: valid_ = kValidCpu | kValidMetalBuffer;
   mutable int valid_ = 0;
-  // The mutex is locked by Get*View and is kept by all Views.
+  // The mutex is locked by Get*View and is kept by all Views. Shared CPU read
+  // views hold it in reader mode.
   mutable absl::Mutex view_mutex_;
 
   mutable void* cpu_buffer_ = nullptr;
+  // Owns cpu_buffer_ if it was obtained from cpu_buffer_pool_, which then
+  // gets it back when the tensor is destroyed.
+  mutable std::shared_ptr<CpuBuffer> pooled_cpu_buffer_;
+  std::shared_ptr<CpuBufferPool> cpu_buffer_pool_;
   void AllocateCpuBuffer() const;
+  // Returns true if cpu_buffer_ can be read without any synchronization with
+  // other backends. Must be called with view_mutex_ held in any mode.
+  bool HasValidCpuBuffer() const;
   // Forward declaration of the MtlResources provides compile-time verification
   // of ODR if this header includes any actual code that uses MtlResources.
   mutable std::unique_ptr<MtlResources> mtl_resources_;
@@ -452,6 +473,13 @@ int BhwcHeightFromShape(const Tensor::Shape& shape);
 int BhwcWidthFromShape(const Tensor::Shape& shape);
 int BhwcDepthFromShape(const Tensor::Shape& shape);
 
+template <>
+struct PayloadSize<Tensor> {
+  static size_t ByteSize(const Tensor& tensor) {
+    return sizeof(tensor) + tensor.bytes();
+  }
+};
+
 }  // namespace mediapipe
 
 #endif  // MEDIAPIPE_FRAMEWORK_FORMATS_TENSOR_H_
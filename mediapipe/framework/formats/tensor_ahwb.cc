@@ -321,7 +321,11 @@ void Tensor::MoveCpuOrSsboToAhwb() const {
   if (valid_ & kValidCpu) {
     std::memcpy(*dest, cpu_buffer_, bytes());
     // Free CPU memory because next time AHWB is mapped instead.
-    free(cpu_buffer_);
+    if (pooled_cpu_buffer_) {
+      pooled_cpu_buffer_ = nullptr;
+    } else {
+      free(cpu_buffer_);
+    }
     cpu_buffer_ = nullptr;
     valid_ &= ~kValidCpu;
   } else if (valid_ & kValidOpenGlBuffer) {
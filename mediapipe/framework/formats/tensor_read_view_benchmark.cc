@@ -0,0 +1,61 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Benchmark for concurrent Tensor::GetCpuReadView calls. All threads read the
+// same tensor, so the items processed per second scale with the number of
+// threads as long as read views don't exclude each other.
+//
+// $ bazel run -c opt mediapipe/framework/formats:tensor_read_view_benchmark
+#include <thread>
+
+#include "benchmark/benchmark.h"
+#include "mediapipe/framework/formats/tensor.h"
+
+namespace mediapipe {
+namespace {
+
+// Number of floats summed per read view.
+constexpr int kNumElements = 1024;
+
+Tensor* SharedTensor() {
+  static Tensor* tensor = [] {
+    auto* tensor =
+        new Tensor(Tensor::ElementType::kFloat32, Tensor::Shape{kNumElements});
+    auto view = tensor->GetCpuWriteView();
+    float* buffer = view.buffer<float>();
+    for (int i = 0; i < kNumElements; ++i) buffer[i] = i;
+    return tensor;
+  }();
+  return tensor;
+}
+
+void BM_ConcurrentCpuReadViews(benchmark::State& state) {
+  const Tensor& tensor = *SharedTensor();
+  for (auto _ : state) {
+    auto view = tensor.GetCpuReadView();
+    const float* buffer = view.buffer<float>();
+    float sum = 0;
+    for (int i = 0; i < kNumElements; ++i) sum += buffer[i];
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ConcurrentCpuReadViews)
+    ->ThreadRange(1, std::thread::hardware_concurrency())
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace mediapipe
+
+BENCHMARK_MAIN();
@@ -1,9 +1,15 @@
 #include "mediapipe/framework/formats/tensor.h"
 
+#include <atomic>
 #include <cstring>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
 #if !MEDIAPIPE_DISABLE_GPU
@@ -80,6 +86,61 @@ TEST(Cpu, TestViewMove) {
   EXPECT_EQ(v1.buffer<float>(), nullptr);  // NOLINT
 }
 
+TEST(Cpu, TestReadViewMove) {
+  Tensor t(Tensor::ElementType::kFloat32, Tensor::Shape{4});
+  t.GetCpuWriteView().buffer<float>()[0] = 1.0f;
+  auto v1 = t.GetCpuReadView();
+  Tensor::CpuReadView v2(std::move(v1));
+  EXPECT_EQ(v2.buffer<float>()[0], 1.0f);
+  EXPECT_EQ(v1.buffer<float>(), nullptr);  // NOLINT
+}
+
+TEST(Cpu, TestConcurrentReadViews) {
+  constexpr int kNumReaders = 4;
+  Tensor t(Tensor::ElementType::kFloat32, Tensor::Shape{4});
+  t.GetCpuWriteView().buffer<float>()[0] = 42.0f;
+
+  // All readers hold their views at the same time, which would deadlock if
+  // read views were exclusive.
+  absl::BlockingCounter views_acquired(kNumReaders);
+  absl::Notification release_views;
+  std::vector<std::thread> readers;
+  std::atomic<int> num_matches = 0;
+  for (int i = 0; i < kNumReaders; ++i) {
+    readers.emplace_back([&] {
+      auto view = t.GetCpuReadView();
+      views_acquired.DecrementCount();
+      release_views.WaitForNotification();
+      if (view.buffer<float>()[0] == 42.0f) ++num_matches;
+    });
+  }
+  views_acquired.Wait();
+  release_views.Notify();
+  for (auto& reader : readers) reader.join();
+  EXPECT_EQ(num_matches, kNumReaders);
+}
+
+TEST(Cpu, TestWriteViewExcludesReadViews) {
+  Tensor t(Tensor::ElementType::kFloat32, Tensor::Shape{4});
+  t.GetCpuWriteView().buffer<float>()[0] = 1.0f;
+
+  std::atomic<bool> written = false;
+  std::thread writer;
+  {
+    auto read_view = t.GetCpuReadView();
+    writer = std::thread([&] {
+      t.GetCpuWriteView().buffer<float>()[0] = 2.0f;
+      written = true;
+    });
+    absl::SleepFor(absl::Milliseconds(50));
+    EXPECT_FALSE(written);
+    EXPECT_EQ(read_view.buffer<float>()[0], 1.0f);
+  }
+  writer.join();
+  EXPECT_TRUE(written);
+  EXPECT_EQ(t.GetCpuReadView().buffer<float>()[0], 2.0f);
+}
+
 }  // namespace mediapipe
 
 int main(int argc, char** argv) {
@@ -0,0 +1,146 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/graph_pool.h"
+
+#include <memory>
+#include <utility>
+
+#include "absl/log/absl_log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/calculator_graph.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+
+namespace mediapipe {
+
+GraphPool::PooledGraph::PooledGraph(PooledGraph&& other)
+    : pool_(other.pool_),
+      graph_(std::move(other.graph_)),
+      finished_(other.finished_) {}
+
+GraphPool::PooledGraph& GraphPool::PooledGraph::operator=(
+    PooledGraph&& other) {
+  if (this != &other) {
+    Release();
+    pool_ = other.pool_;
+    graph_ = std::move(other.graph_);
+    finished_ = other.finished_;
+  }
+  return *this;
+}
+
+GraphPool::PooledGraph::~PooledGraph() { Release(); }
+
+absl::Status GraphPool::PooledGraph::Finish() {
+  RET_CHECK(graph_ != nullptr);
+  RET_CHECK(!finished_) << "Finish() must only be called once.";
+  absl::Status status = graph_->CloseAllInputStreams();
+  status.Update(graph_->WaitUntilDone());
+  finished_ = true;
+  return status;
+}
+
+void GraphPool::PooledGraph::Release() {
+  if (graph_ == nullptr) {
+    return;
+  }
+  if (!finished_) {
+    graph_->Cancel();
+    graph_->WaitUntilDone().IgnoreError();
+  }
+  pool_->Restart(std::move(graph_));
+}
+
+absl::StatusOr<std::unique_ptr<GraphPool>> GraphPool::Create(
+    std::shared_ptr<const CompiledGraph> compiled_graph,
+    const Options& options) {
+  RET_CHECK(compiled_graph != nullptr);
+  RET_CHECK_GT(options.num_graphs, 0);
+  std::unique_ptr<GraphPool> pool(
+      new GraphPool(std::move(compiled_graph), options));
+  for (int i = 0; i < options.num_graphs; ++i) {
+    MP_ASSIGN_OR_RETURN(std::unique_ptr<CalculatorGraph> graph,
+                        pool->CreateGraph());
+    absl::MutexLock lock(&pool->mutex_);
+    pool->idle_graphs_.push_back(std::move(graph));
+    ++pool->num_graphs_;
+  }
+  return pool;
+}
+
+absl::StatusOr<std::unique_ptr<GraphPool>> GraphPool::Create(
+    CalculatorGraphConfig config, const Options& options) {
+  MP_ASSIGN_OR_RETURN(std::shared_ptr<const CompiledGraph> compiled_graph,
+                      CompiledGraph::Create(std::move(config)));
+  return Create(std::move(compiled_graph), options);
+}
+
+GraphPool::~GraphPool() {
+  absl::MutexLock lock(&mutex_);
+  for (auto& graph : idle_graphs_) {
+    graph->Cancel();
+    graph->WaitUntilDone().IgnoreError();
+  }
+}
+
+absl::StatusOr<GraphPool::PooledGraph> GraphPool::Acquire() {
+  {
+    absl::MutexLock lock(&mutex_);
+    auto available = [this]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+      return !idle_graphs_.empty() || num_graphs_ < options_.num_graphs;
+    };
+    mutex_.Await(absl::Condition(&available));
+    if (!idle_graphs_.empty()) {
+      std::unique_ptr<CalculatorGraph> graph = std::move(idle_graphs_.back());
+      idle_graphs_.pop_back();
+      return PooledGraph(this, std::move(graph));
+    }
+    // Replaces a graph that was dropped by Restart().
+    ++num_graphs_;
+  }
+  absl::StatusOr<std::unique_ptr<CalculatorGraph>> graph = CreateGraph();
+  if (!graph.ok()) {
+    absl::MutexLock lock(&mutex_);
+    --num_graphs_;
+    return graph.status();
+  }
+  return PooledGraph(this, *std::move(graph));
+}
+
+absl::StatusOr<std::unique_ptr<CalculatorGraph>> GraphPool::CreateGraph() {
+  auto graph = std::make_unique<CalculatorGraph>();
+  MP_RETURN_IF_ERROR(graph->Initialize(compiled_graph_));
+  if (options_.setup_graph) {
+    MP_RETURN_IF_ERROR(options_.setup_graph(*graph));
+  }
+  MP_RETURN_IF_ERROR(graph->StartRun(options_.side_packets));
+  return graph;
+}
+
+void GraphPool::Restart(std::unique_ptr<CalculatorGraph> graph) {
+  absl::Status status = graph->StartRun(options_.side_packets);
+  absl::MutexLock lock(&mutex_);
+  if (!status.ok()) {
+    ABSL_LOG(WARNING) << "Dropping a pooled graph that failed to start: "
+                      << status;
+    --num_graphs_;
+    return;
+  }
+  idle_graphs_.push_back(std::move(graph));
+}
+
+}  // namespace mediapipe
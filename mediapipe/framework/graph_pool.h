@@ -0,0 +1,147 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_GRAPH_POOL_H_
+#define MEDIAPIPE_FRAMEWORK_GRAPH_POOL_H_
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/calculator_graph.h"
+#include "mediapipe/framework/packet.h"
+
+namespace mediapipe {
+
+// Keeps warmed-up instances of a graph for request/response serving.
+//
+// The graphs of the pool are started ahead of time, so that their calculators
+// are already opened when a request arrives. A request acquires a running
+// graph, adds its packets to the graph input streams and calls Finish(). When
+// the graph is released, the pool starts its next run. Calculators marked
+// resettable (CalculatorContract::SetResettable) are kept between runs and
+// get a Reset() call instead of being created and opened again, so resources
+// loaded in Open() are only loaded once per graph.
+//
+// Example:
+//   GraphPool::Options options;
+//   options.num_graphs = 4;
+//   options.setup_graph = [](CalculatorGraph& graph) {
+//     return graph.ObserveOutputStream("output", ...);
+//   };
+//   MP_ASSIGN_OR_RETURN(std::unique_ptr<GraphPool> pool,
+//                       GraphPool::Create(config, options));
+//
+//   // For every request.
+//   MP_ASSIGN_OR_RETURN(GraphPool::PooledGraph graph, pool->Acquire());
+//   MP_RETURN_IF_ERROR(graph->AddPacketToInputStream("input", packet));
+//   MP_RETURN_IF_ERROR(graph.Finish());
+//
+// GraphPool is thread-safe. It must outlive the graphs acquired from it.
+class GraphPool {
+ public:
+  struct Options {
+    // The number of graphs of the pool, which is also the maximum number of
+    // requests served concurrently.
+    int num_graphs = 1;
+
+    // Called once on every graph after it is initialized and before its first
+    // run, for instance to observe its output streams.
+    std::function<absl::Status(CalculatorGraph&)> setup_graph;
+
+    // The side packets of every run.
+    std::map<std::string, Packet> side_packets;
+  };
+
+  // A running graph acquired from the pool. The graph returns to the pool when
+  // the PooledGraph is destroyed; if Finish() wasn't called, its run is
+  // cancelled first.
+  class PooledGraph {
+   public:
+    PooledGraph(PooledGraph&& other);
+    PooledGraph& operator=(PooledGraph&& other);
+    ~PooledGraph();
+
+    CalculatorGraph* get() const { return graph_.get(); }
+    CalculatorGraph* operator->() const { return graph_.get(); }
+    CalculatorGraph& operator*() const { return *graph_; }
+
+    // Closes the graph input streams and waits until the run is done. Use
+    // this instead of CalculatorGraph::WaitUntilDone().
+    absl::Status Finish();
+
+   private:
+    friend class GraphPool;
+
+    PooledGraph(GraphPool* pool, std::unique_ptr<CalculatorGraph> graph)
+        : pool_(pool), graph_(std::move(graph)) {}
+
+    // Returns the graph to the pool, if any.
+    void Release();
+
+    GraphPool* pool_ = nullptr;
+    std::unique_ptr<CalculatorGraph> graph_;
+    bool finished_ = false;
+  };
+
+  // Creates a pool and starts all of its graphs.
+  static absl::StatusOr<std::unique_ptr<GraphPool>> Create(
+      std::shared_ptr<const CompiledGraph> compiled_graph,
+      const Options& options);
+  static absl::StatusOr<std::unique_ptr<GraphPool>> Create(
+      CalculatorGraphConfig config, const Options& options);
+
+  GraphPool(const GraphPool&) = delete;
+  GraphPool& operator=(const GraphPool&) = delete;
+  // Cancels the runs of the idle graphs.
+  ~GraphPool();
+
+  // Returns a running graph, waiting for one to be released if all graphs are
+  // in use.
+  absl::StatusOr<PooledGraph> Acquire();
+
+ private:
+  GraphPool(std::shared_ptr<const CompiledGraph> compiled_graph,
+            const Options& options)
+      : compiled_graph_(std::move(compiled_graph)), options_(options) {}
+
+  // Creates, sets up and starts a graph.
+  absl::StatusOr<std::unique_ptr<CalculatorGraph>> CreateGraph();
+
+  // Starts the next run of a graph whose previous run is done, and makes it
+  // available. Drops the graph if it can't be started.
+  void Restart(std::unique_ptr<CalculatorGraph> graph);
+
+  const std::shared_ptr<const CompiledGraph> compiled_graph_;
+  const Options options_;
+
+  absl::Mutex mutex_;
+  // The started graphs that are not in use.
+  std::vector<std::unique_ptr<CalculatorGraph>> idle_graphs_
+      ABSL_GUARDED_BY(mutex_);
+  // The number of graphs that exist, in use or not.
+  int num_graphs_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_GRAPH_POOL_H_
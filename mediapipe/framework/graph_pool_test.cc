@@ -0,0 +1,331 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/graph_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/calculators/tensor/inference_calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "tensorflow/lite/core/api/op_resolver.h"
+#include "tensorflow/lite/kernels/register.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::ElementsAre;
+
+// Counts the calls to the methods of the test calculators.
+struct CallCounts {
+  std::atomic<int> constructed{0};
+  std::atomic<int> opened{0};
+  std::atomic<int> reset{0};
+};
+
+CallCounts* Counts() {
+  static CallCounts* counts = new CallCounts;
+  return counts;
+}
+
+void ResetCounts() {
+  Counts()->constructed = 0;
+  Counts()->opened = 0;
+  Counts()->reset = 0;
+}
+
+// Adds the number of packets of the current run to its int inputs, and fails
+// on negative inputs.
+template <bool kResettable>
+class CountingCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<int>();
+    cc->Outputs().Index(0).Set<int>();
+    cc->SetResettable(kResettable);
+    return absl::OkStatus();
+  }
+
+  CountingCalculator() { ++Counts()->constructed; }
+
+  absl::Status Open(CalculatorContext* cc) override {
+    ++Counts()->opened;
+    return absl::OkStatus();
+  }
+
+  absl::Status Reset(CalculatorContext* cc) override {
+    ++Counts()->reset;
+    num_packets_ = 0;
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    const int value = cc->Inputs().Index(0).Get<int>();
+    RET_CHECK_GE(value, 0);
+    cc->Outputs().Index(0).AddPacket(
+        MakePacket<int>(value + num_packets_++).At(cc->InputTimestamp()));
+    return absl::OkStatus();
+  }
+
+ private:
+  int num_packets_ = 0;
+};
+
+using ResettableCalculator = CountingCalculator<true>;
+REGISTER_CALCULATOR(ResettableCalculator);
+using NonResettableCalculator = CountingCalculator<false>;
+REGISTER_CALCULATOR(NonResettableCalculator);
+
+CalculatorGraphConfig GraphConfig(const std::string& calculator) {
+  CalculatorGraphConfig config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "input"
+    output_stream: "output"
+    node { input_stream: "input" output_stream: "output" }
+  )pb");
+  config.mutable_node(0)->set_calculator(calculator);
+  return config;
+}
+
+// Collects the output packets of the graphs of a pool.
+class OutputCollector {
+ public:
+  GraphPool::Options PoolOptions(int num_graphs) {
+    GraphPool::Options options;
+    options.num_graphs = num_graphs;
+    options.setup_graph = [this](CalculatorGraph& graph) {
+      CalculatorGraph* graph_ptr = &graph;
+      return graph.ObserveOutputStream(
+          "output", [this, graph_ptr](const Packet& packet) {
+            absl::MutexLock lock(&mutex_);
+            outputs_[graph_ptr].push_back(packet.Get<int>());
+            return absl::OkStatus();
+          });
+    };
+    return options;
+  }
+
+  // Returns and clears the outputs of "graph".
+  std::vector<int> TakeOutputs(CalculatorGraph* graph) {
+    absl::MutexLock lock(&mutex_);
+    return std::move(outputs_[graph]);
+  }
+
+ private:
+  absl::Mutex mutex_;
+  std::map<CalculatorGraph*, std::vector<int>> outputs_ ABSL_GUARDED_BY(mutex_);
+};
+
+// Runs a request on a graph of the pool, and returns its outputs.
+absl::StatusOr<std::vector<int>> RunRequest(GraphPool& pool,
+                                            OutputCollector& collector,
+                                            const std::vector<int>& inputs) {
+  MP_ASSIGN_OR_RETURN(GraphPool::PooledGraph graph, pool.Acquire());
+  absl::Status status;
+  for (int i = 0; i < inputs.size() && status.ok(); ++i) {
+    status = graph->AddPacketToInputStream(
+        "input", MakePacket<int>(inputs[i]).At(Timestamp(i)));
+  }
+  status.Update(graph.Finish());
+  std::vector<int> outputs = collector.TakeOutputs(graph.get());
+  MP_RETURN_IF_ERROR(status);
+  return outputs;
+}
+
+
+// Counts the op lookups of the interpreters built with it.
+class CountingOpResolver : public tflite::ops::builtin::BuiltinOpResolver {
+ public:
+  const TfLiteRegistration* FindOp(tflite::BuiltinOperator op,
+                                   int version) const override {
+    ++num_lookups_;
+    return BuiltinOpResolver::FindOp(op, version);
+  }
+
+  int num_lookups() const { return num_lookups_; }
+
+ private:
+  mutable std::atomic<int> num_lookups_{0};
+};
+
+TEST(GraphPoolTest, ResetsResettableCalculators) {
+  ResetCounts();
+  OutputCollector collector;
+  MP_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<GraphPool> pool,
+      GraphPool::Create(GraphConfig("ResettableCalculator"),
+                        collector.PoolOptions(1)));
+  for (int i = 0; i < 3; ++i) {
+    // The state of the previous request doesn't leak into the next one.
+    EXPECT_THAT(RunRequest(*pool, collector, {10, 10}),
+                IsOkAndHolds(ElementsAre(10, 11)));
+  }
+  // Waits until the calculators of the next run are opened.
+  MP_ASSERT_OK_AND_ASSIGN(GraphPool::PooledGraph graph, pool->Acquire());
+  MP_ASSERT_OK(graph->WaitUntilIdle());
+  EXPECT_EQ(Counts()->constructed, 1);
+  EXPECT_EQ(Counts()->opened, 1);
+  EXPECT_EQ(Counts()->reset, 3);
+}
+
+TEST(GraphPoolTest, RecreatesOtherCalculators) {
+  ResetCounts();
+  OutputCollector collector;
+  MP_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<GraphPool> pool,
+      GraphPool::Create(GraphConfig("NonResettableCalculator"),
+                        collector.PoolOptions(1)));
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_THAT(RunRequest(*pool, collector, {10, 10}),
+                IsOkAndHolds(ElementsAre(10, 11)));
+  }
+  // Waits until the calculators of the next run are opened.
+  MP_ASSERT_OK_AND_ASSIGN(GraphPool::PooledGraph graph, pool->Acquire());
+  MP_ASSERT_OK(graph->WaitUntilIdle());
+  EXPECT_EQ(Counts()->constructed, 4);
+  EXPECT_EQ(Counts()->opened, 4);
+  EXPECT_EQ(Counts()->reset, 0);
+}
+
+TEST(GraphPoolTest, RecreatesCalculatorsAfterFailedRun) {
+  ResetCounts();
+  OutputCollector collector;
+  MP_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<GraphPool> pool,
+      GraphPool::Create(GraphConfig("ResettableCalculator"),
+                        collector.PoolOptions(1)));
+  EXPECT_FALSE(RunRequest(*pool, collector, {1, -1}).ok());
+  EXPECT_THAT(RunRequest(*pool, collector, {1, 1}),
+              IsOkAndHolds(ElementsAre(1, 2)));
+  // Waits until the calculators of the next run are opened.
+  MP_ASSERT_OK_AND_ASSIGN(GraphPool::PooledGraph graph, pool->Acquire());
+  MP_ASSERT_OK(graph->WaitUntilIdle());
+  EXPECT_EQ(Counts()->constructed, 2);
+  EXPECT_EQ(Counts()->opened, 2);
+  EXPECT_EQ(Counts()->reset, 1);
+}
+
+TEST(GraphPoolTest, KeepsInferenceCalculatorInterpreter) {
+  CalculatorGraphConfig config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "input"
+    input_side_packet: "op_resolver"
+    node {
+      calculator: "InferenceCalculatorCpu"
+      input_stream: "TENSORS:input"
+      output_stream: "TENSORS:output"
+      input_side_packet: "OP_RESOLVER:op_resolver"
+      options {
+        [mediapipe.InferenceCalculatorOptions.ext] {
+          model_path: "mediapipe/calculators/tensor/testdata/add.bin"
+        }
+      }
+    }
+  )pb");
+  auto* op_resolver = new CountingOpResolver;
+  GraphPool::Options options;
+  options.num_graphs = 1;
+  options.side_packets["op_resolver"] =
+      Adopt<tflite::OpResolver>(op_resolver);
+  MP_ASSERT_OK_AND_ASSIGN(std::unique_ptr<GraphPool> pool,
+                          GraphPool::Create(config, options));
+
+  int num_lookups_after_open = 0;
+  for (int i = 0; i < 2; ++i) {
+    MP_ASSERT_OK_AND_ASSIGN(GraphPool::PooledGraph graph, pool->Acquire());
+    // Waits until the calculator of this run is opened or reset.
+    MP_ASSERT_OK(graph->WaitUntilIdle());
+    if (i == 0) {
+      num_lookups_after_open = op_resolver->num_lookups();
+      EXPECT_GT(num_lookups_after_open, 0);
+    } else {
+      // Reset() kept the interpreter built by Open() in the first request.
+      EXPECT_EQ(op_resolver->num_lookups(), num_lookups_after_open);
+    }
+    std::vector<Tensor> input;
+    input.emplace_back(Tensor::ElementType::kFloat32,
+                       Tensor::Shape{1, 8, 8, 3});
+    {
+      auto view = input.back().GetCpuWriteView();
+      std::fill_n(view.buffer<float>(), input.back().shape().num_elements(),
+                  1.0f);
+    }
+    MP_ASSERT_OK(graph->AddPacketToInputStream(
+        "input",
+        MakePacket<std::vector<Tensor>>(std::move(input)).At(Timestamp(0))));
+    MP_ASSERT_OK(graph.Finish());
+  }
+}
+
+TEST(GraphPoolTest, CancelsUnfinishedRuns) {
+  OutputCollector collector;
+  MP_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<GraphPool> pool,
+      GraphPool::Create(GraphConfig("ResettableCalculator"),
+                        collector.PoolOptions(1)));
+  {
+    MP_ASSERT_OK_AND_ASSIGN(GraphPool::PooledGraph graph, pool->Acquire());
+    MP_ASSERT_OK(graph->AddPacketToInputStream(
+        "input", MakePacket<int>(1).At(Timestamp(0))));
+    collector.TakeOutputs(graph.get());
+  }
+  MP_ASSERT_OK_AND_ASSIGN(GraphPool::PooledGraph graph, pool->Acquire());
+  collector.TakeOutputs(graph.get());
+  MP_ASSERT_OK(graph->AddPacketToInputStream(
+      "input", MakePacket<int>(5).At(Timestamp(0))));
+  MP_ASSERT_OK(graph.Finish());
+  EXPECT_THAT(collector.TakeOutputs(graph.get()), ElementsAre(5));
+}
+
+TEST(GraphPoolTest, ServesConcurrentRequests) {
+  OutputCollector collector;
+  MP_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<GraphPool> pool,
+      GraphPool::Create(GraphConfig("ResettableCalculator"),
+                        collector.PoolOptions(2)));
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&pool, &collector, t] {
+      for (int i = 0; i < 10; ++i) {
+        EXPECT_THAT(RunRequest(*pool, collector, {t, t, t}),
+                    IsOkAndHolds(ElementsAre(t, t + 1, t + 2)));
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+TEST(GraphPoolTest, ReportsSetupErrors) {
+  GraphPool::Options options;
+  options.setup_graph = [](CalculatorGraph& graph) {
+    return absl::InternalError("setup failed");
+  };
+  EXPECT_THAT(GraphPool::Create(GraphConfig("ResettableCalculator"), options),
+              StatusIs(absl::StatusCode::kInternal));
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -14,9 +14,13 @@
 
 #include "mediapipe/framework/input_stream_handler.h"
 
+#include "absl/algorithm/container.h"
 #include "absl/log/absl_check.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/substitute.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "mediapipe/framework/collection_item_id.h"
 #include "mediapipe/framework/mediapipe_profiling.h"
 #include "mediapipe/framework/port/ret_check.h"
@@ -24,6 +28,18 @@
 namespace mediapipe {
 using SyncSet = InputStreamHandler::SyncSet;
 
+InputStreamHandler::~InputStreamHandler() {
+  if (batch_timer_thread_ == nullptr) {
+    return;
+  }
+  {
+    absl::MutexLock lock(&batch_timer_mutex_);
+    batch_timer_stopping_ = true;
+    batch_timer_cond_.SignalAll();
+  }
+  batch_timer_thread_->join();
+}
+
 absl::Status InputStreamHandler::InitializeInputStreamManagers(
     InputStreamManager* flat_input_stream_managers) {
   for (CollectionItemId id = input_stream_managers_.BeginId();
@@ -72,6 +88,8 @@ void InputStreamHandler::PrepareForRun(
     std::function<void()> notification_callback,
     std::function<void(CalculatorContext*)> schedule_callback,
     std::function<void(absl::Status)> error_callback) {
+  // The timer of an aborted run must not invoke the old notification_.
+  CancelBatchTimer();
   headers_ready_callback_ = std::move(headers_ready_callback);
   notification_ = std::move(notification_callback);
   schedule_callback_ = std::move(schedule_callback);
@@ -85,6 +103,7 @@ void InputStreamHandler::PrepareForRun(
   }
   unset_header_count_.store(unset_header_count, std::memory_order_relaxed);
   prepared_context_for_close_ = false;
+  batch_deadline_ = absl::InfiniteFuture();
 }
 
 void InputStreamHandler::SetQueueSizeCallbacks(
@@ -130,6 +149,24 @@ void InputStreamHandler::SetMaxQueueSize(int max_queue_size) {
   }
 }
 
+void InputStreamHandler::EnableQueueByteAccounting(
+    InputStreamManager::QueueBytesCallback queue_bytes_callback) {
+  for (auto& stream : input_stream_managers_) {
+    stream->EnableQueueByteAccounting(queue_bytes_callback);
+  }
+}
+
+void InputStreamHandler::SetMaxQueueByteSize(int64_t max_queue_bytes) {
+  for (auto& stream : input_stream_managers_) {
+    stream->SetMaxQueueByteSize(max_queue_bytes);
+  }
+}
+
+void InputStreamHandler::SetMaxQueueByteSize(CollectionItemId id,
+                                             int64_t max_queue_bytes) {
+  input_stream_managers_.Get(id)->SetMaxQueueByteSize(max_queue_bytes);
+}
+
 std::string InputStreamHandler::DebugStreamNames() const {
   std::vector<absl::string_view> stream_names;
   for (const auto& stream : input_stream_managers_) {
@@ -165,6 +202,15 @@ bool InputStreamHandler::ScheduleInvocations(int max_allowance,
       if (batch_size_ > 1 &&
           calculator_context_manager_->ContextHasInputTimestamp(
               *calculator_context_manager_->GetDefaultCalculatorContext())) {
+        if (batch_deadline_ != absl::InfiniteFuture() &&
+            absl::Now() >= batch_deadline_) {
+          // The first input set of the incomplete batch has waited for
+          // max_batch_delay_, so the batch is scheduled as it is.
+          StopBatchTimer();
+          schedule_callback_(
+              calculator_context_manager_->GetDefaultCalculatorContext());
+          ++invocations_scheduled;
+        }
         // When batching is in progress, input_bound stays equal to the first
         // timestamp in the calculator context. This allows timestamp
         // propagation to be performed only for the first timestamp, and
@@ -190,10 +236,15 @@ bool InputStreamHandler::ScheduleInvocations(int max_allowance,
       if (!late_preparation_) {
         FillInputSet(min_stream_timestamp, &calculator_context->Inputs());
       }
-      if (calculator_context_manager_->NumberOfContextTimestamps(
-              *calculator_context) == batch_size_) {
+      const int num_context_timestamps =
+          calculator_context_manager_->NumberOfContextTimestamps(
+              *calculator_context);
+      if (num_context_timestamps == batch_size_) {
+        StopBatchTimer();
         schedule_callback_(calculator_context);
         ++invocations_scheduled;
+      } else if (num_context_timestamps == 1) {
+        StartBatchTimer();
       }
       mediapipe::LogEvent(calculator_context->GetProfilingContext(),
                           TraceEvent(TraceEvent::READY_FOR_PROCESS)
@@ -213,6 +264,7 @@ bool InputStreamHandler::ScheduleInvocations(int max_allowance,
           calculator_context_manager_->GetDefaultCalculatorContext();
       calculator_context_manager_->PushInputTimestampToContext(
           default_context, Timestamp::Done());
+      StopBatchTimer();
       schedule_callback_(default_context);
       ++invocations_scheduled;
       prepared_context_for_close_ = true;
@@ -250,10 +302,14 @@ void LogQueuedPackets(CalculatorContext* context, InputStreamManager* stream,
                            .set_event_data(stream->QueueSize() + 1);
     mediapipe::LogEvent(context->GetProfilingContext(),
                         event.set_packet_ts(queue_tail.Timestamp()));
-    Packet queue_head = stream->QueueHead();
-    if (!queue_head.IsEmpty()) {
+    // This runs on the producer side, so it must not read the packet at the
+    // head of a single-producer/single-consumer queue.
+    bool queue_is_empty;
+    Timestamp queue_head_timestamp =
+        stream->MinTimestampOrBound(&queue_is_empty);
+    if (!queue_is_empty) {
       mediapipe::LogEvent(context->GetProfilingContext(),
-                          event.set_packet_ts(queue_head.Timestamp()));
+                          event.set_packet_ts(queue_head_timestamp));
     }
   }
 }
@@ -269,7 +325,7 @@ void InputStreamHandler::AddPackets(CollectionItemId id,
     error_callback_(result);
   }
   if (notify) {
-    notification_();
+    Notify();
   }
 }
 
@@ -284,7 +340,7 @@ void InputStreamHandler::MovePackets(CollectionItemId id,
     error_callback_(result);
   }
   if (notify) {
-    notification_();
+    Notify();
   }
 }
 
@@ -297,7 +353,35 @@ void InputStreamHandler::SetNextTimestampBound(CollectionItemId id,
     error_callback_(result);
   }
   if (notify) {
+    Notify();
+  }
+}
+
+thread_local InputStreamHandler::NotificationBatch*
+    InputStreamHandler::NotificationBatch::current_ = nullptr;
+
+InputStreamHandler::NotificationBatch::NotificationBatch()
+    : enclosing_batch_(current_) {
+  current_ = this;
+}
+
+InputStreamHandler::NotificationBatch::~NotificationBatch() {
+  current_ = enclosing_batch_;
+  // The notified nodes may be scheduled and propagate their own outputs on
+  // this thread, in batches of their own.
+  for (InputStreamHandler* handler : handlers_) {
+    handler->notification_();
+  }
+}
+
+void InputStreamHandler::Notify() {
+  NotificationBatch* batch = NotificationBatch::current_;
+  if (batch == nullptr) {
     notification_();
+    return;
+  }
+  if (!absl::c_linear_search(batch->handlers_, this)) {
+    batch->handlers_.push_back(this);
   }
 }
 
@@ -315,6 +399,7 @@ void InputStreamHandler::Close() {
   for (auto& stream : input_stream_managers_) {
     stream->Close();
   }
+  CancelBatchTimer();
 }
 
 void InputStreamHandler::SetBatchSize(int batch_size) {
@@ -330,6 +415,73 @@ void InputStreamHandler::SetBatchSize(int batch_size) {
   batch_size_ = batch_size;
 }
 
+void InputStreamHandler::SetMaxBatchDelay(absl::Duration max_batch_delay) {
+  ABSL_CHECK(max_batch_delay > absl::ZeroDuration())
+      << "Max batch delay has to be positive.";
+  max_batch_delay_ = max_batch_delay;
+}
+
+void InputStreamHandler::StartBatchTimer() {
+  if (max_batch_delay_ == absl::InfiniteDuration()) {
+    return;
+  }
+  batch_deadline_ = absl::Now() + max_batch_delay_;
+  absl::MutexLock lock(&batch_timer_mutex_);
+  if (batch_timer_thread_ == nullptr) {
+    batch_timer_thread_ =
+        std::make_unique<std::thread>([this] { RunBatchTimer(); });
+  }
+  batch_timer_deadline_ = batch_deadline_;
+  batch_timer_cond_.SignalAll();
+}
+
+void InputStreamHandler::StopBatchTimer() {
+  if (batch_deadline_ == absl::InfiniteFuture()) {
+    return;
+  }
+  batch_deadline_ = absl::InfiniteFuture();
+  absl::MutexLock lock(&batch_timer_mutex_);
+  batch_timer_deadline_ = absl::InfiniteFuture();
+}
+
+void InputStreamHandler::CancelBatchTimer() {
+  if (batch_timer_thread_ == nullptr) {
+    return;
+  }
+  absl::MutexLock lock(&batch_timer_mutex_);
+  batch_timer_deadline_ = absl::InfiniteFuture();
+  // The timer thread itself may end up here through batch_timer_callback_.
+  if (std::this_thread::get_id() == batch_timer_thread_->get_id()) {
+    return;
+  }
+  while (batch_timer_firing_) {
+    batch_timer_cond_.Wait(&batch_timer_mutex_);
+  }
+}
+
+void InputStreamHandler::RunBatchTimer() {
+  batch_timer_mutex_.Lock();
+  while (!batch_timer_stopping_) {
+    if (absl::Now() < batch_timer_deadline_) {
+      batch_timer_cond_.WaitWithDeadline(&batch_timer_mutex_,
+                                         batch_timer_deadline_);
+      continue;
+    }
+    batch_timer_deadline_ = absl::InfiniteFuture();
+    batch_timer_firing_ = true;
+    batch_timer_mutex_.Unlock();
+    if (batch_timer_callback_) {
+      batch_timer_callback_();
+    } else {
+      notification_();
+    }
+    batch_timer_mutex_.Lock();
+    batch_timer_firing_ = false;
+    batch_timer_cond_.SignalAll();
+  }
+  batch_timer_mutex_.Unlock();
+}
+
 void InputStreamHandler::SetLatePreparation(bool late_preparation) {
   ABSL_CHECK(batch_size_ == 1 || !late_preparation_)
       << "Batching cannot be combined with late preparation.";
@@ -16,13 +16,19 @@
 #define MEDIAPIPE_FRAMEWORK_INPUT_STREAM_HANDLER_H_
 
 #include <atomic>
+#include <cstdint>
 #include <functional>
 #include <list>
 #include <memory>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
 #include <utility>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 // TODO: Move protos in another CL after the C++ code migration.
 #include "mediapipe/framework/calculator_context.h"
 #include "mediapipe/framework/calculator_context_manager.h"
@@ -76,7 +82,7 @@ class InputStreamHandler {
         options_(options),
         calculator_run_in_parallel_(calculator_run_in_parallel) {}
 
-  virtual ~InputStreamHandler() = default;
+  virtual ~InputStreamHandler();
 
   // Initializes the InputStreamManagerSet object.
   // flat_input_stream_managers is expected to point to a contiguous
@@ -108,6 +114,13 @@ class InputStreamHandler {
       std::function<void(CalculatorContext*)> schedule_callback,
       std::function<void(absl::Status)> error_callback);
 
+  // Sets the function that the batch timer invokes instead of the
+  // notification callback. It must keep the graph from becoming idle while
+  // the node is scheduled from the timer thread.
+  void SetBatchTimerCallback(std::function<void()> batch_timer_callback) {
+    batch_timer_callback_ = std::move(batch_timer_callback);
+  }
+
   int NumInputStreams() const { return input_stream_managers_.NumEntries(); }
 
   // Returns the tag map of the input streams.
@@ -127,6 +140,17 @@ class InputStreamHandler {
   // Sets max queue size of a particular stream.
   void SetMaxQueueSize(CollectionItemId id, int max_queue_size);
 
+  // Enables byte accounting on every stream, see
+  // InputStreamManager::EnableQueueByteAccounting().
+  void EnableQueueByteAccounting(
+      InputStreamManager::QueueBytesCallback queue_bytes_callback);
+
+  // Sets max queue bytes of every stream.
+  void SetMaxQueueByteSize(int64_t max_queue_bytes);
+
+  // Sets max queue bytes of a particular stream.
+  void SetMaxQueueByteSize(CollectionItemId id, int64_t max_queue_bytes);
+
   void SetQueueSizeCallbacks(
       InputStreamManager::QueueSizeCallback becomes_full_callback,
       InputStreamManager::QueueSizeCallback becomes_not_full_callback);
@@ -141,6 +165,33 @@ class InputStreamHandler {
   // Sets next timestamp bound in a particular stream.
   void SetNextTimestampBound(CollectionItemId id, Timestamp bound);
 
+  // While a NotificationBatch is in scope, the notifications of the input
+  // stream handlers whose streams the current thread updates are deferred
+  // until it goes out of scope, and each handler is then notified once.
+  // Output stream handlers propagate the outputs of a node invocation in one
+  // batch, so that a downstream node with several updated input streams, such
+  // as optional streams that only carry timestamp bounds, checks its
+  // readiness once per upstream invocation rather than once per stream.
+  // Batches nest, and each notifies the handlers updated in its own scope.
+  class NotificationBatch {
+   public:
+    NotificationBatch();
+    ~NotificationBatch();
+
+    NotificationBatch(const NotificationBatch&) = delete;
+    NotificationBatch& operator=(const NotificationBatch&) = delete;
+
+   private:
+    friend class InputStreamHandler;
+
+    // The innermost batch of the current thread, or nullptr.
+    static thread_local NotificationBatch* current_;
+
+    NotificationBatch* const enclosing_batch_;
+    // The handlers to notify, in the order of their first update.
+    absl::InlinedVector<InputStreamHandler*, 8> handlers_;
+  };
+
   // Clears the current packet of every stream shard and removes the current
   // timestamp from the calculator context.
   void ClearCurrentInputs(CalculatorContext* calculator_context);
@@ -187,6 +238,16 @@ class InputStreamHandler {
   // Returns the number of sync-sets populated by this input stream handler.
   virtual int SyncSetCount() { return 1; }
 
+  // Returns true if the input streams of this handler may use lock-free
+  // single-producer/single-consumer queues. This requires that the handler
+  // only reads its streams through InputStreamManager's MinTimestampOrBound(),
+  // PopPacketAtTimestamp() and PopQueueHead() from within
+  // ScheduleInvocations(). See
+  // InputStreamManager::EnableSingleProducerSingleConsumer().
+  virtual bool SupportsSingleProducerSingleConsumerStreams() const {
+    return false;
+  }
+
   // A helper class to build input packet sets for a certain set of streams.
   //
   // ReadyForProcess requires all of the streams to be fully determined
@@ -237,6 +298,12 @@ class InputStreamHandler {
   // Batching cannot be combined with late_preparation_ behavior.
   void SetBatchSize(int batch_size);
 
+  // Subclasses that enable batching can bound the time that input sets wait
+  // for a batch to fill up: once the first input set of an incomplete batch
+  // has waited for max_batch_delay, the incomplete batch is scheduled.
+  // Should be called in the constructor.
+  void SetMaxBatchDelay(absl::Duration max_batch_delay);
+
   // Subclasses can enable late preparation; however it cannot be used along
   // with batching.
   void SetLatePreparation(bool late_preparation);
@@ -288,6 +355,9 @@ class InputStreamHandler {
   std::function<void(absl::Status)> error_callback_;
 
  private:
+  // Invokes notification_, or defers it to the current NotificationBatch.
+  void Notify();
+
   // Indicates when to fill the input set. If true, every input set will be
   // prepared in FinalizeInputSet(). Otherwise, the input sets will be filled
   // in ScheduleInvocations() in the scheduling phase.
@@ -300,6 +370,40 @@ class InputStreamHandler {
   // CalculatorNode is scheduled.
   int batch_size_ = 1;
 
+  // Starts the timer of the batch whose first input set was just prepared.
+  void StartBatchTimer();
+
+  // Stops the timer of the current batch once it is scheduled.
+  void StopBatchTimer();
+
+  // Stops the timer and waits until it no longer invokes the node.
+  void CancelBatchTimer();
+
+  // Invokes batch_timer_callback_ when the deadline of the current batch has
+  // passed, so that the node schedules the incomplete batch. Runs on
+  // batch_timer_thread_.
+  void RunBatchTimer();
+
+  // See SetBatchTimerCallback(). Defaults to notification_.
+  std::function<void()> batch_timer_callback_;
+
+  // See SetMaxBatchDelay().
+  absl::Duration max_batch_delay_ = absl::InfiniteDuration();
+
+  // The time at which the incomplete batch in the default calculator context
+  // is due. Only accessed in the schedule phase.
+  absl::Time batch_deadline_ = absl::InfiniteFuture();
+
+  // Started when the first batch with a deadline is prepared.
+  std::unique_ptr<std::thread> batch_timer_thread_;
+  absl::Mutex batch_timer_mutex_;
+  absl::CondVar batch_timer_cond_;
+  absl::Time batch_timer_deadline_ ABSL_GUARDED_BY(batch_timer_mutex_) =
+      absl::InfiniteFuture();
+  // True while the timer thread invokes batch_timer_callback_.
+  bool batch_timer_firing_ ABSL_GUARDED_BY(batch_timer_mutex_) = false;
+  bool batch_timer_stopping_ ABSL_GUARDED_BY(batch_timer_mutex_) = false;
+
   // When true, any increase in timestamp bound invokes Calculator::Process.
   bool process_timestamps_ = false;
 
@@ -14,6 +14,8 @@
 
 #include "mediapipe/framework/input_stream_manager.h"
 
+#include <atomic>
+#include <cstdint>
 #include <type_traits>
 #include <utility>
 
@@ -24,6 +26,7 @@
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/source_location.h"
 #include "mediapipe/framework/port/status_builder.h"
+#include "mediapipe/framework/port/status_macros.h"
 #include "mediapipe/framework/tool/status_util.h"
 
 namespace mediapipe {
@@ -47,6 +50,17 @@ void InputStreamManager::SetQueueSizeCallbacks(
   becomes_not_full_callback_ = becomes_not_full_callback;
 }
 
+void InputStreamManager::EnableQueueByteAccounting(
+    QueueBytesCallback queue_bytes_callback) {
+  account_queue_bytes_ = true;
+  queue_bytes_callback_ = std::move(queue_bytes_callback);
+}
+
+void InputStreamManager::EnableSingleProducerSingleConsumer() {
+  single_producer_single_consumer_ = true;
+  PrepareForRun();
+}
+
 void InputStreamManager::PrepareForRun() {
   absl::MutexLock stream_lock(&stream_mutex_);
   queue_.clear();
@@ -56,14 +70,30 @@ void InputStreamManager::PrepareForRun() {
   last_select_timestamp_ = Timestamp::Unstarted();
   closed_ = false;
   header_ = Packet();
+  spsc_queue_.Clear();
+  spsc_num_packets_added_ = 0;
+  spsc_next_timestamp_bound_ = Timestamp::PreStream().Value();
+  spsc_last_select_timestamp_ = Timestamp::Unstarted().Value();
+  spsc_closed_ = false;
+  queue_bytes_ = 0;
+  peak_queue_bytes_ = 0;
 }
 
 bool InputStreamManager::IsEmpty() const {
+  if (single_producer_single_consumer_) {
+    return spsc_queue_.Size() == 0;
+  }
   absl::MutexLock stream_lock(&stream_mutex_);
   return queue_.empty();
 }
 
 Packet InputStreamManager::QueueHead() const {
+  if (single_producer_single_consumer_) {
+    if (spsc_queue_.Size() == 0) {
+      return Packet();
+    }
+    return spsc_queue_.Front();
+  }
   absl::MutexLock stream_lock(&stream_mutex_);
   if (queue_.empty()) {
     return Packet();
@@ -83,20 +113,74 @@ absl::Status InputStreamManager::SetHeader(const Packet& header) {
 
 absl::Status InputStreamManager::AddPackets(const std::list<Packet>& container,
                                             bool* notify) {
+  if (single_producer_single_consumer_) {
+    return AddOrMovePacketsLockFree<const std::list<Packet>&>(container,
+                                                              notify);
+  }
   return AddOrMovePacketsInternal<const std::list<Packet>&>(container, notify);
 }
 
 absl::Status InputStreamManager::MovePackets(std::list<Packet>* container,
                                              bool* notify) {
+  if (single_producer_single_consumer_) {
+    return AddOrMovePacketsLockFree<std::list<Packet>&>(*container, notify);
+  }
   return AddOrMovePacketsInternal<std::list<Packet>&>(*container, notify);
 }
 
+absl::Status InputStreamManager::ValidatePacket(
+    const Packet& packet, Timestamp next_timestamp_bound,
+    int64_t num_packets_added) const {
+  absl::Status result = packet_type_->Validate(packet);
+  if (!result.ok()) {
+    return tool::AddStatusPrefix(
+        absl::StrCat(
+            "Packet type mismatch on a calculator receiving from stream \"",
+            name_, "\": "),
+        result);
+  }
+
+  const Timestamp timestamp = packet.Timestamp();
+  if (!timestamp.IsAllowedInStream()) {
+    return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+           << "In stream \"" << name_
+           << "\", timestamp not specified or set to illegal value: "
+           << timestamp.DebugString();
+  }
+  if (enable_timestamps_) {
+    // Check that PostStream(), if used, is the only timestamp used.  This
+    // is also true for PreStream() but doesn't need to be checked because
+    // Timestamp::PreStream().NextAllowedInStream() is
+    // Timestamp::OneOverPostStream().
+    if (timestamp == Timestamp::PostStream() && num_packets_added > 0) {
+      return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+             << "In stream \"" << name_
+             << "\", a packet at Timestamp::PostStream() must be the only "
+                "Packet in an InputStream.";
+    }
+    if (timestamp < next_timestamp_bound) {
+      return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+             << "Packet timestamp mismatch on a calculator receiving from "
+                "stream \""
+             << name_ << "\". Current minimum expected timestamp is "
+             << next_timestamp_bound.DebugString() << " but received "
+             << timestamp.DebugString()
+             << ". Are you using a custom InputStreamHandler? Note that "
+                "some InputStreamHandlers allow timestamps that are not "
+                "strictly monotonically increasing. See for example the "
+                "ImmediateInputStreamHandler class comment.";
+    }
+  }
+  return absl::OkStatus();
+}
+
 template <typename Container>
 absl::Status InputStreamManager::AddOrMovePacketsInternal(Container container,
                                                           bool* notify) {
   *notify = false;
   bool queue_became_non_empty = false;
   bool queue_became_full = false;
+  int64_t added_bytes = 0;
   {
     // Scope to prevent locking the stream when notification is called.
     absl::MutexLock stream_lock(&stream_mutex_);
@@ -104,58 +188,24 @@ absl::Status InputStreamManager::AddOrMovePacketsInternal(Container container,
       return absl::OkStatus();
     }
     // Check if the queue was full before packets came in.
-    bool was_queue_full =
-        (max_queue_size_ != -1 && queue_.size() >= max_queue_size_);
+    bool was_queue_full = IsFullQueue(queue_.size(), queue_bytes_);
     // Check if the queue becomes non-empty.
     queue_became_non_empty = queue_.empty() && !container.empty();
     for (auto& packet : container) {
-      absl::Status result = packet_type_->Validate(packet);
-      if (!result.ok()) {
-        return tool::AddStatusPrefix(
-            absl::StrCat(
-                "Packet type mismatch on a calculator receiving from stream \"",
-                name_, "\": "),
-            result);
-      }
-
-      const Timestamp timestamp = packet.Timestamp();
-      if (!timestamp.IsAllowedInStream()) {
-        return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
-               << "In stream \"" << name_
-               << "\", timestamp not specified or set to illegal value: "
-               << timestamp.DebugString();
-      }
-      if (enable_timestamps_) {
-        // Check that PostStream(), if used, is the only timestamp used.  This
-        // is also true for PreStream() but doesn't need to be checked because
-        // Timestamp::PreStream().NextAllowedInStream() is
-        // Timestamp::OneOverPostStream().
-        if (timestamp == Timestamp::PostStream() && num_packets_added_ > 0) {
-          return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
-                 << "In stream \"" << name_
-                 << "\", a packet at Timestamp::PostStream() must be the only "
-                    "Packet in an InputStream.";
-        }
-        if (timestamp < next_timestamp_bound_) {
-          return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
-                 << "Packet timestamp mismatch on a calculator receiving from "
-                    "stream \""
-                 << name_ << "\". Current minimum expected timestamp is "
-                 << next_timestamp_bound_.DebugString() << " but received "
-                 << timestamp.DebugString()
-                 << ". Are you using a custom InputStreamHandler? Note that "
-                    "some InputStreamHandlers allow timestamps that are not "
-                    "strictly monotonically increasing. See for example the "
-                    "ImmediateInputStreamHandler class comment.";
-        }
-      }
-      next_timestamp_bound_ = timestamp.NextAllowedInStream();
+      MP_RETURN_IF_ERROR(
+          ValidatePacket(packet, next_timestamp_bound_, num_packets_added_));
+      next_timestamp_bound_ = packet.Timestamp().NextAllowedInStream();
 
       // If the caller is MovePackets(), packet's underlying holder should be
       // transferred into queue_. Otherwise, queue_ keeps a copy of the packet.
       ++num_packets_added_;
       VLOG(3) << "Input stream:" << name_
               << " has added packet at time: " << packet.Timestamp();
+      const int64_t byte_size = AccountedByteSize(packet);
+      if (byte_size != 0) {
+        AddQueueBytes(byte_size);
+        added_bytes += byte_size;
+      }
       if (std::is_const<
               typename std::remove_reference<Container>::type>::value) {
         queue_.emplace_back(packet);
@@ -163,8 +213,8 @@ absl::Status InputStreamManager::AddOrMovePacketsInternal(Container container,
         queue_.emplace_back(std::move(packet));
       }
     }
-    queue_became_full = (!was_queue_full && max_queue_size_ != -1 &&
-                         queue_.size() >= max_queue_size_);
+    queue_became_full =
+        !was_queue_full && IsFullQueue(queue_.size(), queue_bytes_);
     if (queue_.size() > 1) {
       VLOG(3) << "Queue size greater than 1: stream name: " << name_
               << " queue_size: " << queue_.size();
@@ -173,6 +223,9 @@ absl::Status InputStreamManager::AddOrMovePacketsInternal(Container container,
             << " becomes non-empty status:" << queue_became_non_empty
             << " Size: " << queue_.size();
   }
+  if (added_bytes != 0 && queue_bytes_callback_) {
+    queue_bytes_callback_(added_bytes);
+  }
   if (queue_became_full) {
     VLOG(3) << "Queue became full: " << Name();
     becomes_full_callback_(this, &last_reported_stream_full_);
@@ -183,6 +236,9 @@ absl::Status InputStreamManager::AddOrMovePacketsInternal(Container container,
 
 absl::Status InputStreamManager::SetNextTimestampBound(const Timestamp bound,
                                                        bool* notify) {
+  if (single_producer_single_consumer_) {
+    return SetNextTimestampBoundLockFree(bound, notify);
+  }
   *notify = false;
   {
     // Scope to prevent locking the stream when notification is called.
@@ -220,6 +276,14 @@ absl::Status InputStreamManager::SetNextTimestampBound(const Timestamp bound,
 void InputStreamManager::DisableTimestamps() { enable_timestamps_ = false; }
 
 void InputStreamManager::Close() {
+  if (single_producer_single_consumer_) {
+    if (spsc_closed_.exchange(true)) {
+      return;
+    }
+    RaiseNextTimestampBound(Timestamp::Done());
+    spsc_last_select_timestamp_ = Timestamp::Done().Value();
+    return;
+  }
   absl::MutexLock stream_lock(&stream_mutex_);
   if (closed_) {
     return;
@@ -230,6 +294,9 @@ void InputStreamManager::Close() {
 }
 
 Timestamp InputStreamManager::MinTimestampOrBound(bool* is_empty) const {
+  if (single_producer_single_consumer_) {
+    return MinTimestampOrBoundLockFree(is_empty);
+  }
   absl::MutexLock stream_lock(&stream_mutex_);
   if (is_empty) {
     *is_empty = queue_.empty();
@@ -245,10 +312,15 @@ Timestamp InputStreamManager::MinTimestampOrBoundHelper() const
 Packet InputStreamManager::PopPacketAtTimestamp(Timestamp timestamp,
                                                 int* num_packets_dropped,
                                                 bool* stream_is_done) {
+  if (single_producer_single_consumer_) {
+    return PopPacketAtTimestampLockFree(timestamp, num_packets_dropped,
+                                        stream_is_done);
+  }
   ABSL_CHECK(enable_timestamps_);
   *num_packets_dropped = -1;
   *stream_is_done = false;
   bool queue_became_non_full = false;
+  int64_t removed_bytes = 0;
   Packet packet;
   {
     absl::MutexLock stream_lock(&stream_mutex_);
@@ -270,15 +342,18 @@ Packet InputStreamManager::PopPacketAtTimestamp(Timestamp timestamp,
     Timestamp current_timestamp = Timestamp::Unset();
 
     // Checks if queue is full.
-    bool was_queue_full =
-        (max_queue_size_ != -1 && queue_.size() >= max_queue_size_);
+    bool was_queue_full = IsFullQueue(queue_.size(), queue_bytes_);
 
     while (!queue_.empty() && queue_.front().Timestamp() <= timestamp) {
       packet = std::move(queue_.front());
       queue_.pop_front();
+      removed_bytes += AccountedByteSize(packet);
       current_timestamp = packet.Timestamp();
       ++(*num_packets_dropped);
     }
+    if (removed_bytes != 0) {
+      AddQueueBytes(-removed_bytes);
+    }
     // Clear value_ if it doesn't have exactly the right timestamp.
     if (current_timestamp != timestamp) {
       // The timestamp bound reported when no packet is sent.
@@ -289,9 +364,13 @@ Packet InputStreamManager::PopPacketAtTimestamp(Timestamp timestamp,
 
     VLOG(3) << "Input stream removed packets:" << name_
             << " Size:" << queue_.size();
-    queue_became_non_full = (was_queue_full && queue_.size() < max_queue_size_);
+    queue_became_non_full =
+        was_queue_full && !IsFullQueue(queue_.size(), queue_bytes_);
     *stream_is_done = IsDone();
   }
+  if (removed_bytes != 0 && queue_bytes_callback_) {
+    queue_bytes_callback_(-removed_bytes);
+  }
   if (queue_became_non_full) {
     VLOG(3) << "Queue became non-full: " << Name();
     becomes_not_full_callback_(this, &last_reported_stream_full_);
@@ -300,9 +379,13 @@ Packet InputStreamManager::PopPacketAtTimestamp(Timestamp timestamp,
 }
 
 Packet InputStreamManager::PopQueueHead(bool* stream_is_done) {
+  if (single_producer_single_consumer_) {
+    return PopQueueHeadLockFree(stream_is_done);
+  }
   ABSL_CHECK(!enable_timestamps_);
   *stream_is_done = false;
   bool queue_became_non_full = false;
+  int64_t removed_bytes = 0;
   Packet packet;
   {
     absl::MutexLock stream_lock(&stream_mutex_);
@@ -310,21 +393,28 @@ Packet InputStreamManager::PopQueueHead(bool* stream_is_done) {
     VLOG(3) << "Input stream " << name_ << " selecting at queue head";
 
     // Check if queue is full.
-    bool was_queue_full =
-        (max_queue_size_ != -1 && queue_.size() >= max_queue_size_);
+    bool was_queue_full = IsFullQueue(queue_.size(), queue_bytes_);
 
     if (!queue_.empty()) {
       packet = std::move(queue_.front());
       queue_.pop_front();
+      removed_bytes = AccountedByteSize(packet);
+      if (removed_bytes != 0) {
+        AddQueueBytes(-removed_bytes);
+      }
     } else {
       packet = Packet();
     }
 
     VLOG(3) << "Input stream removed a packet:" << name_
             << " Size:" << queue_.size();
-    queue_became_non_full = (was_queue_full && queue_.size() < max_queue_size_);
+    queue_became_non_full =
+        was_queue_full && !IsFullQueue(queue_.size(), queue_bytes_);
     *stream_is_done = IsDone();
   }
+  if (removed_bytes != 0 && queue_bytes_callback_) {
+    queue_bytes_callback_(-removed_bytes);
+  }
   if (queue_became_non_full) {
     VLOG(3) << "Queue became non-full: " << Name();
     becomes_not_full_callback_(this, &last_reported_stream_full_);
@@ -333,28 +423,73 @@ Packet InputStreamManager::PopQueueHead(bool* stream_is_done) {
 }
 
 int InputStreamManager::NumPacketsAdded() const {
+  if (single_producer_single_consumer_) {
+    return spsc_num_packets_added_;
+  }
   absl::MutexLock lock(&stream_mutex_);
   return num_packets_added_;
 }
 
 int InputStreamManager::QueueSize() const {
+  if (single_producer_single_consumer_) {
+    return spsc_queue_.Size();
+  }
   absl::MutexLock lock(&stream_mutex_);
   return static_cast<int>(queue_.size());
 }
 
-int InputStreamManager::MaxQueueSize() const {
-  absl::MutexLock lock(&stream_mutex_);
-  return max_queue_size_;
-}
+int InputStreamManager::MaxQueueSize() const { return max_queue_size_; }
 
 void InputStreamManager::SetMaxQueueSize(int max_queue_size) {
   bool was_full;
   bool is_full;
-  {
+  if (single_producer_single_consumer_) {
+    // The queue size is read after the update, so that a concurrent push or
+    // pop either sees the new maximum or is accounted for here.
+    const int old_max_queue_size = max_queue_size_.exchange(max_queue_size);
+    const int queue_size = spsc_queue_.Size();
+    const bool bytes_full = QueueBytesFull(queue_bytes_);
+    was_full = bytes_full ||
+               (old_max_queue_size != -1 && queue_size >= old_max_queue_size);
+    is_full =
+        bytes_full || (max_queue_size != -1 && queue_size >= max_queue_size);
+  } else {
     absl::MutexLock lock(&stream_mutex_);
-    was_full = (max_queue_size_ != -1 && queue_.size() >= max_queue_size_);
+    was_full = IsFullQueue(queue_.size(), queue_bytes_);
     max_queue_size_ = max_queue_size;
-    is_full = (max_queue_size_ != -1 && queue_.size() >= max_queue_size_);
+    is_full = IsFullQueue(queue_.size(), queue_bytes_);
+  }
+
+  // QueueSizeCallback is called with no mutexes held.
+  if (!was_full && is_full) {
+    VLOG(3) << "Queue became full: " << Name();
+    becomes_full_callback_(this, &last_reported_stream_full_);
+  } else if (was_full && !is_full) {
+    VLOG(3) << "Queue became non-full: " << Name();
+    becomes_not_full_callback_(this, &last_reported_stream_full_);
+  }
+}
+
+void InputStreamManager::SetMaxQueueByteSize(int64_t max_queue_bytes) {
+  ABSL_CHECK(account_queue_bytes_ || max_queue_bytes == -1);
+  bool was_full;
+  bool is_full;
+  if (single_producer_single_consumer_) {
+    // As in SetMaxQueueSize(), the queue is read after the update.
+    const int64_t old_max_queue_bytes =
+        max_queue_bytes_.exchange(max_queue_bytes);
+    const int64_t queue_bytes = queue_bytes_;
+    const int max_queue_size = max_queue_size_;
+    const bool size_full =
+        max_queue_size != -1 && spsc_queue_.Size() >= max_queue_size;
+    was_full = size_full || (old_max_queue_bytes != -1 &&
+                             queue_bytes >= old_max_queue_bytes);
+    is_full = size_full || QueueBytesFull(queue_bytes);
+  } else {
+    absl::MutexLock lock(&stream_mutex_);
+    was_full = IsFullQueue(queue_.size(), queue_bytes_);
+    max_queue_bytes_ = max_queue_bytes;
+    is_full = IsFullQueue(queue_.size(), queue_bytes_);
   }
 
   // QueueSizeCallback is called with no mutexes held.
@@ -368,11 +503,37 @@ void InputStreamManager::SetMaxQueueSize(int max_queue_size) {
 }
 
 bool InputStreamManager::IsFull() const {
+  if (single_producer_single_consumer_) {
+    return IsFullQueue(spsc_queue_.Size(), queue_bytes_);
+  }
   absl::MutexLock lock(&stream_mutex_);
-  return max_queue_size_ != -1 && queue_.size() >= max_queue_size_;
+  return IsFullQueue(queue_.size(), queue_bytes_);
+}
+
+bool InputStreamManager::IsFullQueue(int64_t queue_size,
+                                     int64_t queue_bytes) const {
+  const int max_queue_size = max_queue_size_;
+  return (max_queue_size != -1 && queue_size >= max_queue_size) ||
+         QueueBytesFull(queue_bytes);
+}
+
+bool InputStreamManager::QueueBytesFull(int64_t queue_bytes) const {
+  const int64_t max_queue_bytes = max_queue_bytes_;
+  return max_queue_bytes != -1 && queue_bytes >= max_queue_bytes;
+}
+
+int64_t InputStreamManager::AddQueueBytes(int64_t delta) {
+  const int64_t queue_bytes = queue_bytes_.fetch_add(delta) + delta;
+  int64_t peak_queue_bytes = peak_queue_bytes_.load(std::memory_order_relaxed);
+  while (queue_bytes > peak_queue_bytes &&
+         !peak_queue_bytes_.compare_exchange_weak(peak_queue_bytes,
+                                                  queue_bytes)) {
+  }
+  return queue_bytes;
 }
 
 Timestamp InputStreamManager::GetMinTimestampAmongNLatest(int n) const {
+  ABSL_CHECK(!single_producer_single_consumer_);
   absl::MutexLock lock(&stream_mutex_);
   if (queue_.empty()) {
     return Timestamp::Unset();
@@ -381,20 +542,29 @@ Timestamp InputStreamManager::GetMinTimestampAmongNLatest(int n) const {
 }
 
 void InputStreamManager::ErasePacketsEarlierThan(Timestamp timestamp) {
+  ABSL_CHECK(!single_producer_single_consumer_);
   bool queue_became_non_full = false;
+  int64_t removed_bytes = 0;
   {
     absl::MutexLock lock(&stream_mutex_);
     // Checks if queue is full.
-    bool was_queue_full =
-        (max_queue_size_ != -1 && queue_.size() >= max_queue_size_);
+    bool was_queue_full = IsFullQueue(queue_.size(), queue_bytes_);
 
     while (!queue_.empty() && queue_.front().Timestamp() < timestamp) {
+      removed_bytes += AccountedByteSize(queue_.front());
       queue_.pop_front();
     }
+    if (removed_bytes != 0) {
+      AddQueueBytes(-removed_bytes);
+    }
 
     VLOG(3) << "Input stream removed packets:" << name_
             << " Size:" << queue_.size();
-    queue_became_non_full = (was_queue_full && queue_.size() < max_queue_size_);
+    queue_became_non_full =
+        was_queue_full && !IsFullQueue(queue_.size(), queue_bytes_);
+  }
+  if (removed_bytes != 0 && queue_bytes_callback_) {
+    queue_bytes_callback_(-removed_bytes);
   }
   if (queue_became_non_full) {
     VLOG(3) << "Queue became non-full: " << Name();
@@ -406,4 +576,215 @@ bool InputStreamManager::IsDone() const {
   return queue_.empty() && next_timestamp_bound_ == Timestamp::Done();
 }
 
+// In single-producer/single-consumer mode, the producer adds a packet to
+// spsc_queue_ before it raises spsc_next_timestamp_bound_, and the consumer
+// reads spsc_next_timestamp_bound_ before it checks spsc_queue_. So a consumer
+// that sees the bound for a packet also sees the packet. The sequentially
+// consistent atomics also ensure that a raised bound either finds the queue
+// empty and notifies the consumer, or is seen by the consumer after it empties
+// the queue, just like under stream_mutex_.
+
+template <typename Container>
+absl::Status InputStreamManager::AddOrMovePacketsLockFree(Container container,
+                                                          bool* notify) {
+  *notify = false;
+  if (spsc_closed_.load(std::memory_order_acquire)) {
+    return absl::OkStatus();
+  }
+  bool queue_became_non_empty = false;
+  bool queue_became_full = false;
+  int64_t added_bytes = 0;
+  for (auto& packet : container) {
+    MP_RETURN_IF_ERROR(ValidatePacket(
+        packet,
+        Timestamp::CreateNoErrorChecking(spsc_next_timestamp_bound_.load()),
+        spsc_num_packets_added_.load(std::memory_order_relaxed)));
+    const Timestamp next_timestamp_bound =
+        packet.Timestamp().NextAllowedInStream();
+    spsc_num_packets_added_.fetch_add(1, std::memory_order_relaxed);
+    VLOG(3) << "Input stream:" << name_
+            << " has added packet at time: " << packet.Timestamp();
+    // The bytes are added before the packet is pushed, so that they are never
+    // subtracted before they are added.
+    const int64_t byte_size = AccountedByteSize(packet);
+    if (byte_size != 0) {
+      const int64_t queue_bytes = AddQueueBytes(byte_size);
+      queue_became_full |= QueueBytesFull(queue_bytes) &&
+                           !QueueBytesFull(queue_bytes - byte_size);
+      added_bytes += byte_size;
+    }
+    int queue_size;
+    if (std::is_const<
+            typename std::remove_reference<Container>::type>::value) {
+      queue_size = spsc_queue_.Push(packet);
+    } else {
+      queue_size = spsc_queue_.Push(std::move(packet));
+    }
+    RaiseNextTimestampBound(next_timestamp_bound);
+    // The consumer may pop packets concurrently, so the queue can become
+    // non-empty or full more than once.
+    queue_became_non_empty |= (queue_size == 1);
+    queue_became_full |= (queue_size == max_queue_size_);
+  }
+  if (added_bytes != 0 && queue_bytes_callback_) {
+    queue_bytes_callback_(added_bytes);
+  }
+  if (queue_became_full) {
+    VLOG(3) << "Queue became full: " << Name();
+    becomes_full_callback_(this, &last_reported_stream_full_);
+  }
+  *notify = queue_became_non_empty;
+  return absl::OkStatus();
+}
+
+absl::Status InputStreamManager::SetNextTimestampBoundLockFree(
+    const Timestamp bound, bool* notify) {
+  *notify = false;
+  if (spsc_closed_.load(std::memory_order_acquire)) {
+    return absl::OkStatus();
+  }
+  const Timestamp next_timestamp_bound =
+      Timestamp::CreateNoErrorChecking(spsc_next_timestamp_bound_.load());
+  if (enable_timestamps_ && bound < next_timestamp_bound) {
+    return mediapipe::UnknownErrorBuilder(MEDIAPIPE_LOC)
+           << "SetNextTimestampBound must be called with a timestamp greater "
+              "than or equal to the current bound. In stream \""
+           << name_ << "\". Current minimum expected timestamp is "
+           << next_timestamp_bound.DebugString() << " but received "
+           << bound.DebugString();
+  }
+  if (RaiseNextTimestampBound(bound)) {
+    VLOG(3) << "Next timestamp bound for input " << name_ << " is " << bound;
+    // If the queue is not empty then a change to the bound is not detectable
+    // by the consumer.
+    *notify = (spsc_queue_.Size() == 0);
+  }
+  return absl::OkStatus();
+}
+
+Timestamp InputStreamManager::MinTimestampOrBoundLockFree(
+    bool* is_empty) const {
+  const Timestamp next_timestamp_bound =
+      Timestamp::CreateNoErrorChecking(spsc_next_timestamp_bound_.load());
+  const Timestamp front_timestamp = spsc_queue_.FrontTimestamp();
+  const bool queue_is_empty = (front_timestamp == Timestamp::Unset());
+  if (is_empty) {
+    *is_empty = queue_is_empty;
+  }
+  return queue_is_empty ? next_timestamp_bound : front_timestamp;
+}
+
+Packet InputStreamManager::PopPacketAtTimestampLockFree(
+    Timestamp timestamp, int* num_packets_dropped, bool* stream_is_done) {
+  ABSL_CHECK(enable_timestamps_);
+  *num_packets_dropped = -1;
+  *stream_is_done = false;
+  // Make sure timestamp didn't decrease from last time.
+  const Timestamp last_select_timestamp = Timestamp::CreateNoErrorChecking(
+      spsc_last_select_timestamp_.load(std::memory_order_relaxed));
+  ABSL_CHECK_LE(last_select_timestamp, timestamp);
+  spsc_last_select_timestamp_.store(timestamp.Value(),
+                                    std::memory_order_relaxed);
+
+  // Make sure AddPacket and SetNextTimestampBound are not called with
+  // timestamps we have already passed.
+  RaiseNextTimestampBound(timestamp.NextAllowedInStream());
+
+  VLOG(3) << "Input stream " << name_
+          << " selecting at timestamp:" << timestamp.Value();
+
+  // Advances time to timestamp.
+  Timestamp current_timestamp = Timestamp::Unset();
+  bool queue_became_non_full = false;
+  int64_t removed_bytes = 0;
+  Packet packet;
+  while (true) {
+    const Timestamp front_timestamp = spsc_queue_.FrontTimestamp();
+    if (front_timestamp == Timestamp::Unset() || front_timestamp > timestamp) {
+      break;
+    }
+    int queue_size;
+    packet = spsc_queue_.Pop(&queue_size);
+    queue_became_non_full |= (queue_size == max_queue_size_ - 1);
+    const int64_t byte_size = AccountedByteSize(packet);
+    if (byte_size != 0) {
+      const int64_t queue_bytes = AddQueueBytes(-byte_size);
+      queue_became_non_full |= QueueBytesFull(queue_bytes + byte_size) &&
+                               !QueueBytesFull(queue_bytes);
+      removed_bytes += byte_size;
+    }
+    current_timestamp = packet.Timestamp();
+    ++(*num_packets_dropped);
+  }
+  // Clear value_ if it doesn't have exactly the right timestamp.
+  if (current_timestamp != timestamp) {
+    // The timestamp bound reported when no packet is sent.
+    Timestamp bound = MinTimestampOrBoundLockFree(nullptr);
+    packet = Packet().At(bound.PreviousAllowedInStream());
+    ++(*num_packets_dropped);
+  }
+
+  VLOG(3) << "Input stream removed packets:" << name_
+          << " Size:" << spsc_queue_.Size();
+  *stream_is_done = IsDoneLockFree();
+  if (removed_bytes != 0 && queue_bytes_callback_) {
+    queue_bytes_callback_(-removed_bytes);
+  }
+  if (queue_became_non_full) {
+    VLOG(3) << "Queue became non-full: " << Name();
+    becomes_not_full_callback_(this, &last_reported_stream_full_);
+  }
+  return packet;
+}
+
+Packet InputStreamManager::PopQueueHeadLockFree(bool* stream_is_done) {
+  ABSL_CHECK(!enable_timestamps_);
+  *stream_is_done = false;
+  bool queue_became_non_full = false;
+  Packet packet;
+
+  VLOG(3) << "Input stream " << name_ << " selecting at queue head";
+
+  int64_t removed_bytes = 0;
+  if (spsc_queue_.Size() != 0) {
+    int queue_size;
+    packet = spsc_queue_.Pop(&queue_size);
+    queue_became_non_full = (queue_size == max_queue_size_ - 1);
+    removed_bytes = AccountedByteSize(packet);
+    if (removed_bytes != 0) {
+      const int64_t queue_bytes = AddQueueBytes(-removed_bytes);
+      queue_became_non_full |= QueueBytesFull(queue_bytes + removed_bytes) &&
+                               !QueueBytesFull(queue_bytes);
+    }
+  }
+
+  VLOG(3) << "Input stream removed a packet:" << name_
+          << " Size:" << spsc_queue_.Size();
+  *stream_is_done = IsDoneLockFree();
+  if (removed_bytes != 0 && queue_bytes_callback_) {
+    queue_bytes_callback_(-removed_bytes);
+  }
+  if (queue_became_non_full) {
+    VLOG(3) << "Queue became non-full: " << Name();
+    becomes_not_full_callback_(this, &last_reported_stream_full_);
+  }
+  return packet;
+}
+
+bool InputStreamManager::IsDoneLockFree() const {
+  return spsc_next_timestamp_bound_.load() == Timestamp::Done().Value() &&
+         spsc_queue_.Size() == 0;
+}
+
+bool InputStreamManager::RaiseNextTimestampBound(Timestamp bound) {
+  int64_t current = spsc_next_timestamp_bound_.load();
+  while (current < bound.Value()) {
+    if (spsc_next_timestamp_bound_.compare_exchange_weak(current,
+                                                         bound.Value())) {
+      return true;
+    }
+  }
+  return false;
+}
+
 }  // namespace mediapipe
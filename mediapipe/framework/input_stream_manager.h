@@ -15,6 +15,7 @@
 #ifndef MEDIAPIPE_FRAMEWORK_INPUT_STREAM_MANAGER_H_
 #define MEDIAPIPE_FRAMEWORK_INPUT_STREAM_MANAGER_H_
 
+#include <atomic>
 #include <cstdint>
 #include <deque>
 #include <functional>
@@ -27,6 +28,7 @@
 #include "mediapipe/framework/packet_type.h"
 #include "mediapipe/framework/port.h"
 #include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/spsc_packet_queue.h"
 #include "mediapipe/framework/timestamp.h"
 
 namespace mediapipe {
@@ -43,6 +45,11 @@ namespace mediapipe {
 // An input stream is written to by exactly one output stream and is read by a
 // single node. None of its methods should hold a lock when they invoke a
 // callback in the scheduler.
+//
+// By default, all accesses to the packet queue are serialized by a mutex. If
+// the packets are only ever added by one thread at a time and only ever read
+// by one thread at a time, EnableSingleProducerSingleConsumer() switches the
+// stream to a lock-free queue.
 class InputStreamManager {
  public:
   // Function type for becomes_full_callback and becomes_not_full_callback.
@@ -51,6 +58,10 @@ class InputStreamManager {
   // maintained by the callback.
   typedef std::function<void(InputStreamManager*, bool*)> QueueSizeCallback;
 
+  // Function type for queue_bytes_callback. The argument is the change in the
+  // payload bytes held by the queue.
+  typedef std::function<void(int64_t)> QueueBytesCallback;
+
   InputStreamManager(const InputStreamManager&) = delete;
   InputStreamManager& operator=(const InputStreamManager&) = delete;
 
@@ -66,6 +77,28 @@ class InputStreamManager {
   // Returns true if the input stream is a back edge.
   bool BackEdge() const { return back_edge_; }
 
+  // Makes the stream use a lock-free queue, which requires that:
+  // * AddPackets() and MovePackets() are not called concurrently with each
+  //   other (a single producer), and
+  // * IsEmpty(), QueueHead(), PopPacketAtTimestamp() and PopQueueHead() are
+  //   not called concurrently with each other (a single consumer).
+  // The producer and the consumer may run concurrently. SetNextTimestampBound()
+  // and Close() may be called on any thread. MinTimestampOrBound(),
+  // QueueSize(), NumPacketsAdded() and IsFull() may also be called on any
+  // thread, but return a snapshot that may already be out of date unless they
+  // are called by the consumer. GetMinTimestampAmongNLatest() and
+  // ErasePacketsEarlierThan() are not supported.
+  //
+  // Resets the stream like PrepareForRun(). CalculatorNode calls it at graph
+  // initialization for the input streams that are guaranteed to meet these
+  // requirements.
+  void EnableSingleProducerSingleConsumer();
+
+  // Returns true if EnableSingleProducerSingleConsumer() has been called.
+  bool SingleProducerSingleConsumer() const {
+    return single_producer_single_consumer_;
+  }
+
   // Sets the header Packet.
   absl::Status SetHeader(const Packet& header);
 
@@ -159,6 +192,28 @@ class InputStreamManager {
   // of -1 means that there is no maximum queue size.
   void SetMaxQueueSize(int max_queue_size) ABSL_LOCKS_EXCLUDED(stream_mutex_);
 
+  // Makes the stream account for the payload bytes of its queued packets, as
+  // reported by Packet::PayloadByteSize(). "queue_bytes_callback", if not
+  // null, is invoked with every change in the queued bytes, with no mutexes
+  // held. Must not be called while packets are added or removed.
+  void EnableQueueByteAccounting(QueueBytesCallback queue_bytes_callback);
+
+  // Returns the payload bytes of the queued packets, or 0 if byte accounting
+  // isn't enabled.
+  int64_t QueueByteSize() const { return queue_bytes_; }
+
+  // Returns the largest QueueByteSize() since the last PrepareForRun().
+  int64_t PeakQueueByteSize() const { return peak_queue_bytes_; }
+
+  // Returns the max queue bytes. -1 indicates that there is no maximum.
+  int64_t MaxQueueByteSize() const { return max_queue_bytes_; }
+
+  // Sets the maximum payload bytes of the queue, which requires byte
+  // accounting. Like SetMaxQueueSize(), the queue is full while it holds at
+  // least this many bytes. A value of -1 means that there is no maximum.
+  void SetMaxQueueByteSize(int64_t max_queue_bytes)
+      ABSL_LOCKS_EXCLUDED(stream_mutex_);
+
   // If there are equal to or more than n packets in the queue, this function
   // returns the min timestamp of among the latest n packets of the queue.  If
   // there are fewer than n packets in the queue, this function returns
@@ -189,12 +244,51 @@ class InputStreamManager {
   absl::Status AddOrMovePacketsInternal(Container container, bool* notify)
       ABSL_LOCKS_EXCLUDED(stream_mutex_);
 
+  // Returns an error if "packet" can't be added to the stream, given the
+  // current next timestamp bound and the number of packets added so far.
+  absl::Status ValidatePacket(const Packet& packet,
+                              Timestamp next_timestamp_bound,
+                              int64_t num_packets_added) const;
+
   // Returns true if the next timestamp bound reaches Timestamp::Done().
   bool IsDone() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(stream_mutex_);
 
+  // Returns true if a queue of "queue_size" packets holding "queue_bytes"
+  // payload bytes is full.
+  bool IsFullQueue(int64_t queue_size, int64_t queue_bytes) const;
+
+  // Returns true if "queue_bytes" reaches the max queue bytes.
+  bool QueueBytesFull(int64_t queue_bytes) const;
+
+  // Returns the payload bytes of "packet" if byte accounting is enabled, or 0
+  // otherwise.
+  int64_t AccountedByteSize(const Packet& packet) const {
+    return account_queue_bytes_ ? packet.PayloadByteSize() : 0;
+  }
+
+  // Adds "delta" to the queued bytes and returns the new value.
+  int64_t AddQueueBytes(int64_t delta);
+
   // Returns the smallest timestamp at which this stream might see an input.
   Timestamp MinTimestampOrBoundHelper() const;
 
+  // The implementations of the public functions for single-producer/
+  // single-consumer mode, which use spsc_queue_ and the spsc_ fields below
+  // instead of stream_mutex_.
+  template <typename Container>
+  absl::Status AddOrMovePacketsLockFree(Container container, bool* notify);
+  absl::Status SetNextTimestampBoundLockFree(Timestamp bound, bool* notify);
+  Timestamp MinTimestampOrBoundLockFree(bool* is_empty) const;
+  Packet PopPacketAtTimestampLockFree(Timestamp timestamp,
+                                      int* num_packets_dropped,
+                                      bool* stream_is_done);
+  Packet PopQueueHeadLockFree(bool* stream_is_done);
+  bool IsDoneLockFree() const;
+
+  // Raises spsc_next_timestamp_bound_ to "bound". Returns true if the bound
+  // was lower than "bound".
+  bool RaiseNextTimestampBound(Timestamp bound);
+
   mutable absl::Mutex stream_mutex_;
   std::deque<Packet> queue_ ABSL_GUARDED_BY(stream_mutex_);
   // The number of packets added to queue_.  Used to verify a packet at
@@ -213,8 +307,29 @@ class InputStreamManager {
   // The header packet of the input stream.
   Packet header_;
 
-  // The maximum queue size for this stream if set.
-  int max_queue_size_ ABSL_GUARDED_BY(stream_mutex_) = -1;
+  // The maximum queue size for this stream if set. Only modified while
+  // holding stream_mutex_, but read without it in single-producer/
+  // single-consumer mode.
+  std::atomic<int> max_queue_size_ = -1;
+
+  // The byte accounting state, see EnableQueueByteAccounting(). Like
+  // max_queue_size_, the queued bytes are only modified while holding
+  // stream_mutex_, except in single-producer/single-consumer mode, where they
+  // are added before a packet is pushed and subtracted after it is popped.
+  bool account_queue_bytes_ = false;
+  QueueBytesCallback queue_bytes_callback_;
+  std::atomic<int64_t> max_queue_bytes_ = -1;
+  std::atomic<int64_t> queue_bytes_ = 0;
+  std::atomic<int64_t> peak_queue_bytes_ = 0;
+
+  // The state of the stream in single-producer/single-consumer mode. The
+  // timestamps are stored as Timestamp::Value().
+  bool single_producer_single_consumer_ = false;
+  mutable SpscPacketQueue spsc_queue_;
+  std::atomic<int64_t> spsc_num_packets_added_{0};
+  std::atomic<int64_t> spsc_next_timestamp_bound_{0};
+  std::atomic<int64_t> spsc_last_select_timestamp_{0};
+  std::atomic<bool> spsc_closed_{false};
 
   // Callback to notify the framework that we have hit the maximum queue size.
   QueueSizeCallback becomes_full_callback_;
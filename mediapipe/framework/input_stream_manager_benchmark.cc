@@ -0,0 +1,115 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Benchmark for the InputStreamManager packet queues.
+//
+// BM_StreamProducerConsumer passes packets from a producer thread to a
+// consumer thread through a single stream, with and without the lock-free
+// single-producer/single-consumer queue. BM_LinearChain runs a linear chain of
+// PassThroughCalculators, all of whose streams use the lock-free queue.
+//
+// $ bazel run -c opt mediapipe/framework:input_stream_manager_benchmark
+#include <list>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+
+#include "absl/log/absl_check.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/input_stream_manager.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/packet_type.h"
+#include "mediapipe/framework/thread_pool_executor.pb.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr int kNumPackets = 10000;
+
+// Arg: 1 for single-producer/single-consumer mode, 0 for the mutex.
+void BM_StreamProducerConsumer(benchmark::State& state) {
+  PacketType packet_type;
+  packet_type.Set<int>();
+  InputStreamManager stream;
+  ABSL_CHECK_OK(stream.Initialize("stream", &packet_type, /*back_edge=*/false));
+  if (state.range(0)) {
+    stream.EnableSingleProducerSingleConsumer();
+  }
+  stream.SetQueueSizeCallbacks([](InputStreamManager*, bool*) {},
+                               [](InputStreamManager*, bool*) {});
+  for (auto _ : state) {
+    stream.PrepareForRun();
+    std::thread producer([&stream] {
+      for (int t = 0; t < kNumPackets; ++t) {
+        std::list<Packet> packets = {MakePacket<int>(t).At(Timestamp(t))};
+        bool notify;
+        ABSL_CHECK_OK(stream.MovePackets(&packets, &notify));
+      }
+      bool notify;
+      ABSL_CHECK_OK(stream.SetNextTimestampBound(Timestamp::Done(), &notify));
+    });
+    while (true) {
+      bool empty;
+      const Timestamp timestamp = stream.MinTimestampOrBound(&empty);
+      if (empty) {
+        if (timestamp == Timestamp::Done()) break;
+        continue;
+      }
+      int num_packets_dropped;
+      bool stream_is_done;
+      benchmark::DoNotOptimize(stream.PopPacketAtTimestamp(
+          timestamp, &num_packets_dropped, &stream_is_done));
+    }
+    producer.join();
+  }
+  state.SetItemsProcessed(state.iterations() * kNumPackets);
+}
+BENCHMARK(BM_StreamProducerConsumer)->Arg(0)->Arg(1)->UseRealTime();
+
+// Args: number of nodes, number of threads.
+void BM_LinearChain(benchmark::State& state) {
+  const int num_nodes = state.range(0);
+  CalculatorGraphConfig config;
+  config.add_input_stream("s0");
+  for (int i = 0; i < num_nodes; ++i) {
+    auto* node = config.add_node();
+    node->set_calculator("PassThroughCalculator");
+    node->add_input_stream(absl::StrCat("s", i));
+    node->add_output_stream(absl::StrCat("s", i + 1));
+  }
+  config.add_executor()
+      ->mutable_options()
+      ->MutableExtension(ThreadPoolExecutorOptions::ext)
+      ->set_num_threads(state.range(1));
+
+  for (auto _ : state) {
+    CalculatorGraph graph;
+    ABSL_CHECK_OK(graph.Initialize(config));
+    ABSL_CHECK_OK(graph.StartRun({}));
+    for (int t = 0; t < kNumPackets; ++t) {
+      ABSL_CHECK_OK(graph.AddPacketToInputStream(
+          "s0", MakePacket<int>(t).At(Timestamp(t))));
+    }
+    ABSL_CHECK_OK(graph.CloseAllInputStreams());
+    ABSL_CHECK_OK(graph.WaitUntilDone());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumPackets * num_nodes);
+}
+BENCHMARK(BM_LinearChain)->Args({50, 1})->Args({50, 4})->UseRealTime();
+
+}  // namespace
+}  // namespace mediapipe
+
+BENCHMARK_MAIN();
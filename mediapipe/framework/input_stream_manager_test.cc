@@ -14,7 +14,13 @@
 
 #include "mediapipe/framework/input_stream_manager.h"
 
+#include <atomic>
+#include <cstdint>
+#include <list>
 #include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
 
 #include "absl/memory/memory.h"
 #include "mediapipe/framework/input_stream_shard.h"
@@ -26,7 +32,8 @@
 
 namespace mediapipe {
 namespace {
-class InputStreamManagerTest : public ::testing::Test {
+// The parameter selects single-producer/single-consumer mode.
+class InputStreamManagerTest : public ::testing::TestWithParam<bool> {
  protected:
   InputStreamManagerTest() {}
 
@@ -44,6 +51,9 @@ class InputStreamManagerTest : public ::testing::Test {
     input_stream_manager_ = absl::make_unique<InputStreamManager>();
     MP_ASSERT_OK(input_stream_manager_->Initialize("a_test", &packet_type_,
                                                    /*back_edge=*/false));
+    if (GetParam()) {
+      input_stream_manager_->EnableSingleProducerSingleConsumer();
+    }
 
     queue_full_callback_ =
         std::bind(&InputStreamManagerTest::ReportQueueBecomesFull, this,
@@ -89,9 +99,9 @@ class InputStreamManagerTest : public ::testing::Test {
   int queue_becomes_not_full_count_;
 };
 
-TEST_F(InputStreamManagerTest, Init) {}
+TEST_P(InputStreamManagerTest, Init) {}
 
-TEST_F(InputStreamManagerTest, AddPackets) {
+TEST_P(InputStreamManagerTest, AddPackets) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
@@ -108,7 +118,7 @@ TEST_F(InputStreamManagerTest, AddPackets) {
   }
 }
 
-TEST_F(InputStreamManagerTest, MovePackets) {
+TEST_P(InputStreamManagerTest, MovePackets) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
@@ -128,7 +138,7 @@ TEST_F(InputStreamManagerTest, MovePackets) {
 // InputStreamManager should reject the four timestamps that are not allowed in
 // a stream: Timestamp::Unset(), Timestamp::Unstarted(),
 // Timestamp::OneOverPostStream(), and Timestamp::Done().
-TEST_F(InputStreamManagerTest, AddPacketUnset) {
+TEST_P(InputStreamManagerTest, AddPacketUnset) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp::Unset()));
   EXPECT_TRUE(input_stream_manager_->IsEmpty());
@@ -139,7 +149,7 @@ TEST_F(InputStreamManagerTest, AddPacketUnset) {
   EXPECT_FALSE(notify_);
 }
 
-TEST_F(InputStreamManagerTest, AddPacketUnstarted) {
+TEST_P(InputStreamManagerTest, AddPacketUnstarted) {
   std::list<Packet> packets;
   packets.push_back(
       MakePacket<std::string>("packet 1").At(Timestamp::Unstarted()));
@@ -151,7 +161,7 @@ TEST_F(InputStreamManagerTest, AddPacketUnstarted) {
   EXPECT_FALSE(notify_);
 }
 
-TEST_F(InputStreamManagerTest, AddPacketOneOverPostStream) {
+TEST_P(InputStreamManagerTest, AddPacketOneOverPostStream) {
   std::list<Packet> packets;
   packets.push_back(
       MakePacket<std::string>("packet 1").At(Timestamp::OneOverPostStream()));
@@ -164,7 +174,7 @@ TEST_F(InputStreamManagerTest, AddPacketOneOverPostStream) {
   EXPECT_FALSE(notify_);
 }
 
-TEST_F(InputStreamManagerTest, AddPacketDone) {
+TEST_P(InputStreamManagerTest, AddPacketDone) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp::Done()));
   EXPECT_TRUE(input_stream_manager_->IsEmpty());
@@ -175,7 +185,7 @@ TEST_F(InputStreamManagerTest, AddPacketDone) {
   EXPECT_FALSE(notify_);
 }
 
-TEST_F(InputStreamManagerTest, AddPacketsOnlyPreStream) {
+TEST_P(InputStreamManagerTest, AddPacketsOnlyPreStream) {
   std::list<Packet> packets;
   packets.push_back(
       MakePacket<std::string>("packet 1").At(Timestamp::PreStream()));
@@ -189,7 +199,7 @@ TEST_F(InputStreamManagerTest, AddPacketsOnlyPreStream) {
 
 // An attempt to add a packet after Timestamp::PreStream() should be rejected
 // because the next timestamp bound is Timestamp::OneOverPostStream().
-TEST_F(InputStreamManagerTest, AddPacketsAfterPreStream) {
+TEST_P(InputStreamManagerTest, AddPacketsAfterPreStream) {
   std::list<Packet> packets;
   packets.push_back(
       MakePacket<std::string>("packet 1").At(Timestamp::PreStream()));
@@ -203,7 +213,7 @@ TEST_F(InputStreamManagerTest, AddPacketsAfterPreStream) {
   EXPECT_FALSE(notify_);
 }
 
-TEST_F(InputStreamManagerTest, AddPacketsOnlyPostStream) {
+TEST_P(InputStreamManagerTest, AddPacketsOnlyPostStream) {
   std::list<Packet> packets;
   packets.push_back(
       MakePacket<std::string>("packet 1").At(Timestamp::PostStream()));
@@ -217,7 +227,7 @@ TEST_F(InputStreamManagerTest, AddPacketsOnlyPostStream) {
 
 // A packet at Timestamp::PostStream() must be the only Packet in an input
 // stream.
-TEST_F(InputStreamManagerTest, AddPacketsBeforePostStream) {
+TEST_P(InputStreamManagerTest, AddPacketsBeforePostStream) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(
@@ -230,7 +240,7 @@ TEST_F(InputStreamManagerTest, AddPacketsBeforePostStream) {
   EXPECT_FALSE(notify_);
 }
 
-TEST_F(InputStreamManagerTest, AddPacketsReverseTimestamps) {
+TEST_P(InputStreamManagerTest, AddPacketsReverseTimestamps) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(20)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(10)));
@@ -245,7 +255,7 @@ TEST_F(InputStreamManagerTest, AddPacketsReverseTimestamps) {
   EXPECT_FALSE(notify_);
 }
 
-TEST_F(InputStreamManagerTest, PopPacketAtTimestamp) {
+TEST_P(InputStreamManagerTest, PopPacketAtTimestamp) {
   std::string expected_value_at_10("packet 1");
   std::string expected_value_at_20("packet 2");
   std::string expected_value_at_30("packet 3");
@@ -329,7 +339,7 @@ TEST_F(InputStreamManagerTest, PopPacketAtTimestamp) {
   EXPECT_TRUE(stream_is_done_);
 }
 
-TEST_F(InputStreamManagerTest, PopQueueHead) {
+TEST_P(InputStreamManagerTest, PopQueueHead) {
   input_stream_manager_->DisableTimestamps();
   std::string expected_value_at_10("packet 1");
   std::string expected_value_at_20("packet 2");
@@ -393,7 +403,7 @@ TEST_F(InputStreamManagerTest, PopQueueHead) {
   EXPECT_TRUE(stream_is_done_);
 }
 
-TEST_F(InputStreamManagerTest, BadPacketType) {
+TEST_P(InputStreamManagerTest, BadPacketType) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<int>(10).At(Timestamp(10)));
   EXPECT_TRUE(input_stream_manager_->IsEmpty());
@@ -404,7 +414,7 @@ TEST_F(InputStreamManagerTest, BadPacketType) {
   EXPECT_FALSE(notify_);
 }
 
-TEST_F(InputStreamManagerTest, Close) {
+TEST_P(InputStreamManagerTest, Close) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
@@ -427,7 +437,7 @@ TEST_F(InputStreamManagerTest, Close) {
   EXPECT_TRUE(input_stream_manager_->IsEmpty());
 }
 
-TEST_F(InputStreamManagerTest, ReuseInputStreamManager) {
+TEST_P(InputStreamManagerTest, ReuseInputStreamManager) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
@@ -480,7 +490,7 @@ TEST_F(InputStreamManagerTest, ReuseInputStreamManager) {
   EXPECT_TRUE(input_stream_manager_->IsEmpty());
 }
 
-TEST_F(InputStreamManagerTest, MultipleNotifications) {
+TEST_P(InputStreamManagerTest, MultipleNotifications) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
@@ -516,7 +526,7 @@ TEST_F(InputStreamManagerTest, MultipleNotifications) {
   EXPECT_TRUE(notify_);
 }
 
-TEST_F(InputStreamManagerTest, SetHeader) {
+TEST_P(InputStreamManagerTest, SetHeader) {
   Packet header = MakePacket<std::string>("blah");
   MP_ASSERT_OK(input_stream_manager_->SetHeader(header));
 
@@ -525,7 +535,7 @@ TEST_F(InputStreamManagerTest, SetHeader) {
   EXPECT_EQ(header.Timestamp(), input_stream_manager_->Header().Timestamp());
 }
 
-TEST_F(InputStreamManagerTest, BackwardsInTime) {
+TEST_P(InputStreamManagerTest, BackwardsInTime) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
@@ -592,7 +602,7 @@ TEST_F(InputStreamManagerTest, BackwardsInTime) {
   EXPECT_FALSE(notify_);
 }
 
-TEST_F(InputStreamManagerTest, SelectBackwardsInTime) {
+TEST_P(InputStreamManagerTest, SelectBackwardsInTime) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
@@ -636,7 +646,7 @@ TEST_F(InputStreamManagerTest, SelectBackwardsInTime) {
                "");
 }
 
-TEST_F(InputStreamManagerTest, TimestampBound) {
+TEST_P(InputStreamManagerTest, TimestampBound) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
@@ -746,7 +756,7 @@ TEST_F(InputStreamManagerTest, TimestampBound) {
             input_stream_manager_->MinTimestampOrBound(&is_empty));
 }
 
-TEST_F(InputStreamManagerTest, QueueSizeTest) {
+TEST_P(InputStreamManagerTest, QueueSizeTest) {
   std::list<Packet> packets;
   int max_queue_size = 2;
   input_stream_manager_->SetMaxQueueSize(max_queue_size);
@@ -783,11 +793,14 @@ TEST_F(InputStreamManagerTest, QueueSizeTest) {
   expected_queue_becomes_not_full_count_ = 1;
 }
 
-TEST_F(InputStreamManagerTest, InputReleaseTest) {
+TEST_P(InputStreamManagerTest, InputReleaseTest) {
   packet_type_.Set<LifetimeTracker::Object>();
   input_stream_manager_ = absl::make_unique<InputStreamManager>();
   MP_ASSERT_OK(input_stream_manager_->Initialize("a_test", &packet_type_,
                                                  /*back_edge=*/false));
+  if (GetParam()) {
+    input_stream_manager_->EnableSingleProducerSingleConsumer();
+  }
   input_stream_manager_->PrepareForRun();
   input_stream_manager_->SetQueueSizeCallbacks(queue_full_callback_,
                                                queue_not_full_callback_);
@@ -831,9 +844,58 @@ TEST_F(InputStreamManagerTest, InputReleaseTest) {
   expected_queue_becomes_not_full_count_ = 1;
 }
 
+TEST_P(InputStreamManagerTest, QueueByteSizeTest) {
+  packet_type_.Set<std::vector<uint8_t>>();
+  input_stream_manager_ = absl::make_unique<InputStreamManager>();
+  MP_ASSERT_OK(input_stream_manager_->Initialize("a_test", &packet_type_,
+                                                 /*back_edge=*/false));
+  if (GetParam()) {
+    input_stream_manager_->EnableSingleProducerSingleConsumer();
+  }
+  std::vector<int64_t> byte_changes;
+  input_stream_manager_->EnableQueueByteAccounting(
+      [&byte_changes](int64_t delta) { byte_changes.push_back(delta); });
+  input_stream_manager_->PrepareForRun();
+  input_stream_manager_->SetQueueSizeCallbacks(queue_full_callback_,
+                                               queue_not_full_callback_);
+
+  Timestamp timestamp = Timestamp(0);
+  auto new_packet = [&timestamp] {
+    return MakePacket<std::vector<uint8_t>>(1000).At(++timestamp);
+  };
+  const int64_t packet_bytes = new_packet().PayloadByteSize();
+  EXPECT_EQ(sizeof(std::vector<uint8_t>) + 1000, packet_bytes);
+  timestamp = Timestamp(0);
+
+  // The queue is full once it holds 2.5 packets' worth of bytes, although it
+  // has no maximum number of packets.
+  input_stream_manager_->SetMaxQueueByteSize(packet_bytes * 5 / 2);
+  MP_ASSERT_OK(input_stream_manager_->AddPackets({new_packet()}, &notify_));
+  MP_ASSERT_OK(input_stream_manager_->AddPackets({new_packet()}, &notify_));
+  EXPECT_EQ(2 * packet_bytes, input_stream_manager_->QueueByteSize());
+  MP_ASSERT_OK(input_stream_manager_->AddPackets({new_packet()}, &notify_));
+  EXPECT_EQ(3 * packet_bytes, input_stream_manager_->QueueByteSize());
+
+  popped_packet_ = input_stream_manager_->PopPacketAtTimestamp(
+      Timestamp(1), &num_packets_dropped_, &stream_is_done_);
+  EXPECT_FALSE(popped_packet_.IsEmpty());
+  EXPECT_EQ(2 * packet_bytes, input_stream_manager_->QueueByteSize());
+  popped_packet_ = input_stream_manager_->PopPacketAtTimestamp(
+      Timestamp(3), &num_packets_dropped_, &stream_is_done_);
+  EXPECT_EQ(1, num_packets_dropped_);
+  EXPECT_EQ(0, input_stream_manager_->QueueByteSize());
+  EXPECT_EQ(3 * packet_bytes, input_stream_manager_->PeakQueueByteSize());
+  EXPECT_THAT(byte_changes,
+              testing::ElementsAre(packet_bytes, packet_bytes, packet_bytes,
+                                   -packet_bytes, -2 * packet_bytes));
+
+  expected_queue_becomes_full_count_ = 1;
+  expected_queue_becomes_not_full_count_ = 1;
+}
+
 // An attempt to add a packet after Timestamp::PreStream() should be allowed
 // if packet timestamps don't need to be increasing.
-TEST_F(InputStreamManagerTest, AddPacketsAfterPreStreamUntimed) {
+TEST_P(InputStreamManagerTest, AddPacketsAfterPreStreamUntimed) {
   input_stream_manager_->DisableTimestamps();
   std::list<Packet> packets;
   packets.push_back(
@@ -849,7 +911,7 @@ TEST_F(InputStreamManagerTest, AddPacketsAfterPreStreamUntimed) {
 
 // A packet at Timestamp::PostStream() doesn't need to be the only Packet in
 // an input stream if packet timestamps don't need to be increasing.
-TEST_F(InputStreamManagerTest, AddPacketsBeforePostStreamUntimed) {
+TEST_P(InputStreamManagerTest, AddPacketsBeforePostStreamUntimed) {
   input_stream_manager_->DisableTimestamps();
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
@@ -863,7 +925,7 @@ TEST_F(InputStreamManagerTest, AddPacketsBeforePostStreamUntimed) {
   EXPECT_TRUE(notify_);
 }
 
-TEST_F(InputStreamManagerTest, BackwardsInTimeUntimed) {
+TEST_P(InputStreamManagerTest, BackwardsInTimeUntimed) {
   input_stream_manager_->DisableTimestamps();
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
@@ -924,5 +986,58 @@ TEST_F(InputStreamManagerTest, BackwardsInTimeUntimed) {
   EXPECT_TRUE(notify_);
 }
 
+// The producer and the consumer run on separate threads, while a third thread
+// monitors the stream.
+TEST_P(InputStreamManagerTest, ConcurrentProducerAndConsumer) {
+  constexpr int kNumPackets = 10000;
+  std::atomic<bool> done{false};
+  std::thread producer([this] {
+    for (int i = 0; i < kNumPackets; ++i) {
+      std::list<Packet> packets;
+      packets.push_back(MakePacket<std::string>(std::to_string(i))
+                            .At(Timestamp(i)));
+      bool notify;
+      MP_ASSERT_OK(input_stream_manager_->MovePackets(&packets, &notify));
+    }
+    bool notify;
+    MP_ASSERT_OK(input_stream_manager_->SetNextTimestampBound(
+        Timestamp::Done(), &notify));
+  });
+  std::thread monitor([this, &done] {
+    while (!done) {
+      ASSERT_GE(input_stream_manager_->QueueSize(), 0);
+      input_stream_manager_->MinTimestampOrBound(nullptr);
+    }
+  });
+
+  int num_packets = 0;
+  while (true) {
+    bool empty;
+    Timestamp timestamp = input_stream_manager_->MinTimestampOrBound(&empty);
+    if (empty) {
+      if (timestamp == Timestamp::Done()) {
+        break;
+      }
+      std::this_thread::yield();
+      continue;
+    }
+    ASSERT_EQ(timestamp, Timestamp(num_packets));
+    popped_packet_ = input_stream_manager_->PopPacketAtTimestamp(
+        timestamp, &num_packets_dropped_, &stream_is_done_);
+    ASSERT_EQ(0, num_packets_dropped_);
+    ASSERT_EQ(std::to_string(num_packets), popped_packet_.Get<std::string>());
+    ++num_packets;
+  }
+  done = true;
+  producer.join();
+  monitor.join();
+  EXPECT_EQ(kNumPackets, num_packets);
+  EXPECT_EQ(kNumPackets, input_stream_manager_->NumPacketsAdded());
+  EXPECT_TRUE(input_stream_manager_->IsEmpty());
+}
+
+INSTANTIATE_TEST_SUITE_P(LockingModes, InputStreamManagerTest,
+                         ::testing::Values(false, true));
+
 }  // namespace
 }  // namespace mediapipe
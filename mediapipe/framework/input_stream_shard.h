@@ -81,6 +81,8 @@ class InputStreamShard : public InputStream {
 
   // Accesses InputStreamShard for setting data.
   friend class InputStreamHandler;
+  // Accesses InputStreamShard for running fused calculators.
+  friend class FusedCalculator;
 };
 
 }  // namespace mediapipe
@@ -15,7 +15,10 @@
 #define MEDIAPIPE_FRAMEWORK_MEMORY_MANAGER_H_
 
 #include <memory>
+#include <utility>
 
+#include "absl/status/statusor.h"
+#include "mediapipe/framework/formats/cpu_buffer_pool.h"
 // Defines MEDIAPIPE_TENSOR_USE_AHWB
 #include "mediapipe/framework/port.h"
 
@@ -32,7 +35,7 @@ namespace mediapipe {
 //
 // Example usage:
 // 1) Instantiate the MemoryManager and pass it to the kMemoryManagerService
-//    before graph initialization:
+//    before graph initialization, or let the graph create a default one:
 //    CalculatorGraph graph;
 //    graph.SetServiceObject(kMemoryManagerService,
 //                           std::make_shared<MemoryManager>());
@@ -54,12 +57,30 @@ namespace mediapipe {
 //                     Tensor::Shape{kTensorSize}, &memory_manager_);
 class MemoryManager {
  public:
-  MemoryManager() {
+  MemoryManager() : cpu_buffer_pool_(std::make_shared<CpuBufferPool>()) {
 #ifdef MEDIAPIPE_TENSOR_USE_AHWB
     hardware_buffer_pool_ = std::make_shared<HardwareBufferPool>();
 #endif
   }
 
+  explicit MemoryManager(std::shared_ptr<CpuBufferPool> cpu_buffer_pool)
+      : MemoryManager(std::move(cpu_buffer_pool),
+                      /*pool_hardware_buffers=*/true) {}
+
+  // Creates the MemoryManager of graphs that request the kMemoryManagerService
+  // without setting it. It only pools CPU buffers: AHardwareBuffer pooling
+  // stays opt-in, through a MemoryManager constructed by the application.
+  static absl::StatusOr<std::shared_ptr<MemoryManager>> Create() {
+    return std::shared_ptr<MemoryManager>(
+        new MemoryManager(std::make_shared<CpuBufferPool>(),
+                          /*pool_hardware_buffers=*/false));
+  }
+
+  // Pools the CPU buffers of Tensors. May be null, which disables pooling.
+  std::shared_ptr<CpuBufferPool> GetCpuBufferPool() const {
+    return cpu_buffer_pool_;
+  }
+
 #ifdef MEDIAPIPE_TENSOR_USE_AHWB
   std::shared_ptr<HardwareBufferPool> GetAndroidHardwareBufferPool() const {
     return hardware_buffer_pool_;
@@ -69,10 +90,22 @@ class MemoryManager {
 #ifdef MEDIAPIPE_TENSOR_USE_AHWB
   // For testing only:
   explicit MemoryManager(const MultiPoolOptions& options)
-      : hardware_buffer_pool_(std::make_shared<HardwareBufferPool>(options)) {}
+      : cpu_buffer_pool_(std::make_shared<CpuBufferPool>()),
+        hardware_buffer_pool_(std::make_shared<HardwareBufferPool>(options)) {}
 #endif
 
  private:
+  MemoryManager(std::shared_ptr<CpuBufferPool> cpu_buffer_pool,
+                bool pool_hardware_buffers)
+      : cpu_buffer_pool_(std::move(cpu_buffer_pool)) {
+#ifdef MEDIAPIPE_TENSOR_USE_AHWB
+    if (pool_hardware_buffers) {
+      hardware_buffer_pool_ = std::make_shared<HardwareBufferPool>();
+    }
+#endif
+  }
+
+  std::shared_ptr<CpuBufferPool> cpu_buffer_pool_;
 #ifdef MEDIAPIPE_TENSOR_USE_AHWB
   std::shared_ptr<HardwareBufferPool> hardware_buffer_pool_;
 #endif
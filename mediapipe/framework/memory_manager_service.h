@@ -19,9 +19,11 @@
 
 namespace mediapipe {
 
-// Graph service to request pooled buffer objects.
+// Graph service to request pooled buffer objects. If no MemoryManager is set,
+// the graph creates one with MemoryManager::Create() for the calculators that
+// request this service, which only pools CPU buffers.
 inline constexpr GraphService<MemoryManager> kMemoryManagerService(
-    "MemoryManagerService", GraphServiceBase::kDisallowDefaultInitialization);
+    "MemoryManagerService", GraphServiceBase::kAllowDefaultInitialization);
 
 }  // namespace mediapipe
 
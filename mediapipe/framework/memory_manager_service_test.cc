@@ -0,0 +1,49 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/memory_manager_service.h"
+
+#include <memory>
+
+#include "absl/status/statusor.h"
+#include "mediapipe/framework/memory_manager.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+TEST(MemoryManagerServiceTest, DefaultObjectOnlyPoolsCpuBuffers) {
+  MP_ASSERT_OK_AND_ASSIGN(Packet packet,
+                          kMemoryManagerService.CreateDefaultObject());
+  const auto& memory_manager = packet.Get<std::shared_ptr<MemoryManager>>();
+  ASSERT_NE(memory_manager, nullptr);
+  EXPECT_NE(memory_manager->GetCpuBufferPool(), nullptr);
+#ifdef MEDIAPIPE_TENSOR_USE_AHWB
+  EXPECT_EQ(memory_manager->GetAndroidHardwareBufferPool(), nullptr);
+#endif  // MEDIAPIPE_TENSOR_USE_AHWB
+}
+
+TEST(MemoryManagerServiceTest, ConstructedManagerPoolsAllBuffers) {
+  MemoryManager memory_manager;
+  EXPECT_NE(memory_manager.GetCpuBufferPool(), nullptr);
+#ifdef MEDIAPIPE_TENSOR_USE_AHWB
+  EXPECT_NE(memory_manager.GetAndroidHardwareBufferPool(), nullptr);
+#endif  // MEDIAPIPE_TENSOR_USE_AHWB
+}
+
+}  // namespace
+}  // namespace mediapipe
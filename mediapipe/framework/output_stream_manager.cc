@@ -91,6 +91,13 @@ void OutputStreamManager::SetMaxQueueSize(int max_queue_size) {
   }
 }
 
+void OutputStreamManager::SetMaxQueueByteSize(int64_t max_queue_bytes) {
+  for (auto& mirror : mirrors_) {
+    mirror.input_stream_handler->SetMaxQueueByteSize(mirror.id,
+                                                     max_queue_bytes);
+  }
+}
+
 Timestamp OutputStreamManager::NextTimestampBound() const {
   absl::MutexLock lock(&stream_mutex_);
   return next_timestamp_bound_;
@@ -15,6 +15,7 @@
 #ifndef MEDIAPIPE_FRAMEWORK_OUTPUT_STREAM_MANAGER_H_
 #define MEDIAPIPE_FRAMEWORK_OUTPUT_STREAM_MANAGER_H_
 
+#include <cstdint>
 #include <functional>
 #include <string>
 #include <vector>
@@ -80,6 +81,9 @@ class OutputStreamManager {
   // Sets the maximum queue size on all mirrors.
   void SetMaxQueueSize(int max_queue_size);
 
+  // Sets the maximum queue bytes on all mirrors.
+  void SetMaxQueueByteSize(int64_t max_queue_bytes);
+
   // Returns the next timetstamp bound of the output stream.
   Timestamp NextTimestampBound() const;
 
@@ -132,6 +132,8 @@ class OutputStreamShard : public OutputStream {
   friend class PerfettoTraceScope;
   // Accesses OutputStreamShard for post processing.
   friend class OutputStreamManager;
+  // Accesses OutputStreamShard for running fused calculators.
+  friend class FusedCalculator;
 };
 
 }  // namespace mediapipe
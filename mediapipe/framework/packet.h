@@ -33,6 +33,7 @@
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/deps/no_destructor.h"
 #include "mediapipe/framework/deps/registration.h"
+#include "mediapipe/framework/payload_size.h"
 #include "mediapipe/framework/port.h"
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/logging.h"
@@ -190,6 +191,30 @@ class Packet {
       typename std::enable_if<std::is_array<T>::value &&
                               std::extent<T>::value == 0>::type* = nullptr);
 
+  // Consumes the packet and transfers the ownership of the data to a unique
+  // pointer if the packet is the sole owner of a non-foreign holder, like
+  // Consume(). Otherwise, returns nullptr and leaves the packet unchanged.
+  // The function returns error when the packet doesn't hold a T.
+  //
+  // This is copy-on-write for calculators that modify a payload and send it
+  // downstream, like image calculators: a sole owner modifies the payload in
+  // place, while the caller of a shared payload writes its result into a new
+  // one. Unlike ConsumeOrCopy(), it works for types that can't be copied,
+  // such as ImageFrame, and doesn't copy payloads that the caller overwrites
+  // anyway.
+  //
+  // The warning for Consume() applies.
+  //
+  // Example usage:
+  //   MP_ASSIGN_OR_RETURN(std::unique_ptr<ImageFrame> frame,
+  //                       p.ConsumeIfSoleOwner<ImageFrame>());
+  //   if (frame == nullptr) {
+  //     frame = absl::make_unique<ImageFrame>(...);
+  //     // Copy the input into frame.
+  //   }
+  template <typename T>
+  absl::StatusOr<std::unique_ptr<T>> ConsumeIfSoleOwner();
+
   // Returns the reference to type MessageLite data, if the underlying
   // object type is protocol buffer, crashes otherwise.
   const proto_ns::MessageLite& GetProtoMessageLite() const;
@@ -230,6 +255,10 @@ class Packet {
   // Returns a string with the best guess at the type name.
   std::string DebugTypeName() const;
 
+  // Returns the approximate number of bytes of memory held by the payload, as
+  // reported by PayloadSize<T>, or 0 if the packet is empty.
+  size_t PayloadByteSize() const;
+
  private:
   friend Packet packet_internal::Create(packet_internal::HolderBase* holder);
   friend Packet packet_internal::Create(packet_internal::HolderBase* holder,
@@ -421,6 +450,9 @@ class HolderBase {
   GetVectorOfProtoMessageLite() const = 0;
 
   virtual bool HasForeignOwner() const { return false; }
+
+  // Returns the approximate number of bytes of memory held by the payload.
+  virtual size_t PayloadByteSize() const = 0;
 };
 
 // Two helper functions to get the proto base pointers.
@@ -568,6 +600,10 @@ class Holder : public HolderBase, private HolderPayloadRegistrator<T> {
     return ConvertToVectorOfProtoMessageLitePtrs(ptr_, is_proto_vector<T>());
   }
 
+  size_t PayloadByteSize() const override {
+    return ptr_ ? PayloadSize<std::remove_cv_t<T>>::ByteSize(*ptr_) : 0;
+  }
+
  private:
   // Call delete[] if T is an array, delete otherwise.
   template <typename U = T>
@@ -728,6 +764,15 @@ inline absl::StatusOr<std::unique_ptr<T>> Packet::ConsumeOrCopy(
   return absl::InternalError("Unbounded array isn't supported.");
 }
 
+template <typename T>
+inline absl::StatusOr<std::unique_ptr<T>> Packet::ConsumeIfSoleOwner() {
+  MP_RETURN_IF_ERROR(ValidateAsType<T>());
+  if (holder_->HasForeignOwner() || holder_.use_count() != 1) {
+    return std::unique_ptr<T>();
+  }
+  return Consume<T>();
+}
+
 inline Packet::Packet(Packet&& packet) {
   VLOG(4) << "Using move constructor of " << packet.DebugString();
   holder_ = std::move(packet.holder_);
@@ -747,6 +792,10 @@ inline Packet& Packet::operator=(Packet&& packet) {
 
 inline bool Packet::IsEmpty() const { return holder_ == nullptr; }
 
+inline size_t Packet::PayloadByteSize() const {
+  return holder_ ? holder_->PayloadByteSize() : 0;
+}
+
 inline TypeId Packet::GetTypeId() const {
   ABSL_CHECK(holder_);
   return holder_->GetTypeId();
@@ -0,0 +1,108 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/packet_arena.h"
+
+#include <atomic>
+#include <cstdint>
+#include <new>
+
+namespace mediapipe {
+
+namespace {
+
+// The shard index used by the calling thread. Threads are assigned to shards
+// round-robin the first time they allocate.
+int CurrentShardIndex() {
+  static std::atomic<int> next_shard_index{0};
+  thread_local const int shard_index =
+      next_shard_index.fetch_add(1, std::memory_order_relaxed);
+  return shard_index;
+}
+
+}  // namespace
+
+PacketArena::~PacketArena() {
+  for (Shard& shard : shards_) {
+    absl::MutexLock lock(&shard.mutex);
+    for (void* slab : shard.slabs) {
+      ::operator delete(slab, std::align_val_t(kSlabSize));
+    }
+  }
+}
+
+// static
+int PacketArena::SizeClass(size_t size) {
+  size_t block_size = kMinBlockSize;
+  for (int size_class = 0; size_class < kNumSizeClasses; ++size_class) {
+    if (size <= block_size) return size_class;
+    block_size *= 2;
+  }
+  return -1;
+}
+
+void* PacketArena::Allocate(size_t size, size_t alignment) {
+  const int size_class = SizeClass(size);
+  if (size_class < 0 || alignment > kMinBlockSize) {
+    return ::operator new(size, std::align_val_t(alignment));
+  }
+  Shard& shard = shards_[CurrentShardIndex() % kNumShards];
+  absl::MutexLock lock(&shard.mutex);
+  FreeBlock*& free_list = shard.free_lists[size_class];
+  if (free_list != nullptr) {
+    FreeBlock* block = free_list;
+    free_list = block->next;
+    return block;
+  }
+  const size_t block_size = kMinBlockSize << size_class;
+  if (static_cast<size_t>(shard.slab_end - shard.slab_cursor) < block_size) {
+    // The rest of the current slab is abandoned; it is smaller than
+    // kMaxBlockSize.
+    char* slab = static_cast<char*>(
+        ::operator new(kSlabSize, std::align_val_t(kSlabSize)));
+    *reinterpret_cast<Shard**>(slab) = &shard;
+    shard.slabs.push_back(slab);
+    shard.slab_cursor = slab + kMinBlockSize;
+    shard.slab_end = slab + kSlabSize;
+  }
+  void* block = shard.slab_cursor;
+  shard.slab_cursor += block_size;
+  return block;
+}
+
+void PacketArena::Deallocate(void* ptr, size_t size, size_t alignment) {
+  const int size_class = SizeClass(size);
+  if (size_class < 0 || alignment > kMinBlockSize) {
+    ::operator delete(ptr, std::align_val_t(alignment));
+    return;
+  }
+  const uintptr_t slab =
+      reinterpret_cast<uintptr_t>(ptr) & ~uintptr_t{kSlabSize - 1};
+  Shard* shard = *reinterpret_cast<Shard**>(slab);
+  absl::MutexLock lock(&shard->mutex);
+  FreeBlock* block = static_cast<FreeBlock*>(ptr);
+  block->next = shard->free_lists[size_class];
+  shard->free_lists[size_class] = block;
+}
+
+size_t PacketArena::SlabBytes() const {
+  size_t slab_bytes = 0;
+  for (const Shard& shard : shards_) {
+    absl::MutexLock lock(&shard.mutex);
+    slab_bytes += shard.slabs.size() * kSlabSize;
+  }
+  return slab_bytes;
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,186 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_PACKET_ARENA_H_
+#define MEDIAPIPE_FRAMEWORK_PACKET_ARENA_H_
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/timestamp.h"
+
+namespace mediapipe {
+
+// Recycles the memory of small packet payloads.
+//
+// MakePacket<T>() makes three heap allocations: the payload, its Holder and
+// the shared_ptr control block. MakePacketInArena<T>() places all three in a
+// single block obtained from a PacketArena. Blocks are carved out of large
+// slabs, and a block is put on a free list of the arena when the last Packet
+// referring to it is destroyed, so that steady-state packet creation does not
+// call malloc.
+//
+// The arena is split into shards, each guarded by its own mutex, and every
+// thread allocates from the shard assigned to it. A block released on
+// another thread goes back to the shard it was allocated from.
+//
+// A CalculatorGraph creates one arena per run if the graph config sets
+// use_packet_arena. Calculators obtain it through
+// CalculatorContext::GetPacketArena():
+//
+//   cc->Outputs().Index(0).AddPacket(
+//       MakePacketInArena<NormalizedRect>(cc->GetPacketArena(), rect)
+//           .At(cc->InputTimestamp()));
+//
+// Each block holds a reference to the arena, so packets may outlive the graph
+// run. Payloads in an arena can't be consumed: Packet::Consume() fails and
+// Packet::ConsumeOrCopy() copies.
+class PacketArena {
+ public:
+  // Allocations larger than this, or with an alignment larger than
+  // kMinBlockSize, are forwarded to operator new.
+  static constexpr size_t kMaxBlockSize = 2048;
+
+  PacketArena() = default;
+  PacketArena(const PacketArena&) = delete;
+  PacketArena& operator=(const PacketArena&) = delete;
+  // REQUIRES: all blocks have been deallocated.
+  ~PacketArena();
+
+  // Returns a block of at least "size" bytes aligned to "alignment".
+  void* Allocate(size_t size, size_t alignment);
+
+  // Returns a block obtained from Allocate() with the same size and alignment
+  // to the arena. May be called on any thread.
+  void Deallocate(void* ptr, size_t size, size_t alignment);
+
+  // Returns the number of bytes held in slabs. Provided for testing only.
+  size_t SlabBytes() const;
+
+ private:
+  static constexpr size_t kMinBlockSize = 64;
+  static constexpr int kNumSizeClasses = 6;  // 64, 128, ..., 2048 bytes.
+  static constexpr size_t kSlabSize = 64 * 1024;
+  static constexpr int kNumShards = 8;
+
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  // Slabs are aligned to kSlabSize and start with a pointer to the shard that
+  // owns them, which lets Deallocate() find the shard of any block.
+  struct alignas(64) Shard {
+    mutable absl::Mutex mutex;
+    FreeBlock* free_lists[kNumSizeClasses] ABSL_GUARDED_BY(mutex) = {};
+    // The unused part of the most recent slab.
+    char* slab_cursor ABSL_GUARDED_BY(mutex) = nullptr;
+    char* slab_end ABSL_GUARDED_BY(mutex) = nullptr;
+    std::vector<void*> slabs ABSL_GUARDED_BY(mutex);
+  };
+
+  // Returns the size class for "size", or -1 if it exceeds kMaxBlockSize.
+  static int SizeClass(size_t size);
+
+  Shard shards_[kNumShards];
+};
+
+// A standard allocator backed by a PacketArena. Keeps the arena alive for as
+// long as any memory allocated from it is in use.
+template <typename T>
+class PacketArenaAllocator {
+ public:
+  using value_type = T;
+
+  explicit PacketArenaAllocator(std::shared_ptr<PacketArena> arena)
+      : arena_(std::move(arena)) {}
+  template <typename U>
+  PacketArenaAllocator(const PacketArenaAllocator<U>& other)  // NOLINT
+      : arena_(other.arena_) {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(arena_->Allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T* ptr, size_t n) {
+    arena_->Deallocate(ptr, n * sizeof(T), alignof(T));
+  }
+
+  template <typename U>
+  bool operator==(const PacketArenaAllocator<U>& other) const {
+    return arena_ == other.arena_;
+  }
+  template <typename U>
+  bool operator!=(const PacketArenaAllocator<U>& other) const {
+    return arena_ != other.arena_;
+  }
+
+ private:
+  template <typename U>
+  friend class PacketArenaAllocator;
+
+  std::shared_ptr<PacketArena> arena_;
+};
+
+namespace packet_internal {
+
+// A Holder that stores its payload inline, so that the holder and the payload
+// share one allocation.
+template <typename T>
+class ArenaHolder : public Holder<T> {
+ public:
+  template <typename... Args>
+  explicit ArenaHolder(Args&&... args) : Holder<T>(nullptr) {
+    this->ptr_ = new (&storage_) T(std::forward<Args>(args)...);
+  }
+  ~ArenaHolder() override {
+    this->ptr_->~T();
+    // Null out ptr_ so it doesn't get deleted by ~Holder.
+    this->ptr_ = nullptr;
+  }
+  // The payload is not a separate heap object and can't be released.
+  bool HasForeignOwner() const final { return true; }
+
+ private:
+  alignas(T) unsigned char storage_[sizeof(T)];
+};
+
+}  // namespace packet_internal
+
+// Like MakePacket<T>(), but allocates the packet from "arena". Falls back to
+// MakePacket<T>() if "arena" is null, so calculators can call it whether or
+// not the graph uses a packet arena.
+template <typename T, typename... Args>
+Packet MakePacketInArena(const std::shared_ptr<PacketArena>& arena,
+                         Args&&... args) {  // NOLINT(build/c++11)
+  static_assert(!std::is_array<T>::value,
+                "MakePacketInArena does not support array types.");
+  if (arena == nullptr) {
+    return MakePacket<T>(std::forward<Args>(args)...);
+  }
+  return packet_internal::Create(
+      std::allocate_shared<packet_internal::ArenaHolder<T>>(
+          PacketArenaAllocator<packet_internal::ArenaHolder<T>>(arena),
+          std::forward<Args>(args)...),
+      Timestamp::Unset());
+}
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PACKET_ARENA_H_
@@ -0,0 +1,163 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/packet_arena.h"
+
+#include <array>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/status/status.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/tool/sink.h"
+
+namespace mediapipe {
+namespace {
+
+TEST(PacketArenaTest, MakesPacket) {
+  auto arena = std::make_shared<PacketArena>();
+  Packet packet = MakePacketInArena<std::string>(arena, "hello");
+  ASSERT_TRUE(packet.ValidateAsType<std::string>().ok());
+  EXPECT_EQ(packet.Get<std::string>(), "hello");
+  EXPECT_EQ(packet.Timestamp(), Timestamp::Unset());
+  EXPECT_EQ(packet.At(Timestamp(10)).Timestamp(), Timestamp(10));
+}
+
+TEST(PacketArenaTest, FallsBackToHeapWithoutArena) {
+  Packet packet = MakePacketInArena<int>(nullptr, 42);
+  EXPECT_EQ(packet.Get<int>(), 42);
+  // A heap packet can be consumed.
+  MP_EXPECT_OK(packet.Consume<int>());
+}
+
+TEST(PacketArenaTest, RecyclesBlocks) {
+  auto arena = std::make_shared<PacketArena>();
+  Packet packet = MakePacketInArena<std::vector<float>>(arena, 16, 1.0f);
+  const void* first_payload = &packet.Get<std::vector<float>>();
+  packet = Packet();
+  packet = MakePacketInArena<std::vector<float>>(arena, 16, 2.0f);
+  EXPECT_EQ(&packet.Get<std::vector<float>>(), first_payload);
+
+  const size_t slab_bytes = arena->SlabBytes();
+  for (int i = 0; i < 1000; ++i) {
+    packet = MakePacketInArena<std::vector<float>>(arena, 16, i);
+  }
+  EXPECT_EQ(arena->SlabBytes(), slab_bytes);
+}
+
+TEST(PacketArenaTest, PacketOutlivesArenaOwner) {
+  auto arena = std::make_shared<PacketArena>();
+  Packet packet = MakePacketInArena<int>(arena, 7);
+  arena.reset();
+  EXPECT_EQ(packet.Get<int>(), 7);
+}
+
+TEST(PacketArenaTest, LargePayload) {
+  using LargePayload = std::array<char, 4096>;
+  auto arena = std::make_shared<PacketArena>();
+  Packet packet = MakePacketInArena<LargePayload>(arena);
+  EXPECT_EQ(packet.Get<LargePayload>().size(), 4096);
+  EXPECT_EQ(arena->SlabBytes(), 0);
+}
+
+TEST(PacketArenaTest, ConsumeOrCopyCopies) {
+  auto arena = std::make_shared<PacketArena>();
+  Packet packet = MakePacketInArena<int>(arena, 5);
+  EXPECT_EQ(packet.Consume<int>().status().code(),
+            absl::StatusCode::kFailedPrecondition);
+  bool was_copied = false;
+  auto result = packet.ConsumeOrCopy<int>(&was_copied);
+  MP_ASSERT_OK(result);
+  EXPECT_EQ(*result.value(), 5);
+  EXPECT_TRUE(was_copied);
+  EXPECT_TRUE(packet.IsEmpty());
+}
+
+TEST(PacketArenaTest, ReleasesOnOtherThreads) {
+  auto arena = std::make_shared<PacketArena>();
+  std::vector<Packet> packets;
+  for (int i = 0; i < 1000; ++i) {
+    packets.push_back(MakePacketInArena<int>(arena, i));
+  }
+  std::thread releaser([&packets] { packets.clear(); });
+  releaser.join();
+  std::thread allocator([&arena] {
+    for (int i = 0; i < 1000; ++i) {
+      Packet packet = MakePacketInArena<int>(arena, i);
+      ASSERT_EQ(packet.Get<int>(), i);
+    }
+  });
+  allocator.join();
+}
+
+// Outputs its input, copied into a packet from the graph's packet arena.
+class ArenaCopyCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<int>();
+    cc->Outputs().Index(0).Set<int>();
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    RET_CHECK(cc->GetPacketArena() != nullptr);
+    cc->Outputs().Index(0).AddPacket(
+        MakePacketInArena<int>(cc->GetPacketArena(),
+                               cc->Inputs().Index(0).Get<int>())
+            .At(cc->InputTimestamp()));
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(ArenaCopyCalculator);
+
+TEST(PacketArenaTest, GraphWithPacketArena) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "in"
+        use_packet_arena: true
+        node {
+          calculator: "ArenaCopyCalculator"
+          input_stream: "in"
+          output_stream: "out"
+        }
+      )pb");
+  std::vector<Packet> output_packets;
+  tool::AddVectorSink("out", &config, &output_packets);
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  for (int run = 0; run < 2; ++run) {
+    MP_ASSERT_OK(graph.StartRun({}));
+    for (int i = 0; i < 10; ++i) {
+      MP_ASSERT_OK(graph.AddPacketToInputStream(
+          "in", MakePacket<int>(i).At(Timestamp(i))));
+    }
+    MP_ASSERT_OK(graph.CloseAllInputStreams());
+    MP_ASSERT_OK(graph.WaitUntilDone());
+  }
+  // The packets of both runs remain valid after their arenas are released.
+  ASSERT_EQ(output_packets.size(), 20);
+  for (int i = 0; i < 20; ++i) {
+    EXPECT_EQ(output_packets[i].Get<int>(), i % 10);
+  }
+}
+
+}  // namespace
+}  // namespace mediapipe
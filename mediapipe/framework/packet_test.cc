@@ -14,6 +14,7 @@
 
 #include "mediapipe/framework/packet.h"
 
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <string>
@@ -151,6 +152,32 @@ MEDIAPIPE_REGISTER_TYPE(int, "int", nullptr, nullptr);
 MEDIAPIPE_REGISTER_TYPE(float, "float", nullptr, nullptr);
 constexpr bool kHaveUnregisteredTypeNames = MEDIAPIPE_HAS_RTTI;
 
+TEST(PacketTest, PayloadByteSize) {
+  EXPECT_EQ(0, Packet().PayloadByteSize());
+  EXPECT_EQ(sizeof(int64_t), MakePacket<int64_t>(7).PayloadByteSize());
+
+  std::vector<float> floats(100);
+  EXPECT_EQ(sizeof(floats) + 100 * sizeof(float),
+            MakePacket<std::vector<float>>(floats).PayloadByteSize());
+
+  // Nested vectors hold the buffers of their elements too, and the unused
+  // capacity of the outer vector.
+  std::vector<std::vector<float>> nested;
+  nested.reserve(3);
+  nested.push_back(floats);
+  nested.push_back(std::vector<float>(10));
+  EXPECT_EQ(sizeof(nested) + sizeof(floats) +
+                sizeof(floats) + 100 * sizeof(float) +
+                sizeof(floats) + 10 * sizeof(float),
+            MakePacket<std::vector<std::vector<float>>>(std::move(nested))
+                .PayloadByteSize());
+
+  std::vector<bool> bits(64);
+  Packet bits_packet = MakePacket<std::vector<bool>>(bits);
+  EXPECT_EQ(sizeof(bits) + bits_packet.Get<std::vector<bool>>().capacity() / 8,
+            bits_packet.PayloadByteSize());
+}
+
 TEST(PacketTest, TypeRegistrationDebugString) {
   // Test registered type.
   RegisteredPairStruct s{1, 3.5};
@@ -368,6 +395,52 @@ TEST(PacketTest, TestPacketConsumeOrCopy) {
   EXPECT_TRUE(packet3.IsEmpty());
 }
 
+TEST(PacketTest, TestPacketConsumeIfSoleOwner) {
+  Packet packet1 = MakePacket<int>(33);
+  Packet packet_copy = packet1;
+  absl::StatusOr<std::unique_ptr<int>> result1 =
+      packet_copy.ConsumeIfSoleOwner<int>();
+  // Both packet1 and packet_copy own the data, ConsumeIfSoleOwner() returns
+  // nullptr and leaves both packets unchanged.
+  MP_ASSERT_OK(result1);
+  EXPECT_EQ(nullptr, result1.value());
+  ASSERT_FALSE(packet_copy.IsEmpty());
+  EXPECT_EQ(33, packet_copy.Get<int>());
+  ASSERT_FALSE(packet1.IsEmpty());
+  EXPECT_EQ(33, packet1.Get<int>());
+
+  Packet packet2 = MakePacket<int>(33);
+  // Types don't match (int vs float).
+  absl::StatusOr<std::unique_ptr<float>> result2 =
+      packet2.ConsumeIfSoleOwner<float>();
+  EXPECT_THAT(
+      result2.status().message(),
+      testing::AllOf(testing::HasSubstr("int"), testing::HasSubstr("float")));
+  ASSERT_FALSE(packet2.IsEmpty());
+  EXPECT_EQ(33, packet2.Get<int>());
+
+  // packet3 is the sole owner of the data. ConsumeIfSoleOwner() transfers the
+  // ownership to result3 and makes packet3 empty.
+  Packet packet3 = MakePacket<int>(42);
+  const int* data3 = &packet3.Get<int>();
+  absl::StatusOr<std::unique_ptr<int>> result3 =
+      packet3.ConsumeIfSoleOwner<int>();
+  MP_ASSERT_OK(result3);
+  ASSERT_NE(nullptr, result3.value());
+  EXPECT_EQ(data3, result3.value().get());
+  EXPECT_TRUE(packet3.IsEmpty());
+
+  // A foreign holder is never consumed.
+  std::unique_ptr<int> data4(new int(7));
+  Packet packet4 = PointToForeign(data4.get());
+  absl::StatusOr<std::unique_ptr<int>> result4 =
+      packet4.ConsumeIfSoleOwner<int>();
+  MP_ASSERT_OK(result4);
+  EXPECT_EQ(nullptr, result4.value());
+  ASSERT_FALSE(packet4.IsEmpty());
+  EXPECT_EQ(7, packet4.Get<int>());
+}
+
 TEST(PacketTest, TestConsumeForeignHolder) {
   std::unique_ptr<int> data(new int(33));
   Packet packet = PointToForeign(data.get());
@@ -0,0 +1,77 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_PAYLOAD_SIZE_H_
+#define MEDIAPIPE_FRAMEWORK_PAYLOAD_SIZE_H_
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace mediapipe {
+
+// Reports the approximate number of bytes of memory held by a packet payload
+// of type T, which input streams use to account for the memory held by their
+// queues (see CalculatorGraphConfig::max_queue_bytes).
+//
+// By default a payload holds sizeof(T) bytes. Types that own a buffer of
+// their own specialize PayloadSize in the header that defines them, so that
+// the specialization is visible wherever the type is put in a packet:
+//
+//   template <>
+//   struct PayloadSize<MyBuffer> {
+//     static size_t ByteSize(const MyBuffer& buffer) {
+//       return sizeof(buffer) + buffer.capacity();
+//     }
+//   };
+template <typename T, typename Enable = void>
+struct PayloadSize {
+  static size_t ByteSize(const T& payload) {
+    if constexpr (std::is_array<T>::value && std::extent<T>::value == 0) {
+      // The size of an array of unknown bound isn't known.
+      return 0;
+    } else {
+      return sizeof(T);
+    }
+  }
+};
+
+// A vector holds its elements, including the unused capacity.
+template <typename T, typename Allocator>
+struct PayloadSize<std::vector<T, Allocator>> {
+  static size_t ByteSize(const std::vector<T, Allocator>& payload) {
+    if constexpr (std::is_trivially_copyable<T>::value) {
+      return sizeof(payload) + payload.capacity() * sizeof(T);
+    } else {
+      size_t byte_size =
+          sizeof(payload) + (payload.capacity() - payload.size()) * sizeof(T);
+      for (const T& element : payload) {
+        byte_size += PayloadSize<T>::ByteSize(element);
+      }
+      return byte_size;
+    }
+  }
+};
+
+// std::vector<bool> packs its elements into bits.
+template <typename Allocator>
+struct PayloadSize<std::vector<bool, Allocator>> {
+  static size_t ByteSize(const std::vector<bool, Allocator>& payload) {
+    return sizeof(payload) + payload.capacity() / 8;
+  }
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PAYLOAD_SIZE_H_
@@ -0,0 +1,142 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/binary_trace_buffer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/numeric/bits.h"
+#include "absl/synchronization/mutex.h"
+
+namespace mediapipe {
+
+namespace {
+
+// Returns a new id for each BinaryTraceBuffer, so that a buffer allocated at
+// the address of a deleted one never hits its thread-local ring cache.
+uint64_t NextBufferId() {
+  static std::atomic<uint64_t> next_buffer_id = 1;
+  return next_buffer_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+}  // namespace
+
+BinaryTraceBuffer::ThreadRing::ThreadRing(size_t capacity, int thread_id,
+                                          std::thread::id owner)
+    : mask_(capacity - 1),
+      thread_id_(thread_id),
+      owner_(owner),
+      words_(new std::atomic<uint64_t>[capacity * kEventWords]) {
+  for (size_t i = 0; i < capacity * kEventWords; ++i) {
+    words_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+void BinaryTraceBuffer::ThreadRing::Write(const BinaryTraceEvent& event) {
+  const uint64_t index = head_.load(std::memory_order_relaxed);
+  uint64_t words[kEventWords];
+  std::memcpy(words, &event, sizeof(words));
+  // Orders the previous head_ update before the overwriting of the oldest
+  // event, so that readers can tell which events may be torn.
+  std::atomic_thread_fence(std::memory_order_release);
+  std::atomic<uint64_t>* slot = &words_[(index & mask_) * kEventWords];
+  for (int i = 0; i < kEventWords; ++i) {
+    slot[i].store(words[i], std::memory_order_relaxed);
+  }
+  head_.store(index + 1, std::memory_order_release);
+}
+
+BinaryTraceBuffer::ThreadEvents BinaryTraceBuffer::ThreadRing::Read() const {
+  const uint64_t capacity = mask_ + 1;
+  const uint64_t end = head_.load(std::memory_order_acquire);
+  const uint64_t begin = end > capacity ? end - capacity : 0;
+  std::vector<BinaryTraceEvent> events(end - begin);
+  for (uint64_t index = begin; index < end; ++index) {
+    const std::atomic<uint64_t>* slot = &words_[(index & mask_) * kEventWords];
+    uint64_t words[kEventWords];
+    for (int i = 0; i < kEventWords; ++i) {
+      words[i] = slot[i].load(std::memory_order_relaxed);
+    }
+    std::memcpy(&events[index - begin], words, sizeof(words));
+  }
+  // The writer may have started to overwrite any event older than the one
+  // following the last published event.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  const uint64_t head = head_.load(std::memory_order_relaxed);
+  const uint64_t first_valid =
+      std::max(begin, head + 1 > capacity ? head + 1 - capacity : 0);
+
+  ThreadEvents result;
+  result.thread_id = thread_id_;
+  result.dropped = first_valid;
+  if (first_valid < end) {
+    result.events.assign(events.begin() + (first_valid - begin), events.end());
+  }
+  return result;
+}
+
+BinaryTraceBuffer::BinaryTraceBuffer(size_t capacity)
+    : capacity_(absl::bit_ceil(std::max<size_t>(capacity, 1))),
+      buffer_id_(NextBufferId()) {}
+
+BinaryTraceBuffer::~BinaryTraceBuffer() = default;
+
+BinaryTraceBuffer::ThreadRing* BinaryTraceBuffer::GetThreadRing() {
+  struct CachedRing {
+    uint64_t buffer_id = 0;
+    ThreadRing* ring = nullptr;
+  };
+  static thread_local CachedRing cached_ring;
+  if (cached_ring.buffer_id == buffer_id_) {
+    return cached_ring.ring;
+  }
+
+  // The thread may already have a ring, if it has recorded into another buffer
+  // in the meantime.
+  const std::thread::id owner = std::this_thread::get_id();
+  absl::MutexLock lock(&mutex_);
+  ThreadRing* ring = nullptr;
+  for (const auto& thread_ring : rings_) {
+    if (thread_ring->owner() == owner) {
+      ring = thread_ring.get();
+      break;
+    }
+  }
+  if (ring == nullptr) {
+    rings_.push_back(
+        std::make_unique<ThreadRing>(capacity_, rings_.size(), owner));
+    ring = rings_.back().get();
+  }
+  cached_ring = {buffer_id_, ring};
+  return ring;
+}
+
+std::vector<BinaryTraceBuffer::ThreadEvents> BinaryTraceBuffer::Snapshot()
+    const {
+  absl::MutexLock lock(&mutex_);
+  std::vector<ThreadEvents> result;
+  result.reserve(rings_.size());
+  for (const auto& ring : rings_) {
+    result.push_back(ring->Read());
+  }
+  return result;
+}
+
+}  // namespace mediapipe
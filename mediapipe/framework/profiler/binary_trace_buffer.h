@@ -0,0 +1,139 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_PROFILER_BINARY_TRACE_BUFFER_H_
+#define MEDIAPIPE_FRAMEWORK_PROFILER_BINARY_TRACE_BUFFER_H_
+
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+
+namespace mediapipe {
+
+// A compact, fixed-size trace event. Events are written as raw 64-bit words,
+// so recording one costs a clock read and four stores.
+struct BinaryTraceEvent {
+  // Flags.
+  static constexpr uint16_t kFinish = 1 << 0;
+
+  // Nanoseconds of the monotonic clock, see BinaryTraceBuffer::NowNanos.
+  int64_t time_ns = 0;
+  // The Timestamp value of the packets being processed.
+  int64_t packet_ts = 0;
+  // Event specific data.
+  int64_t event_data = 0;
+  int32_t node_id = -1;
+  // A GraphTrace::EventType.
+  uint16_t event_type = 0;
+  uint16_t flags = 0;
+
+  bool is_finish() const { return flags & kFinish; }
+};
+static_assert(sizeof(BinaryTraceEvent) == 32,
+              "BinaryTraceEvent must fill half a cache line.");
+
+// Records BinaryTraceEvents into one fixed-size ring buffer per thread.
+//
+// Each thread only writes to its own ring, so recording takes no locks and
+// issues no read-modify-write atomics; only the first event of a thread takes
+// a mutex to create its ring. When a ring is full, the oldest events of the
+// thread are overwritten. The rings can be read at any time, even while they
+// are being written, which makes the buffer suitable for always-on tracing
+// that is dumped on demand.
+class BinaryTraceBuffer {
+ public:
+  // The recent events of one thread, oldest first.
+  struct ThreadEvents {
+    // Sequential id of the thread, in the order of its first event.
+    int thread_id = 0;
+    // Number of events that were overwritten before they could be read.
+    int64_t dropped = 0;
+    std::vector<BinaryTraceEvent> events;
+  };
+
+  // Creates rings holding the last "capacity" events of each thread, rounded
+  // up to a power of two.
+  explicit BinaryTraceBuffer(size_t capacity);
+  ~BinaryTraceBuffer();
+
+  BinaryTraceBuffer(const BinaryTraceBuffer&) = delete;
+  BinaryTraceBuffer& operator=(const BinaryTraceBuffer&) = delete;
+
+  // Returns the current time of the clock used for BinaryTraceEvent::time_ns,
+  // which is CLOCK_MONOTONIC on Linux and Android.
+  static inline int64_t NowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  // Appends an event to the ring of the calling thread.
+  inline void Record(const BinaryTraceEvent& event) {
+    GetThreadRing()->Write(event);
+  }
+
+  // Returns a consistent copy of the events of all threads. Events which are
+  // overwritten while being copied are skipped.
+  std::vector<ThreadEvents> Snapshot() const;
+
+  // Returns the number of events kept per thread.
+  size_t capacity() const { return capacity_; }
+
+ private:
+  // The words of a BinaryTraceEvent.
+  static constexpr int kEventWords = sizeof(BinaryTraceEvent) / sizeof(uint64_t);
+
+  class ThreadRing {
+   public:
+    ThreadRing(size_t capacity, int thread_id, std::thread::id owner);
+
+    // Called only by the thread owning this ring.
+    void Write(const BinaryTraceEvent& event);
+
+    // May be called by any thread.
+    ThreadEvents Read() const;
+
+    std::thread::id owner() const { return owner_; }
+
+   private:
+    const size_t mask_;
+    const int thread_id_;
+    const std::thread::id owner_;
+    // Words are written and read with relaxed atomics, so that concurrent
+    // reads are well defined; torn events are detected using head_.
+    std::unique_ptr<std::atomic<uint64_t>[]> words_;
+    // The number of events ever written.
+    std::atomic<uint64_t> head_ = 0;
+  };
+
+  // Returns the ring of the calling thread, creating it if needed.
+  ThreadRing* GetThreadRing();
+
+  const size_t capacity_;
+  // Distinguishes this buffer in the thread-local ring cache.
+  const uint64_t buffer_id_;
+  mutable absl::Mutex mutex_;
+  std::vector<std::unique_ptr<ThreadRing>> rings_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PROFILER_BINARY_TRACE_BUFFER_H_
@@ -0,0 +1,146 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/binary_trace_buffer.h"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/notification.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace {
+
+BinaryTraceEvent MakeEvent(int64_t packet_ts, int node_id = 0) {
+  BinaryTraceEvent event;
+  event.time_ns = BinaryTraceBuffer::NowNanos();
+  event.packet_ts = packet_ts;
+  event.node_id = node_id;
+  return event;
+}
+
+TEST(BinaryTraceBufferTest, RecordsEventsInOrder) {
+  BinaryTraceBuffer buffer(16);
+  for (int i = 0; i < 10; ++i) {
+    buffer.Record(MakeEvent(i));
+  }
+  std::vector<BinaryTraceBuffer::ThreadEvents> snapshot = buffer.Snapshot();
+  ASSERT_EQ(snapshot.size(), 1);
+  EXPECT_EQ(snapshot[0].dropped, 0);
+  ASSERT_EQ(snapshot[0].events.size(), 10);
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(snapshot[0].events[i].packet_ts, i);
+  }
+  EXPECT_LE(snapshot[0].events.front().time_ns,
+            snapshot[0].events.back().time_ns);
+}
+
+TEST(BinaryTraceBufferTest, KeepsMostRecentEvents) {
+  BinaryTraceBuffer buffer(10);
+  EXPECT_EQ(buffer.capacity(), 16);
+  for (int i = 0; i < 100; ++i) {
+    buffer.Record(MakeEvent(i));
+  }
+  std::vector<BinaryTraceBuffer::ThreadEvents> snapshot = buffer.Snapshot();
+  ASSERT_EQ(snapshot.size(), 1);
+  // The oldest remaining slot may be overwritten next, so it is not reported.
+  const std::vector<BinaryTraceEvent>& events = snapshot[0].events;
+  ASSERT_EQ(events.size(), 15);
+  EXPECT_EQ(snapshot[0].dropped, 85);
+  EXPECT_EQ(events.front().packet_ts, 85);
+  EXPECT_EQ(events.back().packet_ts, 99);
+}
+
+TEST(BinaryTraceBufferTest, KeepsOneRingPerThread) {
+  constexpr int kNumThreads = 4;
+  constexpr int kNumEvents = 50;
+  BinaryTraceBuffer buffer(64);
+  // The threads are kept alive until all have recorded, so that none of them
+  // gets the id of a finished thread.
+  absl::BlockingCounter recorded(kNumThreads);
+  absl::Notification exit;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < kNumEvents; ++i) {
+        buffer.Record(MakeEvent(i, t));
+      }
+      recorded.DecrementCount();
+      exit.WaitForNotification();
+    });
+  }
+  recorded.Wait();
+  exit.Notify();
+  for (auto& thread : threads) thread.join();
+
+  std::vector<BinaryTraceBuffer::ThreadEvents> snapshot = buffer.Snapshot();
+  ASSERT_EQ(snapshot.size(), kNumThreads);
+  for (const auto& thread_events : snapshot) {
+    ASSERT_EQ(thread_events.events.size(), kNumEvents);
+    const int node_id = thread_events.events[0].node_id;
+    for (int i = 0; i < kNumEvents; ++i) {
+      EXPECT_EQ(thread_events.events[i].node_id, node_id);
+      EXPECT_EQ(thread_events.events[i].packet_ts, i);
+    }
+  }
+}
+
+TEST(BinaryTraceBufferTest, SeparatesBuffers) {
+  BinaryTraceBuffer first(16);
+  BinaryTraceBuffer second(16);
+  first.Record(MakeEvent(1));
+  second.Record(MakeEvent(2));
+  first.Record(MakeEvent(3));
+  ASSERT_EQ(first.Snapshot().size(), 1);
+  ASSERT_EQ(first.Snapshot()[0].events.size(), 2);
+  EXPECT_EQ(first.Snapshot()[0].events[1].packet_ts, 3);
+  ASSERT_EQ(second.Snapshot()[0].events.size(), 1);
+}
+
+// Snapshots taken while a thread is writing contain only untorn events.
+TEST(BinaryTraceBufferTest, SnapshotsWhileRecording) {
+  BinaryTraceBuffer buffer(32);
+  absl::Notification started;
+  std::atomic<bool> done = false;
+  std::thread writer([&] {
+    for (int64_t i = 0; !done; ++i) {
+      BinaryTraceEvent event = MakeEvent(i, i);
+      event.event_data = i;
+      buffer.Record(event);
+      if (i == 0) started.Notify();
+    }
+  });
+  started.WaitForNotification();
+  for (int n = 0; n < 1000; ++n) {
+    for (const auto& thread_events : buffer.Snapshot()) {
+      int64_t previous = -1;
+      for (const BinaryTraceEvent& event : thread_events.events) {
+        EXPECT_EQ(event.packet_ts, event.event_data);
+        EXPECT_EQ(event.node_id, static_cast<int32_t>(event.packet_ts));
+        EXPECT_GT(event.packet_ts, previous);
+        previous = event.packet_ts;
+      }
+    }
+  }
+  done = true;
+  writer.join();
+}
+
+}  // namespace
+}  // namespace mediapipe
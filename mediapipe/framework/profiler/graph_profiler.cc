@@ -29,7 +29,10 @@
 #include "mediapipe/framework/port/re2.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/profiler/perfetto_exporter.h"
 #include "mediapipe/framework/profiler/profiler_resource_util.h"
+#include "mediapipe/framework/tool/fused_calculator.pb.h"
+#include "mediapipe/framework/tool/graph_fusion.h"
 #include "mediapipe/framework/tool/name_util.h"
 #include "mediapipe/framework/tool/tag_map.h"
 #include "mediapipe/framework/tool/validate_name.h"
@@ -143,6 +146,7 @@ class GraphProfiler::GraphProfileBuilder {
 GraphProfiler::GraphProfiler()
     : is_initialized_(false),
       is_profiling_(false),
+      is_binary_tracing_(false),
       calculator_profiles_(1000),
       packets_info_(1000),
       is_running_(false),
@@ -169,12 +173,26 @@ void GraphProfiler::Initialize(
   if (IsTracerEnabled(profiler_config_)) {
     packet_tracer_ = absl::make_unique<GraphTracer>(profiler_config_);
   }
+  if (profiler_config_.binary_trace_capacity() > 0) {
+    binary_tracer_ = std::make_unique<BinaryTraceBuffer>(
+        profiler_config_.binary_trace_capacity());
+  }
   for (int node_id = 0;
        node_id < validated_graph_config.CalculatorInfos().size(); ++node_id) {
     std::string node_name =
         tool::CanonicalNodeName(validated_graph_config.Config(), node_id);
+    node_names_.push_back(node_name);
     CalculatorProfile profile;
     profile.set_name(node_name);
+    const CalculatorGraphConfig::Node& node =
+        validated_graph_config.Config().node(node_id);
+    if (node.calculator() == tool::kFusedCalculatorName) {
+      // Reports the fusion decisions of the graph fusion pass.
+      for (const auto& fused_node :
+           node.options().GetExtension(FusedCalculatorOptions::ext).node()) {
+        profile.add_fused_node(fused_node.name());
+      }
+    }
     InitializeTimeHistogram(interval_size_usec, num_intervals,
                             profile.mutable_process_runtime());
     if (profiler_config_.enable_stream_latency()) {
@@ -183,10 +201,8 @@ void GraphProfiler::Initialize(
       InitializeTimeHistogram(interval_size_usec, num_intervals,
                               profile.mutable_process_output_latency());
 
-      const CalculatorGraphConfig::Node& node_config =
-          validated_graph_config.Config().node(node_id);
-      InitializeOutputStreams(node_config);
-      InitializeInputStreams(node_config, interval_size_usec, num_intervals,
+      InitializeOutputStreams(node);
+      InitializeInputStreams(node, interval_size_usec, num_intervals,
                              &profile);
     }
 
@@ -213,6 +229,7 @@ const std::shared_ptr<mediapipe::Clock> GraphProfiler::GetClock() const {
 void GraphProfiler::Pause() {
   is_profiling_ = false;
   is_tracing_ = false;
+  is_binary_tracing_ = false;
 }
 
 void GraphProfiler::Resume() {
@@ -222,6 +239,7 @@ void GraphProfiler::Resume() {
   // IsProfilerEnabled and IsTracerEnabled.
   is_profiling_ = IsProfilerEnabled(profiler_config_);
   is_tracing_ = IsTracerEnabled(profiler_config_);
+  is_binary_tracing_ = binary_tracer_ != nullptr;
 }
 
 void GraphProfiler::Reset() {
@@ -703,6 +721,22 @@ absl::Status GraphProfiler::CaptureProfile(
   return status;
 }
 
+absl::Status GraphProfiler::CapturePerfettoTrace(perfetto::Trace* result) {
+  RET_CHECK(binary_tracer_)
+      << "Binary tracing is disabled, see binary_trace_capacity.";
+  ExportPerfettoTrace(binary_tracer_->Snapshot(), node_names_, result);
+  return absl::OkStatus();
+}
+
+absl::Status GraphProfiler::WritePerfettoTrace(const std::string& path) {
+  perfetto::Trace trace;
+  MP_RETURN_IF_ERROR(CapturePerfettoTrace(&trace));
+  std::string contents;
+  RET_CHECK(trace.SerializeToString(&contents))
+      << "Could not serialize the Perfetto trace.";
+  return file::SetContents(path, contents);
+}
+
 absl::Status GraphProfiler::WriteProfile() {
   if (profiler_config_.trace_log_disabled()) {
     // Logging is disabled, so we can exit writing without error.
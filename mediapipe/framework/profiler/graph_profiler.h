@@ -30,7 +30,9 @@
 #include "mediapipe/framework/deps/clock.h"
 #include "mediapipe/framework/deps/monotonic_clock.h"
 #include "mediapipe/framework/executor.h"
+#include "mediapipe/framework/profiler/binary_trace_buffer.h"
 #include "mediapipe/framework/profiler/graph_tracer.h"
+#include "mediapipe/framework/profiler/perfetto_trace.pb.h"
 #include "mediapipe/framework/profiler/sharded_map.h"
 #include "mediapipe/framework/validated_graph_config.h"
 
@@ -164,6 +166,16 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
   // Returns the trace event buffer.
   GraphTracer* tracer() { return packet_tracer_.get(); }
 
+  // Returns the binary trace buffer, if enabled by binary_trace_capacity.
+  BinaryTraceBuffer* binary_tracer() { return binary_tracer_.get(); }
+
+  // Converts the recent events of the binary trace buffer to a Perfetto trace.
+  absl::Status CapturePerfettoTrace(perfetto::Trace* result);
+
+  // Writes the recent events of the binary trace buffer to "path" in
+  // Perfetto's native trace format.
+  absl::Status WritePerfettoTrace(const std::string& path);
+
   // Creates and returns a GlProfilingHelper interface for a single GLContext.
   std::unique_ptr<GlProfilingHelper> CreateGlProfilingHelper();
 
@@ -183,6 +195,10 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
           calculator_context_(*calculator_context),
           profiler_(profiler) {
       start_time_usec_ = profiler_->TimeNowUsec();
+      if (profiler_->is_binary_tracing_) {
+        profiler_->RecordBinaryEvent(calculator_method_, calculator_context_,
+                                     /*is_finish=*/false);
+      }
       if (profiler_->is_tracing_) {
         absl::Time time_now = absl::FromUnixMicros(start_time_usec_);
         profiler_->packet_tracer_->LogInputEvents(
@@ -216,6 +232,10 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
             break;
         }
       }
+      if (profiler_->is_binary_tracing_) {
+        profiler_->RecordBinaryEvent(calculator_method_, calculator_context_,
+                                     /*is_finish=*/true);
+      }
       if (profiler_->is_tracing_) {
         absl::Time time_now = absl::FromUnixMicros(end_time_usec);
         profiler_->packet_tracer_->LogOutputEvents(
@@ -313,6 +333,19 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
   // Helper method to get the clock time in microsecond.
   int64_t TimeNowUsec() { return ToUnixMicros(clock_->TimeNow()); }
 
+  // Records a calculator method call in the binary trace buffer.
+  void RecordBinaryEvent(GraphTrace::EventType event_type,
+                         const CalculatorContext& calculator_context,
+                         bool is_finish) {
+    BinaryTraceEvent event;
+    event.time_ns = BinaryTraceBuffer::NowNanos();
+    event.packet_ts = calculator_context.InputTimestamp().Value();
+    event.node_id = calculator_context.NodeId();
+    event.event_type = event_type;
+    event.flags = is_finish ? BinaryTraceEvent::kFinish : 0;
+    binary_tracer_->Record(event);
+  }
+
  private:
   // The settings for this tracer.
   ProfilerConfig profiler_config_;
@@ -327,6 +360,9 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
   // If true, the tracer records timing events.
   std::atomic_bool is_tracing_;
 
+  // If true, calculator calls are recorded in binary_tracer_.
+  std::atomic_bool is_binary_tracing_;
+
   // Stores all the calculator profiles with the calculator name as the key.
   using CalculatorProfileMap = ShardedMap<std::string, CalculatorProfile>;
   CalculatorProfileMap calculator_profiles_;
@@ -341,6 +377,12 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
   // Buffer of recent profile trace events.
   std::unique_ptr<GraphTracer> packet_tracer_;
 
+  // Per-thread buffers of recent calculator calls, for always-on tracing.
+  std::unique_ptr<BinaryTraceBuffer> binary_tracer_;
+
+  // The canonical node names, indexed by node id.
+  std::vector<std::string> node_names_;
+
   // The clock for time measurement, which must be a monotonic real time clock.
   std::shared_ptr<mediapipe::Clock> clock_;
 
@@ -16,6 +16,7 @@
 #define MEDIAPIPE_FRAMEWORK_PROFILER_MEDIAPIPE_PROFILER_STUB_H_
 
 #include <cstdint>
+#include <string>
 
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/framework/timestamp.h"
@@ -104,6 +105,9 @@ class GraphProfilerStub {
   }
   inline absl::Status Stop() { return absl::OkStatus(); }
   inline GraphTracer* tracer() { return nullptr; }
+  inline absl::Status WritePerfettoTrace(const std::string& path) {
+    return absl::OkStatus();
+  }
   inline std::unique_ptr<GlProfilingHelper> CreateGlProfilingHelper() {
     return nullptr;
   }
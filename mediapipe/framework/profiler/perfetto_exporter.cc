@@ -0,0 +1,105 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/perfetto_exporter.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/profiler/binary_trace_buffer.h"
+#include "mediapipe/framework/profiler/perfetto_trace.pb.h"
+
+namespace mediapipe {
+
+namespace {
+
+// Arbitrary ids, which only need to be unique within the trace.
+constexpr uint32_t kSequenceId = 0x4d50;
+constexpr uint64_t kTrackUuidBase = 0x4d50000000000000;
+
+bool IsSliceEvent(GraphTrace::EventType event_type) {
+  return event_type == GraphTrace::OPEN || event_type == GraphTrace::PROCESS ||
+         event_type == GraphTrace::CLOSE;
+}
+
+std::string EventName(const BinaryTraceEvent& event,
+                      const std::vector<std::string>& node_names) {
+  if (event.node_id >= 0 && event.node_id < node_names.size()) {
+    return node_names[event.node_id];
+  }
+  return event.node_id < 0 ? "graph" : absl::StrCat("node_", event.node_id);
+}
+
+}  // namespace
+
+void ExportPerfettoTrace(
+    const std::vector<BinaryTraceBuffer::ThreadEvents>& thread_events,
+    const std::vector<std::string>& node_names, perfetto::Trace* result) {
+  for (const BinaryTraceBuffer::ThreadEvents& thread : thread_events) {
+    const uint64_t track_uuid = kTrackUuidBase + thread.thread_id;
+    perfetto::TracePacket* descriptor_packet = result->add_packet();
+    descriptor_packet->set_trusted_packet_sequence_id(kSequenceId);
+    perfetto::TrackDescriptor* track =
+        descriptor_packet->mutable_track_descriptor();
+    track->set_uuid(track_uuid);
+    track->set_name(absl::StrCat("MediaPipe thread ", thread.thread_id));
+
+    // The begin events of the oldest slices may have been overwritten.
+    int open_slices = 0;
+    for (const BinaryTraceEvent& event : thread.events) {
+      const auto event_type =
+          static_cast<GraphTrace::EventType>(event.event_type);
+      perfetto::TrackEvent::Type type = perfetto::TrackEvent::TYPE_INSTANT;
+      if (IsSliceEvent(event_type)) {
+        if (!event.is_finish()) {
+          type = perfetto::TrackEvent::TYPE_SLICE_BEGIN;
+          ++open_slices;
+        } else if (open_slices > 0) {
+          type = perfetto::TrackEvent::TYPE_SLICE_END;
+          --open_slices;
+        } else {
+          continue;
+        }
+      }
+
+      perfetto::TracePacket* packet = result->add_packet();
+      packet->set_trusted_packet_sequence_id(kSequenceId);
+      packet->set_timestamp(event.time_ns);
+      packet->set_timestamp_clock_id(perfetto::BUILTIN_CLOCK_MONOTONIC);
+      perfetto::TrackEvent* track_event = packet->mutable_track_event();
+      track_event->set_type(type);
+      track_event->set_track_uuid(track_uuid);
+      if (type == perfetto::TrackEvent::TYPE_SLICE_END) {
+        continue;
+      }
+      track_event->set_name(EventName(event, node_names));
+      track_event->add_categories(GraphTrace::EventType_Name(event_type));
+      perfetto::DebugAnnotation* packet_ts =
+          track_event->add_debug_annotations();
+      packet_ts->set_name("packet_timestamp");
+      packet_ts->set_int_value(event.packet_ts);
+      if (event.event_data != 0) {
+        perfetto::DebugAnnotation* event_data =
+            track_event->add_debug_annotations();
+        event_data->set_name("event_data");
+        event_data->set_int_value(event.event_data);
+      }
+    }
+  }
+}
+
+}  // namespace mediapipe
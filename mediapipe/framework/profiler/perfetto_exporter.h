@@ -0,0 +1,38 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_PROFILER_PERFETTO_EXPORTER_H_
+#define MEDIAPIPE_FRAMEWORK_PROFILER_PERFETTO_EXPORTER_H_
+
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/profiler/binary_trace_buffer.h"
+#include "mediapipe/framework/profiler/perfetto_trace.pb.h"
+
+namespace mediapipe {
+
+// Converts BinaryTraceBuffer events to a Perfetto trace with one track per
+// thread. Begin and finish events become slices named after their node, other
+// events become instant events. "node_names" is indexed by node id.
+//
+// The timestamps refer to Perfetto's BUILTIN_CLOCK_MONOTONIC, so the trace can
+// be merged with a system trace recorded on the same Linux or Android device.
+void ExportPerfettoTrace(
+    const std::vector<BinaryTraceBuffer::ThreadEvents>& thread_events,
+    const std::vector<std::string>& node_names, perfetto::Trace* result);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PROFILER_PERFETTO_EXPORTER_H_
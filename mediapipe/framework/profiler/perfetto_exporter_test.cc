@@ -0,0 +1,140 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/perfetto_exporter.h"
+
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/deps/file_path.h"
+#include "mediapipe/framework/port/file_helpers.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/profiler/binary_trace_buffer.h"
+#include "mediapipe/framework/profiler/perfetto_trace.pb.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::ElementsAre;
+
+BinaryTraceEvent MakeEvent(int64_t time_ns, GraphTrace::EventType event_type,
+                           bool is_finish, int node_id) {
+  BinaryTraceEvent event;
+  event.time_ns = time_ns;
+  event.packet_ts = 7;
+  event.node_id = node_id;
+  event.event_type = event_type;
+  event.flags = is_finish ? BinaryTraceEvent::kFinish : 0;
+  return event;
+}
+
+TEST(PerfettoExporterTest, ExportsSlicesAndInstants) {
+  BinaryTraceBuffer::ThreadEvents thread;
+  thread.thread_id = 3;
+  thread.events = {
+      // Finishes a slice whose begin event was overwritten.
+      MakeEvent(100, GraphTrace::PROCESS, true, 0),
+      MakeEvent(200, GraphTrace::PROCESS, false, 1),
+      MakeEvent(250, GraphTrace::THROTTLED, false, -1),
+      MakeEvent(300, GraphTrace::PROCESS, true, 1),
+  };
+  perfetto::Trace trace;
+  ExportPerfettoTrace({thread}, {"first", "second"}, &trace);
+
+  ASSERT_EQ(trace.packet_size(), 4);
+  const perfetto::TrackDescriptor& track = trace.packet(0).track_descriptor();
+  EXPECT_EQ(track.name(), "MediaPipe thread 3");
+
+  const perfetto::TracePacket& begin = trace.packet(1);
+  EXPECT_EQ(begin.timestamp(), 200);
+  EXPECT_EQ(begin.timestamp_clock_id(), perfetto::BUILTIN_CLOCK_MONOTONIC);
+  EXPECT_EQ(begin.track_event().type(), perfetto::TrackEvent::TYPE_SLICE_BEGIN);
+  EXPECT_EQ(begin.track_event().track_uuid(), track.uuid());
+  EXPECT_EQ(begin.track_event().name(), "second");
+  EXPECT_THAT(begin.track_event().categories(), ElementsAre("PROCESS"));
+  ASSERT_EQ(begin.track_event().debug_annotations_size(), 1);
+  EXPECT_EQ(begin.track_event().debug_annotations(0).int_value(), 7);
+
+  const perfetto::TracePacket& instant = trace.packet(2);
+  EXPECT_EQ(instant.track_event().type(), perfetto::TrackEvent::TYPE_INSTANT);
+  EXPECT_EQ(instant.track_event().name(), "graph");
+  EXPECT_THAT(instant.track_event().categories(), ElementsAre("THROTTLED"));
+
+  const perfetto::TracePacket& end = trace.packet(3);
+  EXPECT_EQ(end.timestamp(), 300);
+  EXPECT_EQ(end.track_event().type(), perfetto::TrackEvent::TYPE_SLICE_END);
+}
+
+TEST(PerfettoExporterTest, GraphWritesPerfettoTrace) {
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "input"
+    profiler_config { binary_trace_capacity: 64 }
+    node {
+      name: "pass"
+      calculator: "PassThroughCalculator"
+      input_stream: "input"
+      output_stream: "output"
+    }
+  )pb")));
+  MP_ASSERT_OK(graph.StartRun({}));
+  for (int i = 0; i < 3; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "input", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  const std::string path =
+      file::JoinPath(::testing::TempDir(), "graph_trace.perfetto-trace");
+  MP_ASSERT_OK(graph.profiler()->WritePerfettoTrace(path));
+  std::string contents;
+  MP_ASSERT_OK(file::GetContents(path, &contents));
+  perfetto::Trace trace;
+  ASSERT_TRUE(trace.ParseFromString(contents));
+
+  std::vector<std::string> slices;
+  for (const perfetto::TracePacket& packet : trace.packet()) {
+    if (packet.track_event().type() ==
+        perfetto::TrackEvent::TYPE_SLICE_BEGIN) {
+      slices.push_back(packet.track_event().categories(0));
+      EXPECT_EQ(packet.track_event().name(), "pass");
+    }
+  }
+  EXPECT_THAT(slices, ElementsAre("OPEN", "PROCESS", "PROCESS", "PROCESS",
+                                  "CLOSE"));
+}
+
+TEST(PerfettoExporterTest, BinaryTracingIsOptIn) {
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "input"
+    node {
+      calculator: "PassThroughCalculator"
+      input_stream: "input"
+      output_stream: "output"
+    }
+  )pb")));
+  EXPECT_EQ(graph.profiler()->binary_tracer(), nullptr);
+  perfetto::Trace trace;
+  EXPECT_FALSE(graph.profiler()->CapturePerfettoTrace(&trace).ok());
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -67,6 +67,7 @@ void Scheduler::Reset() {
     throttled_graph_input_stream_count_ = 0;
     unthrottle_seq_num_ = 0;
     observed_output_signal_ = false;
+    update_node_priorities_when_idle_ = false;
   }
   for (auto queue : scheduler_queues_) {
     queue->Reset();
@@ -75,6 +76,23 @@ void Scheduler::Reset() {
   shared_.has_error = false;
 }
 
+void Scheduler::SetNumNodes(int num_nodes) {
+  for (auto queue : scheduler_queues_) {
+    queue->SetNumNodes(num_nodes);
+  }
+}
+
+void Scheduler::SetNodePriorities(const std::vector<int>& priorities) {
+  for (auto queue : scheduler_queues_) {
+    queue->SetNodePriorities(priorities);
+  }
+}
+
+void Scheduler::SetUpdateNodePrioritiesWhenIdle(bool update) {
+  absl::MutexLock lock(&state_mutex_);
+  update_node_priorities_when_idle_ = update;
+}
+
 void Scheduler::CloseAllSourceNodes() { shared_.stopping = true; }
 
 void Scheduler::SetExecutor(Executor* executor) {
@@ -165,6 +183,15 @@ void Scheduler::HandleIdle() {
       }
     }
 
+    // The nodes that just ran may have changed the node costs. The
+    // priorities only affect the order in which nodes run, so the update
+    // doesn't need to be synchronized with the nodes being scheduled.
+    if (update_node_priorities_when_idle_) {
+      state_mutex_.Unlock();
+      graph_->UpdateNodePriorities();
+      state_mutex_.Lock();
+    }
+
     // If HandleIdle has been called again, then continue scheduling.
     if (handling_idle_ > 1) {
       handling_idle_ = 1;
@@ -446,6 +473,13 @@ void Scheduler::AssignNodeToSchedulerQueue(CalculatorNode* node) {
     queue = &default_queue_;
   }
   node->SetSchedulerQueue(queue);
+  node->SetBatchTimerCallback([queue, node]() {
+    // Keeps the graph from being considered idle while the node is scheduled
+    // from the batch timer thread.
+    queue->BeginExternalWork();
+    node->CheckIfBecameReady();
+    queue->EndExternalWork();
+  });
 }
 
 void Scheduler::QueueIdleStateChanged(bool idle) {
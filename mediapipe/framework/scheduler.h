@@ -61,6 +61,20 @@ class Scheduler {
   // Resets the data members at the beginning of each graph run.
   void Reset();
 
+  // Sizes the per-node structures of the scheduler queues for node ids in
+  // [0, num_nodes). Must be called after Reset() and before any node is
+  // assigned to a scheduler queue.
+  void SetNumNodes(int num_nodes);
+
+  // Sets the priority of the non-source nodes in the scheduler queues, see
+  // SchedulerQueue::SetNodePriorities. Can be called while the graph runs.
+  void SetNodePriorities(const std::vector<int>& priorities);
+
+  // If true, the scheduler calls CalculatorGraph::UpdateNodePriorities()
+  // whenever the running graph becomes idle. Reset() sets it to false.
+  void SetUpdateNodePrioritiesWhenIdle(bool update)
+      ABSL_LOCKS_EXCLUDED(state_mutex_);
+
   // Starts scheduling nodes.
   void Start();
 
@@ -327,6 +341,9 @@ class Scheduler {
   // Number of throttled graph input streams.
   int throttled_graph_input_stream_count_ ABSL_GUARDED_BY(state_mutex_) = 0;
 
+  // See SetUpdateNodePrioritiesWhenIdle.
+  bool update_node_priorities_when_idle_ ABSL_GUARDED_BY(state_mutex_) = false;
+
   // Used to stop WaitUntilGraphInputStreamUnthrottled.
   int unthrottle_seq_num_ ABSL_GUARDED_BY(state_mutex_) = 0;
 
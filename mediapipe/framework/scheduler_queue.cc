@@ -14,11 +14,16 @@
 
 #include "mediapipe/framework/scheduler_queue.h"
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <queue>
 #include <utility>
+#include <vector>
 
 #include "absl/log/absl_check.h"
+#include "absl/numeric/bits.h"
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/calculator_node.h"
 #include "mediapipe/framework/executor.h"
@@ -35,6 +40,20 @@
 namespace mediapipe {
 namespace internal {
 
+namespace {
+
+// SchedulerQueue::submit_state_ holds the running count in its upper 32 bits
+// and the number of tasks to add in its lower 32 bits.
+constexpr int64_t kRunningCountUnit = int64_t{1} << 32;
+
+int RunningCount(int64_t state) { return static_cast<int>(state >> 32); }
+
+int TasksToAdd(int64_t state) {
+  return static_cast<int>(state & (kRunningCountUnit - 1));
+}
+
+}  // namespace
+
 SchedulerQueue::Item::Item(CalculatorNode* node, CalculatorContext* cc)
     : node_(node), cc_(cc) {
   ABSL_CHECK(node);
@@ -88,24 +107,111 @@ bool SchedulerQueue::Item::operator<(const SchedulerQueue::Item& that) const {
 }
 
 void SchedulerQueue::Reset() {
-  absl::MutexLock lock(&mutex_);
-  num_pending_tasks_ = 0;
-  num_tasks_to_add_ = 0;
-  running_count_ = 0;
+  submit_state_.store(0);
+  num_pending_tasks_.store(0);
 }
 
-void SchedulerQueue::SetExecutor(Executor* executor) { executor_ = executor; }
+void SchedulerQueue::SetNumNodes(int num_nodes) {
+  if (num_nodes == num_nodes_) return;
+  ABSL_CHECK_EQ(num_queued_items_.load(), 0)
+      << "SetNumNodes must be called while the scheduler queue is empty.";
+  num_nodes_ = num_nodes;
+  num_buckets_ = 2 * num_nodes;
+  buckets_ = std::make_unique<Bucket[]>(num_buckets_);
+  num_occupancy_words_ = (num_buckets_ + 63) / 64;
+  occupancy_ =
+      std::make_unique<std::atomic<uint64_t>[]>(num_occupancy_words_);
+  for (int i = 0; i < num_occupancy_words_; ++i) {
+    occupancy_[i].store(0, std::memory_order_relaxed);
+  }
+  node_priorities_ = std::make_unique<std::atomic<int>[]>(num_nodes_);
+  SetNodePriorities({});
+}
 
-bool SchedulerQueue::IsIdle() {
-  VLOG(3) << "Scheduler queue empty: " << queue_.empty()
-          << ", # of pending tasks: " << num_pending_tasks_;
-  return queue_.empty() && num_pending_tasks_ == 0;
+void SchedulerQueue::SetNodePriorities(const std::vector<int>& priorities) {
+  for (int id = 0; id < num_nodes_; ++id) {
+    const int priority =
+        id < static_cast<int>(priorities.size()) ? priorities[id] : id;
+    node_priorities_[id].store(priority, std::memory_order_relaxed);
+  }
 }
 
+void SchedulerQueue::SetExecutor(Executor* executor) { executor_ = executor; }
+
 void SchedulerQueue::SetRunning(bool running) {
-  absl::MutexLock lock(&mutex_);
-  running_count_ += running ? 1 : -1;
-  ABSL_DCHECK_LE(running_count_, 1);
+  const int64_t delta = running ? kRunningCountUnit : -kRunningCountUnit;
+  const int64_t state = submit_state_.fetch_add(delta) + delta;
+  ABSL_DCHECK_LE(RunningCount(state), 1);
+}
+
+int SchedulerQueue::BucketIndex(const Item& item) const {
+  const int id = item.Id();
+  if (id < 0 || id >= num_nodes_) return -1;
+  // OpenNode() runs before ProcessNode(), lower ids first.
+  if (item.IsOpenNode()) return id;
+  // Sources are ordered by their SourceProcessOrder, which is only known at
+  // runtime, so they need the full comparison.
+  if (item.IsSource()) return -1;
+  // For non-sources, higher priorities run before lower priorities.
+  const int priority = node_priorities_[id].load(std::memory_order_relaxed);
+  if (priority < 0 || priority >= num_nodes_) return -1;
+  return num_nodes_ + (num_nodes_ - 1 - priority);
+}
+
+void SchedulerQueue::PushItem(Item&& item) {
+  const int index = BucketIndex(item);
+  if (index < 0) {
+    absl::MutexLock lock(&fallback_mutex_);
+    fallback_queue_.push(std::move(item));
+    fallback_size_.fetch_add(1);
+  } else {
+    Bucket& bucket = buckets_[index];
+    absl::MutexLock lock(&bucket.mutex);
+    bucket.items.push_back(std::move(item));
+    occupancy_[index / 64].fetch_or(uint64_t{1} << (index % 64));
+  }
+  num_queued_items_.fetch_add(1);
+}
+
+std::optional<SchedulerQueue::Item> SchedulerQueue::TryPopFromBucket(
+    int index) {
+  Bucket& bucket = buckets_[index];
+  absl::MutexLock lock(&bucket.mutex);
+  if (bucket.items.empty()) return std::nullopt;
+  Item item = std::move(bucket.items.front());
+  bucket.items.pop_front();
+  if (bucket.items.empty()) {
+    occupancy_[index / 64].fetch_and(~(uint64_t{1} << (index % 64)));
+  }
+  return item;
+}
+
+std::optional<SchedulerQueue::Item> SchedulerQueue::TryPopFromFallbackQueue() {
+  absl::MutexLock lock(&fallback_mutex_);
+  if (fallback_queue_.empty()) return std::nullopt;
+  Item item = fallback_queue_.top();
+  fallback_queue_.pop();
+  fallback_size_.fetch_sub(1);
+  return item;
+}
+
+SchedulerQueue::Item SchedulerQueue::PopItem() {
+  // The caller has claimed one of the stored items, so this terminates. A
+  // scan can miss an item that is pushed concurrently into a bucket that was
+  // already visited; in that case we simply scan again.
+  while (true) {
+    for (int word = 0; word < num_occupancy_words_; ++word) {
+      uint64_t bits = occupancy_[word].load();
+      while (bits != 0) {
+        const int index = word * 64 + absl::countr_zero(bits);
+        if (auto item = TryPopFromBucket(index)) return *std::move(item);
+        bits &= bits - 1;
+      }
+    }
+    if (fallback_size_.load() > 0) {
+      if (auto item = TryPopFromFallbackQueue()) return *std::move(item);
+    }
+  }
 }
 
 void SchedulerQueue::AddNode(CalculatorNode* node, CalculatorContext* cc) {
@@ -133,21 +239,15 @@ void SchedulerQueue::AddNodeForOpen(CalculatorNode* node) {
 
 void SchedulerQueue::AddItemToQueue(Item&& item) {
   const CalculatorNode* node = item.Node();
-  bool was_idle;
-  int tasks_to_add = 0;
-  {
-    absl::MutexLock lock(&mutex_);
-    was_idle = IsIdle();
-    queue_.push(item);
-    ++num_tasks_to_add_;
-    VLOG(4) << node->DebugName() << " was added to the scheduler queue.";
-
-    // Now grab the tasks to execute while still holding the lock. This will
-    // gather any waiting tasks, in addition to the one we just added.
-    if (running_count_ > 0) {
-      tasks_to_add = GetTasksToSubmitToExecutor();
-    }
-  }
+  // Count the item before it becomes visible, so that its completion can never
+  // be observed before its addition.
+  const bool was_idle = num_outstanding_items_.fetch_add(1) == 0;
+  PushItem(std::move(item));
+  VLOG(4) << node->DebugName() << " was added to the scheduler queue.";
+
+  // Now grab the tasks to execute. This will gather any waiting tasks, in
+  // addition to the one we just added.
+  const int tasks_to_add = GetTasksToSubmitToExecutor(/*num_new_tasks=*/1);
   if (was_idle && idle_callback_) {
     // Became not idle.
     idle_callback_(false);
@@ -156,55 +256,71 @@ void SchedulerQueue::AddItemToQueue(Item&& item) {
   // This ensures that we never get an idle_callback_(true) that is not
   // preceded by the corresponding idle_callback_(false). See the comments on
   // SetIdleCallback for details.
-  while (tasks_to_add > 0) {
-    executor_->AddTask(this);
-    --tasks_to_add;
+  SubmitTasks(tasks_to_add);
+}
+
+void SchedulerQueue::BeginExternalWork() {
+  const bool was_idle = num_outstanding_items_.fetch_add(1) == 0;
+  if (was_idle && idle_callback_) {
+    // Became not idle.
+    idle_callback_(false);
   }
 }
 
-int SchedulerQueue::GetTasksToSubmitToExecutor() {
-  int tasks_to_add = num_tasks_to_add_;
-  num_tasks_to_add_ = 0;
-  num_pending_tasks_ += tasks_to_add;
+void SchedulerQueue::EndExternalWork() {
+  const bool is_idle = num_outstanding_items_.fetch_sub(1) == 1;
+  if (is_idle && idle_callback_) {
+    // Became idle.
+    idle_callback_(true);
+  }
+}
+
+int SchedulerQueue::GetTasksToSubmitToExecutor(int num_new_tasks) {
+  int64_t state = submit_state_.load();
+  int tasks_to_add;
+  while (true) {
+    int64_t new_state;
+    if (RunningCount(state) > 0) {
+      tasks_to_add = TasksToAdd(state) + num_new_tasks;
+      new_state = state - TasksToAdd(state);
+    } else {
+      tasks_to_add = 0;
+      new_state = state + num_new_tasks;
+    }
+    if (new_state == state ||
+        submit_state_.compare_exchange_weak(state, new_state)) {
+      break;
+    }
+  }
+  num_pending_tasks_.fetch_add(tasks_to_add);
   return tasks_to_add;
 }
 
+void SchedulerQueue::SubmitTasks(int num_tasks) {
+  while (num_tasks > 0) {
+    executor_->AddTask(this);
+    --num_tasks;
+  }
+}
+
 void SchedulerQueue::SubmitWaitingTasksToExecutor() {
   // If a node is added to the scheduler queue while the queue is not running,
   // we do not immediately submit tasks to the executor. Here we check for any
   // such waiting tasks, and submit them.
-  int tasks_to_add = 0;
-  {
-    absl::MutexLock lock(&mutex_);
-    if (running_count_ > 0) {
-      tasks_to_add = GetTasksToSubmitToExecutor();
-    }
-  }
-  while (tasks_to_add > 0) {
-    executor_->AddTask(this);
-    --tasks_to_add;
-  }
+  SubmitTasks(GetTasksToSubmitToExecutor(/*num_new_tasks=*/0));
 }
 
 void SchedulerQueue::RunNextTask() {
-  CalculatorNode* node;
-  CalculatorContext* calculator_context;
-  bool is_open_node;
-  {
-    absl::MutexLock lock(&mutex_);
-
-    ABSL_CHECK(!queue_.empty())
-        << "Called RunNextTask when the queue is empty. "
-           "This should not happen.";
-
-    node = queue_.top().Node();
-    calculator_context = queue_.top().Context();
-    is_open_node = queue_.top().IsOpenNode();
-    queue_.pop();
-
-    ABSL_CHECK(!node->Closed())
-        << "Scheduled a node that was closed. This should not happen.";
-  }
+  const int num_queued_items = num_queued_items_.fetch_sub(1);
+  ABSL_CHECK_GT(num_queued_items, 0)
+      << "Called RunNextTask when the queue is empty. "
+         "This should not happen.";
+  const Item item = PopItem();
+  CalculatorNode* node = item.Node();
+  CalculatorContext* calculator_context = item.Context();
+  const bool is_open_node = item.IsOpenNode();
+  ABSL_CHECK(!node->Closed())
+      << "Scheduled a node that was closed. This should not happen.";
 
   // On iOS, calculators may rely on the existence of an autorelease pool
   // (either directly, or because system code they call does). We do not
@@ -220,13 +336,11 @@ void SchedulerQueue::RunNextTask() {
     }
   }
 
-  bool is_idle;
-  {
-    absl::MutexLock lock(&mutex_);
-    ABSL_DCHECK_GT(num_pending_tasks_, 0);
-    --num_pending_tasks_;
-    is_idle = IsIdle();
-  }
+  const int num_pending_tasks = num_pending_tasks_.fetch_sub(1);
+  ABSL_DCHECK_GT(num_pending_tasks, 0);
+  const bool is_idle = num_outstanding_items_.fetch_sub(1) == 1;
+  VLOG(3) << "Scheduler queue idle: " << is_idle
+          << ", # of pending tasks: " << num_pending_tasks - 1;
   if (is_idle && idle_callback_) {
     // Became idle.
     idle_callback_(true);
@@ -297,17 +411,26 @@ void SchedulerQueue::OpenCalculatorNode(CalculatorNode* node) {
 }
 
 void SchedulerQueue::CleanupAfterRun() {
-  bool was_idle;
+  ABSL_CHECK_EQ(num_pending_tasks_.load(), 0);
+  const int64_t state = submit_state_.load();
+  ABSL_CHECK_EQ(TasksToAdd(state), num_queued_items_.load());
+  submit_state_.store(state - TasksToAdd(state));
+  for (int i = 0; i < num_buckets_; ++i) {
+    absl::MutexLock lock(&buckets_[i].mutex);
+    buckets_[i].items.clear();
+  }
+  for (int i = 0; i < num_occupancy_words_; ++i) {
+    occupancy_[i].store(0);
+  }
   {
-    absl::MutexLock lock(&mutex_);
-    was_idle = IsIdle();
-    ABSL_CHECK_EQ(num_pending_tasks_, 0);
-    ABSL_CHECK_EQ(num_tasks_to_add_, queue_.size());
-    num_tasks_to_add_ = 0;
-    while (!queue_.empty()) {
-      queue_.pop();
+    absl::MutexLock lock(&fallback_mutex_);
+    while (!fallback_queue_.empty()) {
+      fallback_queue_.pop();
     }
+    fallback_size_.store(0);
   }
+  num_queued_items_.store(0);
+  const bool was_idle = num_outstanding_items_.exchange(0) == 0;
   if (!was_idle && idle_callback_) {
     // Became idle.
     idle_callback_(true);
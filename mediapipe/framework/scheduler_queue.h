@@ -17,12 +17,16 @@
 
 #include <atomic>
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <queue>
 #include <utility>
+#include <vector>
 
 #include "absl/base/macros.h"
+#include "absl/base/thread_annotations.h"
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/calculator_context.h"
 #include "mediapipe/framework/executor.h"
@@ -35,6 +39,13 @@ class CalculatorNode;
 namespace internal {
 
 // Manages a priority queue of nodes to be run on the associated executor.
+//
+// The queue is designed for concurrent access from all the executor threads
+// without a queue-wide lock: the idle and task bookkeeping uses atomics, and
+// ready items are kept in per-node buckets located through an occupancy
+// bitmap. Only source nodes, which need the full Item::operator< ordering, go
+// through a small mutex-guarded priority queue. Under concurrency the
+// priority order is best effort; with a single thread it is exact.
 class SchedulerQueue : public TaskQueue {
  public:
   // Callback to be invoked when the queue's idle state changes.
@@ -55,6 +66,10 @@ class SchedulerQueue : public TaskQueue {
 
     bool IsOpenNode() const { return is_open_node_; }
 
+    bool IsSource() const { return is_source_; }
+
+    int Id() const { return id_; }
+
     // This comparison is meant to be used with a std::priority_queue. Since
     // the priority queue returns higher priority items first, this function
     // means "this is lower priority than that", i.e. "this runs after that".
@@ -99,75 +114,149 @@ class SchedulerQueue : public TaskQueue {
   // Resets the data members at the beginning of each graph run.
   void Reset();
 
+  // Sizes the per-node buckets for node ids in [0, num_nodes). Must be called
+  // while the queue is empty, before any node is added for the run. Items of
+  // nodes with larger ids are still accepted, but fall back to a locked
+  // priority queue.
+  void SetNumNodes(int num_nodes);
+
+  // Sets the priority of the non-source nodes, indexed by node id: nodes with
+  // higher priorities run first. The priorities should be distinct, and nodes
+  // without a priority use their id. An empty vector restores the default
+  // order, in which larger ids run first. Nodes without a bucket keep the
+  // Item::operator< order.
+  //
+  // Can be called while nodes are being added and run: the items already in
+  // the queue keep their place, and the new priorities apply to the items
+  // added afterwards. Nodes briefly sharing a priority during the update run
+  // in the order in which they were added.
+  void SetNodePriorities(const std::vector<int>& priorities);
+
   // Implements the TaskQueue interface.
   void RunNextTask() override;
 
   // NOTE: After calling SetRunning(true), the caller must call
   // SubmitWaitingTasksToExecutor since tasks may have been added while the
   // queue was not running.
-  void SetRunning(bool running) ABSL_LOCKS_EXCLUDED(mutex_);
-
-  // Gets the number of tasks that need to be submitted to the executor, and
-  // updates num_pending_tasks_. If this method is called and returns a
-  // non-zero value, the executor's AddTask method *must* be called for each
-  // task returned, but it can be called without holding the lock.
-  int GetTasksToSubmitToExecutor() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void SetRunning(bool running);
 
   // Submits tasks that are waiting (e.g. that were added while the queue was
   // not running) if the queue is running. The caller must not hold any mutex.
-  void SubmitWaitingTasksToExecutor() ABSL_LOCKS_EXCLUDED(mutex_);
+  void SubmitWaitingTasksToExecutor();
 
   // Adds a node and a calculator context to the scheduler queue if the node is
   // not already running. Note that if the node was running, then it will be
   // rescheduled upon completion (after checking dependencies), so this call is
   // not lost.
-  void AddNode(CalculatorNode* node, CalculatorContext* cc)
-      ABSL_LOCKS_EXCLUDED(mutex_);
+  void AddNode(CalculatorNode* node, CalculatorContext* cc);
 
   // Adds a node to the scheduler queue for an OpenNode() call.
-  void AddNodeForOpen(CalculatorNode* node) ABSL_LOCKS_EXCLUDED(mutex_);
+  void AddNodeForOpen(CalculatorNode* node);
 
-  // Adds an Item to queue_.
+  // Adds an Item to the queue.
   void AddItemToQueue(Item&& item);
 
-  void CleanupAfterRun() ABSL_LOCKS_EXCLUDED(mutex_);
+  // Keeps the queue from becoming idle while a thread other than the executor
+  // threads may add items to it, e.g. a timer that schedules a node. Each call
+  // must be matched by a call to EndExternalWork().
+  void BeginExternalWork();
+  void EndExternalWork();
+
+  void CleanupAfterRun();
 
  private:
+  // A FIFO of the ready items for one node and one kind of task (OpenNode()
+  // or ProcessNode()). Most buckets hold at most one item, since a node is
+  // only queued again while running if it runs in parallel.
+  struct alignas(64) Bucket {
+    absl::Mutex mutex;
+    std::deque<Item> items ABSL_GUARDED_BY(mutex);
+  };
+
   // Used internally by RunNextTask. Invokes ProcessNode or CloseNode, followed
   // by EndScheduling.
-  void RunCalculatorNode(CalculatorNode* node, CalculatorContext* cc)
-      ABSL_LOCKS_EXCLUDED(mutex_);
+  void RunCalculatorNode(CalculatorNode* node, CalculatorContext* cc);
 
   // Used internally by RunNextTask. Invokes OpenNode, followed by
   // CheckIfBecameReady.
-  void OpenCalculatorNode(CalculatorNode* node) ABSL_LOCKS_EXCLUDED(mutex_);
+  void OpenCalculatorNode(CalculatorNode* node);
+
+  // Returns the bucket index for "item", or -1 if the item belongs in
+  // fallback_queue_. Bucket indices are ordered by priority: OpenNode() items
+  // by increasing node id, then non-source ProcessNode() items by decreasing
+  // node priority, which is the node id by default, matching
+  // Item::operator<.
+  int BucketIndex(const Item& item) const;
 
-  // Checks whether the queue has no queued nodes or pending tasks.
-  bool IsIdle() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Stores "item" in its bucket or in fallback_queue_.
+  void PushItem(Item&& item);
+
+  // Removes the highest priority item that can be found. The caller must have
+  // claimed an item by decrementing num_queued_items_.
+  Item PopItem();
+
+  // Tries to pop an item from the bucket at "index". Clears the occupancy bit
+  // when the bucket becomes empty.
+  std::optional<Item> TryPopFromBucket(int index);
+
+  // Tries to pop the top item of fallback_queue_.
+  std::optional<Item> TryPopFromFallbackQueue();
+
+  // Grabs the tasks waiting to be submitted if the queue is running.
+  // "num_new_tasks" tasks are added to the returned count. The executor's
+  // AddTask method *must* be called once for each task returned.
+  int GetTasksToSubmitToExecutor(int num_new_tasks);
+
+  // Calls executor_->AddTask() "num_tasks" times.
+  void SubmitTasks(int num_tasks);
 
   Executor* executor_ = nullptr;
 
   IdleCallback idle_callback_;
 
-  // The net number of times SetRunning(true) has been called.
-  // SetRunning(true) increments running_count_ and SetRunning(false)
-  // decrements it. The queue is running if running_count_ > 0. A running
-  // queue will submit tasks to the executor.
-  // Invariant: running_count_ <= 1.
-  int running_count_ ABSL_GUARDED_BY(mutex_) = 0;
+  // Packs the running count (upper 32 bits) and the number of tasks that need
+  // to be added to the Executor (lower 32 bits), so that adding an item and
+  // starting the queue cannot race and lose a task.
+  //
+  // The running count is the net number of times SetRunning(true) has been
+  // called: SetRunning(true) increments it and SetRunning(false) decrements
+  // it. The queue is running if the count is > 0. A running queue will submit
+  // tasks to the executor. Invariant: running count <= 1.
+  std::atomic<int64_t> submit_state_{0};
 
   // Number of tasks added to the Executor and not yet complete.
-  int num_pending_tasks_ ABSL_GUARDED_BY(mutex_);
-
-  // Number of tasks that need to be added to the Executor.
-  int num_tasks_to_add_ ABSL_GUARDED_BY(mutex_);
-
-  // Queue of nodes that need to be run.
-  std::priority_queue<Item> queue_ ABSL_GUARDED_BY(mutex_);
+  std::atomic<int> num_pending_tasks_{0};
+
+  // Number of items added and not yet run (or dropped by CleanupAfterRun).
+  // The queue is idle iff this is zero, so its 0 <-> 1 transitions drive the
+  // idle callback.
+  std::atomic<int> num_outstanding_items_{0};
+
+  // Number of items stored and not yet claimed by RunNextTask. Incremented
+  // after an item is stored and decremented before one is removed, so it
+  // never exceeds the number of stored items.
+  std::atomic<int> num_queued_items_{0};
+
+  // Buckets of ready items, see BucketIndex.
+  int num_nodes_ = 0;
+  int num_buckets_ = 0;
+  std::unique_ptr<Bucket[]> buckets_;
+  // Bit i is set while bucket i may be non-empty. Lets RunNextTask find the
+  // highest priority bucket without touching the empty ones.
+  std::unique_ptr<std::atomic<uint64_t>[]> occupancy_;
+  int num_occupancy_words_ = 0;
+  // The priority of every node, see SetNodePriorities. Atomic so that the
+  // priorities can be updated while items are pushed.
+  std::unique_ptr<std::atomic<int>[]> node_priorities_;
+
+  // Items that need the full Item::operator< ordering: source nodes (whose
+  // priority depends on their SourceProcessOrder) and nodes without a bucket.
+  absl::Mutex fallback_mutex_;
+  std::priority_queue<Item> fallback_queue_ ABSL_GUARDED_BY(fallback_mutex_);
+  // Size of fallback_queue_, readable without fallback_mutex_.
+  std::atomic<int> fallback_size_{0};
 
   SchedulerShared* const shared_;
-
-  absl::Mutex mutex_;
 };
 
 }  // namespace internal
@@ -0,0 +1,111 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Benchmark for SchedulerQueue. Runs graphs of trivial nodes, so that the
+// time is dominated by scheduling: each iteration schedules
+// num_nodes * kNumPackets node invocations (one million for 100 nodes).
+//
+// $ bazel run -c opt mediapipe/framework:scheduler_queue_benchmark
+#include <string>
+
+#include "absl/log/absl_check.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/thread_pool_executor.pb.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr int kNumPackets = 10000;
+
+// Adds the default executor with "num_threads" threads to "config".
+void SetNumThreads(int num_threads, CalculatorGraphConfig* config) {
+  config->add_executor()
+      ->mutable_options()
+      ->MutableExtension(ThreadPoolExecutorOptions::ext)
+      ->set_num_threads(num_threads);
+}
+
+// A linear chain of "num_nodes" PassThroughCalculators.
+CalculatorGraphConfig ChainConfig(int num_nodes) {
+  CalculatorGraphConfig config;
+  config.add_input_stream("s0");
+  for (int i = 0; i < num_nodes; ++i) {
+    auto* node = config.add_node();
+    node->set_calculator("PassThroughCalculator");
+    node->add_input_stream(absl::StrCat("s", i));
+    node->add_output_stream(absl::StrCat("s", i + 1));
+  }
+  return config;
+}
+
+// "num_nodes" PassThroughCalculators all reading the graph input stream.
+CalculatorGraphConfig FanOutConfig(int num_nodes) {
+  CalculatorGraphConfig config;
+  config.add_input_stream("in");
+  for (int i = 0; i < num_nodes; ++i) {
+    auto* node = config.add_node();
+    node->set_calculator("PassThroughCalculator");
+    node->add_input_stream("in");
+    node->add_output_stream(absl::StrCat("out_", i));
+  }
+  return config;
+}
+
+void RunGraph(benchmark::State& state, const CalculatorGraphConfig& config) {
+  for (auto _ : state) {
+    CalculatorGraph graph;
+    ABSL_CHECK_OK(graph.Initialize(config));
+    ABSL_CHECK_OK(graph.StartRun({}));
+    for (int t = 0; t < kNumPackets; ++t) {
+      ABSL_CHECK_OK(graph.AddPacketToInputStream(
+          config.input_stream(0), MakePacket<int>(t).At(Timestamp(t))));
+    }
+    ABSL_CHECK_OK(graph.CloseAllInputStreams());
+    ABSL_CHECK_OK(graph.WaitUntilDone());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumPackets *
+                          config.node_size());
+}
+
+// Args: number of nodes, number of threads.
+void BM_ScheduleChain(benchmark::State& state) {
+  CalculatorGraphConfig config = ChainConfig(state.range(0));
+  SetNumThreads(state.range(1), &config);
+  RunGraph(state, config);
+}
+BENCHMARK(BM_ScheduleChain)
+    ->Args({100, 1})
+    ->Args({100, 4})
+    ->Args({100, 16})
+    ->UseRealTime();
+
+// Args: number of nodes, number of threads.
+void BM_ScheduleFanOut(benchmark::State& state) {
+  CalculatorGraphConfig config = FanOutConfig(state.range(0));
+  SetNumThreads(state.range(1), &config);
+  RunGraph(state, config);
+}
+BENCHMARK(BM_ScheduleFanOut)
+    ->Args({100, 1})
+    ->Args({100, 4})
+    ->Args({100, 16})
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace mediapipe
+
+BENCHMARK_MAIN();
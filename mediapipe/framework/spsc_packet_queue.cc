@@ -0,0 +1,133 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/spsc_packet_queue.h"
+
+#include <utility>
+
+namespace mediapipe {
+
+SpscPacketQueue::SpscPacketQueue() {
+  chunks_.push_back(std::make_unique<Chunk>());
+  head_chunk_.store(chunks_.back().get(), std::memory_order_relaxed);
+  tail_chunk_ = chunks_.back().get();
+}
+
+SpscPacketQueue::~SpscPacketQueue() = default;
+
+int SpscPacketQueue::Push(Packet packet) {
+  if (tail_index_ == kChunkSize) {
+    Chunk* chunk = NewChunk();
+    // Published to the consumer by the increment of size_ below.
+    tail_chunk_->next.store(chunk, std::memory_order_relaxed);
+    tail_chunk_ = chunk;
+    tail_index_ = 0;
+  }
+  tail_chunk_->timestamps[tail_index_].store(packet.Timestamp().Value(),
+                                             std::memory_order_relaxed);
+  tail_chunk_->packets[tail_index_] = std::move(packet);
+  ++tail_index_;
+  return size_.fetch_add(1) + 1;
+}
+
+const Packet& SpscPacketQueue::Front() {
+  AdvanceHeadChunk();
+  return head_chunk_.load(std::memory_order_relaxed)
+      ->packets[head_index_.load(std::memory_order_relaxed)];
+}
+
+Packet SpscPacketQueue::Pop(int* size) {
+  AdvanceHeadChunk();
+  Chunk* chunk = head_chunk_.load(std::memory_order_relaxed);
+  const int index = head_index_.load(std::memory_order_relaxed);
+  Packet packet = std::move(chunk->packets[index]);
+  head_index_.store(index + 1, std::memory_order_relaxed);
+  *size = size_.fetch_sub(1) - 1;
+  return packet;
+}
+
+Timestamp SpscPacketQueue::FrontTimestamp() const {
+  if (size_.load() == 0) {
+    return Timestamp::Unset();
+  }
+  // Other threads may see the consumer position in the middle of an update,
+  // in which case they read a stale timestamp. The chunk stays valid since
+  // chunks are not freed while the queue is in use.
+  const Chunk* chunk = head_chunk_.load(std::memory_order_acquire);
+  int index = head_index_.load(std::memory_order_relaxed);
+  if (index == kChunkSize) {
+    chunk = chunk->next.load(std::memory_order_acquire);
+    index = 0;
+    if (chunk == nullptr) {
+      return Timestamp::Unset();
+    }
+  }
+  return Timestamp::CreateNoErrorChecking(
+      chunk->timestamps[index].load(std::memory_order_relaxed));
+}
+
+void SpscPacketQueue::Clear() {
+  Chunk* first = chunks_.front().get();
+  Chunk* free_chunks = nullptr;
+  for (auto& chunk : chunks_) {
+    for (Packet& packet : chunk->packets) {
+      packet = Packet();
+    }
+    chunk->next.store(nullptr, std::memory_order_relaxed);
+    if (chunk.get() != first) {
+      chunk->next_free = free_chunks;
+      free_chunks = chunk.get();
+    }
+  }
+  free_chunks_.store(free_chunks, std::memory_order_relaxed);
+  head_chunk_.store(first, std::memory_order_relaxed);
+  head_index_.store(0, std::memory_order_relaxed);
+  tail_chunk_ = first;
+  tail_index_ = 0;
+  size_.store(0);
+}
+
+SpscPacketQueue::Chunk* SpscPacketQueue::NewChunk() {
+  Chunk* chunk = free_chunks_.load(std::memory_order_acquire);
+  while (chunk != nullptr &&
+         !free_chunks_.compare_exchange_weak(chunk, chunk->next_free,
+                                             std::memory_order_acquire)) {
+  }
+  if (chunk == nullptr) {
+    chunks_.push_back(std::make_unique<Chunk>());
+    return chunks_.back().get();
+  }
+  chunk->next.store(nullptr, std::memory_order_relaxed);
+  return chunk;
+}
+
+void SpscPacketQueue::AdvanceHeadChunk() {
+  if (head_index_.load(std::memory_order_relaxed) < kChunkSize) {
+    return;
+  }
+  Chunk* chunk = head_chunk_.load(std::memory_order_relaxed);
+  // Not null, since the queue is not empty and the producer links the next
+  // chunk before it increments size_.
+  Chunk* next = chunk->next.load(std::memory_order_relaxed);
+  head_chunk_.store(next, std::memory_order_release);
+  head_index_.store(0, std::memory_order_relaxed);
+  // Hands the chunk, whose packets have all been moved out, to the producer.
+  chunk->next_free = free_chunks_.load(std::memory_order_relaxed);
+  while (!free_chunks_.compare_exchange_weak(chunk->next_free, chunk,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed)) {
+  }
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,109 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_SPSC_PACKET_QUEUE_H_
+#define MEDIAPIPE_FRAMEWORK_SPSC_PACKET_QUEUE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/timestamp.h"
+
+namespace mediapipe {
+
+// An unbounded lock-free FIFO queue of packets with a single producer thread
+// and a single consumer thread.
+//
+// Packets are stored in fixed-size chunks that form a linked list. When the
+// consumer has read a chunk, it hands the chunk back to the producer for
+// reuse, so that a queue in steady state doesn't allocate. Chunks are only
+// freed by Clear() and the destructor, which lets any thread read the size
+// and the front timestamp of the queue while it is in use.
+//
+// "Single producer" and "single consumer" mean that the calls to the
+// respective functions are serialized, not that they happen on the same
+// thread.
+class SpscPacketQueue {
+ public:
+  SpscPacketQueue();
+  SpscPacketQueue(const SpscPacketQueue&) = delete;
+  SpscPacketQueue& operator=(const SpscPacketQueue&) = delete;
+  ~SpscPacketQueue();
+
+  // Appends "packet" and returns the size of the queue after the push.
+  // Must only be called by the producer.
+  int Push(Packet packet);
+
+  // Returns the packet at the front of the queue. Must only be called by the
+  // consumer. REQUIRES: Size() > 0.
+  const Packet& Front();
+
+  // Removes and returns the packet at the front of the queue, and sets "size"
+  // to the size of the queue after the pop. Must only be called by the
+  // consumer. REQUIRES: Size() > 0.
+  Packet Pop(int* size);
+
+  // Returns the number of packets in the queue. May be called on any thread.
+  int Size() const { return size_.load(); }
+
+  // Returns the timestamp of the packet at the front of the queue, or
+  // Timestamp::Unset() if the queue is empty. May be called on any thread,
+  // but the result is only exact when called by the consumer.
+  Timestamp FrontTimestamp() const;
+
+  // Removes all packets. REQUIRES: no concurrent access.
+  void Clear();
+
+ private:
+  static constexpr int kChunkSize = 32;
+
+  struct Chunk {
+    Packet packets[kChunkSize];
+    // The timestamps of the packets, which are read by FrontTimestamp()
+    // without synchronizing with the consumer.
+    std::atomic<int64_t> timestamps[kChunkSize];
+    std::atomic<Chunk*> next{nullptr};
+    // The next chunk in free_chunks_.
+    Chunk* next_free = nullptr;
+  };
+
+  // Returns an empty chunk for the producer, reusing one released by the
+  // consumer if possible.
+  Chunk* NewChunk();
+
+  // Moves the consumer to the next chunk if it has read the current one.
+  void AdvanceHeadChunk();
+
+  // The consumer position. Also read by FrontTimestamp().
+  alignas(64) std::atomic<Chunk*> head_chunk_;
+  std::atomic<int> head_index_{0};
+
+  // The producer position.
+  alignas(64) Chunk* tail_chunk_;
+  int tail_index_ = 0;
+  // Owns all chunks. Only modified by the producer.
+  std::vector<std::unique_ptr<Chunk>> chunks_;
+
+  alignas(64) std::atomic<int> size_{0};
+  // A stack of chunks released by the consumer. Since only the producer pops
+  // from it, it isn't subject to the ABA problem.
+  std::atomic<Chunk*> free_chunks_{nullptr};
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_SPSC_PACKET_QUEUE_H_
@@ -0,0 +1,104 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/spsc_packet_queue.h"
+
+#include <thread>  // NOLINT(build/c++11)
+
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/timestamp.h"
+
+namespace mediapipe {
+namespace {
+
+TEST(SpscPacketQueueTest, PushAndPop) {
+  SpscPacketQueue queue;
+  EXPECT_EQ(queue.Size(), 0);
+  EXPECT_EQ(queue.FrontTimestamp(), Timestamp::Unset());
+
+  EXPECT_EQ(queue.Push(MakePacket<int>(1).At(Timestamp(10))), 1);
+  EXPECT_EQ(queue.Push(MakePacket<int>(2).At(Timestamp(20))), 2);
+  EXPECT_EQ(queue.FrontTimestamp(), Timestamp(10));
+  EXPECT_EQ(queue.Front().Get<int>(), 1);
+
+  int size;
+  Packet packet = queue.Pop(&size);
+  EXPECT_EQ(size, 1);
+  EXPECT_EQ(packet.Get<int>(), 1);
+  EXPECT_EQ(packet.Timestamp(), Timestamp(10));
+  EXPECT_EQ(queue.FrontTimestamp(), Timestamp(20));
+  packet = queue.Pop(&size);
+  EXPECT_EQ(size, 0);
+  EXPECT_EQ(packet.Get<int>(), 2);
+  EXPECT_EQ(queue.FrontTimestamp(), Timestamp::Unset());
+}
+
+// Grows across many chunks, then drains and refills the queue so that the
+// chunks are reused.
+TEST(SpscPacketQueueTest, SpansChunks) {
+  SpscPacketQueue queue;
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 1000; ++i) {
+      EXPECT_EQ(queue.Push(MakePacket<int>(i).At(Timestamp(i))), i + 1);
+    }
+    for (int i = 0; i < 1000; ++i) {
+      ASSERT_EQ(queue.FrontTimestamp(), Timestamp(i));
+      int size;
+      ASSERT_EQ(queue.Pop(&size).Get<int>(), i);
+      ASSERT_EQ(size, 999 - i);
+    }
+  }
+}
+
+TEST(SpscPacketQueueTest, ClearReleasesPackets) {
+  SpscPacketQueue queue;
+  Packet packet = MakePacket<int>(7);
+  for (int i = 0; i < 100; ++i) {
+    queue.Push(packet.At(Timestamp(i)));
+  }
+  queue.Clear();
+  EXPECT_EQ(queue.Size(), 0);
+  EXPECT_EQ(queue.FrontTimestamp(), Timestamp::Unset());
+  // Only "packet" still refers to the payload.
+  EXPECT_TRUE(packet.Consume<int>().ok());
+
+  queue.Push(MakePacket<int>(8).At(Timestamp(1)));
+  EXPECT_EQ(queue.Front().Get<int>(), 8);
+}
+
+TEST(SpscPacketQueueTest, ConcurrentProducerAndConsumer) {
+  constexpr int kNumPackets = 100000;
+  SpscPacketQueue queue;
+  std::thread producer([&queue] {
+    for (int i = 0; i < kNumPackets; ++i) {
+      queue.Push(MakePacket<int>(i).At(Timestamp(i)));
+    }
+  });
+  for (int i = 0; i < kNumPackets; ++i) {
+    while (queue.Size() == 0) {
+      std::this_thread::yield();
+    }
+    ASSERT_EQ(queue.FrontTimestamp(), Timestamp(i));
+    int size;
+    Packet packet = queue.Pop(&size);
+    ASSERT_EQ(packet.Get<int>(), i);
+    ASSERT_EQ(packet.Timestamp(), Timestamp(i));
+  }
+  producer.join();
+  EXPECT_EQ(queue.Size(), 0);
+}
+
+}  // namespace
+}  // namespace mediapipe
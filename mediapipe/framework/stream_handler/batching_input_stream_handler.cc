@@ -0,0 +1,42 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/stream_handler/batching_input_stream_handler.h"
+
+#include <memory>
+#include <utility>
+
+#include "absl/time/time.h"
+#include "mediapipe/framework/input_stream_handler.h"
+#include "mediapipe/framework/stream_handler/batching_input_stream_handler.pb.h"
+
+namespace mediapipe {
+
+REGISTER_INPUT_STREAM_HANDLER(BatchingInputStreamHandler);
+
+BatchingInputStreamHandler::BatchingInputStreamHandler(
+    std::shared_ptr<tool::TagMap> tag_map, CalculatorContextManager* cc_manager,
+    const MediaPipeOptions& options, bool calculator_run_in_parallel)
+    : DefaultInputStreamHandler(std::move(tag_map), cc_manager, options,
+                                calculator_run_in_parallel) {
+  const auto& handler_options =
+      options.GetExtension(BatchingInputStreamHandlerOptions::ext);
+  SetBatchSize(handler_options.batch_size());
+  if (handler_options.max_batch_delay_us() > 0) {
+    SetMaxBatchDelay(
+        absl::Microseconds(handler_options.max_batch_delay_us()));
+  }
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,72 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_STREAM_HANDLER_BATCHING_INPUT_STREAM_HANDLER_H_
+#define MEDIAPIPE_FRAMEWORK_STREAM_HANDLER_BATCHING_INPUT_STREAM_HANDLER_H_
+
+#include <memory>
+
+#include "mediapipe/framework/calculator_context_manager.h"
+#include "mediapipe/framework/mediapipe_options.pb.h"
+#include "mediapipe/framework/stream_handler/default_input_stream_handler.h"
+#include "mediapipe/framework/tool/tag_map.h"
+
+namespace mediapipe {
+
+// Input stream handler that collects up to batch_size input sets, with the
+// same synchronization as DefaultInputStreamHandler, and then calls the
+// calculator's Process() for all of them in a row. The calculator can process
+// the batch as a whole by checking CalculatorContext::IsLastInBatch(), and
+// should output packets at the timestamps of the input sets they belong to.
+//
+// To bound the latency, an incomplete batch is processed once its first input
+// set has waited for max_batch_delay_us. For example, the following node runs
+// inference on up to 4 frames at a time, which wait at most 10 ms:
+//
+// node {
+//   calculator: "InferenceCalculator"
+//   input_stream: "TENSORS:input_tensors"
+//   output_stream: "TENSORS:output_tensors"
+//   input_stream_handler {
+//     input_stream_handler: "BatchingInputStreamHandler"
+//     options: {
+//       [mediapipe.BatchingInputStreamHandlerOptions.ext]: {
+//         batch_size: 4
+//         max_batch_delay_us: 10000
+//       }
+//     }
+//   }
+//   options: {
+//     [mediapipe.InferenceCalculatorOptions.ext] {
+//       model_path: "model.tflite"
+//       batch_across_timestamps: true
+//     }
+//   }
+// }
+//
+// Since the timestamp bounds of the output streams only advance when the batch
+// has been processed, the calculator must not set a timestamp offset.
+// Batching cannot be combined with parallel execution.
+class BatchingInputStreamHandler : public DefaultInputStreamHandler {
+ public:
+  BatchingInputStreamHandler() = delete;
+  BatchingInputStreamHandler(std::shared_ptr<tool::TagMap> tag_map,
+                             CalculatorContextManager* cc_manager,
+                             const MediaPipeOptions& options,
+                             bool calculator_run_in_parallel);
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_STREAM_HANDLER_BATCHING_INPUT_STREAM_HANDLER_H_
@@ -0,0 +1,176 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/substitute.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+// Collects the input packets of a batch, and outputs the size of the batch at
+// the timestamp of each of them once the batch is complete.
+class BatchSizeCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).SetAny();
+    cc->Outputs().Index(0).Set<int>();
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    timestamps_.push_back(cc->InputTimestamp());
+    if (!cc->IsLastInBatch()) {
+      return absl::OkStatus();
+    }
+    for (Timestamp timestamp : timestamps_) {
+      cc->Outputs().Index(0).AddPacket(
+          MakePacket<int>(timestamps_.size()).At(timestamp));
+    }
+    timestamps_.clear();
+    return absl::OkStatus();
+  }
+
+ private:
+  std::vector<Timestamp> timestamps_;
+};
+REGISTER_CALCULATOR(BatchSizeCalculator);
+
+CalculatorGraphConfig BatchingConfig(int batch_size, int max_batch_delay_us) {
+  return ParseTextProtoOrDie<CalculatorGraphConfig>(absl::Substitute(
+      R"pb(
+        input_stream: "input"
+        node {
+          calculator: "BatchSizeCalculator"
+          input_stream: "input"
+          output_stream: "output"
+          input_stream_handler {
+            input_stream_handler: "BatchingInputStreamHandler"
+            options: {
+              [mediapipe.BatchingInputStreamHandlerOptions.ext]: {
+                batch_size: $0
+                max_batch_delay_us: $1
+              }
+            }
+          }
+        }
+      )pb",
+      batch_size, max_batch_delay_us));
+}
+
+std::vector<int> BatchSizes(const std::vector<Packet>& packets) {
+  std::vector<int> result;
+  for (const Packet& packet : packets) {
+    result.push_back(packet.Get<int>());
+  }
+  return result;
+}
+
+TEST(BatchingInputStreamHandlerTest, ProcessesFullBatches) {
+  CalculatorGraphConfig config =
+      BatchingConfig(/*batch_size=*/3, /*max_batch_delay_us=*/0);
+  std::vector<Packet> output_packets;
+  tool::AddVectorSink("output", &config, &output_packets);
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun({}));
+
+  for (int i = 0; i < 7; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "input", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  MP_ASSERT_OK(graph.WaitUntilIdle());
+  EXPECT_THAT(BatchSizes(output_packets),
+              testing::ElementsAre(3, 3, 3, 3, 3, 3));
+
+  // The incomplete batch is processed when the node is closed.
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+  EXPECT_THAT(BatchSizes(output_packets),
+              testing::ElementsAre(3, 3, 3, 3, 3, 3, 1));
+  for (int i = 0; i < 7; ++i) {
+    EXPECT_EQ(output_packets[i].Timestamp(), Timestamp(i));
+  }
+}
+
+TEST(BatchingInputStreamHandlerTest, ProcessesIncompleteBatchAfterDelay) {
+  CalculatorGraphConfig config =
+      BatchingConfig(/*batch_size=*/4, /*max_batch_delay_us=*/20000);
+  std::vector<Packet> output_packets;
+  absl::Notification batch_processed;
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.ObserveOutputStream("output", [&](const Packet& packet) {
+    output_packets.push_back(packet);
+    if (output_packets.size() == 2) {
+      batch_processed.Notify();
+    }
+    return absl::OkStatus();
+  }));
+  MP_ASSERT_OK(graph.StartRun({}));
+
+  const absl::Time start_time = absl::Now();
+  MP_ASSERT_OK(graph.AddPacketToInputStream(
+      "input", MakePacket<int>(0).At(Timestamp(0))));
+  MP_ASSERT_OK(graph.AddPacketToInputStream(
+      "input", MakePacket<int>(1).At(Timestamp(1))));
+  ASSERT_TRUE(
+      batch_processed.WaitForNotificationWithTimeout(absl::Seconds(10)));
+  EXPECT_GE(absl::Now() - start_time, absl::Milliseconds(20));
+  EXPECT_THAT(BatchSizes(output_packets), testing::ElementsAre(2, 2));
+
+  // The following batches are timed from their own first input set.
+  for (int i = 2; i < 6; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "input", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+  EXPECT_THAT(BatchSizes(output_packets),
+              testing::ElementsAre(2, 2, 4, 4, 4, 4));
+}
+
+TEST(BatchingInputStreamHandlerTest, RunsGraphRepeatedly) {
+  CalculatorGraphConfig config =
+      BatchingConfig(/*batch_size=*/2, /*max_batch_delay_us=*/1000);
+  std::vector<Packet> output_packets;
+  tool::AddVectorSink("output", &config, &output_packets);
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  for (int run = 0; run < 3; ++run) {
+    output_packets.clear();
+    MP_ASSERT_OK(graph.StartRun({}));
+    for (int i = 0; i < 5; ++i) {
+      MP_ASSERT_OK(graph.AddPacketToInputStream(
+          "input", MakePacket<int>(i).At(Timestamp(i))));
+    }
+    MP_ASSERT_OK(graph.CloseAllInputStreams());
+    MP_ASSERT_OK(graph.WaitUntilDone());
+    ASSERT_EQ(output_packets.size(), 5);
+    for (int i = 0; i < 5; ++i) {
+      EXPECT_EQ(output_packets[i].Timestamp(), Timestamp(i));
+    }
+  }
+}
+
+}  // namespace
+}  // namespace mediapipe
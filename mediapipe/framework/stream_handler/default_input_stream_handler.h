@@ -34,6 +34,10 @@ class DefaultInputStreamHandler : public InputStreamHandler {
                             const MediaPipeOptions& options,
                             bool calculator_run_in_parallel);
 
+  bool SupportsSingleProducerSingleConsumerStreams() const override {
+    return true;
+  }
+
  protected:
   // Reinitializes this InputStreamHandler before each CalculatorGraph run.
   void PrepareForRun(std::function<void()> headers_ready_callback,
@@ -59,6 +59,11 @@ class FixedSizeInputStreamHandler : public DefaultInputStreamHandler {
                               const MediaPipeOptions& options,
                               bool calculator_run_in_parallel);
 
+  // Packets are also erased from the producer side in AddPackets().
+  bool SupportsSingleProducerSingleConsumerStreams() const override {
+    return false;
+  }
+
  private:
   // Drops packets if all input streams exceed trigger_queue_size.
   void EraseAllSurplus() ABSL_EXCLUSIVE_LOCKS_REQUIRED(erase_mutex_);
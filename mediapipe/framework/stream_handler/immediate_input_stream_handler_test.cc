@@ -40,9 +40,7 @@ class ImmediateInputStreamHandlerTest : public ::testing::Test {
     headers_ready_callback_ = [this]() {
       ImmediateInputStreamHandlerTest::HeadersReadyNoOp();
     };
-    notification_callback_ = [this]() {
-      ImmediateInputStreamHandlerTest::NotifyNoOp();
-    };
+    notification_callback_ = [this]() { ++num_notifications_; };
     schedule_callback_ = std::bind(&ImmediateInputStreamHandlerTest::Schedule,
                                    this, std::placeholders::_1);
     error_callback_ = std::bind(&ImmediateInputStreamHandlerTest::RecordError,
@@ -102,8 +100,6 @@ class ImmediateInputStreamHandlerTest : public ::testing::Test {
 
   void HeadersReadyNoOp() {}
 
-  void NotifyNoOp() {}
-
   void Schedule(CalculatorContext* cc) {
     ABSL_CHECK(cc);
     cc_ = cc;
@@ -148,6 +144,8 @@ class ImmediateInputStreamHandlerTest : public ::testing::Test {
 
   // Vector of errors encountered while using the stream.
   std::vector<absl::Status> errors_;
+  // Number of times the handler notified the node of new input.
+  int num_notifications_ = 0;
 
   std::unique_ptr<CalculatorState> calculator_state_;
   CalculatorContextManager cc_manager_;
@@ -231,6 +229,53 @@ TEST_F(ImmediateInputStreamHandlerTest, StreamDoneReady) {
   input_stream_handler_->ClearCurrentInputs(cc_);
 }
 
+// This test checks that a NotificationBatch notifies the node once for all
+// the input streams updated while the batch is alive.
+TEST_F(ImmediateInputStreamHandlerTest, NotificationBatchNotifiesOnce) {
+  input_stream_handler_->SetNextTimestampBound(name_to_id_["input_a"],
+                                               Timestamp(10));
+  input_stream_handler_->SetNextTimestampBound(name_to_id_["input_b"],
+                                               Timestamp(10));
+  EXPECT_EQ(num_notifications_, 2);
+
+  num_notifications_ = 0;
+  {
+    InputStreamHandler::NotificationBatch batch;
+    input_stream_handler_->SetNextTimestampBound(name_to_id_["input_a"],
+                                                 Timestamp(20));
+    input_stream_handler_->SetNextTimestampBound(name_to_id_["input_b"],
+                                                 Timestamp(20));
+    input_stream_handler_->SetNextTimestampBound(name_to_id_["input_c"],
+                                                 Timestamp(20));
+    EXPECT_EQ(num_notifications_, 0);
+  }
+  EXPECT_EQ(num_notifications_, 1);
+
+  // A nested batch notifies the updates made in its own scope.
+  num_notifications_ = 0;
+  {
+    InputStreamHandler::NotificationBatch batch;
+    input_stream_handler_->SetNextTimestampBound(name_to_id_["input_a"],
+                                                 Timestamp(30));
+    {
+      InputStreamHandler::NotificationBatch nested_batch;
+      input_stream_handler_->SetNextTimestampBound(name_to_id_["input_b"],
+                                                   Timestamp(30));
+    }
+    EXPECT_EQ(num_notifications_, 1);
+  }
+  EXPECT_EQ(num_notifications_, 2);
+
+  // An unchanged bound doesn't notify the node.
+  num_notifications_ = 0;
+  {
+    InputStreamHandler::NotificationBatch batch;
+    input_stream_handler_->SetNextTimestampBound(name_to_id_["input_a"],
+                                                 Timestamp(30));
+  }
+  EXPECT_EQ(num_notifications_, 0);
+}
+
 // This test checks that the state is ReadyForClose after all streams reach
 // Timestamp::Max.
 TEST_F(ImmediateInputStreamHandlerTest, ReadyForCloseAfterTimestampMax) {
@@ -14,16 +14,62 @@
 
 #include "mediapipe/framework/thread_pool_executor.h"
 
+#include <iterator>
+#include <set>
 #include <utility>
 
+#include "absl/algorithm/container.h"
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/status_builder.h"
+#include "mediapipe/framework/port/status_macros.h"
 #include "mediapipe/framework/thread_pool_executor.pb.h"
 #include "mediapipe/util/cpu_util.h"
 
 namespace mediapipe {
 
+namespace {
+
+// Returns the processors selected by the cpu_ids and numa_nodes fields of
+// "options".
+absl::StatusOr<std::set<int>> GetSelectedCpuIds(
+    const ThreadPoolExecutorOptions& options) {
+  std::set<int> cpu_ids;
+  for (const int cpu_id : options.cpu_ids()) {
+    if (cpu_id < 0) {
+      return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+             << "The cpu_ids field in ThreadPoolExecutorOptions should only "
+                "contain non-negative values but contains "
+             << cpu_id;
+    }
+    cpu_ids.insert(cpu_id);
+  }
+  if (options.numa_nodes().empty()) {
+    return cpu_ids;
+  }
+  std::set<int> numa_cpu_ids;
+  for (const int numa_node : options.numa_nodes()) {
+    MP_ASSIGN_OR_RETURN(std::set<int> node_cpu_ids,
+                        GetNumaNodeCpuIds(numa_node));
+    numa_cpu_ids.insert(node_cpu_ids.begin(), node_cpu_ids.end());
+  }
+  if (cpu_ids.empty()) {
+    return numa_cpu_ids;
+  }
+  std::set<int> selected_cpu_ids;
+  absl::c_set_intersection(
+      cpu_ids, numa_cpu_ids,
+      std::inserter(selected_cpu_ids, selected_cpu_ids.end()));
+  if (selected_cpu_ids.empty()) {
+    return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+           << "None of the cpu_ids in ThreadPoolExecutorOptions belong to the "
+              "NUMA nodes listed in numa_nodes.";
+  }
+  return selected_cpu_ids;
+}
+
+}  // namespace
+
 // static
 absl::StatusOr<Executor*> ThreadPoolExecutor::Create(
     const MediaPipeOptions& extendable_options) {
@@ -71,6 +117,27 @@ absl::StatusOr<Executor*> ThreadPoolExecutor::Create(
       break;
   }
 #endif
+  if (!options.cpu_ids().empty() || !options.numa_nodes().empty()) {
+    MP_ASSIGN_OR_RETURN(std::set<int> cpu_ids, GetSelectedCpuIds(options));
+    thread_options.set_cpu_set(cpu_ids);
+  }
+  switch (options.memory_policy()) {
+    case ThreadPoolExecutorOptions::LOCAL_MEMORY:
+      thread_options.set_memory_policy(ThreadOptions::MemoryPolicy::kLocal);
+      break;
+    case ThreadPoolExecutorOptions::BIND_MEMORY:
+      if (options.numa_nodes().empty()) {
+        return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+               << "The BIND_MEMORY memory_policy in ThreadPoolExecutorOptions "
+                  "requires the numa_nodes field to be set.";
+      }
+      thread_options.set_numa_nodes(
+          {options.numa_nodes().begin(), options.numa_nodes().end()});
+      thread_options.set_memory_policy(ThreadOptions::MemoryPolicy::kBind);
+      break;
+    default:
+      break;
+  }
   return new ThreadPoolExecutor(thread_options, options.num_threads());
 }
 
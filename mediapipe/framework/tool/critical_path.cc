@@ -0,0 +1,165 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/tool/critical_path.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/tool/name_util.h"
+#include "mediapipe/framework/validated_graph_config.h"
+
+namespace mediapipe {
+
+namespace tool {
+
+std::vector<double> NodeCostsFromProfiles(
+    const ValidatedGraphConfig& validated_graph,
+    const std::vector<CalculatorProfile>& profiles) {
+  absl::flat_hash_map<std::string, const CalculatorProfile*> profile_by_name;
+  for (const CalculatorProfile& profile : profiles) {
+    profile_by_name[profile.name()] = &profile;
+  }
+
+  const int num_nodes = validated_graph.CalculatorInfos().size();
+  // Negative costs mark the nodes without history.
+  std::vector<double> costs(num_nodes, -1.0);
+  double known_cost_sum = 0;
+  int num_known_costs = 0;
+  for (int i = 0; i < num_nodes; ++i) {
+    auto it =
+        profile_by_name.find(CanonicalNodeName(validated_graph.Config(), i));
+    if (it == profile_by_name.end()) continue;
+    const TimeHistogram& runtime = it->second->process_runtime();
+    const int64_t num_calls =
+        std::accumulate(runtime.count().begin(), runtime.count().end(),
+                        int64_t{0});
+    if (num_calls == 0) continue;
+    // Process() times are recorded in whole microseconds, so the cost is at
+    // least 1, which also stands for the scheduling overhead of the node.
+    costs[i] = std::max(1.0, static_cast<double>(runtime.total()) / num_calls);
+    known_cost_sum += costs[i];
+    ++num_known_costs;
+  }
+
+  const double default_cost =
+      num_known_costs > 0 ? known_cost_sum / num_known_costs : 1.0;
+  for (double& cost : costs) {
+    if (cost < 0) cost = default_cost;
+  }
+  return costs;
+}
+
+std::vector<int> CriticalPathPriorities(
+    const ValidatedGraphConfig& validated_graph,
+    const std::vector<double>& node_costs) {
+  const int num_nodes = validated_graph.CalculatorInfos().size();
+  std::vector<int> priorities(num_nodes);
+  std::iota(priorities.begin(), priorities.end(), 0);
+  if (num_nodes == 0 || node_costs.size() != priorities.size()) {
+    return priorities;
+  }
+
+  // The edges between calculator nodes, without back edges.
+  std::vector<std::vector<int>> successors(num_nodes);
+  std::vector<std::vector<int>> predecessors(num_nodes);
+  std::vector<int> num_pending_predecessors(num_nodes, 0);
+  for (const EdgeInfo& input : validated_graph.InputStreamInfos()) {
+    if (input.back_edge || input.upstream < 0) continue;
+    const EdgeInfo& output =
+        validated_graph.OutputStreamInfos()[input.upstream];
+    if (output.parent_node.type != NodeTypeInfo::NodeType::CALCULATOR ||
+        input.parent_node.type != NodeTypeInfo::NodeType::CALCULATOR) {
+      continue;
+    }
+    successors[output.parent_node.index].push_back(input.parent_node.index);
+    predecessors[input.parent_node.index].push_back(output.parent_node.index);
+    ++num_pending_predecessors[input.parent_node.index];
+  }
+
+  // Sorts the nodes topologically.
+  std::vector<int> order;
+  order.reserve(num_nodes);
+  std::deque<int> ready;
+  for (int i = 0; i < num_nodes; ++i) {
+    if (num_pending_predecessors[i] == 0) ready.push_back(i);
+  }
+  while (!ready.empty()) {
+    const int node = ready.front();
+    ready.pop_front();
+    order.push_back(node);
+    for (int successor : successors[node]) {
+      if (--num_pending_predecessors[successor] == 0) {
+        ready.push_back(successor);
+      }
+    }
+  }
+  if (order.size() != priorities.size()) return priorities;
+
+  // The longest path from the graph inputs to the end of each node, and from
+  // the start of each node to the graph outputs.
+  std::vector<double> head(num_nodes, 0.0);
+  std::vector<double> tail(num_nodes, 0.0);
+  for (int node : order) {
+    for (int predecessor : predecessors[node]) {
+      head[node] = std::max(head[node], head[predecessor]);
+    }
+    head[node] += node_costs[node];
+  }
+  for (auto it = order.rbegin(); it != order.rend(); ++it) {
+    const int node = *it;
+    for (int successor : successors[node]) {
+      tail[node] = std::max(tail[node], tail[successor]);
+    }
+    tail[node] += node_costs[node];
+  }
+  const double critical_length = *std::max_element(tail.begin(), tail.end());
+
+  // Lengths are compared in millionths of the critical path length, so that
+  // nodes on paths of the same length are not ordered by rounding errors.
+  auto quantize = [critical_length](double length) {
+    return critical_length > 0 ? std::llround(length / critical_length * 1e6)
+                               : 0;
+  };
+  std::vector<int64_t> slack(num_nodes);
+  std::vector<int64_t> remaining(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) {
+    slack[i] =
+        quantize(critical_length - (head[i] + tail[i] - node_costs[i]));
+    remaining[i] = quantize(tail[i]);
+  }
+
+  // Sorts the nodes from the lowest to the highest priority.
+  std::vector<int> nodes(num_nodes);
+  std::iota(nodes.begin(), nodes.end(), 0);
+  std::sort(nodes.begin(), nodes.end(), [&](int a, int b) {
+    if (slack[a] != slack[b]) return slack[a] > slack[b];
+    if (remaining[a] != remaining[b]) return remaining[a] > remaining[b];
+    return a < b;
+  });
+  for (int i = 0; i < num_nodes; ++i) {
+    priorities[nodes[i]] = i;
+  }
+  return priorities;
+}
+
+}  // namespace tool
+}  // namespace mediapipe
@@ -0,0 +1,56 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_TOOL_CRITICAL_PATH_H_
+#define MEDIAPIPE_FRAMEWORK_TOOL_CRITICAL_PATH_H_
+
+#include <vector>
+
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/validated_graph_config.h"
+
+namespace mediapipe {
+
+namespace tool {
+
+// Returns the expected cost of every calculator node of "validated_graph",
+// indexed by node id: the mean Process() time recorded in "profiles", in
+// microseconds, and at least 1. Nodes without history get the mean cost of
+// the nodes with history, and all nodes get a cost of 1 if there is no
+// history at all.
+std::vector<double> NodeCostsFromProfiles(
+    const ValidatedGraphConfig& validated_graph,
+    const std::vector<CalculatorProfile>& profiles);
+
+// Returns the scheduling priority of every calculator node of
+// "validated_graph", indexed by node id, for the CRITICAL_PATH scheduling
+// policy. The priorities are a permutation of [0, num_nodes), and higher
+// priorities run first.
+//
+// The slack of a node is how much longer its path from the graph inputs to
+// the graph outputs would have to be to become the critical path, with the
+// length of a path being the sum of "node_costs" along it. Nodes with less
+// slack get higher priorities. Ties are broken in favor of the nodes with the
+// least remaining cost to the graph outputs, which finish the packets in
+// flight first, then of the nodes with larger ids as in the NODE_ORDER
+// policy. Back edges are ignored. If the graph has a cycle without back
+// edges, the priorities are the node ids.
+std::vector<int> CriticalPathPriorities(
+    const ValidatedGraphConfig& validated_graph,
+    const std::vector<double>& node_costs);
+
+}  // namespace tool
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_TOOL_CRITICAL_PATH_H_
@@ -0,0 +1,185 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/tool/critical_path.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/log/absl_check.h"
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/validated_graph_config.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::ElementsAre;
+
+// A chain of three nodes and a single node, both fed by the graph input. The
+// chain is declared first, so it runs last in the NODE_ORDER policy.
+constexpr char kBranchedGraph[] = R"pb(
+  input_stream: "in"
+  node {
+    name: "a0"
+    calculator: "RecordingCalculator"
+    input_stream: "in"
+    output_stream: "a1"
+  }
+  node {
+    name: "a1"
+    calculator: "RecordingCalculator"
+    input_stream: "a1"
+    output_stream: "a2"
+  }
+  node {
+    name: "a2"
+    calculator: "RecordingCalculator"
+    input_stream: "a2"
+    output_stream: "a_out"
+  }
+  node {
+    name: "b"
+    calculator: "RecordingCalculator"
+    input_stream: "in"
+    output_stream: "b_out"
+  }
+)pb";
+
+absl::Mutex run_order_mutex;
+std::vector<std::string>* run_order ABSL_GUARDED_BY(run_order_mutex) =
+    new std::vector<std::string>;
+
+// Passes its input through and records the name of its node.
+class RecordingCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).SetAny();
+    cc->Outputs().Index(0).SetSameAs(&cc->Inputs().Index(0));
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    {
+      absl::MutexLock lock(&run_order_mutex);
+      run_order->push_back(cc->NodeName());
+    }
+    cc->Outputs().Index(0).AddPacket(cc->Inputs().Index(0).Value());
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(RecordingCalculator);
+
+std::unique_ptr<ValidatedGraphConfig> ValidateGraph(
+    const std::string& config) {
+  auto validated_graph = std::make_unique<ValidatedGraphConfig>();
+  ABSL_CHECK_OK(validated_graph->Initialize(
+      ParseTextProtoOrDie<CalculatorGraphConfig>(config)));
+  return validated_graph;
+}
+
+TEST(CriticalPathTest, PrioritizesLongestPathWithUniformCosts) {
+  auto validated_graph = ValidateGraph(kBranchedGraph);
+  EXPECT_THAT(tool::CriticalPathPriorities(*validated_graph, {1, 1, 1, 1}),
+              ElementsAre(1, 2, 3, 0));
+}
+
+TEST(CriticalPathTest, PrioritizesCostliestPath) {
+  auto validated_graph = ValidateGraph(kBranchedGraph);
+  EXPECT_THAT(tool::CriticalPathPriorities(*validated_graph, {1, 1, 1, 10}),
+              ElementsAre(0, 1, 2, 3));
+}
+
+TEST(CriticalPathTest, BreaksTiesTowardGraphOutputs) {
+  auto validated_graph = ValidateGraph(R"pb(
+    input_stream: "in"
+    node {
+      name: "a"
+      calculator: "RecordingCalculator"
+      input_stream: "in"
+      output_stream: "a_out"
+    }
+    node {
+      name: "b"
+      calculator: "RecordingCalculator"
+      input_stream: "a_out"
+      output_stream: "b_out"
+    }
+    node {
+      name: "c"
+      calculator: "RecordingCalculator"
+      input_stream: "in"
+      output_stream: "c_out"
+    }
+  )pb");
+  EXPECT_THAT(tool::CriticalPathPriorities(*validated_graph, {1, 1, 1}),
+              ElementsAre(1, 2, 0));
+}
+
+TEST(CriticalPathTest, NodeCostsFromProfiles) {
+  auto validated_graph = ValidateGraph(kBranchedGraph);
+  std::vector<CalculatorProfile> profiles(2);
+  profiles[0].set_name("a0");
+  profiles[0].mutable_process_runtime()->set_total(300);
+  profiles[0].mutable_process_runtime()->add_count(3);
+  // Process() calls shorter than a microsecond.
+  profiles[1].set_name("a1");
+  profiles[1].mutable_process_runtime()->set_total(0);
+  profiles[1].mutable_process_runtime()->add_count(2);
+  EXPECT_THAT(tool::NodeCostsFromProfiles(*validated_graph, profiles),
+              ElementsAre(100, 1, 50.5, 50.5));
+  EXPECT_THAT(tool::NodeCostsFromProfiles(*validated_graph, {}),
+              ElementsAre(1, 1, 1, 1));
+}
+
+// Returns the order in which the nodes of kBranchedGraph run for one packet,
+// with the given scheduling policy.
+std::vector<std::string> RunOrder(
+    CalculatorGraphConfig::SchedulingPolicy policy) {
+  auto config = ParseTextProtoOrDie<CalculatorGraphConfig>(kBranchedGraph);
+  config.set_scheduling_policy(policy);
+  // Runs the nodes on the calling thread, so that the order is exact.
+  config.add_executor()->set_type("ApplicationThreadExecutor");
+  {
+    absl::MutexLock lock(&run_order_mutex);
+    run_order->clear();
+  }
+  CalculatorGraph graph;
+  ABSL_CHECK_OK(graph.Initialize(config));
+  ABSL_CHECK_OK(graph.StartRun({}));
+  ABSL_CHECK_OK(graph.AddPacketToInputStream(
+      "in", MakePacket<int>(0).At(Timestamp(0))));
+  ABSL_CHECK_OK(graph.CloseAllInputStreams());
+  ABSL_CHECK_OK(graph.WaitUntilDone());
+  absl::MutexLock lock(&run_order_mutex);
+  return *run_order;
+}
+
+TEST(CriticalPathTest, GraphRunsCriticalPathFirst) {
+  EXPECT_THAT(RunOrder(CalculatorGraphConfig::NODE_ORDER),
+              ElementsAre("b", "a0", "a1", "a2"));
+  EXPECT_THAT(RunOrder(CalculatorGraphConfig::CRITICAL_PATH),
+              ElementsAre("a0", "a1", "a2", "b"));
+}
+
+}  // namespace
+}  // namespace mediapipe
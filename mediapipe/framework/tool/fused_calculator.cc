@@ -0,0 +1,380 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <list>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "mediapipe/framework/calculator_base.h"
+#include "mediapipe/framework/calculator_context.h"
+#include "mediapipe/framework/calculator_context_manager.h"
+#include "mediapipe/framework/calculator_contract.h"
+#include "mediapipe/framework/calculator_registry.h"
+#include "mediapipe/framework/calculator_state.h"
+#include "mediapipe/framework/counter_factory.h"
+#include "mediapipe/framework/collection_item_id.h"
+#include "mediapipe/framework/input_stream_shard.h"
+#include "mediapipe/framework/legacy_calculator_support.h"
+#include "mediapipe/framework/output_stream_shard.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/packet_set.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/framework/timestamp.h"
+#include "mediapipe/framework/tool/fused_calculator.pb.h"
+
+namespace mediapipe {
+
+// Runs a chain of calculators that the graph fusion pass (graph_fusion.h) has
+// fused into one node. For each input timestamp, the calculators are run back
+// to back, each one receiving the output of the previous one together with its
+// other inputs, which are inputs of the fused node. The output streams of the
+// last calculator are the output streams of the fused node.
+//
+// The calculators see their own options, node name and counters, but no stream
+// headers and no side packets.
+class FusedCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    RET_CHECK_GE(cc->Options<FusedCalculatorOptions>().node_size(), 2);
+    // The streams of the fused nodes have been validated before fusion.
+    for (CollectionItemId id = cc->Inputs().BeginId();
+         id < cc->Inputs().EndId(); ++id) {
+      cc->Inputs().Get(id).SetAny();
+    }
+    for (CollectionItemId id = cc->Outputs().BeginId();
+         id < cc->Outputs().EndId(); ++id) {
+      cc->Outputs().Get(id).SetAny();
+    }
+    // Fusable calculators only output packets at the input timestamp.
+    cc->SetTimestampOffset(0);
+    return absl::OkStatus();
+  }
+
+  absl::Status Open(CalculatorContext* cc) override;
+  absl::Status Process(CalculatorContext* cc) override;
+  absl::Status Close(CalculatorContext* cc) override;
+
+ private:
+  // One of the fused calculators.
+  struct Stage {
+    std::string node_name;
+    CalculatorContract contract;
+    std::unique_ptr<CalculatorState> state;
+    std::unique_ptr<PacketSet> input_side_packets;
+    CalculatorContextManager context_manager;
+    std::vector<OutputStreamSpec> output_specs;
+    std::unique_ptr<CalculatorBase> calculator;
+    // For each input stream, the input stream of the fused node that feeds
+    // it, or an invalid id if it is fed by the previous stage.
+    std::vector<CollectionItemId> fused_inputs;
+    // For each output stream of the last stage, the output stream of the
+    // fused node.
+    std::vector<CollectionItemId> fused_outputs;
+  };
+
+  absl::Status InitializeStage(const CalculatorGraphConfig::Node& node,
+                               const std::string& package, bool is_first,
+                               bool is_last, CalculatorContext* cc,
+                               Stage* stage);
+
+  // Connects the stream shards of a newly created calculator context of
+  // "stage".
+  static absl::Status ConnectShards(Stage* stage, CalculatorContext* context);
+
+  // Runs Process() of "stage" at "timestamp" on "chain_packet", which is the
+  // output of the previous stage, and the packets of the other inputs in
+  // "cc". Does nothing if all these packets are empty.
+  absl::Status ProcessStage(int stage_index, Timestamp timestamp,
+                            const Packet& chain_packet, CalculatorContext* cc,
+                            std::vector<Packet>* chain_outputs);
+
+  // Moves the packets output by "stage" either to the output streams of the
+  // fused node if "stage" is the last stage, or to "chain_outputs".
+  absl::Status CollectOutputs(int stage_index, CalculatorContext* cc,
+                              std::vector<Packet>* chain_outputs);
+
+  // Returns the first error reported by an output stream shard of a stage
+  // since the last call.
+  absl::Status TakeStreamStatus() {
+    absl::Status status = std::move(stream_status_);
+    stream_status_ = absl::OkStatus();
+    return status;
+  }
+
+  std::vector<std::unique_ptr<Stage>> stages_;
+  absl::Status stream_status_;
+};
+REGISTER_CALCULATOR(FusedCalculator);
+
+absl::Status FusedCalculator::Open(CalculatorContext* cc) {
+  const auto& options = cc->Options<FusedCalculatorOptions>();
+  stages_.clear();
+  for (int i = 0; i < options.node_size(); ++i) {
+    stages_.push_back(std::make_unique<Stage>());
+    MP_RETURN_IF_ERROR(InitializeStage(options.node(i), options.package(),
+                                       /*is_first=*/i == 0,
+                                       /*is_last=*/i == options.node_size() - 1,
+                                       cc, stages_.back().get()));
+  }
+
+  for (int i = 0; i < stages_.size(); ++i) {
+    Stage& stage = *stages_[i];
+    CalculatorContext* context =
+        stage.context_manager.GetDefaultCalculatorContext();
+    stage.context_manager.PushInputTimestampToContext(context,
+                                                      Timestamp::Unstarted());
+    absl::Status status;
+    {
+      LegacyCalculatorSupport::Scoped<CalculatorContext> s(context);
+      status = stage.calculator->Open(context);
+    }
+    stage.context_manager.PopInputTimestampFromContext(context);
+    status.Update(TakeStreamStatus());
+    MP_RETURN_IF_ERROR(status).SetPrepend()
+        << "Calculator::Open() for fused node \"" << stage.node_name
+        << "\" failed: ";
+    std::vector<Packet> chain_outputs;
+    MP_RETURN_IF_ERROR(CollectOutputs(i, cc, &chain_outputs));
+    RET_CHECK(chain_outputs.empty())
+        << "Fused node \"" << stage.node_name
+        << "\" must not output packets in Open().";
+    for (OutputStreamSpec& spec : stage.output_specs) {
+      spec.locked_intro_data = true;
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status FusedCalculator::InitializeStage(
+    const CalculatorGraphConfig::Node& node, const std::string& package,
+    bool is_first, bool is_last, CalculatorContext* cc, Stage* stage) {
+  stage->node_name = node.name();
+  MP_RETURN_IF_ERROR(stage->contract.Initialize(node));
+  MP_ASSIGN_OR_RETURN(
+      auto calculator_factory,
+      CalculatorBaseRegistry::CreateByNameInNamespace(package,
+                                                      node.calculator()),
+      _ << "Unable to find Calculator \"" << node.calculator() << "\"");
+  {
+    LegacyCalculatorSupport::Scoped<CalculatorContract> s(&stage->contract);
+    MP_RETURN_IF_ERROR(calculator_factory->GetContract(&stage->contract))
+            .SetPrepend()
+        << node.calculator() << ": ";
+  }
+
+  stage->state = std::make_unique<CalculatorState>(
+      node.name(), cc->NodeId(), node.calculator(), node,
+      /*profiling_context=*/nullptr);
+  stage->input_side_packets = std::make_unique<PacketSet>(
+      stage->contract.InputSidePackets().TagMap());
+  stage->state->SetInputSidePackets(stage->input_side_packets.get());
+  stage->state->SetCounterFactory(cc->GetCounterFactory());
+  stage->state->SetPacketArena(cc->GetPacketArena());
+  stage->state->SetDeadlineTracker(cc->GetDeadlineTracker());
+
+  const std::vector<std::string>& fused_input_names =
+      cc->Inputs().TagMap()->Names();
+  for (const std::string& name : stage->contract.Inputs().TagMap()->Names()) {
+    auto iter =
+        std::find(fused_input_names.begin(), fused_input_names.end(), name);
+    if (iter == fused_input_names.end()) {
+      RET_CHECK(!is_first) << "Input stream \"" << name
+                           << "\" is missing from the fused node.";
+      stage->fused_inputs.push_back(CollectionItemId::GetInvalid());
+    } else {
+      stage->fused_inputs.push_back(
+          cc->Inputs().BeginId() +
+          static_cast<int>(iter - fused_input_names.begin()));
+    }
+  }
+
+  const std::vector<std::string>& output_names =
+      stage->contract.Outputs().TagMap()->Names();
+  RET_CHECK(is_last || output_names.size() == 1)
+      << "Fused node \"" << node.name() << "\" must have one output stream.";
+  stage->output_specs.resize(output_names.size());
+  for (int i = 0; i < output_names.size(); ++i) {
+    OutputStreamSpec& spec = stage->output_specs[i];
+    spec.name = output_names[i];
+    spec.packet_type = &stage->contract.Outputs().Get(
+        stage->contract.Outputs().BeginId() + i);
+    spec.error_callback = [this](absl::Status status) {
+      stream_status_.Update(status);
+    };
+    spec.locked_intro_data = false;
+    spec.offset_enabled = false;
+  }
+  if (is_last) {
+    const std::vector<std::string>& fused_output_names =
+        cc->Outputs().TagMap()->Names();
+    for (const std::string& name : output_names) {
+      auto iter = std::find(fused_output_names.begin(),
+                            fused_output_names.end(), name);
+      RET_CHECK(iter != fused_output_names.end())
+          << "Output stream \"" << name << "\" is missing from the fused node.";
+      stage->fused_outputs.push_back(
+          cc->Outputs().BeginId() +
+          static_cast<int>(iter - fused_output_names.begin()));
+    }
+  }
+
+  stage->context_manager.Initialize(
+      stage->state.get(), stage->contract.Inputs().TagMap(),
+      stage->contract.Outputs().TagMap(),
+      /*calculator_run_in_parallel=*/false);
+  MP_RETURN_IF_ERROR(stage->context_manager.PrepareForRun(
+      [stage](CalculatorContext* context) {
+        return ConnectShards(stage, context);
+      }));
+  stage->calculator = calculator_factory->CreateCalculator(
+      stage->context_manager.GetDefaultCalculatorContext());
+  return absl::OkStatus();
+}
+
+absl::Status FusedCalculator::ConnectShards(Stage* stage,
+                                            CalculatorContext* context) {
+  const std::vector<std::string>& input_names =
+      stage->contract.Inputs().TagMap()->Names();
+  for (CollectionItemId id = context->Inputs().BeginId();
+       id < context->Inputs().EndId(); ++id) {
+    context->Inputs().Get(id).SetName(&input_names[id.value()]);
+  }
+  for (CollectionItemId id = context->Outputs().BeginId();
+       id < context->Outputs().EndId(); ++id) {
+    context->Outputs().Get(id).SetSpec(&stage->output_specs[id.value()]);
+  }
+  return absl::OkStatus();
+}
+
+absl::Status FusedCalculator::Process(CalculatorContext* cc) {
+  const Timestamp timestamp = cc->InputTimestamp();
+  Packet chain_packet;
+  for (int i = 0; i < stages_.size(); ++i) {
+    std::vector<Packet> chain_outputs;
+    MP_RETURN_IF_ERROR(
+        ProcessStage(i, timestamp, chain_packet, cc, &chain_outputs));
+    RET_CHECK_LE(chain_outputs.size(), 1);
+    chain_packet = chain_outputs.empty() ? Packet() : chain_outputs[0];
+    RET_CHECK(chain_packet.IsEmpty() || chain_packet.Timestamp() == timestamp)
+        << "Fused node \"" << stages_[i]->node_name
+        << "\" must only output packets at the input timestamp.";
+  }
+  return absl::OkStatus();
+}
+
+absl::Status FusedCalculator::Close(CalculatorContext* cc) {
+  // Packets output by a stage in Close() are processed by the next stage
+  // before it is closed.
+  std::vector<Packet> chain_packets;
+  for (int i = 0; i < stages_.size(); ++i) {
+    Stage& stage = *stages_[i];
+    std::vector<Packet> chain_outputs;
+    for (const Packet& packet : chain_packets) {
+      MP_RETURN_IF_ERROR(
+          ProcessStage(i, packet.Timestamp(), packet, cc, &chain_outputs));
+    }
+
+    CalculatorContext* context =
+        stage.context_manager.GetDefaultCalculatorContext();
+    stage.context_manager.SetGraphStatusInContext(context, cc->GraphStatus());
+    stage.context_manager.PushInputTimestampToContext(context,
+                                                      Timestamp::Done());
+    absl::Status status;
+    {
+      LegacyCalculatorSupport::Scoped<CalculatorContext> s(context);
+      status = stage.calculator->Close(context);
+    }
+    stage.context_manager.PopInputTimestampFromContext(context);
+    status.Update(TakeStreamStatus());
+    MP_RETURN_IF_ERROR(status).SetPrepend()
+        << "Calculator::Close() for fused node \"" << stage.node_name
+        << "\" failed: ";
+    MP_RETURN_IF_ERROR(CollectOutputs(i, cc, &chain_outputs));
+    chain_packets = std::move(chain_outputs);
+  }
+  return absl::OkStatus();
+}
+
+absl::Status FusedCalculator::ProcessStage(int stage_index, Timestamp timestamp,
+                                           const Packet& chain_packet,
+                                           CalculatorContext* cc,
+                                           std::vector<Packet>* chain_outputs) {
+  Stage& stage = *stages_[stage_index];
+  CalculatorContext* context =
+      stage.context_manager.GetDefaultCalculatorContext();
+  InputStreamShardSet& inputs = context->Inputs();
+  bool has_packet = false;
+  for (CollectionItemId id = inputs.BeginId(); id < inputs.EndId(); ++id) {
+    const CollectionItemId fused_id = stage.fused_inputs[id.value()];
+    Packet packet;
+    bool is_done = false;
+    if (!fused_id.IsValid()) {
+      packet = chain_packet;
+    } else if (cc->Inputs().Get(fused_id).Value().Timestamp() == timestamp) {
+      packet = cc->Inputs().Get(fused_id).Value();
+    } else {
+      is_done = cc->Inputs().Get(fused_id).IsDone();
+    }
+    has_packet = has_packet || !packet.IsEmpty();
+    inputs.Get(id).AddPacket(std::move(packet), is_done);
+  }
+
+  absl::Status status;
+  if (has_packet) {
+    stage.context_manager.PushInputTimestampToContext(context, timestamp);
+    {
+      LegacyCalculatorSupport::Scoped<CalculatorContext> s(context);
+      status = stage.calculator->Process(context);
+    }
+    stage.context_manager.PopInputTimestampFromContext(context);
+    status.Update(TakeStreamStatus());
+  }
+  for (CollectionItemId id = inputs.BeginId(); id < inputs.EndId(); ++id) {
+    inputs.Get(id).ClearCurrentPacket();
+  }
+  MP_RETURN_IF_ERROR(status).SetPrepend()
+      << "Calculator::Process() for fused node \"" << stage.node_name
+      << "\" failed: ";
+  return CollectOutputs(stage_index, cc, chain_outputs);
+}
+
+absl::Status FusedCalculator::CollectOutputs(
+    int stage_index, CalculatorContext* cc,
+    std::vector<Packet>* chain_outputs) {
+  Stage& stage = *stages_[stage_index];
+  const bool is_last = stage_index == stages_.size() - 1;
+  OutputStreamShardSet& outputs =
+      stage.context_manager.GetDefaultCalculatorContext()->Outputs();
+  for (CollectionItemId id = outputs.BeginId(); id < outputs.EndId(); ++id) {
+    std::list<Packet>* queue = outputs.Get(id).OutputQueue();
+    for (Packet& packet : *queue) {
+      if (is_last) {
+        cc->Outputs()
+            .Get(stage.fused_outputs[id.value()])
+            .AddPacket(std::move(packet));
+      } else {
+        chain_outputs->push_back(std::move(packet));
+      }
+    }
+    queue->clear();
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,184 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/tool/graph_fusion.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_join.h"
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/calculator_contract.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/tool/fused_calculator.pb.h"
+#include "mediapipe/framework/tool/name_util.h"
+#include "mediapipe/framework/tool/validate_name.h"
+
+namespace mediapipe {
+
+namespace tool {
+
+namespace {
+
+constexpr char kDefaultInputStreamHandler[] = "DefaultInputStreamHandler";
+
+// Returns the stream name in a "TAG:index:name" stream specification.
+std::string StreamName(const std::string& tag_index_name) {
+  std::string tag;
+  int index;
+  std::string name;
+  // The graph has been validated, so the specification is well formed.
+  ParseTagIndexName(tag_index_name, &tag, &index, &name).IgnoreError();
+  return name;
+}
+
+bool UsesDefaultInputStreamHandler(const CalculatorGraphConfig::Node& node,
+                                   const CalculatorContract& contract) {
+  if (node.has_input_stream_handler()) {
+    return node.input_stream_handler().input_stream_handler() ==
+               kDefaultInputStreamHandler &&
+           !node.input_stream_handler().has_options();
+  }
+  const std::string handler = contract.GetInputStreamHandler();
+  return handler.empty() || handler == kDefaultInputStreamHandler;
+}
+
+bool IsFusableNode(const CalculatorGraphConfig::Node& node,
+                   const CalculatorContract& contract) {
+  return contract.IsFusable() && !contract.GetProcessTimestampBounds() &&
+         !contract.GetProcessStaleTimestamps() &&
+         contract.ServiceRequests().empty() && node.input_stream_size() > 0 &&
+         node.output_stream_size() > 0 && node.input_side_packet().empty() &&
+         node.output_side_packet().empty() &&
+         node.input_stream_info().empty() &&
+         node.executor().empty() && node.max_in_flight() <= 1 &&
+         node.buffer_size_hint() <= 0 && !node.has_output_stream_handler() &&
+         UsesDefaultInputStreamHandler(node, contract);
+}
+
+}  // namespace
+
+bool FuseCalculatorChains(const ValidatedGraphConfig& validated_graph,
+                          CalculatorGraphConfig* fused_config) {
+  const CalculatorGraphConfig& config = validated_graph.Config();
+  const int num_nodes = config.node_size();
+
+  // The nodes consuming each stream. Graph output streams are consumed by -1.
+  absl::flat_hash_map<std::string, std::vector<int>> consumers;
+  for (int i = 0; i < num_nodes; ++i) {
+    const CalculatorGraphConfig::Node& node = config.node(i);
+    for (const auto& info : node.input_stream_info()) {
+      if (info.back_edge()) {
+        return false;
+      }
+    }
+    for (const std::string& stream : node.input_stream()) {
+      consumers[StreamName(stream)].push_back(i);
+    }
+  }
+  for (const std::string& stream : config.output_stream()) {
+    consumers[StreamName(stream)].push_back(-1);
+  }
+
+  std::vector<bool> fusable(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) {
+    fusable[i] = IsFusableNode(
+        config.node(i), validated_graph.CalculatorInfos()[i].Contract());
+  }
+  // The fusable node that is the only consumer of the single output stream of
+  // each fusable node, if any.
+  std::vector<int> consumer(num_nodes, -1);
+  std::vector<int> num_producers(num_nodes, 0);
+  for (int i = 0; i < num_nodes; ++i) {
+    if (!fusable[i] || config.node(i).output_stream_size() != 1) {
+      continue;
+    }
+    const std::vector<int>& stream_consumers =
+        consumers[StreamName(config.node(i).output_stream(0))];
+    if (stream_consumers.size() != 1 || stream_consumers[0] < 0 ||
+        !fusable[stream_consumers[0]]) {
+      continue;
+    }
+    consumer[i] = stream_consumers[0];
+    ++num_producers[consumer[i]];
+  }
+  // A node fed by several such producers can only join one of their chains,
+  // so it starts a new chain instead.
+  std::vector<int> next(num_nodes, -1);
+  std::vector<int> previous(num_nodes, -1);
+  bool has_chain = false;
+  for (int i = 0; i < num_nodes; ++i) {
+    const int c = consumer[i];
+    if (c < 0 || num_producers[c] != 1 || previous[c] >= 0) {
+      continue;
+    }
+    next[i] = c;
+    previous[c] = i;
+    has_chain = true;
+  }
+  if (!has_chain) {
+    return false;
+  }
+
+  *fused_config = config;
+  fused_config->clear_node();
+  for (int i = 0; i < num_nodes; ++i) {
+    if (previous[i] >= 0) {
+      // Added with the chain it belongs to.
+      continue;
+    }
+    if (next[i] < 0) {
+      *fused_config->add_node() = config.node(i);
+      continue;
+    }
+
+    CalculatorGraphConfig::Node* fused_node = fused_config->add_node();
+    fused_node->set_calculator(kFusedCalculatorName);
+    auto* options = fused_node->mutable_options()->MutableExtension(
+        FusedCalculatorOptions::ext);
+    options->set_package(config.package());
+    std::vector<std::string> node_names;
+    absl::flat_hash_set<std::string> internal_streams;
+    absl::flat_hash_set<std::string> input_streams;
+    for (int j = i; j >= 0; j = next[j]) {
+      CalculatorGraphConfig::Node* node = options->add_node();
+      *node = config.node(j);
+      node->set_name(CanonicalNodeName(config, j));
+      node_names.push_back(node->name());
+      for (const std::string& stream : node->input_stream()) {
+        const std::string name = StreamName(stream);
+        if (!internal_streams.contains(name) &&
+            input_streams.insert(name).second) {
+          fused_node->add_input_stream(name);
+        }
+      }
+      if (next[j] >= 0) {
+        internal_streams.insert(StreamName(node->output_stream(0)));
+      } else {
+        for (const std::string& stream : node->output_stream()) {
+          fused_node->add_output_stream(StreamName(stream));
+        }
+      }
+    }
+    fused_node->set_name(absl::StrJoin(node_names, "__"));
+    VLOG(1) << "Fused nodes " << absl::StrJoin(node_names, ", ")
+            << " into node \"" << fused_node->name() << "\".";
+  }
+  return true;
+}
+
+}  // namespace tool
+}  // namespace mediapipe
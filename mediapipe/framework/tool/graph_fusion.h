@@ -0,0 +1,47 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_TOOL_GRAPH_FUSION_H_
+#define MEDIAPIPE_FRAMEWORK_TOOL_GRAPH_FUSION_H_
+
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/validated_graph_config.h"
+
+namespace mediapipe {
+
+namespace tool {
+
+// The calculator that runs a fused chain of nodes.
+inline constexpr char kFusedCalculatorName[] = "FusedCalculator";
+
+// Replaces linear chains of fusable nodes in a validated graph by
+// FusedCalculator nodes, which run the calculators of a chain back to back.
+// Returns false, leaving "fused_config" untouched, if there is nothing to fuse.
+//
+// A node is fusable if its calculator is marked fusable in its contract
+// (CalculatorContract::SetFusable), it has no side packets, it uses the
+// default stream handlers and executor, and it doesn't process timestamp
+// bounds or stale timestamps or run in parallel. Two fusable nodes are
+// chained if the first one has a single output stream and that stream is only
+// consumed by the second one. Graphs with back edges are not fused.
+//
+// The fused node is named after the fused nodes, and its input streams are the
+// input streams of the chain that don't come from within the chain.
+bool FuseCalculatorChains(const ValidatedGraphConfig& validated_graph,
+                          CalculatorGraphConfig* fused_config);
+
+}  // namespace tool
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_TOOL_GRAPH_FUSION_H_
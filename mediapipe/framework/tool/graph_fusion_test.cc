@@ -0,0 +1,353 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/tool/graph_fusion.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/match.h"
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::ElementsAre;
+
+// Adds one to its int input.
+class FusableAddOneCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<int>();
+    cc->Outputs().Index(0).Set<int>();
+    cc->SetFusable(true);
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    cc->Outputs().Index(0).AddPacket(
+        MakePacket<int>(cc->Inputs().Index(0).Get<int>() + 1)
+            .At(cc->InputTimestamp()));
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(FusableAddOneCalculator);
+
+// Multiplies its "VALUE" input by its "FACTOR" input, if present.
+class FusableMultiplyCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Tag("VALUE").Set<int>();
+    cc->Inputs().Tag("FACTOR").Set<int>();
+    cc->Outputs().Index(0).Set<int>();
+    cc->SetFusable(true);
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    if (cc->Inputs().Tag("VALUE").IsEmpty() ||
+        cc->Inputs().Tag("FACTOR").IsEmpty()) {
+      return absl::OkStatus();
+    }
+    cc->Outputs().Index(0).AddPacket(
+        MakePacket<int>(cc->Inputs().Tag("VALUE").Get<int>() *
+                        cc->Inputs().Tag("FACTOR").Get<int>())
+            .At(cc->InputTimestamp()));
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(FusableMultiplyCalculator);
+
+// Outputs the sum of its inputs when it is closed.
+class FusableSumCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<int>();
+    cc->Outputs().Index(0).Set<int>();
+    cc->SetFusable(true);
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    sum_ += cc->Inputs().Index(0).Get<int>();
+    return absl::OkStatus();
+  }
+
+  absl::Status Close(CalculatorContext* cc) override {
+    cc->Outputs().Index(0).AddPacket(
+        MakePacket<int>(sum_).At(Timestamp::PostStream()));
+    return absl::OkStatus();
+  }
+
+ private:
+  int sum_ = 0;
+};
+REGISTER_CALCULATOR(FusableSumCalculator);
+
+std::vector<int> RunGraph(const CalculatorGraphConfig& config,
+                          const std::vector<int>& inputs,
+                          CalculatorGraphConfig* final_config = nullptr) {
+  CalculatorGraphConfig graph_config = config;
+  std::vector<Packet> output_packets;
+  tool::AddVectorSink("output", &graph_config, &output_packets);
+  CalculatorGraph graph;
+  MP_EXPECT_OK(graph.Initialize(graph_config));
+  MP_EXPECT_OK(graph.StartRun({}));
+  for (int i = 0; i < inputs.size(); ++i) {
+    MP_EXPECT_OK(graph.AddPacketToInputStream(
+        "input", MakePacket<int>(inputs[i]).At(Timestamp(i))));
+    if (graph_config.input_stream_size() > 1) {
+      MP_EXPECT_OK(graph.AddPacketToInputStream(
+          "factor", MakePacket<int>(i).At(Timestamp(i))));
+    }
+  }
+  MP_EXPECT_OK(graph.CloseAllInputStreams());
+  MP_EXPECT_OK(graph.WaitUntilDone());
+  if (final_config) {
+    *final_config = graph.Config();
+  }
+  std::vector<int> result;
+  for (const Packet& packet : output_packets) {
+    result.push_back(packet.Get<int>());
+  }
+  return result;
+}
+
+// Returns the calculators of the graph, except the ones of the vector sink.
+std::vector<std::string> Calculators(const CalculatorGraphConfig& config) {
+  std::vector<std::string> result;
+  for (const auto& node : config.node()) {
+    if (absl::StartsWith(node.calculator(), "Callback")) {
+      continue;
+    }
+    result.push_back(node.calculator());
+  }
+  return result;
+}
+
+TEST(GraphFusionTest, FusesChain) {
+  CalculatorGraphConfig config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "input"
+    input_stream: "factor"
+    node {
+      calculator: "FusableAddOneCalculator"
+      input_stream: "input"
+      output_stream: "a"
+    }
+    node {
+      calculator: "FusableMultiplyCalculator"
+      input_stream: "VALUE:a"
+      input_stream: "FACTOR:factor"
+      output_stream: "b"
+    }
+    node {
+      calculator: "FusableAddOneCalculator"
+      input_stream: "b"
+      output_stream: "output"
+    }
+  )pb");
+  const std::vector<int> unfused = RunGraph(config, {1, 2, 3, 4});
+  EXPECT_THAT(unfused, ElementsAre(1, 4, 9, 16));
+
+  config.set_fuse_calculator_chains(true);
+  CalculatorGraphConfig fused_config;
+  EXPECT_EQ(RunGraph(config, {1, 2, 3, 4}, &fused_config), unfused);
+  EXPECT_THAT(Calculators(fused_config),
+              ElementsAre("FusedCalculator"));
+  const CalculatorGraphConfig::Node& fused_node = fused_config.node(0);
+  EXPECT_EQ(fused_node.name(),
+            "FusableAddOneCalculator_1__FusableMultiplyCalculator__"
+            "FusableAddOneCalculator_2");
+  EXPECT_THAT(fused_node.input_stream(), ElementsAre("input", "factor"));
+  EXPECT_THAT(fused_node.output_stream(), ElementsAre("output"));
+}
+
+TEST(GraphFusionTest, FusesChainWithOutputsInClose) {
+  CalculatorGraphConfig config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "input"
+    fuse_calculator_chains: true
+    node {
+      calculator: "FusableAddOneCalculator"
+      input_stream: "input"
+      output_stream: "a"
+    }
+    node {
+      calculator: "FusableSumCalculator"
+      input_stream: "a"
+      output_stream: "b"
+    }
+    node {
+      calculator: "FusableAddOneCalculator"
+      input_stream: "b"
+      output_stream: "output"
+    }
+  )pb");
+  CalculatorGraphConfig fused_config;
+  EXPECT_THAT(RunGraph(config, {1, 2, 3}, &fused_config), ElementsAre(10));
+  EXPECT_THAT(Calculators(fused_config),
+              ElementsAre("FusedCalculator"));
+}
+
+TEST(GraphFusionTest, KeepsObservedStreams) {
+  // Stream "a" has two consumers, so only the last two nodes are fused.
+  CalculatorGraphConfig config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "input"
+    output_stream: "a"
+    fuse_calculator_chains: true
+    node {
+      calculator: "FusableAddOneCalculator"
+      input_stream: "input"
+      output_stream: "a"
+    }
+    node {
+      calculator: "FusableAddOneCalculator"
+      input_stream: "a"
+      output_stream: "b"
+    }
+    node {
+      calculator: "FusableAddOneCalculator"
+      input_stream: "b"
+      output_stream: "output"
+    }
+  )pb");
+  CalculatorGraphConfig fused_config;
+  EXPECT_THAT(RunGraph(config, {1, 2}, &fused_config), ElementsAre(4, 5));
+  EXPECT_THAT(Calculators(fused_config),
+              ElementsAre("FusableAddOneCalculator", "FusedCalculator"));
+}
+
+TEST(GraphFusionTest, StartsNewChainAtFanIn) {
+  // Both AddOne nodes feed the Multiply node, which can join only one of
+  // their chains, so it starts a chain with the last node instead.
+  CalculatorGraphConfig config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "input"
+    input_stream: "factor"
+    node {
+      calculator: "FusableAddOneCalculator"
+      input_stream: "input"
+      output_stream: "a"
+    }
+    node {
+      calculator: "FusableAddOneCalculator"
+      input_stream: "factor"
+      output_stream: "b"
+    }
+    node {
+      calculator: "FusableMultiplyCalculator"
+      input_stream: "VALUE:a"
+      input_stream: "FACTOR:b"
+      output_stream: "c"
+    }
+    node {
+      calculator: "FusableAddOneCalculator"
+      input_stream: "c"
+      output_stream: "output"
+    }
+  )pb");
+  const std::vector<int> unfused = RunGraph(config, {1, 2, 3});
+  EXPECT_THAT(unfused, ElementsAre(3, 7, 13));
+
+  config.set_fuse_calculator_chains(true);
+  CalculatorGraphConfig fused_config;
+  EXPECT_EQ(RunGraph(config, {1, 2, 3}, &fused_config), unfused);
+  EXPECT_THAT(Calculators(fused_config),
+              ElementsAre("FusableAddOneCalculator", "FusableAddOneCalculator",
+                          "FusedCalculator"));
+}
+
+TEST(GraphFusionTest, DoesNotFuseOtherCalculators) {
+  CalculatorGraphConfig config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "input"
+    fuse_calculator_chains: true
+    node {
+      calculator: "FusableAddOneCalculator"
+      input_stream: "input"
+      output_stream: "a"
+    }
+    node {
+      calculator: "PassThroughCalculator"
+      input_stream: "a"
+      output_stream: "b"
+    }
+    node {
+      calculator: "FusableAddOneCalculator"
+      input_stream: "b"
+      output_stream: "output"
+    }
+  )pb");
+  CalculatorGraphConfig fused_config;
+  EXPECT_THAT(RunGraph(config, {1, 2}, &fused_config), ElementsAre(3, 4));
+  EXPECT_THAT(Calculators(fused_config),
+              ElementsAre("FusableAddOneCalculator", "PassThroughCalculator",
+                          "FusableAddOneCalculator"));
+}
+
+TEST(GraphFusionTest, FusionIsOptIn) {
+  CalculatorGraphConfig config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "input"
+    node {
+      calculator: "FusableAddOneCalculator"
+      input_stream: "input"
+      output_stream: "a"
+    }
+    node {
+      calculator: "FusableAddOneCalculator"
+      input_stream: "a"
+      output_stream: "output"
+    }
+  )pb");
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  EXPECT_THAT(
+      Calculators(graph.Config()),
+      ElementsAre("FusableAddOneCalculator", "FusableAddOneCalculator"));
+}
+
+TEST(GraphFusionTest, ReportsFusedNodesInProfile) {
+  CalculatorGraphConfig config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "input"
+    output_stream: "output"
+    fuse_calculator_chains: true
+    profiler_config { enable_profiler: true }
+    node {
+      name: "first"
+      calculator: "FusableAddOneCalculator"
+      input_stream: "input"
+      output_stream: "a"
+    }
+    node {
+      name: "second"
+      calculator: "FusableAddOneCalculator"
+      input_stream: "a"
+      output_stream: "output"
+    }
+  )pb");
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  std::vector<CalculatorProfile> profiles;
+  MP_ASSERT_OK(graph.profiler()->GetCalculatorProfiles(&profiles));
+  ASSERT_EQ(profiles.size(), 1);
+  EXPECT_EQ(profiles[0].name(), "first__second");
+  EXPECT_THAT(profiles[0].fused_node(), ElementsAre("first", "second"));
+}
+
+}  // namespace
+}  // namespace mediapipe
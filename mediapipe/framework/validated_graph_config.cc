@@ -222,6 +222,7 @@ absl::Status NodeTypeInfo::Initialize(
       _ << "Unable to find Calculator \"" << node_class << "\"");
   MP_RETURN_IF_ERROR(calculator_factory->GetContract(&contract_)).SetPrepend()
       << node_class << ": ";
+  calculator_factory_ = std::move(calculator_factory);
 
   // Validate result of FillExpectations or GetContract.
   std::vector<absl::Status> statuses;
@@ -245,7 +246,8 @@ absl::Status NodeTypeInfo::Initialize(
   }
   if (!statuses.empty()) {
     return tool::CombinedStatus(
-        absl::StrCat(node_class, "::", calculator_factory->ContractMethodName(),
+        absl::StrCat(node_class,
+                     "::", calculator_factory_->ContractMethodName(),
                      " failed to validate: "),
         statuses);
   }
@@ -16,12 +16,14 @@
 #define MEDIAPIPE_FRAMEWORK_VALIDATED_GRAPH_CONFIG_H_
 
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "absl/container/flat_hash_set.h"
 #include "google/protobuf/repeated_ptr_field.h"
 #include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/calculator_base.h"
 #include "mediapipe/framework/calculator_contract.h"
 #include "mediapipe/framework/graph_service_manager.h"
 #include "mediapipe/framework/packet_generator.pb.h"
@@ -95,6 +97,12 @@ class NodeTypeInfo {
 
   const CalculatorContract& Contract() const { return contract_; }
 
+  // Returns the factory of the calculator, which was resolved when the node
+  // was validated. Returns nullptr for nodes that aren't calculators.
+  internal::CalculatorBaseFactory* CalculatorFactory() const {
+    return calculator_factory_.get();
+  }
+
   // Non-const accessors.
   PacketTypeSet& InputSidePacketTypes() { return contract_.InputSidePackets(); }
   PacketTypeSet& OutputSidePacketTypes() {
@@ -161,6 +169,10 @@ class NodeTypeInfo {
   // ValidatedGraphConfig::EdgeInfo objects).
   CalculatorContract contract_;
 
+  // The factory used to validate the calculator, kept so that the calculator
+  // doesn't need to be looked up in the registry again at every run.
+  std::shared_ptr<internal::CalculatorBaseFactory> calculator_factory_;
+
   // The base indexes of the first entry belonging to this node in
   // the main flat arrays of ValidatedGraphConfig.  Subsequent
   // entries are guaranteed to be sequential and in the order of the
@@ -0,0 +1,61 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_WORK_STEALING_EXECUTOR_H_
+#define MEDIAPIPE_FRAMEWORK_WORK_STEALING_EXECUTOR_H_
+
+#include <functional>
+
+#include "mediapipe/framework/deps/thread_options.h"
+#include "mediapipe/framework/deps/work_stealing_threadpool.h"
+#include "mediapipe/framework/executor.h"
+#include "mediapipe/framework/port/statusor.h"
+
+namespace mediapipe {
+
+// A multithreaded executor based on a work-stealing thread pool. Each worker
+// owns a task deque, so tasks scheduled by a node running on a worker (which
+// is how the scheduler queue submits the successors of a node) do not contend
+// with the other workers.
+//
+// Select it in the CalculatorGraphConfig with:
+//
+//   executor {
+//     type: "WorkStealingExecutor"
+//     options {
+//       [mediapipe.WorkStealingExecutorOptions.ext] { num_threads: 16 }
+//     }
+//   }
+class WorkStealingExecutor : public Executor {
+ public:
+  static absl::StatusOr<Executor*> Create(
+      const MediaPipeOptions& extendable_options);
+
+  explicit WorkStealingExecutor(int num_threads);
+  ~WorkStealingExecutor() override;
+  void Schedule(std::function<void()> task) override;
+
+  // For testing.
+  int num_threads() const { return thread_pool_.num_threads(); }
+  int64_t num_steals() const { return thread_pool_.num_steals(); }
+
+ private:
+  WorkStealingExecutor(const ThreadOptions& thread_options, int num_threads);
+
+  WorkStealingThreadPool thread_pool_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_WORK_STEALING_EXECUTOR_H_
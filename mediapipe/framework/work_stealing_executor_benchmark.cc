@@ -0,0 +1,95 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Compares WorkStealingExecutor with ThreadPoolExecutor on a wide fan-out
+// graph of cheap nodes, where the single ThreadPool queue is contended.
+//
+// $ bazel run -c opt \
+//   mediapipe/framework:work_stealing_executor_benchmark
+#include <string>
+
+#include "absl/log/absl_check.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/thread_pool_executor.pb.h"
+#include "mediapipe/framework/work_stealing_executor.pb.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr int kNumBranches = 64;
+constexpr int kNumPackets = 200;
+
+CalculatorGraphConfig FanOutConfig(const std::string& executor_type,
+                                   int num_threads) {
+  CalculatorGraphConfig config;
+  config.add_input_stream("in");
+  ExecutorConfig* executor = config.add_executor();
+  executor->set_type(executor_type);
+  if (executor_type == "WorkStealingExecutor") {
+    executor->mutable_options()
+        ->MutableExtension(WorkStealingExecutorOptions::ext)
+        ->set_num_threads(num_threads);
+  } else {
+    executor->mutable_options()
+        ->MutableExtension(ThreadPoolExecutorOptions::ext)
+        ->set_num_threads(num_threads);
+  }
+  for (int i = 0; i < kNumBranches; ++i) {
+    auto* node = config.add_node();
+    node->set_calculator("PassThroughCalculator");
+    node->add_input_stream("in");
+    node->add_output_stream(absl::StrCat("out_", i));
+  }
+  return config;
+}
+
+void RunFanOutGraph(benchmark::State& state,
+                    const std::string& executor_type) {
+  const CalculatorGraphConfig config =
+      FanOutConfig(executor_type, state.range(0));
+  for (auto _ : state) {
+    CalculatorGraph graph;
+    ABSL_CHECK_OK(graph.Initialize(config));
+    ABSL_CHECK_OK(graph.StartRun({}));
+    for (int t = 0; t < kNumPackets; ++t) {
+      ABSL_CHECK_OK(graph.AddPacketToInputStream(
+          "in", MakePacket<int>(t).At(Timestamp(t))));
+    }
+    ABSL_CHECK_OK(graph.CloseAllInputStreams());
+    ABSL_CHECK_OK(graph.WaitUntilDone());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumPackets * kNumBranches);
+}
+
+void BM_FanOutThreadPoolExecutor(benchmark::State& state) {
+  RunFanOutGraph(state, "ThreadPoolExecutor");
+}
+BENCHMARK(BM_FanOutThreadPoolExecutor)->Arg(4)->Arg(8)->Arg(16)->UseRealTime();
+
+void BM_FanOutWorkStealingExecutor(benchmark::State& state) {
+  RunFanOutGraph(state, "WorkStealingExecutor");
+}
+BENCHMARK(BM_FanOutWorkStealingExecutor)
+    ->Arg(4)
+    ->Arg(8)
+    ->Arg(16)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace mediapipe
+
+BENCHMARK_MAIN();
@@ -0,0 +1,95 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/work_stealing_executor.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/tool/sink.h"
+#include "mediapipe/framework/work_stealing_executor.pb.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::HasSubstr;
+
+TEST(WorkStealingExecutorTest, CreateRequiresPositiveNumThreads) {
+  MediaPipeOptions options;
+  EXPECT_THAT(WorkStealingExecutor::Create(options).status().message(),
+              HasSubstr("num_threads is not specified"));
+  options.MutableExtension(WorkStealingExecutorOptions::ext)
+      ->set_num_threads(0);
+  EXPECT_THAT(WorkStealingExecutor::Create(options).status().message(),
+              HasSubstr("should be positive"));
+  options.MutableExtension(WorkStealingExecutorOptions::ext)
+      ->set_num_threads(3);
+  MP_ASSERT_OK_AND_ASSIGN(Executor * executor,
+                          WorkStealingExecutor::Create(options));
+  std::unique_ptr<WorkStealingExecutor> work_stealing_executor(
+      static_cast<WorkStealingExecutor*>(executor));
+  EXPECT_EQ(work_stealing_executor->num_threads(), 3);
+}
+
+// Runs a wide fan-out graph on a WorkStealingExecutor selected through the
+// CalculatorGraphConfig and checks that every branch sees every packet.
+TEST(WorkStealingExecutorTest, RunsFanOutGraph) {
+  constexpr int kNumBranches = 16;
+  constexpr int kNumPackets = 100;
+  auto config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "in"
+    executor {
+      type: "WorkStealingExecutor"
+      options {
+        [mediapipe.WorkStealingExecutorOptions.ext] { num_threads: 4 }
+      }
+    }
+  )pb");
+  std::vector<std::vector<Packet>> outputs(kNumBranches);
+  for (int i = 0; i < kNumBranches; ++i) {
+    auto* node = config.add_node();
+    node->set_calculator("PassThroughCalculator");
+    node->add_input_stream("in");
+    node->add_output_stream(absl::StrCat("out_", i));
+    tool::AddVectorSink(absl::StrCat("out_", i), &config, &outputs[i]);
+  }
+
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun({}));
+  for (int t = 0; t < kNumPackets; ++t) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(t).At(Timestamp(t))));
+  }
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  for (int i = 0; i < kNumBranches; ++i) {
+    ASSERT_EQ(outputs[i].size(), kNumPackets);
+    for (int t = 0; t < kNumPackets; ++t) {
+      EXPECT_EQ(outputs[i][t].Get<int>(), t);
+      EXPECT_EQ(outputs[i][t].Timestamp(), Timestamp(t));
+    }
+  }
+}
+
+}  // namespace
+}  // namespace mediapipe
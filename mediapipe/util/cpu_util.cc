@@ -24,12 +24,19 @@
 #else
 #include <unistd.h>
 #endif
+#if defined(__linux__)
+#include <sched.h>
+#endif
 #include <fstream>
+#include <string>
+#include <vector>
 
 #include "absl/algorithm/container.h"
 #include "absl/strings/match.h"
 #include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/statusor.h"
@@ -126,4 +133,46 @@ std::set<int> InferHigherCoreIds() {
   return InferLowerOrHigherCoreIds(/* lower= */ false);
 }
 
+absl::StatusOr<std::set<int>> ParseCpuList(absl::string_view cpu_list) {
+  std::set<int> cpu_ids;
+  for (absl::string_view range :
+       absl::StrSplit(cpu_list, ',', absl::SkipWhitespace())) {
+    std::vector<absl::string_view> bounds = absl::StrSplit(range, '-');
+    int first, last;
+    if (bounds.size() > 2 || !absl::SimpleAtoi(bounds.front(), &first) ||
+        !absl::SimpleAtoi(bounds.back(), &last) || first < 0 || last < first) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Invalid CPU list: ", cpu_list));
+    }
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpu_ids.insert(cpu);
+    }
+  }
+  return cpu_ids;
+}
+
+absl::StatusOr<std::set<int>> GetNumaNodeCpuIds(int numa_node) {
+#if defined(__linux__)
+  const std::string path = absl::Substitute(
+      "/sys/devices/system/node/node$0/cpulist", numa_node);
+  std::ifstream file(path);
+  std::string cpu_list;
+  if (numa_node < 0 || !file.is_open() || !std::getline(file, cpu_list)) {
+    return absl::NotFoundError(absl::StrCat("Couldn't read ", path));
+  }
+  return ParseCpuList(cpu_list);
+#else
+  return absl::UnimplementedError(
+      "NUMA nodes are only supported on Linux.");
+#endif
+}
+
+int GetCurrentCpuId() {
+#if defined(__linux__)
+  return sched_getcpu();
+#else
+  return -1;
+#endif
+}
+
 }  // namespace mediapipe.
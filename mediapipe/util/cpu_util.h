@@ -17,6 +17,9 @@
 
 #include <set>
 
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+
 namespace mediapipe {
 // Returns the number of CPU cores. Compatible with Android.
 int NumCPUCores();
@@ -24,6 +27,14 @@ int NumCPUCores();
 std::set<int> InferLowerCoreIds();
 // Returns a set of inferred CPU ids of higher cores.
 std::set<int> InferHigherCoreIds();
+// Parses a CPU list such as "0-3,8,10-11", the format used by the sysfs
+// cpulist files.
+absl::StatusOr<std::set<int>> ParseCpuList(absl::string_view cpu_list);
+// Returns the CPU ids of the given NUMA node. Only implemented on Linux.
+absl::StatusOr<std::set<int>> GetNumaNodeCpuIds(int numa_node);
+// Returns the id of the CPU the calling thread is running on, or -1 if it
+// cannot be determined on the current platform.
+int GetCurrentCpuId();
 }  // namespace mediapipe
 
 #endif  // MEDIAPIPE_UTIL_CPU_UTIL_H_
@@ -0,0 +1,80 @@
+// Copyright 2024 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/cpu_util.h"
+
+#include <set>
+
+#include "absl/status/status.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::Not;
+
+TEST(ParseCpuListTest, ParsesRanges) {
+  EXPECT_THAT(ParseCpuList("0-3"), IsOkAndHolds(ElementsAre(0, 1, 2, 3)));
+  EXPECT_THAT(ParseCpuList("0-1,4-5"), IsOkAndHolds(ElementsAre(0, 1, 4, 5)));
+  EXPECT_THAT(ParseCpuList("2-2"), IsOkAndHolds(ElementsAre(2)));
+}
+
+TEST(ParseCpuListTest, ParsesSingleCpus) {
+  EXPECT_THAT(ParseCpuList("7"), IsOkAndHolds(ElementsAre(7)));
+  EXPECT_THAT(ParseCpuList("0-3,8,10-11"),
+              IsOkAndHolds(ElementsAre(0, 1, 2, 3, 8, 10, 11)));
+  EXPECT_THAT(ParseCpuList("3,1,3"), IsOkAndHolds(ElementsAre(1, 3)));
+}
+
+TEST(ParseCpuListTest, IgnoresWhitespace) {
+  // The sysfs files end with a newline.
+  EXPECT_THAT(ParseCpuList("0-1\n"), IsOkAndHolds(ElementsAre(0, 1)));
+  EXPECT_THAT(ParseCpuList(" 0 - 1 , 4 "), IsOkAndHolds(ElementsAre(0, 1, 4)));
+  EXPECT_THAT(ParseCpuList("0,,1"), IsOkAndHolds(ElementsAre(0, 1)));
+  EXPECT_THAT(ParseCpuList(""), IsOkAndHolds(IsEmpty()));
+  EXPECT_THAT(ParseCpuList("\n"), IsOkAndHolds(IsEmpty()));
+}
+
+TEST(ParseCpuListTest, RejectsMalformedLists) {
+  for (const char* cpu_list :
+       {"a", "0-a", "1-", "-1", "3-1", "0-1-2", "0;1", "1.5"}) {
+    EXPECT_THAT(ParseCpuList(cpu_list),
+                StatusIs(absl::StatusCode::kInvalidArgument))
+        << cpu_list;
+  }
+}
+
+TEST(GetNumaNodeCpuIdsTest, RejectsInvalidNode) {
+  EXPECT_THAT(GetNumaNodeCpuIds(-1), Not(IsOk()));
+}
+
+#if defined(__linux__)
+TEST(GetNumaNodeCpuIdsTest, ReadsExistingNode) {
+  const absl::StatusOr<std::set<int>> cpu_ids = GetNumaNodeCpuIds(0);
+  if (!cpu_ids.ok()) {
+    GTEST_SKIP() << "No NUMA node 0: " << cpu_ids.status();
+  }
+  // Node 0 may have memory only, and then lists no CPUs.
+  for (int cpu : *cpu_ids) {
+    EXPECT_GE(cpu, 0);
+  }
+}
+#endif  // defined(__linux__)
+
+}  // namespace
+}  // namespace mediapipe